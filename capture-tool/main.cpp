@@ -0,0 +1,373 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Offline analysis of the capture files written by the layer (see the "capture" setting).
+//
+// Usage: capture-tool summary <capture>
+//        capture-tool compare <baseline capture> <candidate capture>
+//
+// The comparison reports the CPU cost of the layer (time spent in its entry points, minus the time spent in the
+// runtime) and the differences between the outputs of the layer for identical inputs from the runtime.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <utils/capture.h>
+
+using namespace openxr_api_layer::utils;
+using namespace openxr_api_layer::utils::capture;
+
+namespace {
+
+    bool load(const char* path, Capture& capture) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            fprintf(stderr, "Cannot open %s\n", path);
+            return false;
+        }
+        capture.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        if (!parse(capture)) {
+            fprintf(stderr, "%s is not a supported capture file\n", path);
+            return false;
+        }
+
+        return true;
+    }
+
+    struct Distribution {
+        std::vector<uint64_t> values;
+
+        void add(uint64_t value) {
+            values.push_back(value);
+        }
+
+        uint64_t percentile(double p) {
+            if (values.empty()) {
+                return 0;
+            }
+            std::sort(values.begin(), values.end());
+            return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+        }
+
+        double mean() const {
+            if (values.empty()) {
+                return 0.0;
+            }
+            double sum = 0.0;
+            for (const uint64_t value : values) {
+                sum += (double)value;
+            }
+            return sum / values.size();
+        }
+    };
+
+    struct Statistics {
+        uint64_t count[(size_t)RecordType::Count]{};
+        uint64_t failures[(size_t)RecordType::Count]{};
+        Distribution layerNs[(size_t)RecordType::Count];
+        Distribution runtimeNs[(size_t)RecordType::Count];
+        Distribution frameIntervalNs;
+    };
+
+    Statistics computeStatistics(const Capture& capture) {
+        Statistics stats;
+        uint64_t lastEndFrame = 0;
+        for (const Record& record : capture.records) {
+            const size_t index = (size_t)record.type;
+            if (index >= (size_t)RecordType::Count) {
+                continue;
+            }
+            stats.count[index]++;
+            if (record.result < 0) {
+                stats.failures[index]++;
+            }
+            stats.layerNs[index].add(record.durationNs - std::min(record.durationNs, record.runtimeNs));
+            stats.runtimeNs[index].add(record.runtimeNs);
+
+            if (record.type == RecordType::EndFrame) {
+                if (lastEndFrame) {
+                    stats.frameIntervalNs.add(record.timestampNs - lastEndFrame);
+                }
+                lastEndFrame = record.timestampNs;
+            }
+        }
+        return stats;
+    }
+
+    double toDegrees(float radians) {
+        return radians * 180.0 / 3.14159265358979323846;
+    }
+
+    void printHeader(const char* label, const Capture& capture) {
+        printf("%s: %s (pid %u) on %s %u.%u.%u, fov_up=%d fov_down=%d angle_up=%d angle_down=%d upscaling=%d "
+               "padding=%d, %zu records, %llu dropped\n",
+               label,
+               capture.header.applicationName,
+               capture.header.processId,
+               capture.header.runtimeName,
+               (uint32_t)(capture.header.runtimeVersion >> 48),
+               (uint32_t)((capture.header.runtimeVersion >> 32) & 0xffff),
+               (uint32_t)(capture.header.runtimeVersion & 0xffffffff),
+               capture.header.fovUpSetting,
+               capture.header.fovDownSetting,
+               capture.header.angleUpSetting,
+               capture.header.angleDownSetting,
+               capture.header.upscalingSetting,
+               capture.header.paddingSetting,
+               capture.records.size(),
+               capture.header.droppedRecords);
+    }
+
+    void printSummary(const Capture& capture) {
+        printHeader("Capture", capture);
+        Statistics stats = computeStatistics(capture);
+
+        printf("\n%-36s %8s %8s %12s %12s %12s %12s\n",
+               "Function",
+               "Calls",
+               "Failed",
+               "Layer p50us",
+               "Layer p99us",
+               "Layer maxus",
+               "Runtime p50us");
+        for (size_t i = 1; i < (size_t)RecordType::Count; i++) {
+            if (!stats.count[i]) {
+                continue;
+            }
+            printf("%-36s %8llu %8llu %12.2f %12.2f %12.2f %12.2f\n",
+                   getRecordTypeName((RecordType)i),
+                   stats.count[i],
+                   stats.failures[i],
+                   stats.layerNs[i].percentile(0.5) / 1e3,
+                   stats.layerNs[i].percentile(0.99) / 1e3,
+                   stats.layerNs[i].percentile(1.0) / 1e3,
+                   stats.runtimeNs[i].percentile(0.5) / 1e3);
+        }
+
+        if (!stats.frameIntervalNs.values.empty()) {
+            const double mean = stats.frameIntervalNs.mean();
+            printf("\nFrame cadence: %.2f fps, interval p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+                   1e9 / mean,
+                   stats.frameIntervalNs.percentile(0.5) / 1e6,
+                   stats.frameIntervalNs.percentile(0.99) / 1e6,
+                   stats.frameIntervalNs.percentile(1.0) / 1e6);
+        }
+
+        for (auto it = capture.records.rbegin(); it != capture.records.rend(); ++it) {
+            if (it->type != RecordType::EnumerateViewConfigurationViews) {
+                continue;
+            }
+            const auto& payload = it->as<EnumerateViewConfigurationViewsPayload>();
+            if (!payload.viewCount || !payload.nativeImageSize[0].width) {
+                continue;
+            }
+            printf("\nView configuration %u:\n", payload.viewConfigurationType);
+            for (uint32_t i = 0; i < std::min(payload.viewCount, MaxViews); i++) {
+                printf("  view %u: %ux%u -> %ux%u\n",
+                       i,
+                       payload.nativeImageSize[i].width,
+                       payload.nativeImageSize[i].height,
+                       payload.recommendedImageSize[i].width,
+                       payload.recommendedImageSize[i].height);
+            }
+            break;
+        }
+
+        for (const Record& record : capture.records) {
+            if (record.type != RecordType::LocateViews || record.result < 0) {
+                continue;
+            }
+            const auto& payload = record.as<LocateViewsPayload>();
+            if (!payload.viewCount) {
+                continue;
+            }
+            printf("\nField of view (degrees, up/down):\n");
+            for (uint32_t i = 0; i < std::min(payload.viewCount, MaxViews); i++) {
+                printf("  view %u: %.2f/%.2f -> %.2f/%.2f\n",
+                       i,
+                       toDegrees(payload.nativeFov[i].angleUp),
+                       toDegrees(payload.nativeFov[i].angleDown),
+                       toDegrees(payload.customizedFov[i].angleUp),
+                       toDegrees(payload.customizedFov[i].angleDown));
+            }
+            break;
+        }
+    }
+
+    // Round the inputs so that the same runtime output matches across captures.
+    using FovKey = std::vector<int64_t>;
+
+    FovKey makeFovKey(const LocateViewsPayload& payload) {
+        FovKey key{payload.viewConfigurationType, payload.viewCount};
+        for (uint32_t i = 0; i < std::min(payload.viewCount, MaxViews); i++) {
+            for (const float angle : {payload.nativeFov[i].angleLeft,
+                                      payload.nativeFov[i].angleRight,
+                                      payload.nativeFov[i].angleUp,
+                                      payload.nativeFov[i].angleDown}) {
+                key.push_back(std::llround(angle * 1e5));
+            }
+        }
+        return key;
+    }
+
+    using ImageSizeKey = std::vector<uint32_t>;
+
+    ImageSizeKey makeImageSizeKey(const EnumerateViewConfigurationViewsPayload& payload) {
+        ImageSizeKey key{payload.viewConfigurationType, payload.viewCount};
+        for (uint32_t i = 0; i < std::min(payload.viewCount, MaxViews); i++) {
+            key.push_back(payload.nativeImageSize[i].width);
+            key.push_back(payload.nativeImageSize[i].height);
+        }
+        return key;
+    }
+
+    int compare(const Capture& baseline, const Capture& candidate) {
+        printHeader("Baseline", baseline);
+        printHeader("Candidate", candidate);
+        if (baseline.header.fovUpSetting != candidate.header.fovUpSetting ||
+            baseline.header.fovDownSetting != candidate.header.fovDownSetting ||
+            baseline.header.upscalingSetting != candidate.header.upscalingSetting ||
+            baseline.header.paddingSetting != candidate.header.paddingSetting) {
+            printf("Warning: the captures were made with different settings\n");
+        }
+
+        Statistics baselineStats = computeStatistics(baseline);
+        Statistics candidateStats = computeStatistics(candidate);
+
+        printf("\n%-36s %14s %14s %14s %14s\n",
+               "Layer CPU cost",
+               "Base p50us",
+               "Cand p50us",
+               "Base p99us",
+               "Cand p99us");
+        for (size_t i = 1; i < (size_t)RecordType::Count; i++) {
+            if (!baselineStats.count[i] && !candidateStats.count[i]) {
+                continue;
+            }
+            printf("%-36s %14.2f %14.2f %14.2f %14.2f\n",
+                   getRecordTypeName((RecordType)i),
+                   baselineStats.layerNs[i].percentile(0.5) / 1e3,
+                   candidateStats.layerNs[i].percentile(0.5) / 1e3,
+                   baselineStats.layerNs[i].percentile(0.99) / 1e3,
+                   candidateStats.layerNs[i].percentile(0.99) / 1e3);
+        }
+
+        // Index the outputs of the baseline by their inputs.
+        std::map<FovKey, const LocateViewsPayload*> baselineFov;
+        std::map<ImageSizeKey, const EnumerateViewConfigurationViewsPayload*> baselineImageSize;
+        for (const Record& record : baseline.records) {
+            if (record.type == RecordType::LocateViews && record.result >= 0) {
+                const auto& payload = record.as<LocateViewsPayload>();
+                baselineFov.emplace(makeFovKey(payload), &payload);
+            } else if (record.type == RecordType::EnumerateViewConfigurationViews && record.result >= 0) {
+                const auto& payload = record.as<EnumerateViewConfigurationViewsPayload>();
+                baselineImageSize.emplace(makeImageSizeKey(payload), &payload);
+            }
+        }
+
+        uint64_t fovCompared = 0;
+        uint64_t fovMismatches = 0;
+        double fovMaxDifference = 0.0;
+        uint64_t imageSizeCompared = 0;
+        uint64_t imageSizeMismatches = 0;
+        for (const Record& record : candidate.records) {
+            if (record.type == RecordType::LocateViews && record.result >= 0) {
+                const auto& payload = record.as<LocateViewsPayload>();
+                const auto it = baselineFov.find(makeFovKey(payload));
+                if (it == baselineFov.end()) {
+                    continue;
+                }
+                fovCompared++;
+                double difference = 0.0;
+                for (uint32_t i = 0; i < std::min(payload.viewCount, MaxViews); i++) {
+                    const telemetry::Fov& a = it->second->customizedFov[i];
+                    const telemetry::Fov& b = payload.customizedFov[i];
+                    difference = std::max({difference,
+                                           (double)std::abs(a.angleLeft - b.angleLeft),
+                                           (double)std::abs(a.angleRight - b.angleRight),
+                                           (double)std::abs(a.angleUp - b.angleUp),
+                                           (double)std::abs(a.angleDown - b.angleDown)});
+                }
+                if (difference > 1e-5) {
+                    fovMismatches++;
+                }
+                fovMaxDifference = std::max(fovMaxDifference, difference);
+            } else if (record.type == RecordType::EnumerateViewConfigurationViews && record.result >= 0) {
+                const auto& payload = record.as<EnumerateViewConfigurationViewsPayload>();
+                const auto it = baselineImageSize.find(makeImageSizeKey(payload));
+                if (it == baselineImageSize.end()) {
+                    continue;
+                }
+                imageSizeCompared++;
+                for (uint32_t i = 0; i < std::min(payload.viewCount, MaxViews); i++) {
+                    if (it->second->recommendedImageSize[i].width != payload.recommendedImageSize[i].width ||
+                        it->second->recommendedImageSize[i].height != payload.recommendedImageSize[i].height) {
+                        imageSizeMismatches++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        printf("\nxrLocateViews outputs: %llu compared, %llu differ (max %.6f degrees)\n",
+               fovCompared,
+               fovMismatches,
+               toDegrees((float)fovMaxDifference));
+        printf("xrEnumerateViewConfigurationViews outputs: %llu compared, %llu differ\n",
+               imageSizeCompared,
+               imageSizeMismatches);
+
+        return (fovMismatches || imageSizeMismatches) ? 2 : 0;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string command(argc > 1 ? argv[1] : "");
+    if (command == "summary" && argc == 3) {
+        Capture capture;
+        if (!load(argv[2], capture)) {
+            return 1;
+        }
+        printSummary(capture);
+        return 0;
+    } else if (command == "compare" && argc == 4) {
+        Capture baseline;
+        Capture candidate;
+        if (!load(argv[2], baseline) || !load(argv[3], candidate)) {
+            return 1;
+        }
+        return compare(baseline, candidate);
+    }
+
+    fprintf(stderr, "Usage: %s summary <capture>\n", argv[0]);
+    fprintf(stderr, "       %s compare <baseline capture> <candidate capture>\n", argv[0]);
+    return 1;
+}
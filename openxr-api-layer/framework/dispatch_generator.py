@@ -50,6 +50,10 @@ if 'xrGetInstanceProcAddr' in layer_apis.override_functions:
 if 'xrGetInstanceProcAddr' in layer_apis.requested_functions:
     raise Exception("xrGetInstanceProcAddr() cannot be specified in requested_functions. Use the m_xrGetInstanceProcAddr() class member.")
 
+for func in layer_apis.fast_functions:
+    if func not in layer_apis.override_functions:
+        raise Exception(f"{func}() is specified in fast_functions but not in override_functions")
+
 
 class DispatchGenOutputGenerator(AutomaticSourceOutputGenerator):
     '''Common generator utilities and formatting.'''
@@ -157,7 +161,36 @@ namespace openxr_api_layer
                 parameters_list = self.makeParametersList(cur_cmd)
                 arguments_list = self.makeArgumentsList(cur_cmd)
 
-                if cur_cmd.return_type is not None:
+                if cur_cmd.name in layer_apis.fast_functions:
+                    if cur_cmd.return_type is None:
+                        raise Exception(f"{cur_cmd.name}() does not return a result and cannot be specified in fast_functions")
+
+                    generated += f'''
+	XrResult XRAPI_CALL {cur_cmd.name}({parameters_list}) noexcept
+	{{
+		XrResult result;
+		if (!IsTraceEnabled())
+		{{
+			result = openxr_api_layer::GetInstance()->{cur_cmd.name}({arguments_list});
+		}}
+		else
+		{{
+			TraceLocalActivity(local);
+			TraceLoggingWriteStart(local, "{cur_cmd.name}");
+
+			result = openxr_api_layer::GetInstance()->{cur_cmd.name}({arguments_list});
+
+			TraceLoggingWriteStop(local, "{cur_cmd.name}", TLArg(xr::ToCString(result), "Result"));
+		}}
+
+		if (XR_FAILED(result)) {{
+			ErrorLog(fmt::format("{cur_cmd.name} failed with {{}}\\n", xr::ToCString(result)));
+		}}
+
+		return result;
+	}}
+'''
+                elif cur_cmd.return_type is not None:
                     generated += f'''
 	XrResult XRAPI_CALL {cur_cmd.name}({parameters_list})
 	{{
@@ -423,7 +456,14 @@ namespace openxr_api_layer
                 generated += '''
 	public:'''
 
-                if cur_cmd.return_type is not None:
+                if cur_cmd.name in layer_apis.fast_functions:
+                    generated += f'''
+		virtual XrResult {cur_cmd.name}({parameters_list}) noexcept
+		{{
+			return m_{cur_cmd.name}({arguments_list});
+		}}
+'''
+                elif cur_cmd.return_type is not None:
                     generated += f'''
 		virtual XrResult {cur_cmd.name}({parameters_list})
 		{{
@@ -2,8 +2,23 @@
 override_functions = [
     "xrGetSystem",
     "xrCreateSession",
+    "xrDestroySession",
     "xrEnumerateViewConfigurationViews",
-    "xrLocateViews"
+    "xrLocateViews",
+    "xrCreateSwapchain",
+    "xrDestroySwapchain",
+    "xrAcquireSwapchainImage",
+    "xrWaitSwapchainImage",
+    "xrReleaseSwapchainImage",
+    "xrEndFrame"
+]
+
+# The subset of override_functions that are called every frame. Their wrappers do not catch exceptions and only create
+# trace activities when a trace session is listening: the layer's implementation must be noexcept and report errors
+# through its return value.
+fast_functions = [
+    "xrLocateViews",
+    "xrEndFrame"
 ]
 
 # The list of OpenXR functions our layer will use from the runtime.
@@ -24,7 +24,7 @@
 
 namespace {
     constexpr uint32_t k_maxLoggedErrors = 100;
-    uint32_t g_globalErrorCount = 0;
+    std::atomic<uint32_t> g_globalErrorCount = 0;
 } // namespace
 
 namespace openxr_api_layer::log {
@@ -73,6 +73,11 @@ namespace openxr_api_layer::log {
         }
     }
 
+    uint32_t GetDroppedErrorCount() {
+        const uint32_t errorCount = g_globalErrorCount.load(std::memory_order_relaxed);
+        return errorCount > k_maxLoggedErrors ? errorCount - k_maxLoggedErrors : 0;
+    }
+
     void DebugLog(const char* fmt, ...) {
 #ifdef _DEBUG
         va_list va;
@@ -60,4 +60,7 @@ namespace openxr_api_layer::log {
         Log(str.data());
     }
 
+    // Number of error messages that were not logged after going silent.
+    uint32_t GetDroppedErrorCount();
+
 } // namespace openxr_api_layer::log
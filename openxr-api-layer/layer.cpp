@@ -28,11 +28,97 @@
 #include "layer.h"
 #include <log.h>
 #include <util.h>
+#include <utils/capture.h>
+#include <utils/placement.h>
+#include <utils/screenshot.h>
+#include <utils/telemetry.h>
 
 namespace openxr_api_layer {
 
     using namespace log;
 
+    using clock = std::chrono::steady_clock;
+
+    static inline uint64_t elapsedMicroseconds(clock::time_point start, clock::time_point end = clock::now()) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+
+    static inline utils::telemetry::Fov toTelemetry(const XrFovf& fov) {
+        return {fov.angleLeft, fov.angleRight, fov.angleUp, fov.angleDown};
+    }
+
+    static inline float angleSettingToRadians(int angle) {
+        return DirectX::XM_PI * angle / 180000.0f;
+    }
+
+    // The FOV customization. Published as an immutable snapshot so that concurrent callers of xrLocateViews() and
+    // xrEnumerateViewConfigurationViews() never wait on a writer.
+    struct FovSettings {
+        // The FOV angles of the system, as last discovered and stored in the registry.
+        XrFovf cachedEyeFov[2]{};
+
+        // The scale factors applied to the up/down angles.
+        float fovUp{1.f};
+        float fovDown{1.f};
+    };
+
+    // The state of a session. Published the same way as FovSettings.
+    struct SessionState {
+        bool anglesWrittenToReg{false};
+    };
+
+    using SessionStatePublisher = utils::general::SnapshotPublisher<SessionState>;
+    using SessionTable = std::vector<std::pair<XrSession, std::shared_ptr<SessionStatePublisher>>>;
+
+    // How the cropped image is extended back to the native FOV.
+    enum class PaddingMode {
+        None,
+        Black,
+        EdgeClamped,
+    };
+
+    // An application swapchain rendered with the cropped FOV or at reduced resolution, and the swapchain submitted
+    // instead, at full resolution and covering the native FOV when padding.
+    struct ResampledSwapchain {
+        std::shared_ptr<utils::graphics::ISwapchain> application;
+        // Created upon first submission.
+        std::shared_ptr<utils::graphics::ISwapchain> submitted;
+        // Ratio of the submitted height to the upscaled application height.
+        float paddingRatio{1.f};
+        // Black borders are cleared once per image, since the views never write outside of their content rectangle.
+        std::vector<bool> clearedImages;
+        // Created upon first frame capture.
+        std::shared_ptr<utils::graphics::IGraphicsReadback> readback;
+    };
+
+    // The resampled swapchains of a session, owned by its composition framework.
+    struct ResamplingSessionData : utils::graphics::ICompositionSessionData {
+        std::mutex mutex;
+        std::unordered_map<XrSwapchain, ResampledSwapchain> swapchains;
+
+        uint64_t frameIndex{0};
+        std::optional<clock::time_point> lastFrameCaptureRequestPoll;
+
+        // The GPU time of the composition, reported through telemetry.
+        std::shared_ptr<utils::graphics::IGraphicsTimerPool> compositionTimerPool;
+        bool isCompositionTimerPoolCreated{false};
+    };
+
+    using SwapchainImages = std::unordered_map<ResampledSwapchain*, utils::graphics::ISwapchainImage*>;
+
+    // A copy of the layers submitted by the application, for the compositions deferred to the worker thread.
+    // Deques keep the pointers between the structures stable.
+    struct FrameCopy {
+        XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
+        std::vector<const XrCompositionLayerBaseHeader*> layers;
+        std::deque<XrCompositionLayerProjection> projections;
+        std::deque<std::vector<XrCompositionLayerProjectionView>> projectionViews;
+        std::deque<XrCompositionLayerQuad> quads;
+    };
+
+    // The views of a frame capture are tagged with the frame index and their index in the frame.
+    constexpr uint32_t MaxCapturedViews = 16;
+
     // Our API layer implement these extensions, and their specified version.
     const std::vector<std::pair<std::string, uint32_t>> advertisedExtensions = {};
 
@@ -43,11 +129,7 @@ namespace openxr_api_layer {
 
     // This class implements our API layer.
     class OpenXrLayer : public openxr_api_layer::OpenXrApi {
-        XrFovf m_cachedEyeFov[2] = {{}, {}};
-        float fovUp;
-        float fovDown;
-        bool anglesWrittenToReg = false;
-        const float defaultFovAngle = 45000;
+        const int defaultFovAngle = 45000;
 
       public:
         OpenXrLayer() = default;
@@ -60,6 +142,7 @@ namespace openxr_api_layer {
                                                               uint32_t* viewCountOutput,
                                                    XrViewConfigurationView* views) override {
             Log("xrEnumerateViewConfigurationViews\n");
+            const auto callStart = clock::now();
             const XrResult result = OpenXrApi::xrEnumerateViewConfigurationViews(
                 instance,
                                                                  systemId,
@@ -67,17 +150,77 @@ namespace openxr_api_layer {
                                                                  viewCapacityInput,
                                                                  viewCountOutput,
                                                                  views);
+            const auto runtimeEnd = clock::now();
+
+            utils::capture::EnumerateViewConfigurationViewsPayload capture{};
+            capture.viewConfigurationType = viewConfigurationType;
+            if (XR_SUCCEEDED(result)) {
+                capture.viewCount = *viewCountOutput;
+            }
+
             if (XR_SUCCEEDED(result) && viewCapacityInput) {
                 if (viewConfigurationType == XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+                    const auto fovSettings = m_fovSettings.load();
+                    const FovSettings& settings = *fovSettings;
+                    // Without a composition framework, xrEndFrame() cannot upscale and the runtime values are kept.
+                    const bool isUpscalingSupported = m_upscalingFactor < 1.f && m_compositionFrameworkFactory &&
+                                                      m_compositionFrameworkFactory->isCompositionSupported();
+                    utils::telemetry::Update telemetry(m_telemetry.get());
+                    if (telemetry) {
+                        telemetry->nativePixelCount = telemetry->recommendedPixelCount = 0;
+                    }
                     for (uint32_t i = 0; i < *viewCountOutput; i++) {
-                        float sumTan = tan(m_cachedEyeFov[i].angleUp) + tan(m_cachedEyeFov[i].angleDown);
+                        const utils::telemetry::ImageSize nativeImageSize{views[i].recommendedImageRectWidth,
+                                                                          views[i].recommendedImageRectHeight};
+                        const XrFovf& cachedFov = settings.cachedEyeFov[std::min(i, 1u)];
+                        float sumTan = tan(cachedFov.angleUp) + tan(cachedFov.angleDown);
                         views[i].recommendedImageRectHeight =
-                            ((tan(m_cachedEyeFov[i].angleUp * fovUp) + tan(m_cachedEyeFov[i].angleDown * fovDown)) /
+                            ((tan(cachedFov.angleUp * settings.fovUp) + tan(cachedFov.angleDown * settings.fovDown)) /
                              sumTan) *
-                            views[i].recommendedImageRectHeight;                                                                   
+                            views[i].recommendedImageRectHeight;
+                        if (isUpscalingSupported) {
+                            // The cropped image is rendered at reduced resolution and upscaled in xrEndFrame().
+                            views[i].recommendedImageRectWidth =
+                                std::max((uint32_t)(views[i].recommendedImageRectWidth * m_upscalingFactor), 1u);
+                            views[i].recommendedImageRectHeight =
+                                std::max((uint32_t)(views[i].recommendedImageRectHeight * m_upscalingFactor), 1u);
+                        }
+
+                        if (m_capture && i < utils::capture::MaxViews) {
+                            capture.nativeImageSize[i] = nativeImageSize;
+                            capture.recommendedImageSize[i] = {views[i].recommendedImageRectWidth,
+                                                               views[i].recommendedImageRectHeight};
+                        }
+
+                        if (telemetry && i < 2) {
+                            telemetry->nativeImageSize[i] = nativeImageSize;
+                            telemetry->recommendedImageSize[i] = {views[i].recommendedImageRectWidth,
+                                                                  views[i].recommendedImageRectHeight};
+                            telemetry->nativePixelCount += (uint64_t)nativeImageSize.width * nativeImageSize.height;
+                            telemetry->recommendedPixelCount +=
+                                (uint64_t)views[i].recommendedImageRectWidth * views[i].recommendedImageRectHeight;
+                        }
                     }
                 }
             }
+
+            if (m_telemetry) {
+                const uint64_t duration = elapsedMicroseconds(callStart);
+                utils::telemetry::Update telemetry(m_telemetry.get());
+                if (telemetry) {
+                    utils::telemetry::recordLatency(telemetry->enumerateViewConfigurationViews, duration);
+                }
+            }
+
+            if (m_capture) {
+                m_capture->record(utils::capture::RecordType::EnumerateViewConfigurationViews,
+                                  result,
+                                  systemId,
+                                  callStart,
+                                  runtimeEnd,
+                                  capture);
+            }
+
             return result;
 
         }
@@ -87,33 +230,249 @@ namespace openxr_api_layer {
                                XrViewState* viewState,
                                uint32_t viewCapacityInput,
                                uint32_t* viewCountOutput,
-                               XrView* views) override {
+                               XrView* views) noexcept override {
+            const auto callStart = clock::now();
             XrResult result =
                 OpenXrApi::xrLocateViews(session, viewLocateInfo, viewState, viewCapacityInput, viewCountOutput, views);
-                
+            const auto runtimeEnd = clock::now();
+
+            utils::capture::LocateViewsPayload capture{};
+            capture.viewConfigurationType = viewLocateInfo->viewConfigurationType;
+            capture.displayTime = viewLocateInfo->displayTime;
+            if (XR_SUCCEEDED(result)) {
+                capture.viewCount = *viewCountOutput;
+            }
 
             if (XR_SUCCEEDED(result) && viewCapacityInput &&
                 viewLocateInfo->viewConfigurationType == XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+                // This is a hot path: only the first-frame discovery may throw.
+                try {
+                    const std::shared_ptr<SessionStatePublisher> sessionState = getSessionState(session);
+                    if (*viewCountOutput && !sessionState->load()->anglesWrittenToReg) {
+                        discoverSystemAngles(*sessionState, views);
+                    }
+                } catch (std::exception& exc) {
+                    ErrorLog(fmt::format("xrLocateViews: {}\n", exc.what()));
+                    return XR_ERROR_RUNTIME_FAILURE;
+                }
+
+                const auto fovSettings = m_fovSettings.load();
+                const FovSettings& settings = *fovSettings;
                 for (uint32_t i = 0; i < *viewCountOutput; i++) {
-                    if (!anglesWrittenToReg) {
-                        int systemAngleUp = abs(views[i].fov.angleUp * 180000.0f / DirectX::XM_PI);
-                        int systemAngleDown = abs(views[i].fov.angleDown * 180000.0f / DirectX::XM_PI);
-                        Log(fmt::format("system angle_up: {}\n", systemAngleUp));
-                        Log(fmt::format("system angle_down: {}\n", systemAngleDown));
-                        utils::general::setSetting("angle_up", systemAngleUp);
-                        utils::general::setSetting("angle_down", systemAngleDown);
-                        Log(fmt::format("written angle_up: {}\n",
-                                        utils::general::getSetting("angle_up").value_or(defaultFovAngle)));
-                        Log(fmt::format("written angle_down: {}\n",
-                                        utils::general::getSetting("angle_down").value_or(defaultFovAngle)));
-                        getFovAnglesSettings();
-                        anglesWrittenToReg = true;
+                    const XrFovf nativeFov = views[i].fov;
+                    views[i].fov.angleUp = views[i].fov.angleUp * settings.fovUp;
+                    views[i].fov.angleDown = views[i].fov.angleDown * settings.fovDown;
+
+                    if (m_capture && i < utils::capture::MaxViews) {
+                        capture.nativeFov[i] = toTelemetry(nativeFov);
+                        capture.customizedFov[i] = toTelemetry(views[i].fov);
+                    }
+
+                    if (m_telemetry && i < 2) {
+                        utils::telemetry::Update telemetry(m_telemetry.get());
+                        if (telemetry) {
+                            telemetry->nativeFov[i] = toTelemetry(nativeFov);
+                            telemetry->customizedFov[i] = toTelemetry(views[i].fov);
+                        }
                     }
-                    views[i].fov.angleUp = views[i].fov.angleUp * fovUp;
-                    views[i].fov.angleDown = views[i].fov.angleDown * fovDown;
                 }
             }
 
+            if (m_telemetry) {
+                const uint64_t duration = elapsedMicroseconds(callStart);
+                utils::telemetry::Update telemetry(m_telemetry.get());
+                if (telemetry) {
+                    utils::telemetry::recordLatency(telemetry->locateViews, duration);
+                }
+            }
+
+            if (m_capture) {
+                m_capture->record(
+                    utils::capture::RecordType::LocateViews, result, (uint64_t)session, callStart, runtimeEnd, capture);
+            }
+
+            return result;
+        }
+
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrCreateSwapchain
+        XrResult xrCreateSwapchain(XrSession session,
+                                   const XrSwapchainCreateInfo* createInfo,
+                                   XrSwapchain* swapchain) override {
+            const auto callStart = clock::now();
+            auto runtimeStart = callStart;
+            auto runtimeEnd = callStart;
+            const XrResult result = createSwapchain(session, createInfo, swapchain, runtimeStart, runtimeEnd);
+
+            if (m_capture) {
+                utils::capture::CreateSwapchainPayload capture{};
+                capture.swapchain = XR_SUCCEEDED(result) ? (uint64_t)*swapchain : 0;
+                capture.createFlags = createInfo->createFlags;
+                capture.usageFlags = createInfo->usageFlags;
+                capture.format = createInfo->format;
+                capture.sampleCount = createInfo->sampleCount;
+                capture.width = createInfo->width;
+                capture.height = createInfo->height;
+                capture.faceCount = createInfo->faceCount;
+                capture.arraySize = createInfo->arraySize;
+                capture.mipCount = createInfo->mipCount;
+                m_capture->record(utils::capture::RecordType::CreateSwapchain,
+                                  result,
+                                  (uint64_t)session,
+                                  callStart,
+                                  runtimeStart,
+                                  runtimeEnd,
+                                  capture);
+            }
+
+            return result;
+        }
+
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrDestroySwapchain
+        XrResult xrDestroySwapchain(XrSwapchain swapchain) override {
+            const auto callStart = clock::now();
+            auto runtimeStart = callStart;
+            auto runtimeEnd = callStart;
+            const XrResult result = destroySwapchain(swapchain, runtimeStart, runtimeEnd);
+
+            if (m_capture) {
+                m_capture->record(utils::capture::RecordType::DestroySwapchain,
+                                  result,
+                                  (uint64_t)swapchain,
+                                  callStart,
+                                  runtimeStart,
+                                  runtimeEnd,
+                                  utils::capture::DestroySwapchainPayload{});
+            }
+
+            return result;
+        }
+
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrAcquireSwapchainImage
+        XrResult xrAcquireSwapchainImage(XrSwapchain swapchain,
+                                         const XrSwapchainImageAcquireInfo* acquireInfo,
+                                         uint32_t* index) override {
+            const auto callStart = clock::now();
+            auto runtimeStart = callStart;
+            auto runtimeEnd = callStart;
+            const XrResult result = acquireSwapchainImage(swapchain, acquireInfo, index, runtimeStart, runtimeEnd);
+
+            if (m_capture) {
+                utils::capture::AcquireSwapchainImagePayload capture{};
+                capture.index = XR_SUCCEEDED(result) ? *index : 0;
+                m_capture->record(utils::capture::RecordType::AcquireSwapchainImage,
+                                  result,
+                                  (uint64_t)swapchain,
+                                  callStart,
+                                  runtimeStart,
+                                  runtimeEnd,
+                                  capture);
+            }
+
+            return result;
+        }
+
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrWaitSwapchainImage
+        XrResult xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo) override {
+            const auto callStart = clock::now();
+            auto runtimeStart = callStart;
+            auto runtimeEnd = callStart;
+            const XrResult result = waitSwapchainImage(swapchain, waitInfo, runtimeStart, runtimeEnd);
+
+            if (m_capture) {
+                utils::capture::WaitSwapchainImagePayload capture{};
+                capture.timeout = waitInfo->timeout;
+                m_capture->record(utils::capture::RecordType::WaitSwapchainImage,
+                                  result,
+                                  (uint64_t)swapchain,
+                                  callStart,
+                                  runtimeStart,
+                                  runtimeEnd,
+                                  capture);
+            }
+
+            return result;
+        }
+
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrReleaseSwapchainImage
+        XrResult xrReleaseSwapchainImage(XrSwapchain swapchain,
+                                         const XrSwapchainImageReleaseInfo* releaseInfo) override {
+            const auto callStart = clock::now();
+            auto runtimeStart = callStart;
+            auto runtimeEnd = callStart;
+            const XrResult result = releaseSwapchainImage(swapchain, releaseInfo, runtimeStart, runtimeEnd);
+
+            if (m_capture) {
+                m_capture->record(utils::capture::RecordType::ReleaseSwapchainImage,
+                                  result,
+                                  (uint64_t)swapchain,
+                                  callStart,
+                                  runtimeStart,
+                                  runtimeEnd,
+                                  utils::capture::ReleaseSwapchainImagePayload{});
+            }
+
+            return result;
+        }
+
+        XrResult xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) noexcept override {
+            const auto callStart = clock::now();
+            // The part of the call spent in the runtime, excluding the resampling.
+            auto runtimeStart = callStart;
+            auto runtimeEnd = callStart;
+            XrResult result;
+            utils::graphics::ICompositionFramework* const compositionFramework =
+                m_compositionFrameworkFactory ? m_compositionFrameworkFactory->getCompositionFramework(session)
+                                              : nullptr;
+            if (compositionFramework) {
+                try {
+                    result = resampleAndEndFrame(*compositionFramework, frameEndInfo, runtimeStart, runtimeEnd);
+                } catch (std::exception& exc) {
+                    ErrorLog(fmt::format("xrEndFrame: {}\n", exc.what()));
+                    result = XR_ERROR_RUNTIME_FAILURE;
+                }
+            } else {
+                result = OpenXrApi::xrEndFrame(session, frameEndInfo);
+                runtimeEnd = clock::now();
+            }
+            const auto callEnd = clock::now();
+
+            if (m_telemetry) {
+                utils::telemetry::Update telemetry(m_telemetry.get());
+                if (telemetry) {
+                    utils::telemetry::recordLatency(telemetry->endFrame, elapsedMicroseconds(callStart, callEnd));
+
+                    if (m_lastEndFrameTime.has_value()) {
+                        const uint64_t interval = elapsedMicroseconds(m_lastEndFrameTime.value(), callStart);
+                        telemetry->lastFrameIntervalUs = interval;
+                        telemetry->minFrameIntervalUs = telemetry->minFrameIntervalUs
+                                                            ? std::min(telemetry->minFrameIntervalUs, interval)
+                                                            : interval;
+                        telemetry->maxFrameIntervalUs = std::max(telemetry->maxFrameIntervalUs, interval);
+                        // Exponential moving average over roughly the last second of frames.
+                        telemetry->averageFrameIntervalUs =
+                            telemetry->averageFrameIntervalUs
+                                ? (telemetry->averageFrameIntervalUs * 63 + interval) / 64
+                                : interval;
+                    }
+                    telemetry->frameCount++;
+                    m_lastEndFrameTime = callStart;
+                }
+            }
+
+            if (m_capture) {
+                utils::capture::EndFramePayload capture{};
+                capture.displayTime = frameEndInfo->displayTime;
+                capture.layerCount = frameEndInfo->layerCount;
+                capture.environmentBlendMode = frameEndInfo->environmentBlendMode;
+                m_capture->record(utils::capture::RecordType::EndFrame,
+                                  result,
+                                  (uint64_t)session,
+                                  callStart,
+                                  runtimeStart,
+                                  runtimeEnd,
+                                  capture);
+            }
+
             return result;
         }
 
@@ -129,6 +488,9 @@ namespace openxr_api_layer {
 
             XrResult result = m_bypassApiLayer ? m_xrGetInstanceProcAddr(instance, name, function)
                                                : OpenXrApi::xrGetInstanceProcAddr(instance, name, function);
+            if (XR_SUCCEEDED(result) && m_compositionFrameworkFactory) {
+                m_compositionFrameworkFactory->xrGetInstanceProcAddr_post(instance, name, function);
+            }
 
             TraceLoggingWrite(g_traceProvider, "xrGetInstanceProcAddr", TLPArg(*function, "Function"));
 
@@ -182,30 +544,93 @@ namespace openxr_api_layer {
             TraceLoggingWrite(g_traceProvider, "xrCreateInstance", TLArg(runtimeName.c_str(), "RuntimeName"));
             Log(fmt::format("Using OpenXR runtime: {}\n", runtimeName));
 
-            getFovAnglesSettings();
-
             if (!utils::general::getSetting("fov_up").has_value()) {
                 utils::general::setSetting("fov_up", 1000);
             }
             if (!utils::general::getSetting("fov_down").has_value()) {
                 utils::general::setSetting("fov_down", 1000);
             }
-            fovUp = utils::general::getSetting("fov_up").value_or(1000) / 1e3f;
-            fovDown = utils::general::getSetting("fov_down").value_or(1000) / 1e3f;
-            
+
+            FovSettings settings;
+            getFovAnglesSettings(settings);
+            settings.fovUp = utils::general::getSetting("fov_up").value_or(1000) / 1e3f;
+            settings.fovDown = utils::general::getSetting("fov_down").value_or(1000) / 1e3f;
+            m_fovSettings.publish(settings);
+
             Log(fmt::format("angle_up: {}\n", utils::general::getSetting("angle_up").value_or(defaultFovAngle)));
             Log(fmt::format("angle_down: {}\n", utils::general::getSetting("angle_down").value_or(defaultFovAngle)));
-            Log(fmt::format("fov_up: {}\n", fovUp));
-            Log(fmt::format("fov_down: {}\n", fovDown));
+            Log(fmt::format("fov_up: {}\n", settings.fovUp));
+            Log(fmt::format("fov_down: {}\n", settings.fovDown));
+
+            // Upscaling is a factor per thousand of the cropped resolution, 1000 disables it.
+            m_upscalingFactor = std::clamp(utils::general::getSetting("upscaling").value_or(1000), 250, 1000) / 1e3f;
+            m_upscalingFilter = (utils::graphics::ScalingFilter)std::clamp(
+                utils::general::getSetting("upscaling_filter").value_or((int)utils::graphics::ScalingFilter::Lanczos),
+                (int)utils::graphics::ScalingFilter::Bilinear,
+                (int)utils::graphics::ScalingFilter::EdgeAdaptive);
+            // Padding submits the native FOV, with a black (1) or edge-clamped (2) border around the cropped image.
+            m_paddingMode = (PaddingMode)std::clamp(utils::general::getSetting("padding").value_or(0),
+                                                    (int)PaddingMode::None,
+                                                    (int)PaddingMode::EdgeClamped);
+            // Frame capture writes the views submitted by the application to PNG (0) or QOI (1) files upon request.
+            if (utils::general::getSetting("frame_capture").value_or(0)) {
+                const auto format = (utils::screenshot::FileFormat)std::clamp(
+                    utils::general::getSetting("frame_capture_format").value_or(0),
+                    (int)utils::screenshot::FileFormat::PNG,
+                    (int)utils::screenshot::FileFormat::QOI);
+                // Converting the captures in parallel is only worth it for the high bit depth formats.
+                const int threads = utils::general::getSetting("frame_capture_threads").value_or(0);
+                m_frameCapture = std::make_unique<utils::screenshot::Writer>(
+                    format, threads > 0 ? utils::executor::createExecutor(threads) : nullptr);
+                Log(fmt::format("frame_capture: {} (format {})\n", localAppData.string(), (int)format));
+            }
+            if (m_upscalingFactor < 1.f || m_paddingMode != PaddingMode::None || m_frameCapture) {
+                Log(fmt::format("upscaling: {} (filter {})\n", m_upscalingFactor, (int)m_upscalingFilter));
+                Log(fmt::format("padding: {}\n", (int)m_paddingMode));
+                // Composing on a Direct3D 11 application's own device avoids the bounce buffers and the fences.
+                const bool shareApplicationDevice = utils::general::getSetting("composition_share_device").value_or(0);
+                Log(fmt::format("composition_share_device: {}\n", shareApplicationDevice));
+                // The composition and the submission to the runtime overlap with the application's next frame.
+                m_useCompositionWorker = utils::general::getSetting("composition_worker").value_or(0);
+                Log(fmt::format("composition_worker: {}\n", m_useCompositionWorker));
+                m_compositionFrameworkFactory =
+                    utils::graphics::createCompositionFrameworkFactory(*createInfo,
+                                                                       GetXrInstance(),
+                                                                       m_xrGetInstanceProcAddr,
+                                                                       utils::graphics::CompositionApi::Automatic,
+                                                                       shareApplicationDevice);
+            }
+
+            if (utils::general::getSetting("telemetry").value_or(1)) {
+                m_telemetry = std::make_unique<utils::telemetry::Writer>(GetApplicationName());
+            }
+
+            if (utils::general::getSetting("capture").value_or(0)) {
+                utils::capture::FileHeader header{};
+                strncpy_s(header.applicationName, GetApplicationName().c_str(), _TRUNCATE);
+                strncpy_s(header.runtimeName, instanceProperties.runtimeName, _TRUNCATE);
+                header.runtimeVersion = instanceProperties.runtimeVersion;
+                header.fovUpSetting = utils::general::getSetting("fov_up").value_or(1000);
+                header.fovDownSetting = utils::general::getSetting("fov_down").value_or(1000);
+                header.angleUpSetting = utils::general::getSetting("angle_up").value_or(defaultFovAngle);
+                header.angleDownSetting = utils::general::getSetting("angle_down").value_or(defaultFovAngle);
+                header.upscalingSetting = (int32_t)std::lround(m_upscalingFactor * 1e3f);
+                header.paddingSetting = (int32_t)m_paddingMode;
+
+                const auto path =
+                    localAppData / fmt::format("{}-{}.capture", GetApplicationName(), GetCurrentProcessId());
+                const uint64_t capacity = (uint64_t)utils::general::getSetting("capture_size_mb").value_or(64) << 20;
+                m_capture = std::make_unique<utils::capture::Writer>(path.string(), capacity, header);
+            }
 
             return XR_SUCCESS;
         }
 
-        void getFovAnglesSettings() {
-            m_cachedEyeFov[0].angleUp = m_cachedEyeFov[1].angleUp =
-                DirectX::XM_PI * utils::general::getSetting("angle_up").value_or(defaultFovAngle) / 180000.0f;
-            m_cachedEyeFov[0].angleDown = m_cachedEyeFov[1].angleDown =
-                DirectX::XM_PI * utils::general::getSetting("angle_down").value_or(defaultFovAngle) / 180000.0f;
+        void getFovAnglesSettings(FovSettings& settings) const {
+            settings.cachedEyeFov[0].angleUp = settings.cachedEyeFov[1].angleUp =
+                angleSettingToRadians(utils::general::getSetting("angle_up").value_or(defaultFovAngle));
+            settings.cachedEyeFov[0].angleDown = settings.cachedEyeFov[1].angleDown =
+                angleSettingToRadians(utils::general::getSetting("angle_down").value_or(defaultFovAngle));
         }
 
         // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrGetSystem
@@ -219,7 +644,9 @@ namespace openxr_api_layer {
                               TLXArg(instance, "Instance"),
                               TLArg(xr::ToCString(getInfo->formFactor), "FormFactor"));
 
+            const auto callStart = clock::now();
             const XrResult result = OpenXrApi::xrGetSystem(instance, getInfo, systemId);
+            const auto runtimeEnd = clock::now();
             if (XR_SUCCEEDED(result) && getInfo->formFactor == XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) {
                 if (*systemId != m_systemId) {
                     XrSystemProperties systemProperties{XR_TYPE_SYSTEM_PROPERTIES};
@@ -234,6 +661,17 @@ namespace openxr_api_layer {
 
             TraceLoggingWrite(g_traceProvider, "xrGetSystem", TLArg((int)*systemId, "SystemId"));
 
+            if (m_capture) {
+                utils::capture::GetSystemPayload capture{};
+                capture.formFactor = getInfo->formFactor;
+                m_capture->record(utils::capture::RecordType::GetSystem,
+                                  result,
+                                  XR_SUCCEEDED(result) ? *systemId : XR_NULL_SYSTEM_ID,
+                                  callStart,
+                                  runtimeEnd,
+                                  capture);
+            }
+
             return result;
         }
 
@@ -251,15 +689,66 @@ namespace openxr_api_layer {
                               TLArg((int)createInfo->systemId, "SystemId"),
                               TLArg(createInfo->createFlags, "CreateFlags"));
 
+            const auto callStart = clock::now();
             const XrResult result = OpenXrApi::xrCreateSession(instance, createInfo, session);
+            const auto runtimeEnd = clock::now();
             if (XR_SUCCEEDED(result)) {
                 if (isSystemHandled(createInfo->systemId)) {
-                    // Do something useful here...
+                    getSessionState(*session);
                 }
 
                 TraceLoggingWrite(g_traceProvider, "xrCreateSession", TLXArg(*session, "Session"));
             }
 
+            if (m_capture) {
+                utils::capture::CreateSessionPayload capture{};
+                capture.systemId = createInfo->systemId;
+                m_capture->record(utils::capture::RecordType::CreateSession,
+                                  result,
+                                  XR_SUCCEEDED(result) ? (uint64_t)*session : 0,
+                                  callStart,
+                                  runtimeEnd,
+                                  capture);
+            }
+
+            return result;
+        }
+
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrDestroySession
+        XrResult xrDestroySession(XrSession session) override {
+            TraceLoggingWrite(g_traceProvider, "xrDestroySession", TLXArg(session, "Session"));
+
+            const auto callStart = clock::now();
+            const XrResult result = OpenXrApi::xrDestroySession(session);
+            const auto runtimeEnd = clock::now();
+            if (XR_SUCCEEDED(result)) {
+                m_sessions.update([session](SessionTable& sessions) {
+                    const auto it = std::find_if(sessions.begin(), sessions.end(), [session](const auto& entry) {
+                        return entry.first == session;
+                    });
+                    if (it == sessions.end()) {
+                        return false;
+                    }
+                    sessions.erase(it);
+                    return true;
+                });
+
+                // The resampled swapchains were destroyed with the composition framework.
+                std::unique_lock lock(m_resampledSwapchainsMutex);
+                for (auto it = m_resampledSwapchains.begin(); it != m_resampledSwapchains.end();) {
+                    it = it->second.first == session ? m_resampledSwapchains.erase(it) : std::next(it);
+                }
+            }
+
+            if (m_capture) {
+                m_capture->record(utils::capture::RecordType::DestroySession,
+                                  result,
+                                  (uint64_t)session,
+                                  callStart,
+                                  runtimeEnd,
+                                  utils::capture::DestroySessionPayload{});
+            }
+
             return result;
         }
 
@@ -268,8 +757,754 @@ namespace openxr_api_layer {
             return systemId == m_systemId;
         }
 
+        // The swapchain entry points, without the capture. The runtime calls made through the composition framework
+        // are counted as the layer's own time.
+        XrResult createSwapchain(XrSession session,
+                                 const XrSwapchainCreateInfo* createInfo,
+                                 XrSwapchain* swapchain,
+                                 clock::time_point& runtimeStart,
+                                 clock::time_point& runtimeEnd) {
+            if (createInfo->type != XR_TYPE_SWAPCHAIN_CREATE_INFO) {
+                return XR_ERROR_VALIDATION_FAILURE;
+            }
+
+            utils::graphics::ICompositionFramework* const compositionFramework =
+                m_compositionFrameworkFactory ? m_compositionFrameworkFactory->getCompositionFramework(session)
+                                              : nullptr;
+            // Without a composition device, the swapchains are not resampled and the application's views are submitted.
+            if (!compositionFramework || !isResamplable(*createInfo) ||
+                !compositionFramework->isCompositionDeviceAvailable()) {
+                runtimeStart = clock::now();
+                const XrResult result = OpenXrApi::xrCreateSwapchain(session, createInfo, swapchain);
+                runtimeEnd = clock::now();
+                return result;
+            }
+
+            TraceLoggingWrite(g_traceProvider,
+                              "xrCreateSwapchain",
+                              TLXArg(session, "Session"),
+                              TLArg(createInfo->width, "Width"),
+                              TLArg(createInfo->height, "Height"),
+                              TLArg(createInfo->arraySize, "ArraySize"),
+                              TLArg(createInfo->format, "Format"),
+                              TLArg(createInfo->usageFlags, "UsageFlags"),
+                              TLArg(true, "Resampled"));
+
+            // The composition device may be in use by the worker.
+            compositionFramework->waitForComposition();
+
+            // The images are sampled by the upscaling and padding passes, or blitted from on Vulkan.
+            XrSwapchainCreateInfo info = *createInfo;
+            info.usageFlags |= XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT;
+            std::shared_ptr<utils::graphics::ISwapchain> applicationSwapchain = compositionFramework->createSwapchain(
+                info, utils::graphics::SwapchainMode::Submit | utils::graphics::SwapchainMode::Read);
+            *swapchain = applicationSwapchain->getSwapchainHandle();
+
+            std::unique_lock lock(m_resampledSwapchainsMutex);
+            ResamplingSessionData* sessionData = compositionFramework->getSessionData<ResamplingSessionData>();
+            if (!sessionData) {
+                compositionFramework->setSessionData(std::make_unique<ResamplingSessionData>());
+                sessionData = compositionFramework->getSessionData<ResamplingSessionData>();
+
+                if (m_useCompositionWorker) {
+                    try {
+                        compositionFramework->enableCompositionWorker();
+                    } catch (std::exception& exc) {
+                        Log(fmt::format("Composition worker is disabled: {}\n", exc.what()));
+                    }
+                }
+            }
+            m_resampledSwapchains.insert_or_assign(*swapchain, std::make_pair(session, applicationSwapchain));
+            {
+                std::unique_lock sessionLock(sessionData->mutex);
+                sessionData->swapchains.insert_or_assign(*swapchain,
+                                                         ResampledSwapchain{std::move(applicationSwapchain), {}});
+            }
+
+            TraceLoggingWrite(g_traceProvider, "xrCreateSwapchain", TLXArg(*swapchain, "Swapchain"));
+
+            return XR_SUCCESS;
+        }
+
+        XrResult destroySwapchain(XrSwapchain swapchain,
+                                  clock::time_point& runtimeStart,
+                                  clock::time_point& runtimeEnd) {
+            XrSession session = XR_NULL_HANDLE;
+            {
+                std::unique_lock lock(m_resampledSwapchainsMutex);
+                auto it = m_resampledSwapchains.find(swapchain);
+                if (it != m_resampledSwapchains.end()) {
+                    session = it->second.first;
+                    m_resampledSwapchains.erase(it);
+                }
+            }
+
+            utils::graphics::ICompositionFramework* const compositionFramework =
+                session != XR_NULL_HANDLE ? m_compositionFrameworkFactory->getCompositionFramework(session) : nullptr;
+            if (!compositionFramework) {
+                runtimeStart = clock::now();
+                const XrResult result = OpenXrApi::xrDestroySwapchain(swapchain);
+                runtimeEnd = clock::now();
+                return result;
+            }
+
+            TraceLoggingWrite(g_traceProvider, "xrDestroySwapchain", TLXArg(swapchain, "Swapchain"));
+
+            // The compositions queued on the worker may still use the swapchain.
+            compositionFramework->waitForComposition();
+
+            // Destroying the wrappers destroys both swapchains.
+            ResamplingSessionData* const sessionData = compositionFramework->getSessionData<ResamplingSessionData>();
+            std::unique_lock lock(sessionData->mutex);
+            sessionData->swapchains.erase(swapchain);
+
+            return XR_SUCCESS;
+        }
+
+        XrResult acquireSwapchainImage(XrSwapchain swapchain,
+                                       const XrSwapchainImageAcquireInfo* acquireInfo,
+                                       uint32_t* index,
+                                       clock::time_point& runtimeStart,
+                                       clock::time_point& runtimeEnd) {
+            const std::shared_ptr<utils::graphics::ISwapchain> resampledSwapchain = getResampledSwapchain(swapchain);
+            if (!resampledSwapchain) {
+                runtimeStart = clock::now();
+                const XrResult result = OpenXrApi::xrAcquireSwapchainImage(swapchain, acquireInfo, index);
+                runtimeEnd = clock::now();
+                return result;
+            }
+
+            *index = resampledSwapchain->acquireImage(false /* wait */)->getIndex();
+
+            return XR_SUCCESS;
+        }
+
+        XrResult waitSwapchainImage(XrSwapchain swapchain,
+                                    const XrSwapchainImageWaitInfo* waitInfo,
+                                    clock::time_point& runtimeStart,
+                                    clock::time_point& runtimeEnd) {
+            const std::shared_ptr<utils::graphics::ISwapchain> resampledSwapchain = getResampledSwapchain(swapchain);
+            if (!resampledSwapchain) {
+                runtimeStart = clock::now();
+                const XrResult result = OpenXrApi::xrWaitSwapchainImage(swapchain, waitInfo);
+                runtimeEnd = clock::now();
+                return result;
+            }
+
+            // The runtime's XR_TIMEOUT_EXPIRED is returned to the application, which may wait again.
+            return resampledSwapchain->waitImage(waitInfo->timeout);
+        }
+
+        XrResult releaseSwapchainImage(XrSwapchain swapchain,
+                                       const XrSwapchainImageReleaseInfo* releaseInfo,
+                                       clock::time_point& runtimeStart,
+                                       clock::time_point& runtimeEnd) {
+            const std::shared_ptr<utils::graphics::ISwapchain> resampledSwapchain = getResampledSwapchain(swapchain);
+            if (!resampledSwapchain) {
+                runtimeStart = clock::now();
+                const XrResult result = OpenXrApi::xrReleaseSwapchainImage(swapchain, releaseInfo);
+                runtimeEnd = clock::now();
+                return result;
+            }
+
+            // The image is handed back to the runtime in xrEndFrame(), after resampling.
+            resampledSwapchain->releaseImage();
+
+            return XR_SUCCESS;
+        }
+
+        // Only plain color swapchains can be resampled.
+        static bool isResamplable(const XrSwapchainCreateInfo& info) {
+            return (info.usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT) &&
+                   !(info.usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) &&
+                   !(info.createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) && info.sampleCount == 1 &&
+                   info.faceCount == 1;
+        }
+
+        // The compositions queued on the worker commit the images of the swapchain: they are completed first.
+        std::shared_ptr<utils::graphics::ISwapchain> getResampledSwapchain(XrSwapchain swapchain) const {
+            XrSession session = XR_NULL_HANDLE;
+            std::shared_ptr<utils::graphics::ISwapchain> resampledSwapchain;
+            {
+                std::unique_lock lock(m_resampledSwapchainsMutex);
+                auto it = m_resampledSwapchains.find(swapchain);
+                if (it == m_resampledSwapchains.end()) {
+                    return nullptr;
+                }
+                session = it->second.first;
+                resampledSwapchain = it->second.second.lock();
+            }
+
+            utils::graphics::ICompositionFramework* const compositionFramework =
+                m_compositionFrameworkFactory->getCompositionFramework(session);
+            if (compositionFramework) {
+                compositionFramework->waitForComposition();
+            }
+
+            return resampledSwapchain;
+        }
+
+        // Upscale and/or pad the projection views rendered into the application's swapchains and submit the resampled
+        // swapchains in their place. Depth information is dropped from the resampled views since it does not match the
+        // new resolution and FOV. runtimeStart and runtimeEnd bracket the call to the runtime, for the capture.
+        // With the composition worker, the frame is copied and composed on the worker thread, and the failures are
+        // reported with the next frame.
+        XrResult resampleAndEndFrame(utils::graphics::ICompositionFramework& compositionFramework,
+                                     const XrFrameEndInfo* frameEndInfo,
+                                     clock::time_point& runtimeStart,
+                                     clock::time_point& runtimeEnd) {
+            ResamplingSessionData* const sessionData = compositionFramework.getSessionData<ResamplingSessionData>();
+            if (!sessionData) {
+                runtimeStart = clock::now();
+                const XrResult result = OpenXrApi::xrEndFrame(compositionFramework.getSessionHandle(), frameEndInfo);
+                runtimeEnd = clock::now();
+                return result;
+            }
+
+            // The previous frame must be submitted before the swapchains are updated.
+            compositionFramework.waitForComposition();
+
+            std::unique_lock lock(sessionData->mutex);
+
+            compositionFramework.serializePreComposition();
+
+            const auto fovSettings = m_fovSettings.load();
+            const FovSettings& settings = *fovSettings;
+            const bool isPadding = m_paddingMode != PaddingMode::None;
+            // The swapchains are only wrapped for frame capture otherwise, and the application's images are submitted.
+            const bool isResampling = m_upscalingFactor < 1.f || isPadding;
+            const uint64_t frameIndex = sessionData->frameIndex++;
+
+            // Only copy the submitted regions of the application's images when they are not shareable.
+            std::unordered_map<ResampledSwapchain*, std::vector<XrSwapchainSubImage>> submittedSubImages;
+            std::unordered_map<ResampledSwapchain*, float> paddingRatios;
+            for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
+                if (frameEndInfo->layers[i]->type != XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+                    continue;
+                }
+                const XrCompositionLayerProjection* const projection =
+                    reinterpret_cast<const XrCompositionLayerProjection*>(frameEndInfo->layers[i]);
+                for (uint32_t viewIndex = 0; viewIndex < projection->viewCount; viewIndex++) {
+                    const XrCompositionLayerProjectionView& view = projection->views[viewIndex];
+                    auto it = sessionData->swapchains.find(view.subImage.swapchain);
+                    if (it != sessionData->swapchains.end()) {
+                        submittedSubImages[&it->second].push_back(view.subImage);
+                        if (isPadding) {
+                            const XrFovf nativeFov =
+                                utils::placement::getNativeFov(view.fov, settings.fovUp, settings.fovDown);
+                            float& ratio = paddingRatios.insert({&it->second, 1.f}).first->second;
+                            ratio = std::max(ratio, utils::placement::getPaddingRatio(view.fov, nativeFov));
+                        }
+                    }
+                }
+            }
+
+            SwapchainImages sourceImages;
+            for (auto& [swapchain, subImages] : submittedSubImages) {
+                swapchain->application->setSubmittedSubImages(subImages);
+                utils::graphics::ISwapchainImage* const image = swapchain->application->getLastReleasedImage();
+                if (!image) {
+                    continue;
+                }
+                sourceImages.insert_or_assign(swapchain, image);
+
+                if (isResampling && !swapchain->submitted) {
+                    // The padding ratio is set for the lifetime of the swapchain, from the FOV of its first submission.
+                    auto ratioIt = paddingRatios.find(swapchain);
+                    swapchain->paddingRatio = ratioIt != paddingRatios.end() ? ratioIt->second : 1.f;
+
+                    XrSwapchainCreateInfo info = swapchain->application->getInfoOnCompositionDevice();
+                    info.next = nullptr;
+                    info.createFlags = 0;
+                    info.format = swapchain->application->getFormatOnApplicationDevice();
+                    const XrExtent2Di size = utils::placement::getSubmittedSize(
+                        {(int32_t)info.width, (int32_t)info.height}, m_upscalingFactor, swapchain->paddingRatio);
+                    info.width = (uint32_t)size.width;
+                    info.height = (uint32_t)size.height;
+                    info.mipCount = 1;
+                    // Vulkan composition blits and clears as transfers.
+                    info.usageFlags = XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT |
+                                      XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+                    swapchain->submitted = compositionFramework.createSwapchain(
+                        info, utils::graphics::SwapchainMode::Submit | utils::graphics::SwapchainMode::Write);
+                }
+            }
+
+            if (compositionFramework.isCompositionWorkerEnabled()) {
+                std::shared_ptr<FrameCopy> frame = copyFrame(*frameEndInfo, *sessionData, sourceImages, isResampling);
+                if (frame) {
+                    lock.unlock();
+                    return compositionFramework.queueComposition(
+                        [this, &compositionFramework, sessionData, frame, sourceImages, frameIndex, settings] {
+                            std::unique_lock sessionLock(sessionData->mutex);
+                            clock::time_point runtimeStart, runtimeEnd;
+                            return composeAndEndFrame(compositionFramework,
+                                                      sessionData,
+                                                      &frame->frameEndInfo,
+                                                      sourceImages,
+                                                      frameIndex,
+                                                      settings,
+                                                      runtimeStart,
+                                                      runtimeEnd);
+                        });
+                }
+            }
+
+            return composeAndEndFrame(compositionFramework,
+                                      sessionData,
+                                      frameEndInfo,
+                                      sourceImages,
+                                      frameIndex,
+                                      settings,
+                                      runtimeStart,
+                                      runtimeEnd);
+        }
+
+        // Copy the frame for the worker thread. Returns nullptr when the frame has structures that cannot be copied, in
+        // which case the frame is composed immediately.
+        static std::shared_ptr<FrameCopy> copyFrame(const XrFrameEndInfo& frameEndInfo,
+                                                    ResamplingSessionData& sessionData,
+                                                    const SwapchainImages& sourceImages,
+                                                    bool isResampling) {
+            if (frameEndInfo.next) {
+                return nullptr;
+            }
+
+            auto frame = std::make_shared<FrameCopy>();
+            frame->frameEndInfo = frameEndInfo;
+            for (uint32_t i = 0; i < frameEndInfo.layerCount; i++) {
+                const XrCompositionLayerBaseHeader* const layer = frameEndInfo.layers[i];
+                if (layer->next) {
+                    return nullptr;
+                }
+
+                if (layer->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+                    const XrCompositionLayerProjection* const projection =
+                        reinterpret_cast<const XrCompositionLayerProjection*>(layer);
+                    std::vector<XrCompositionLayerProjectionView>& views = frame->projectionViews.emplace_back(
+                        projection->views, projection->views + projection->viewCount);
+                    for (XrCompositionLayerProjectionView& view : views) {
+                        if (!view.next) {
+                            continue;
+                        }
+                        // The chained structures (eg: depth) are only dropped from the resampled views.
+                        auto it = sessionData.swapchains.find(view.subImage.swapchain);
+                        if (!isResampling || it == sessionData.swapchains.end() ||
+                            sourceImages.find(&it->second) == sourceImages.end()) {
+                            return nullptr;
+                        }
+                        view.next = nullptr;
+                    }
+                    XrCompositionLayerProjection& copy = frame->projections.emplace_back(*projection);
+                    copy.views = views.data();
+                    frame->layers.push_back(reinterpret_cast<const XrCompositionLayerBaseHeader*>(&copy));
+                } else if (layer->type == XR_TYPE_COMPOSITION_LAYER_QUAD) {
+                    frame->quads.push_back(*reinterpret_cast<const XrCompositionLayerQuad*>(layer));
+                    frame->layers.push_back(
+                        reinterpret_cast<const XrCompositionLayerBaseHeader*>(&frame->quads.back()));
+                } else {
+                    return nullptr;
+                }
+            }
+            frame->frameEndInfo.layers = frame->layers.data();
+
+            return frame;
+        }
+
+        // The composition and submission of a frame, once the source images are known. Called with the lock of the
+        // session data held.
+        XrResult composeAndEndFrame(utils::graphics::ICompositionFramework& compositionFramework,
+                                    ResamplingSessionData* sessionData,
+                                    const XrFrameEndInfo* frameEndInfo,
+                                    const SwapchainImages& sourceImages,
+                                    uint64_t frameIndex,
+                                    const FovSettings& settings,
+                                    clock::time_point& runtimeStart,
+                                    clock::time_point& runtimeEnd) {
+            const XrSession session = compositionFramework.getSessionHandle();
+            const bool isPadding = m_paddingMode != PaddingMode::None;
+            const bool isResampling = m_upscalingFactor < 1.f || isPadding;
+
+            // Copies of the application's layers, with the resampled views. Reserved so that pointers remain stable.
+            std::vector<const XrCompositionLayerBaseHeader*> layers(frameEndInfo->layers,
+                                                                    frameEndInfo->layers + frameEndInfo->layerCount);
+            std::vector<XrCompositionLayerProjection> projections;
+            std::vector<std::vector<XrCompositionLayerProjectionView>> projectionViews;
+            projections.reserve(frameEndInfo->layerCount);
+            projectionViews.reserve(frameEndInfo->layerCount);
+
+            utils::graphics::IGraphicsDevice* const compositionDevice = compositionFramework.getCompositionDevice();
+            if (m_frameCapture && !sourceImages.empty() && isFrameCaptureRequested(*sessionData)) {
+                captureFrame(*compositionDevice, *frameEndInfo, *sessionData, sourceImages, frameIndex);
+            }
+
+            utils::graphics::IGraphicsTimerPool* const timerPool =
+                isResampling && !sourceImages.empty() ? getCompositionTimerPool(*sessionData, *compositionDevice)
+                                                      : nullptr;
+            if (timerPool) {
+                timerPool->start(frameIndex);
+            }
+
+            SwapchainImages destinationImages;
+            for (uint32_t i = 0; i < frameEndInfo->layerCount && isResampling && !sourceImages.empty(); i++) {
+                if (layers[i]->type != XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+                    continue;
+                }
+                const XrCompositionLayerProjection* const projection =
+                    reinterpret_cast<const XrCompositionLayerProjection*>(layers[i]);
+                std::vector<XrCompositionLayerProjectionView> views(projection->views,
+                                                                    projection->views + projection->viewCount);
+                for (XrCompositionLayerProjectionView& view : views) {
+                    auto swapchainIt = sessionData->swapchains.find(view.subImage.swapchain);
+                    if (swapchainIt == sessionData->swapchains.end()) {
+                        continue;
+                    }
+                    ResampledSwapchain* const swapchain = &swapchainIt->second;
+                    auto sourceIt = sourceImages.find(swapchain);
+                    if (sourceIt == sourceImages.end()) {
+                        continue;
+                    }
+
+                    const XrSwapchainCreateInfo& sourceInfo = swapchain->application->getInfoOnCompositionDevice();
+                    const XrSwapchainCreateInfo& destinationInfo =
+                        swapchain->submitted->getInfoOnCompositionDevice();
+
+                    auto destinationIt = destinationImages.find(swapchain);
+                    if (destinationIt == destinationImages.end()) {
+                        destinationIt =
+                            destinationImages.insert({swapchain, swapchain->submitted->acquireImage()}).first;
+                        const uint32_t index = destinationIt->second->getIndex();
+                        if (m_paddingMode == PaddingMode::Black) {
+                            if (swapchain->clearedImages.size() <= index) {
+                                swapchain->clearedImages.resize(index + 1);
+                            }
+                            if (!swapchain->clearedImages[index]) {
+                                for (uint32_t slice = 0; slice < destinationInfo.arraySize; slice++) {
+                                    compositionDevice->clearTexture(destinationIt->second->getTextureForWrite(),
+                                                                    slice,
+                                                                    destinationInfo.format,
+                                                                    XrColor4f{0.f, 0.f, 0.f, 1.f});
+                                }
+                                swapchain->clearedImages[index] = true;
+                            }
+                        }
+                    }
+
+                    const int32_t upscaledHeight =
+                        (int32_t)std::lround(view.subImage.imageRect.extent.height / m_upscalingFactor);
+                    const XrFovf nativeFov =
+                        utils::placement::getNativeFov(view.fov, settings.fovUp, settings.fovDown);
+                    auto [topPadding, bottomPadding] =
+                        isPadding ? utils::placement::getPadding(view.fov, nativeFov, upscaledHeight)
+                                  : std::make_pair(0, 0);
+                    const XrExtent2Di destinationSize{(int32_t)destinationInfo.width,
+                                                      (int32_t)destinationInfo.height};
+                    const XrRect2Di destinationRect = utils::placement::getUpscaledRect(view.subImage.imageRect,
+                                                                                        m_upscalingFactor,
+                                                                                        swapchain->paddingRatio,
+                                                                                        destinationSize,
+                                                                                        topPadding);
+                    // The borders may be cut short by the edges of the image.
+                    topPadding = std::min(topPadding, destinationRect.offset.y);
+                    bottomPadding =
+                        std::min(bottomPadding,
+                                 (int32_t)destinationInfo.height -
+                                     (destinationRect.offset.y + destinationRect.extent.height));
+
+                    utils::graphics::IGraphicsTexture* const source = sourceIt->second->getTextureForRead();
+                    utils::graphics::IGraphicsTexture* const destination = destinationIt->second->getTextureForWrite();
+                    const XrRect2Di& sourceRect = view.subImage.imageRect;
+                    const uint32_t slice = view.subImage.imageArrayIndex;
+                    if (m_upscalingFactor < 1.f) {
+                        compositionDevice->scaleTextureRegion(source,
+                                                              sourceRect,
+                                                              slice,
+                                                              sourceInfo.format,
+                                                              destination,
+                                                              destinationRect,
+                                                              slice,
+                                                              destinationInfo.format,
+                                                              m_upscalingFilter);
+                    } else {
+                        compositionDevice->copyTextureRegion(source,
+                                                             {sourceRect.offset, destinationRect.extent},
+                                                             slice,
+                                                             destination,
+                                                             destinationRect.offset,
+                                                             slice);
+                    }
+
+                    if (m_paddingMode == PaddingMode::EdgeClamped) {
+                        // Stretch the first and last rows of the source across the borders.
+                        if (topPadding > 0) {
+                            compositionDevice->scaleTextureRegion(
+                                source,
+                                {sourceRect.offset, {sourceRect.extent.width, 1}},
+                                slice,
+                                sourceInfo.format,
+                                destination,
+                                {{destinationRect.offset.x, destinationRect.offset.y - topPadding},
+                                 {destinationRect.extent.width, topPadding}},
+                                slice,
+                                destinationInfo.format,
+                                utils::graphics::ScalingFilter::Bilinear);
+                        }
+                        if (bottomPadding > 0) {
+                            compositionDevice->scaleTextureRegion(
+                                source,
+                                {{sourceRect.offset.x, sourceRect.offset.y + sourceRect.extent.height - 1},
+                                 {sourceRect.extent.width, 1}},
+                                slice,
+                                sourceInfo.format,
+                                destination,
+                                {{destinationRect.offset.x, destinationRect.offset.y + destinationRect.extent.height},
+                                 {destinationRect.extent.width, bottomPadding}},
+                                slice,
+                                destinationInfo.format,
+                                utils::graphics::ScalingFilter::Bilinear);
+                        }
+                    }
+
+                    view.next = nullptr;
+                    view.subImage.swapchain = swapchain->submitted->getSwapchainHandle();
+                    view.subImage.imageRect = {
+                        {destinationRect.offset.x, destinationRect.offset.y - topPadding},
+                        {destinationRect.extent.width, topPadding + destinationRect.extent.height + bottomPadding}};
+                    if (isPadding) {
+                        view.fov = utils::placement::getPaddedFov(
+                            view.fov, destinationRect.extent.height, topPadding, bottomPadding);
+                    }
+                }
+
+                projectionViews.push_back(std::move(views));
+                projections.push_back(*projection);
+                projections.back().views = projectionViews.back().data();
+                layers[i] = reinterpret_cast<const XrCompositionLayerBaseHeader*>(&projections.back());
+            }
+
+            if (timerPool) {
+                timerPool->stop(frameIndex);
+                recordCompositionTimes(*timerPool);
+            }
+
+            for (auto& [swapchain, image] : destinationImages) {
+                swapchain->submitted->releaseImage();
+                swapchain->submitted->commitLastReleasedImage();
+            }
+
+            // Hand the application's images back to the runtime, including those submitted in other layers.
+            for (auto& [handle, swapchain] : sessionData->swapchains) {
+                swapchain.application->commitLastReleasedImage();
+            }
+
+            compositionFramework.serializePostComposition();
+
+            if (m_frameCapture) {
+                collectFrameCaptures(*sessionData);
+            }
+
+            XrFrameEndInfo resampledFrameEndInfo = *frameEndInfo;
+            resampledFrameEndInfo.layers = layers.data();
+            runtimeStart = clock::now();
+            const XrResult result = OpenXrApi::xrEndFrame(session, &resampledFrameEndInfo);
+            runtimeEnd = clock::now();
+            return result;
+        }
+
+        // The timer pool is only created with telemetry enabled, and on the composition devices that support it.
+        utils::graphics::IGraphicsTimerPool* getCompositionTimerPool(ResamplingSessionData& sessionData,
+                                                                     utils::graphics::IGraphicsDevice& device) const {
+            if (!m_telemetry) {
+                return nullptr;
+            }
+
+            if (!sessionData.isCompositionTimerPoolCreated) {
+                sessionData.isCompositionTimerPoolCreated = true;
+                try {
+                    sessionData.compositionTimerPool = device.createTimerPool();
+                } catch (std::exception& exc) {
+                    Log(fmt::format("Composition GPU time is not measured: {}\n", exc.what()));
+                }
+            }
+            return sessionData.compositionTimerPool.get();
+        }
+
+        // Collect the GPU times of the earlier compositions that completed, without waiting for the GPU.
+        void recordCompositionTimes(utils::graphics::IGraphicsTimerPool& timerPool) const {
+            const std::vector<utils::graphics::TimerMeasurement> measurements = timerPool.resolve();
+            if (measurements.empty()) {
+                return;
+            }
+
+            utils::telemetry::Update telemetry(m_telemetry.get());
+            if (telemetry) {
+                for (const utils::graphics::TimerMeasurement& measurement : measurements) {
+                    utils::telemetry::recordLatency(telemetry->compositionGpu, measurement.duration);
+                }
+            }
+        }
+
+        // The request is a setting, which is reset once served. The registry is only read about once per second.
+        bool isFrameCaptureRequested(ResamplingSessionData& sessionData) const {
+            const auto now = clock::now();
+            if (sessionData.lastFrameCaptureRequestPoll.has_value() &&
+                now - sessionData.lastFrameCaptureRequestPoll.value() < 1s) {
+                return false;
+            }
+            sessionData.lastFrameCaptureRequestPoll = now;
+
+            if (!utils::general::getSetting("frame_capture_request").value_or(0)) {
+                return false;
+            }
+            utils::general::setSetting("frame_capture_request", 0);
+            return true;
+        }
+
+        // Queue the readback of the projection views as rendered by the application. They are collected in a later
+        // frame, once the composition device is done with the copies.
+        void captureFrame(utils::graphics::IGraphicsDevice& compositionDevice,
+                          const XrFrameEndInfo& frameEndInfo,
+                          ResamplingSessionData& sessionData,
+                          const SwapchainImages& sourceImages,
+                          uint64_t frameIndex) const {
+            uint32_t viewIndex = 0;
+            for (uint32_t i = 0; i < frameEndInfo.layerCount; i++) {
+                if (frameEndInfo.layers[i]->type != XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+                    continue;
+                }
+                const XrCompositionLayerProjection* const projection =
+                    reinterpret_cast<const XrCompositionLayerProjection*>(frameEndInfo.layers[i]);
+                for (uint32_t j = 0; j < projection->viewCount && viewIndex < MaxCapturedViews; j++, viewIndex++) {
+                    const XrCompositionLayerProjectionView& view = projection->views[j];
+                    auto swapchainIt = sessionData.swapchains.find(view.subImage.swapchain);
+                    if (swapchainIt == sessionData.swapchains.end()) {
+                        continue;
+                    }
+                    ResampledSwapchain& swapchain = swapchainIt->second;
+                    auto sourceIt = sourceImages.find(&swapchain);
+                    if (sourceIt == sourceImages.end()) {
+                        continue;
+                    }
+
+                    if (!swapchain.readback) {
+                        // Room for both views of a stereo array swapchain, twice.
+                        const XrSwapchainCreateInfo& info = swapchain.application->getInfoOnCompositionDevice();
+                        swapchain.readback = compositionDevice.createReadback(info.format, info.width, info.height, 4);
+                    }
+                    if (!swapchain.readback->enqueue(sourceIt->second->getTextureForRead(),
+                                                     view.subImage.imageRect,
+                                                     view.subImage.imageArrayIndex,
+                                                     frameIndex * MaxCapturedViews + viewIndex)) {
+                        Log(fmt::format("Frame capture of view {} skipped: readback is busy\n", viewIndex));
+                    }
+                }
+            }
+        }
+
+        // Hand the completed readbacks to the writer, which encodes them off the frame thread.
+        void collectFrameCaptures(ResamplingSessionData& sessionData) const {
+            for (auto& [handle, swapchain] : sessionData.swapchains) {
+                if (!swapchain.readback) {
+                    continue;
+                }
+                while (swapchain.readback->poll([&](uint64_t tag, const utils::graphics::ReadbackImage& image) {
+                    // The padding of the last row may be missing.
+                    const size_t rowSize =
+                        (size_t)image.width * utils::image::getBytesPerPixel((DXGI_FORMAT)image.format);
+                    const size_t size = image.height ? (size_t)image.rowPitch * (image.height - 1) + rowSize : 0;
+                    std::vector<uint8_t> pixels(image.data, image.data + size);
+                    m_frameCapture->write(localAppData / fmt::format("{}-{}-frame{}-view{}",
+                                                                     GetApplicationName(),
+                                                                     GetCurrentProcessId(),
+                                                                     tag / MaxCapturedViews,
+                                                                     tag % MaxCapturedViews),
+                                          std::move(pixels),
+                                          image.width,
+                                          image.height,
+                                          image.rowPitch,
+                                          (DXGI_FORMAT)image.format);
+                })) {
+                }
+            }
+        }
+
+        // Sessions are registered in xrCreateSession(), but we tolerate sessions created before the layer was ready.
+        std::shared_ptr<SessionStatePublisher> getSessionState(XrSession session) {
+            const auto find = [session](const SessionTable& sessions) -> std::shared_ptr<SessionStatePublisher> {
+                for (const auto& entry : sessions) {
+                    if (entry.first == session) {
+                        return entry.second;
+                    }
+                }
+                return {};
+            };
+
+            std::shared_ptr<SessionStatePublisher> state = find(*m_sessions.load());
+            if (!state) {
+                m_sessions.update([&](SessionTable& sessions) {
+                    // Another thread may have registered the session in the meantime.
+                    state = find(sessions);
+                    if (state) {
+                        return false;
+                    }
+                    state = std::make_shared<SessionStatePublisher>();
+                    sessions.emplace_back(session, state);
+                    return true;
+                });
+            }
+            return state;
+        }
+
+        // Record the FOV angles of the system on the first frame of a session. When several threads locate views
+        // concurrently, only the one publishing the new session state writes the registry.
+        void discoverSystemAngles(SessionStatePublisher& sessionState, const XrView* views) {
+            const bool isFirst = sessionState.update([](SessionState& state) {
+                if (state.anglesWrittenToReg) {
+                    return false;
+                }
+                state.anglesWrittenToReg = true;
+                return true;
+            });
+            if (!isFirst) {
+                return;
+            }
+
+            int systemAngleUp = abs(views[0].fov.angleUp * 180000.0f / DirectX::XM_PI);
+            int systemAngleDown = abs(views[0].fov.angleDown * 180000.0f / DirectX::XM_PI);
+            Log(fmt::format("system angle_up: {}\n", systemAngleUp));
+            Log(fmt::format("system angle_down: {}\n", systemAngleDown));
+            utils::general::setSetting("angle_up", systemAngleUp);
+            utils::general::setSetting("angle_down", systemAngleDown);
+            Log(fmt::format("written angle_up: {}\n",
+                            utils::general::getSetting("angle_up").value_or(defaultFovAngle)));
+            Log(fmt::format("written angle_down: {}\n",
+                            utils::general::getSetting("angle_down").value_or(defaultFovAngle)));
+
+            m_fovSettings.update([&](FovSettings& settings) {
+                getFovAnglesSettings(settings);
+                return true;
+            });
+        }
+
         bool m_bypassApiLayer{false};
         XrSystemId m_systemId{XR_NULL_SYSTEM_ID};
+
+        utils::general::SnapshotPublisher<FovSettings> m_fovSettings;
+        utils::general::SnapshotPublisher<SessionTable> m_sessions;
+
+        float m_upscalingFactor{1.f};
+        utils::graphics::ScalingFilter m_upscalingFilter{utils::graphics::ScalingFilter::Lanczos};
+        PaddingMode m_paddingMode{PaddingMode::None};
+        bool m_useCompositionWorker{false};
+        std::shared_ptr<utils::graphics::ICompositionFrameworkFactory> m_compositionFrameworkFactory;
+        mutable std::mutex m_resampledSwapchainsMutex;
+        std::unordered_map<XrSwapchain, std::pair<XrSession, std::weak_ptr<utils::graphics::ISwapchain>>>
+            m_resampledSwapchains;
+
+        std::unique_ptr<utils::telemetry::Writer> m_telemetry;
+        std::unique_ptr<utils::capture::Writer> m_capture;
+        std::unique_ptr<utils::screenshot::Writer> m_frameCapture;
+        std::optional<clock::time_point> m_lastEndFrameTime;
     };
 
     // This method is required by the framework to instantiate your OpenXrApi implementation.
@@ -29,14 +29,24 @@
 
 #define XR_USE_GRAPHICS_API_D3D11
 #define XR_USE_GRAPHICS_API_D3D12
+#ifdef _WIN64
+// Requires the Vulkan SDK headers. The backend relies on Vulkan handles being pointers, which is only true in 64-bit.
+#define XR_USE_GRAPHICS_API_VULKAN
+#endif
+// Requires OpenGL 4.5, and EXT_memory_object_win32/EXT_semaphore_win32 for interop with the composition device.
+#define XR_USE_GRAPHICS_API_OPENGL
 
 // Standard library.
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdarg>
 #include <ctime>
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <condition_variable>
 #include <deque>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <mutex>
@@ -46,6 +56,7 @@
 #include <string>
 #include <memory>
 #include <optional>
+#include <thread>
 
 using namespace std::chrono_literals;
 
@@ -69,6 +80,14 @@ using Microsoft::WRL::ComPtr;
 #ifdef XR_USE_GRAPHICS_API_D3D12
 #include <d3d12.h>
 #endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+#define VK_NO_PROTOTYPES
+#define VK_USE_PLATFORM_WIN32_KHR
+#include <vulkan/vulkan.h>
+#endif
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+#include <GL/gl.h>
+#endif
 
 // OpenXR + Windows-specific definitions.
 #define XR_NO_PROTOTYPES
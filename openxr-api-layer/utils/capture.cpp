@@ -0,0 +1,108 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "capture.h"
+#include <log.h>
+
+namespace openxr_api_layer::utils::capture {
+
+    using namespace openxr_api_layer::log;
+
+    Writer::Writer(const std::string& path, uint64_t capacity, const FileHeader& header)
+        : m_path(path), m_start(clock::now()) {
+        m_file = CreateFileA(path.c_str(),
+                             GENERIC_READ | GENERIC_WRITE,
+                             FILE_SHARE_READ,
+                             nullptr,
+                             CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            ErrorLog(fmt::format("Failed to create capture file {}: {}\n", path, GetLastError()));
+            return;
+        }
+
+        // Mapping the file extends it to its full capacity. It is truncated when the capture is closed.
+        const uint64_t mappingSize = sizeof(FileHeader) + capacity;
+        m_mapping = CreateFileMappingA(
+            m_file, nullptr, PAGE_READWRITE, (DWORD)(mappingSize >> 32), (DWORD)mappingSize, nullptr);
+        if (m_mapping) {
+            m_view = reinterpret_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, mappingSize));
+        }
+        if (!m_view) {
+            ErrorLog(fmt::format("Failed to map capture file {}: {}\n", path, GetLastError()));
+            return;
+        }
+        m_capacity = capacity;
+
+        FileHeader* const fileHeader = reinterpret_cast<FileHeader*>(m_view);
+        *fileHeader = header;
+        fileHeader->magic = FileMagic;
+        fileHeader->version = FileVersion;
+        fileHeader->headerSize = sizeof(FileHeader);
+        fileHeader->processId = GetCurrentProcessId();
+
+        Log(fmt::format("Capturing to {}\n", path));
+    }
+
+    Writer::~Writer() {
+        const uint64_t used = std::min(m_used.load(), m_capacity);
+        if (m_view) {
+            FileHeader* const fileHeader = reinterpret_cast<FileHeader*>(m_view);
+            fileHeader->recordsSize = used;
+            fileHeader->droppedRecords = m_dropped.load();
+            UnmapViewOfFile(m_view);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER size;
+            size.QuadPart = sizeof(FileHeader) + used;
+            if (SetFilePointerEx(m_file, size, nullptr, FILE_BEGIN)) {
+                SetEndOfFile(m_file);
+            }
+            CloseHandle(m_file);
+        }
+
+        if (m_dropped.load()) {
+            Log(fmt::format("Capture is full, {} records were dropped\n", m_dropped.load()));
+        }
+    }
+
+    uint8_t* Writer::allocate(uint32_t size) noexcept {
+        if (!m_view) {
+            return nullptr;
+        }
+
+        const uint64_t offset = m_used.fetch_add(size, std::memory_order_relaxed);
+        if (offset + size > m_capacity) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        return m_view + sizeof(FileHeader) + offset;
+    }
+
+} // namespace openxr_api_layer::utils::capture
@@ -0,0 +1,329 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+// This header is shared with the capture-tool and must not depend on the layer's precompiled header.
+//
+// A capture file is a FileHeader followed by a sequence of records. Each record is a RecordHeader followed by a
+// payload, padded to 8 bytes. The file is written through a memory mapping: a record is complete once its type is set
+// (the remaining of the file is zero-filled), so that a capture survives the application crashing.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "telemetry.h"
+
+namespace openxr_api_layer::utils::capture {
+
+    constexpr uint32_t FileMagic = 0x50434643; // "CFCP"
+    constexpr uint32_t FileVersion = 2;
+
+    // Fixed values: only append new entries and bump FileVersion when a payload changes.
+    enum class RecordType : uint16_t {
+        None = 0,
+        GetSystem,
+        CreateSession,
+        DestroySession,
+        EnumerateViewConfigurationViews,
+        LocateViews,
+        EndFrame,
+        CreateSwapchain,
+        DestroySwapchain,
+        AcquireSwapchainImage,
+        WaitSwapchainImage,
+        ReleaseSwapchainImage,
+
+        Count
+    };
+
+    static inline const char* getRecordTypeName(RecordType type) {
+        switch (type) {
+        case RecordType::GetSystem:
+            return "xrGetSystem";
+        case RecordType::CreateSession:
+            return "xrCreateSession";
+        case RecordType::DestroySession:
+            return "xrDestroySession";
+        case RecordType::EnumerateViewConfigurationViews:
+            return "xrEnumerateViewConfigurationViews";
+        case RecordType::LocateViews:
+            return "xrLocateViews";
+        case RecordType::EndFrame:
+            return "xrEndFrame";
+        case RecordType::CreateSwapchain:
+            return "xrCreateSwapchain";
+        case RecordType::DestroySwapchain:
+            return "xrDestroySwapchain";
+        case RecordType::AcquireSwapchainImage:
+            return "xrAcquireSwapchainImage";
+        case RecordType::WaitSwapchainImage:
+            return "xrWaitSwapchainImage";
+        case RecordType::ReleaseSwapchainImage:
+            return "xrReleaseSwapchainImage";
+        default:
+            return "Unknown";
+        }
+    }
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t processId;
+        char applicationName[128];
+        char runtimeName[128];
+        uint64_t runtimeVersion;
+
+        // The registry settings in effect, in thousandths.
+        int32_t fovUpSetting;
+        int32_t fovDownSetting;
+
+        // Only accurate once the capture is closed.
+        uint64_t recordsSize;
+        uint64_t droppedRecords;
+
+        // The remaining registry settings that change the layer's outputs, so that a replay can restore them.
+        int32_t angleUpSetting;
+        int32_t angleDownSetting;
+        int32_t upscalingSetting;
+        int32_t paddingSetting;
+    };
+
+    struct RecordHeader {
+        std::atomic<RecordType> type;
+        uint16_t size;
+        int32_t result;
+
+        // The session, system or swapchain the call refers to.
+        uint64_t handle;
+
+        // Time since the start of the capture when the call entered the layer.
+        uint64_t timestampNs;
+
+        // Time spent in the layer's entry point, and the part of it spent in the next layer or the runtime.
+        uint64_t durationNs;
+        uint64_t runtimeNs;
+    };
+    static_assert(sizeof(RecordHeader) % 8 == 0);
+    static_assert(std::atomic<RecordType>::is_always_lock_free);
+
+    constexpr uint32_t MaxViews = 4;
+
+    struct GetSystemPayload {
+        uint32_t formFactor;
+        uint32_t reserved;
+    };
+
+    struct CreateSessionPayload {
+        uint64_t systemId;
+    };
+
+    struct DestroySessionPayload {};
+
+    struct EnumerateViewConfigurationViewsPayload {
+        uint32_t viewConfigurationType;
+        uint32_t viewCount;
+        telemetry::ImageSize nativeImageSize[MaxViews];
+        telemetry::ImageSize recommendedImageSize[MaxViews];
+    };
+
+    struct LocateViewsPayload {
+        uint32_t viewConfigurationType;
+        uint32_t viewCount;
+        int64_t displayTime;
+        telemetry::Fov nativeFov[MaxViews];
+        telemetry::Fov customizedFov[MaxViews];
+    };
+
+    struct EndFramePayload {
+        int64_t displayTime;
+        uint32_t layerCount;
+        uint32_t environmentBlendMode;
+    };
+
+    // The record's handle is the session.
+    struct CreateSwapchainPayload {
+        uint64_t swapchain;
+        uint64_t createFlags;
+        uint64_t usageFlags;
+        int64_t format;
+        uint32_t sampleCount;
+        uint32_t width;
+        uint32_t height;
+        uint32_t faceCount;
+        uint32_t arraySize;
+        uint32_t mipCount;
+    };
+
+    // The records' handle is the swapchain.
+    struct DestroySwapchainPayload {};
+
+    struct AcquireSwapchainImagePayload {
+        uint32_t index;
+        uint32_t reserved;
+    };
+
+    struct WaitSwapchainImagePayload {
+        int64_t timeout;
+    };
+
+    struct ReleaseSwapchainImagePayload {};
+
+    static constexpr uint32_t getRecordSize(uint32_t payloadSize) {
+        return (sizeof(RecordHeader) + payloadSize + 7) & ~7u;
+    }
+
+    // A record of a loaded capture, pointing into the capture's data.
+    struct Record {
+        RecordType type;
+        int32_t result;
+        uint64_t handle;
+        uint64_t timestampNs;
+        uint64_t durationNs;
+        uint64_t runtimeNs;
+        const uint8_t* payload;
+
+        template <typename Payload>
+        const Payload& as() const {
+            return *reinterpret_cast<const Payload*>(payload);
+        }
+    };
+
+    struct Capture {
+        std::vector<uint8_t> data;
+        FileHeader header{};
+        std::vector<Record> records;
+    };
+
+    // Index the records of capture.data. Returns false if it is not a supported capture file.
+    static inline bool parse(Capture& capture) {
+        capture.records.clear();
+        if (capture.data.size() < sizeof(FileHeader)) {
+            return false;
+        }
+        memcpy(&capture.header, capture.data.data(), sizeof(FileHeader));
+        if (capture.header.magic != FileMagic || capture.header.version != FileVersion ||
+            capture.header.headerSize != sizeof(FileHeader)) {
+            return false;
+        }
+
+        // The records size is not written if the application crashed: stop at the first incomplete record instead.
+        size_t offset = sizeof(FileHeader);
+        while (offset + sizeof(RecordHeader) <= capture.data.size()) {
+            const RecordHeader* header = reinterpret_cast<const RecordHeader*>(capture.data.data() + offset);
+            const RecordType type = header->type.load(std::memory_order_relaxed);
+            if (type == RecordType::None || header->size < sizeof(RecordHeader) ||
+                offset + header->size > capture.data.size()) {
+                break;
+            }
+
+            capture.records.push_back({type,
+                                       header->result,
+                                       header->handle,
+                                       header->timestampNs,
+                                       header->durationNs,
+                                       header->runtimeNs,
+                                       capture.data.data() + offset + sizeof(RecordHeader)});
+            offset += header->size;
+        }
+
+        return true;
+    }
+
+    // The layer-side recorder. Records may be appended concurrently from any thread.
+    class Writer {
+      public:
+        using clock = std::chrono::steady_clock;
+
+        Writer(const std::string& path, uint64_t capacity, const FileHeader& header);
+        ~Writer();
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        // For entry points that call the runtime first, before any of the layer's own work.
+        template <typename Payload>
+        void record(RecordType type,
+                    int32_t result,
+                    uint64_t handle,
+                    clock::time_point callStart,
+                    clock::time_point runtimeEnd,
+                    const Payload& payload) noexcept {
+            record(type, result, handle, callStart, callStart, runtimeEnd, payload);
+        }
+
+        template <typename Payload>
+        void record(RecordType type,
+                    int32_t result,
+                    uint64_t handle,
+                    clock::time_point callStart,
+                    clock::time_point runtimeStart,
+                    clock::time_point runtimeEnd,
+                    const Payload& payload) noexcept {
+            const auto callEnd = clock::now();
+            constexpr uint32_t size = getRecordSize(sizeof(Payload));
+            uint8_t* const buffer = allocate(size);
+            if (!buffer) {
+                return;
+            }
+
+            RecordHeader* const header = reinterpret_cast<RecordHeader*>(buffer);
+            header->size = (uint16_t)size;
+            header->result = result;
+            header->handle = handle;
+            header->timestampNs = toNanoseconds(callStart - m_start);
+            header->durationNs = toNanoseconds(callEnd - callStart);
+            header->runtimeNs = toNanoseconds(runtimeEnd - runtimeStart);
+            memcpy(buffer + sizeof(RecordHeader), &payload, sizeof(Payload));
+
+            // Publish the record last.
+            header->type.store(type, std::memory_order_release);
+        }
+
+        const std::string& getPath() const {
+            return m_path;
+        }
+
+      private:
+        static uint64_t toNanoseconds(clock::duration duration) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        }
+
+        // Returns nullptr when the capture is full.
+        uint8_t* allocate(uint32_t size) noexcept;
+
+        const std::string m_path;
+        const clock::time_point m_start;
+        HANDLE m_file{INVALID_HANDLE_VALUE};
+        HANDLE m_mapping{nullptr};
+        uint8_t* m_view{nullptr};
+        uint64_t m_capacity{0};
+        std::atomic<uint64_t> m_used{0};
+        std::atomic<uint64_t> m_dropped{0};
+    };
+
+} // namespace openxr_api_layer::utils::capture
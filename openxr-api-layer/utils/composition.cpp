@@ -40,6 +40,14 @@ namespace xr {
 #ifdef XR_USE_GRAPHICS_API_D3D12
         case Api::D3D12:
             return "D3D12";
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+        case Api::Vulkan:
+            return "Vulkan";
+#endif
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+        case Api::OpenGL:
+            return "OpenGL";
 #endif
         };
 
@@ -48,9 +56,15 @@ namespace xr {
 
     static inline std::string ToString(CompositionApi api) {
         switch (api) {
+        case CompositionApi::Automatic:
+            return "Automatic";
 #ifdef XR_USE_GRAPHICS_API_D3D11
         case CompositionApi::D3D11:
             return "D3D11";
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+        case CompositionApi::Vulkan:
+            return "Vulkan";
 #endif
         };
 
@@ -64,24 +78,294 @@ namespace {
     using namespace openxr_api_layer::log;
     using namespace openxr_api_layer::utils::graphics;
 
-    bool isSRGBFormat(DXGI_FORMAT format) {
+    // The classification of formats, used to build FormatTable at compile time.
+    constexpr bool isSRGBFormat(DXGI_FORMAT format) {
         return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
                format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB || format == DXGI_FORMAT_BC1_UNORM_SRGB ||
                format == DXGI_FORMAT_BC2_UNORM_SRGB || format == DXGI_FORMAT_BC3_UNORM_SRGB ||
                format == DXGI_FORMAT_BC7_UNORM_SRGB;
     }
 
-    bool isDepthFormat(DXGI_FORMAT format) {
+    constexpr bool isDepthFormat(DXGI_FORMAT format) {
         return format == DXGI_FORMAT_D16_UNORM || format == DXGI_FORMAT_D24_UNORM_S8_UINT ||
                format == DXGI_FORMAT_D32_FLOAT || format == DXGI_FORMAT_D32_FLOAT_S8X24_UINT;
     }
 
+    constexpr uint32_t getBitsPerPixel(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32G32B32A32_UINT:
+        case DXGI_FORMAT_R32G32B32A32_SINT:
+            return 128;
+        case DXGI_FORMAT_R32G32B32_TYPELESS:
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+        case DXGI_FORMAT_R32G32B32_UINT:
+        case DXGI_FORMAT_R32G32B32_SINT:
+            return 96;
+        case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+        case DXGI_FORMAT_R16G16B16A16_UINT:
+        case DXGI_FORMAT_R16G16B16A16_SNORM:
+        case DXGI_FORMAT_R16G16B16A16_SINT:
+        case DXGI_FORMAT_R32G32_TYPELESS:
+        case DXGI_FORMAT_R32G32_FLOAT:
+        case DXGI_FORMAT_R32G32_UINT:
+        case DXGI_FORMAT_R32G32_SINT:
+        case DXGI_FORMAT_R32G8X24_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+        case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+        case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+            return 64;
+        case DXGI_FORMAT_R8G8_TYPELESS:
+        case DXGI_FORMAT_R8G8_UNORM:
+        case DXGI_FORMAT_R8G8_UINT:
+        case DXGI_FORMAT_R8G8_SNORM:
+        case DXGI_FORMAT_R8G8_SINT:
+        case DXGI_FORMAT_R16_TYPELESS:
+        case DXGI_FORMAT_R16_FLOAT:
+        case DXGI_FORMAT_D16_UNORM:
+        case DXGI_FORMAT_R16_UNORM:
+        case DXGI_FORMAT_R16_UINT:
+        case DXGI_FORMAT_R16_SNORM:
+        case DXGI_FORMAT_R16_SINT:
+        case DXGI_FORMAT_B5G6R5_UNORM:
+        case DXGI_FORMAT_B5G5R5A1_UNORM:
+        case DXGI_FORMAT_B4G4R4A4_UNORM:
+            return 16;
+        case DXGI_FORMAT_R8_TYPELESS:
+        case DXGI_FORMAT_R8_UNORM:
+        case DXGI_FORMAT_R8_UINT:
+        case DXGI_FORMAT_R8_SNORM:
+        case DXGI_FORMAT_R8_SINT:
+        case DXGI_FORMAT_A8_UNORM:
+        case DXGI_FORMAT_BC2_TYPELESS:
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_TYPELESS:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_TYPELESS:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+        case DXGI_FORMAT_BC6H_TYPELESS:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+        case DXGI_FORMAT_BC7_TYPELESS:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return 8;
+        case DXGI_FORMAT_BC1_TYPELESS:
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_TYPELESS:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            return 4;
+        default:
+            return 32;
+        }
+    }
+
+    struct FormatInfo {
+        uint32_t bitsPerPixel;
+        bool isSRGB;
+        bool isDepth;
+    };
+
+    // Covers all the DXGI formats, which are numbered below 256.
+    constexpr std::array<FormatInfo, 256> makeFormatTable() {
+        std::array<FormatInfo, 256> table{};
+        for (uint32_t i = 0; i < table.size(); i++) {
+            const DXGI_FORMAT format = (DXGI_FORMAT)i;
+            table[i] = {getBitsPerPixel(format), isSRGBFormat(format), isDepthFormat(format)};
+        }
+        return table;
+    }
+
+    constexpr std::array<FormatInfo, 256> FormatTable = makeFormatTable();
+    static_assert(FormatTable[DXGI_FORMAT_R8G8B8A8_UNORM_SRGB].isSRGB && FormatTable[DXGI_FORMAT_D32_FLOAT].isDepth &&
+                  FormatTable[DXGI_FORMAT_R16G16B16A16_FLOAT].bitsPerPixel == 64);
+
+    const FormatInfo& getFormatInfo(DXGI_FORMAT format) {
+        return FormatTable[(uint32_t)format < FormatTable.size() ? format : DXGI_FORMAT_UNKNOWN];
+    }
+
+    // Estimated size of a texture, ignoring the alignment and compression done by the driver.
+    uint64_t getTextureMemorySize(const XrSwapchainCreateInfo& info, DXGI_FORMAT format) {
+        uint64_t pixels = 0;
+        for (uint32_t mip = 0; mip < std::max(info.mipCount, 1u); mip++) {
+            pixels += (uint64_t)std::max(info.width >> mip, 1u) * std::max(info.height >> mip, 1u);
+        }
+        return pixels * getFormatInfo(format).bitsPerPixel / 8 * std::max(info.arraySize, 1u) *
+               std::max(info.faceCount, 1u) * std::max(info.sampleCount, 1u);
+    }
+
+    // Set to true to open all the swapchain images on the composition device when the swapchain is created, rather than
+    // upon first use.
+    constexpr bool EagerSwapchainImages = false;
+
+    // The memory kept for textures released by destroyed swapchains, per composition device.
+    constexpr uint64_t TexturePoolMemoryBudget = 256ull << 20;
+
+    // How long to wait for another thread to release an image of a non-submittable swapchain.
+    constexpr auto ImageReleaseTimeout = 1s;
+
+    struct SubmittableSwapchain;
+
+    // The synchronization between the application and composition device for a session.
+    // Commands issued on either device only mark the timeline, and a single signal/wait pair is issued when the other
+    // device needs to observe them. This way, a frame costs one synchronization in each direction regardless of the
+    // number of swapchains.
+    struct FenceTimeline {
+        FenceTimeline(IGraphicsDevice* applicationDevice, IGraphicsDevice* compositionDevice) {
+            m_fenceOnCompositionDevice = compositionDevice->createFence();
+            m_fenceOnApplicationDevice = applicationDevice->openFence(m_fenceOnCompositionDevice->getFenceHandle());
+        }
+
+        void markApplicationWork() {
+            std::unique_lock lock(m_mutex);
+            m_applicationWorkPending = true;
+        }
+
+        // Returns the lowest fence value that the composition device signals once it completes this work.
+        uint64_t markCompositionWork() {
+            std::unique_lock lock(m_mutex);
+            m_compositionWorkPending = true;
+            return m_fenceValue + 1;
+        }
+
+        void syncApplicationToComposition() {
+            std::unique_lock lock(m_mutex);
+
+            if (!m_applicationWorkPending) {
+                m_statistics.coalescedSyncs++;
+                return;
+            }
+
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "FenceTimeline_SyncApplicationToComposition", TLPArg(this, "Timeline"));
+
+            m_fenceValue++;
+            m_fenceOnApplicationDevice->signal(m_fenceValue);
+            m_fenceOnCompositionDevice->waitOnDevice(m_fenceValue);
+            m_applicationWorkPending = false;
+
+            m_statistics.applicationToCompositionSyncs++;
+            m_statistics.fenceSignals++;
+            m_statistics.fenceDeviceWaits++;
+
+            TraceLoggingWriteStop(
+                local, "FenceTimeline_SyncApplicationToComposition", TLArg(m_fenceValue, "FenceValue"));
+        }
+
+        void syncCompositionToApplication() {
+            std::unique_lock lock(m_mutex);
+
+            if (!m_compositionWorkPending) {
+                m_statistics.coalescedSyncs++;
+                return;
+            }
+
+            syncCompositionToApplicationLocked();
+        }
+
+        // Make the application device wait for the composition work that returned the fence value from
+        // markCompositionWork(), unless it already does.
+        void waitForCompositionOnApplication(uint64_t fenceValue) {
+            std::unique_lock lock(m_mutex);
+
+            if (m_compositionToApplicationValue >= fenceValue) {
+                m_statistics.coalescedSyncs++;
+                return;
+            }
+
+            syncCompositionToApplicationLocked();
+        }
+
+        void syncCompositionToApplicationLocked() {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "FenceTimeline_SyncCompositionToApplication", TLPArg(this, "Timeline"));
+
+            m_fenceValue++;
+            m_fenceOnCompositionDevice->signal(m_fenceValue);
+            m_fenceOnApplicationDevice->waitOnDevice(m_fenceValue);
+            m_compositionWorkPending = false;
+            m_compositionToApplicationValue = m_fenceValue;
+
+            m_statistics.compositionToApplicationSyncs++;
+            m_statistics.fenceSignals++;
+            m_statistics.fenceDeviceWaits++;
+
+            TraceLoggingWriteStop(
+                local, "FenceTimeline_SyncCompositionToApplication", TLArg(m_fenceValue, "FenceValue"));
+        }
+
+        // Wait for all the commands on both devices to complete.
+        void waitForIdle() {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "FenceTimeline_WaitForIdle", TLPArg(this, "Timeline"));
+
+            std::unique_lock lock(m_mutex);
+
+            m_fenceValue++;
+            m_fenceOnCompositionDevice->signal(m_fenceValue);
+            m_fenceOnCompositionDevice->waitOnCpu(m_fenceValue);
+            m_fenceValue++;
+            m_fenceOnApplicationDevice->signal(m_fenceValue);
+            m_fenceOnApplicationDevice->waitOnCpu(m_fenceValue);
+            m_applicationWorkPending = m_compositionWorkPending = false;
+            m_compositionToApplicationValue = m_fenceValue;
+
+            m_statistics.fenceSignals += 2;
+            m_statistics.fenceCpuWaits += 2;
+
+            TraceLoggingWriteStop(local, "FenceTimeline_WaitForIdle");
+        }
+
+        void deferCommit(SubmittableSwapchain* swapchain) {
+            std::unique_lock lock(m_commitsMutex);
+            if (std::find(m_deferredCommits.cbegin(), m_deferredCommits.cend(), swapchain) ==
+                m_deferredCommits.cend()) {
+                m_deferredCommits.push_back(swapchain);
+            }
+        }
+
+        void cancelCommit(SubmittableSwapchain* swapchain) {
+            std::unique_lock lock(m_commitsMutex);
+            m_deferredCommits.erase(std::remove(m_deferredCommits.begin(), m_deferredCommits.end(), swapchain),
+                                    m_deferredCommits.end());
+        }
+
+        // Defined after SubmittableSwapchain.
+        void completeDeferredCommits();
+
+        SynchronizationStatistics getStatistics() const {
+            std::unique_lock lock(m_mutex);
+            return m_statistics;
+        }
+
+        mutable std::mutex m_mutex;
+        std::shared_ptr<IGraphicsFence> m_fenceOnApplicationDevice;
+        std::shared_ptr<IGraphicsFence> m_fenceOnCompositionDevice;
+        uint64_t m_fenceValue{0};
+        uint64_t m_compositionToApplicationValue{0};
+        bool m_applicationWorkPending{false};
+        bool m_compositionWorkPending{false};
+        SynchronizationStatistics m_statistics;
+
+        std::mutex m_commitsMutex;
+        std::vector<SubmittableSwapchain*> m_deferredCommits;
+    };
+
     struct SwapchainImage : ISwapchainImage {
         SwapchainImage(std::shared_ptr<IGraphicsTexture> textureOnApplicationDevice,
                        std::shared_ptr<IGraphicsTexture> textureOnCompositionDevice,
-                       uint32_t index)
+                       uint32_t index,
+                       FenceTimeline* timeline = nullptr)
             : m_textureOnApplicationDevice(textureOnApplicationDevice), m_textureForRead(textureOnCompositionDevice),
-              m_textureForWrite(textureOnCompositionDevice), m_index(index) {
+              m_textureForWrite(textureOnCompositionDevice), m_index(index), m_timeline(timeline) {
         }
 
         IGraphicsTexture* getApplicationTexture() const override {
@@ -89,10 +373,12 @@ namespace {
         }
 
         IGraphicsTexture* getTextureForRead() const override {
+            serializeAccess();
             return m_textureForRead.get();
         }
 
         IGraphicsTexture* getTextureForWrite() const override {
+            serializeAccess();
             return m_textureForWrite.get();
         }
 
@@ -100,10 +386,27 @@ namespace {
             return m_index;
         }
 
+        // The texture is about to be used on the composition device: the pending application commands must complete
+        // first, and the application must then wait for the composition.
+        void serializeAccess() const {
+            if (m_timeline) {
+                m_timeline->syncApplicationToComposition();
+                m_compositionFenceValue = m_timeline->markCompositionWork();
+            }
+        }
+
+        // The fence value that the composition device signals once it is done with the texture.
+        uint64_t getCompositionFenceValue() const {
+            return m_compositionFenceValue;
+        }
+
         const std::shared_ptr<IGraphicsTexture> m_textureOnApplicationDevice;
         const std::shared_ptr<IGraphicsTexture> m_textureForRead;
         const std::shared_ptr<IGraphicsTexture> m_textureForWrite;
         const uint32_t m_index;
+        FenceTimeline* const m_timeline;
+
+        mutable std::atomic<uint64_t> m_compositionFenceValue{0};
     };
 
     struct SubmittableSwapchain : ISwapchain {
@@ -113,12 +416,17 @@ namespace {
                              const XrSwapchainCreateInfo& infoOnApplicationDevice,
                              IGraphicsDevice* applicationDevice,
                              IGraphicsDevice* compositionDevice,
+                             std::shared_ptr<ITexturePool> texturePool,
+                             std::shared_ptr<FenceTimeline> timeline,
                              SwapchainMode mode,
                              std::optional<bool> overrideShareable = {},
                              bool hasOwnership = true)
-            : m_swapchain(swapchain), m_infoOnCompositionDevice(infoOnApplicationDevice),
+            : m_swapchain(swapchain), m_infoOnApplicationDevice(infoOnApplicationDevice),
+              m_infoOnCompositionDevice(infoOnApplicationDevice),
               m_formatOnApplicationDevice(infoOnApplicationDevice.format), m_applicationDevice(applicationDevice),
-              m_compositionDevice(compositionDevice),
+              m_compositionDevice(compositionDevice), m_texturePool(texturePool), m_timeline(timeline),
+              m_isSameDevice(applicationDevice == compositionDevice),
+              m_canShareImages(overrideShareable.value_or(true)),
               m_accessForRead((mode & SwapchainMode::Read) == SwapchainMode::Read),
               m_accessForWrite((mode & SwapchainMode::Write) == SwapchainMode::Write) {
             TraceLocalActivity(local);
@@ -171,45 +479,45 @@ namespace {
                     textures.push_back(m_applicationDevice->openTexture<D3D12>(image.texture, infoOnApplicationDevice));
                 }
             } break;
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+            case Api::Vulkan: {
+                std::vector<XrSwapchainImageVulkanKHR> images(imagesCount, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR});
+                CHECK_XRCMD(xrEnumerateSwapchainImages(m_swapchain,
+                                                       imagesCount,
+                                                       &imagesCount,
+                                                       reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+                for (const XrSwapchainImageVulkanKHR& image : images) {
+                    textures.push_back(m_applicationDevice->openTexture<Vulkan>(image.image, infoOnApplicationDevice));
+                }
+            } break;
+#endif
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+            case Api::OpenGL: {
+                std::vector<XrSwapchainImageOpenGLKHR> images(imagesCount, {XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR});
+                CHECK_XRCMD(xrEnumerateSwapchainImages(m_swapchain,
+                                                       imagesCount,
+                                                       &imagesCount,
+                                                       reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+                for (const XrSwapchainImageOpenGLKHR& image : images) {
+                    textures.push_back(m_applicationDevice->openTexture<OpenGL>(image.image, infoOnApplicationDevice));
+                }
+            } break;
 #endif
             default:
                 throw std::runtime_error("Composition graphics API is not supported");
             }
 
-            // Make the images available on the composition device.
-            uint32_t index = 0;
-            for (std::shared_ptr<IGraphicsTexture>& textureOnApplicationDevice : textures) {
-                std::unique_ptr<SwapchainImage> image;
-                if (overrideShareable.value_or(true) && textureOnApplicationDevice->isShareable()) {
-                    const std::shared_ptr<IGraphicsTexture> textureOnCompositionDevice =
-                        m_compositionDevice->openTexture(textureOnApplicationDevice->getTextureHandle(),
-                                                         m_infoOnCompositionDevice);
-                    image =
-                        std::make_unique<SwapchainImage>(textureOnApplicationDevice, textureOnCompositionDevice, index);
-                } else {
-                    // If the swapchain image isn't shareable, we will need to create a copy accessible on both the
-                    // application and composition device, and make sure to perform copy operations as needed.
-                    // TODO: Reduce memory occupation by using a shared texture at the IGraphicsDevice level.
-                    if (!m_bounceBufferOnApplicationDevice) {
-                        m_bounceBufferOnCompositionDevice =
-                            m_compositionDevice->createTexture(m_infoOnCompositionDevice, true /* shareable */);
-                        m_bounceBufferOnApplicationDevice = m_applicationDevice->openTexture(
-                            m_bounceBufferOnCompositionDevice->getTextureHandle(), infoOnApplicationDevice);
-                    }
-                    image = std::make_unique<SwapchainImage>(
-                        textureOnApplicationDevice, m_bounceBufferOnCompositionDevice, index);
+            // Exporting and opening the images on the composition device is deferred until they are used, since
+            // swapchains are often created while the application is loading.
+            m_applicationTextures = std::move(textures);
+            m_images.resize(m_applicationTextures.size());
+            if (EagerSwapchainImages) {
+                for (uint32_t i = 0; i < m_applicationTextures.size(); i++) {
+                    getOrCreateImage(i);
                 }
-
-                TraceLoggingWriteTagged(local, "Swapchain_Create", TLPArg(image.get(), "Image"));
-
-                m_images.push_back(std::move(image));
-                index++;
             }
 
-            // A fence to be used to synchronize between the application/runtime and the composition device.
-            m_fenceOnCompositionDevice = m_compositionDevice->createFence();
-            m_fenceOnApplicationDevice = m_applicationDevice->openFence(m_fenceOnCompositionDevice->getFenceHandle());
-
             TraceLoggingWriteStop(local, "Swapchain_Create", TLPArg(this, "Swapchain"));
         }
 
@@ -217,11 +525,13 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_Destroy", TLPArg(this, "Swapchain"));
 
-            if (m_fenceOnApplicationDevice) {
-                m_fenceOnApplicationDevice->waitOnCpu(m_fenceValue);
+            if (m_timeline) {
+                m_timeline->cancelCommit(this);
+                m_timeline->waitForIdle();
             }
-            if (m_fenceOnCompositionDevice) {
-                m_fenceOnCompositionDevice->waitOnCpu(m_fenceValue);
+            if (m_bounceBuffer.onApplicationDevice) {
+                const uint64_t memorySize = getMemoryFootprint();
+                m_texturePool->release(std::move(m_bounceBuffer), memorySize);
             }
             if (xrDestroySwapchain) {
                 xrDestroySwapchain(m_swapchain);
@@ -244,15 +554,13 @@ namespace {
                 CHECK_XRCMD(xrWaitSwapchainImage(m_swapchain, &waitInfo));
             }
 
-            // Serialize the operations on the application device that might have occurred when acquiring the swapchain
-            // image.
-            m_fenceValue++;
-            m_fenceOnApplicationDevice->signal(m_fenceValue);
-            m_fenceOnCompositionDevice->waitOnDevice(m_fenceValue);
+            // The operations on the application device that might have occurred when acquiring the swapchain image
+            // must be serialized before composition.
+            markApplicationWork();
 
             m_acquiredImages.push_back(index);
 
-            ISwapchainImage* const image = m_images[index].get();
+            ISwapchainImage* const image = getOrCreateImage(index);
 
             TraceLoggingWriteStop(
                 local, "Swapchain_AcquireImage", TLArg(index, "AcquiredIndex"), TLPArg(image, "Image"));
@@ -260,17 +568,20 @@ namespace {
             return image;
         }
 
-        void waitImage() override {
+        XrResult waitImage(XrDuration timeout) override {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(local, "Swapchain_WaitImage", TLPArg(this, "Swapchain"));
+            TraceLoggingWriteStart(
+                local, "Swapchain_WaitImage", TLPArg(this, "Swapchain"), TLArg(timeout, "Timeout"));
 
             // We don't need to check that an image was acquired since OpenXR will do it for us and throw an error
-            // below.
+            // below. XR_TIMEOUT_EXPIRED is a success code: the image remains acquired and may be waited on again.
             XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
-            waitInfo.timeout = XR_INFINITE_DURATION;
-            CHECK_XRCMD(xrWaitSwapchainImage(m_swapchain, &waitInfo));
+            waitInfo.timeout = timeout;
+            const XrResult result = CHECK_XRCMD(xrWaitSwapchainImage(m_swapchain, &waitInfo));
 
-            TraceLoggingWriteStop(local, "Swapchain_WaitImage");
+            TraceLoggingWriteStop(local, "Swapchain_WaitImage", TLArg(xr::ToCString(result), "Result"));
+
+            return result;
         }
 
         void releaseImage() override {
@@ -306,19 +617,16 @@ namespace {
 
             ISwapchainImage* image = nullptr;
             if (m_lastReleasedImage.has_value()) {
-                if (m_bounceBufferOnApplicationDevice) {
+                image = getOrCreateImage(m_lastReleasedImage.value());
+
+                if (m_bounceBuffer.onApplicationDevice) {
                     // The swapchain image wasn't shareable and we must perform a copy to a shareable texture accessible
                     // on the composition device.
-                    m_applicationDevice->copyTexture(m_images[m_lastReleasedImage.value()]->getApplicationTexture(),
-                                                     m_bounceBufferOnApplicationDevice.get());
+                    copyBounceBuffer(image->getApplicationTexture(), m_bounceBuffer.onApplicationDevice.get());
                 }
 
                 // Serialize the operations on the application device before accessing from the composition device.
-                m_fenceValue++;
-                m_fenceOnApplicationDevice->signal(m_fenceValue);
-                m_fenceOnCompositionDevice->waitOnDevice(m_fenceValue);
-
-                image = m_images[m_lastReleasedImage.value()].get();
+                markApplicationWork();
             }
 
             TraceLoggingWriteStop(local, "Swapchain_GetLastReleasedImage", TLPArg(image, "Image"));
@@ -333,29 +641,48 @@ namespace {
                                    TLPArg(this, "Swapchain"),
                                    TLArg(m_lastReleasedImage.value_or(-1), "Index"));
 
-            if (!m_accessForWrite) {
-                throw std::runtime_error("Not a writable swapchain");
+            // Committing a readable swapchain hands the image back to the runtime once composition has read it.
+            if (!(m_accessForRead || m_accessForWrite)) {
+                throw std::runtime_error("Not a readable or writable swapchain");
             }
 
             if (m_lastReleasedImage.has_value()) {
-                // Serialize the operations on the composition device before copying to the application device or
-                // releasing the swapchain image.
-                m_fenceValue++;
-                m_fenceOnCompositionDevice->signal(m_fenceValue);
-                m_fenceOnApplicationDevice->waitOnDevice(m_fenceValue);
+                if (m_timeline) {
+                    // The operations on the composition device must be serialized before copying to the application
+                    // device or releasing the swapchain image. This is done once for all swapchains.
+                    m_timeline->deferCommit(this);
+                } else {
+                    completeCommit();
+                }
+            }
+
+            TraceLoggingWriteStop(local, "Swapchain_CommitLastReleasedImage");
+        }
 
-                if (m_bounceBufferOnApplicationDevice) {
+        // Called after the composition device was serialized with the application device.
+        void completeCommit() {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "Swapchain_CompleteCommit",
+                                   TLPArg(this, "Swapchain"),
+                                   TLArg(m_lastReleasedImage.value_or(-1), "Index"));
+
+            if (m_lastReleasedImage.has_value()) {
+                if (m_accessForWrite && m_bounceBuffer.onApplicationDevice) {
                     // The swapchain image wasn't shareable and we must perform a copy from a shareable texture written
                     // on the composition device.
-                    m_applicationDevice->copyTexture(m_bounceBufferOnApplicationDevice.get(),
-                                                     m_images[m_lastReleasedImage.value()]->getApplicationTexture());
+                    copyBounceBuffer(m_bounceBuffer.onApplicationDevice.get(),
+                                     m_applicationTextures[m_lastReleasedImage.value()].get());
+
+                    // The composition device must not overwrite the bounce buffer before the copy completes.
+                    markApplicationWork();
                 }
 
                 CHECK_XRCMD(xrReleaseSwapchainImage(m_swapchain, nullptr));
                 m_lastReleasedImage = {};
             }
 
-            TraceLoggingWriteStop(local, "Swapchain_CommitLastReleasedImage");
+            TraceLoggingWriteStop(local, "Swapchain_CompleteCommit");
         }
 
         const XrSwapchainCreateInfo& getInfoOnCompositionDevice() const override {
@@ -367,13 +694,23 @@ namespace {
         }
 
         ISwapchainImage* getImage(uint32_t index) const override {
-            return m_images[index].get();
+            return getOrCreateImage(index);
         }
 
         uint32_t getLength() const override {
             return (uint32_t)m_images.size();
         }
 
+        uint64_t getMemoryFootprint() const override {
+            std::unique_lock lock(m_imagesMutex);
+
+            return m_bounceBuffer.onCompositionDevice
+                       ? getTextureMemorySize(m_infoOnCompositionDevice,
+                                              m_compositionDevice->translateToGenericFormat(
+                                                  m_infoOnCompositionDevice.format))
+                       : 0;
+        }
+
         XrSwapchain getSwapchainHandle() const override {
             return m_swapchain;
         }
@@ -388,10 +725,123 @@ namespace {
             return subImage;
         }
 
+        void setSubmittedSubImages(const std::vector<XrSwapchainSubImage>& subImages) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "Swapchain_SetSubmittedSubImages", TLPArg(this, "Swapchain"), TLArg(subImages.size(), "Count"));
+
+            m_copyRegions.clear();
+
+            // Multisampled and depth textures can only be copied as whole subresources, and mip levels other than the
+            // first one are not described by the sub-images.
+            const bool canCopyRegions =
+                m_infoOnCompositionDevice.sampleCount == 1 && m_infoOnCompositionDevice.mipCount == 1 &&
+                !(m_infoOnCompositionDevice.usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+            if (canCopyRegions) {
+                const int32_t width = (int32_t)m_infoOnCompositionDevice.width;
+                const int32_t height = (int32_t)m_infoOnCompositionDevice.height;
+                for (const XrSwapchainSubImage& subImage : subImages) {
+                    if (subImage.imageArrayIndex >= m_infoOnCompositionDevice.arraySize) {
+                        continue;
+                    }
+
+                    // Clamp to the texture bounds, the copy is undefined otherwise.
+                    XrSwapchainSubImage region = subImage;
+                    const int32_t left = std::clamp(subImage.imageRect.offset.x, 0, width);
+                    const int32_t top = std::clamp(subImage.imageRect.offset.y, 0, height);
+                    const int32_t right =
+                        std::clamp(subImage.imageRect.offset.x + subImage.imageRect.extent.width, left, width);
+                    const int32_t bottom =
+                        std::clamp(subImage.imageRect.offset.y + subImage.imageRect.extent.height, top, height);
+                    region.imageRect.offset = {left, top};
+                    region.imageRect.extent = {right - left, bottom - top};
+                    if (!region.imageRect.extent.width || !region.imageRect.extent.height) {
+                        continue;
+                    }
+
+                    if (region.imageRect.extent.width == width && region.imageRect.extent.height == height &&
+                        m_infoOnCompositionDevice.arraySize == 1) {
+                        // The whole texture is used, a full copy is the fastest.
+                        m_copyRegions.clear();
+                        break;
+                    }
+
+                    TraceLoggingWriteTagged(local,
+                                            "Swapchain_SetSubmittedSubImages",
+                                            TLArg(region.imageRect.offset.x, "X"),
+                                            TLArg(region.imageRect.offset.y, "Y"),
+                                            TLArg(region.imageRect.extent.width, "Width"),
+                                            TLArg(region.imageRect.extent.height, "Height"),
+                                            TLArg(region.imageArrayIndex, "ImageArrayIndex"));
+                    m_copyRegions.push_back(region);
+                }
+            }
+
+            TraceLoggingWriteStop(
+                local, "Swapchain_SetSubmittedSubImages", TLArg(m_copyRegions.size(), "CopyRegionsCount"));
+        }
+
+        // Copy between the swapchain image and the bounce buffer, limited to the submitted regions when known.
+        void copyBounceBuffer(IGraphicsTexture* from, IGraphicsTexture* to) const {
+            m_texturePool->copy(m_applicationDevice, from, to, m_copyRegions);
+        }
+
+        ISwapchainImage* getOrCreateImage(uint32_t index) const {
+            std::unique_lock lock(m_imagesMutex);
+
+            if (m_images[index]) {
+                return m_images[index].get();
+            }
+
+            const std::shared_ptr<IGraphicsTexture>& textureOnApplicationDevice = m_applicationTextures[index];
+            std::unique_ptr<SwapchainImage> image;
+            if (m_isSameDevice) {
+                // Composition happens on the application device: use the swapchain images directly.
+                image = std::make_unique<SwapchainImage>(textureOnApplicationDevice, textureOnApplicationDevice, index);
+            } else if (m_canShareImages && textureOnApplicationDevice->isShareable()) {
+                const std::shared_ptr<IGraphicsTexture> textureOnCompositionDevice = m_compositionDevice->openTexture(
+                    textureOnApplicationDevice->getTextureHandle(), m_infoOnCompositionDevice);
+                image = std::make_unique<SwapchainImage>(
+                    textureOnApplicationDevice, textureOnCompositionDevice, index, m_timeline.get());
+            } else if (m_accessForRead || m_accessForWrite) {
+                // If the swapchain image isn't shareable, we will need a copy accessible on both the application and
+                // composition device, and make sure to perform copy operations as needed.
+                if (!m_bounceBuffer.onApplicationDevice) {
+                    m_bounceBuffer = m_texturePool->acquire(
+                        m_applicationDevice, m_infoOnApplicationDevice, m_infoOnCompositionDevice);
+                }
+                image = std::make_unique<SwapchainImage>(
+                    textureOnApplicationDevice, m_bounceBuffer.onCompositionDevice, index, m_timeline.get());
+            } else {
+                // The swapchain is never accessed during composition.
+                image = std::make_unique<SwapchainImage>(textureOnApplicationDevice, nullptr, index);
+            }
+
+            TraceLoggingWrite(g_traceProvider,
+                              "Swapchain_CreateImage",
+                              TLPArg(this, "Swapchain"),
+                              TLArg(index, "Index"),
+                              TLPArg(image.get(), "Image"));
+
+            m_images[index] = std::move(image);
+            return m_images[index].get();
+        }
+
+        // When composition happens on the application device, commands are already serialized.
+        void markApplicationWork() const {
+            if (m_timeline) {
+                m_timeline->markApplicationWork();
+            }
+        }
+
         const XrSwapchain m_swapchain;
         const int64_t m_formatOnApplicationDevice;
         IGraphicsDevice* const m_compositionDevice;
         IGraphicsDevice* const m_applicationDevice;
+        const std::shared_ptr<ITexturePool> m_texturePool;
+        const std::shared_ptr<FenceTimeline> m_timeline;
+        const bool m_isSameDevice;
+        const bool m_canShareImages;
         const bool m_accessForRead;
         const bool m_accessForWrite;
 
@@ -401,20 +851,36 @@ namespace {
         PFN_xrEnumerateSwapchainImages xrEnumerateSwapchainImages{nullptr};
         PFN_xrDestroySwapchain xrDestroySwapchain{nullptr};
 
+        const XrSwapchainCreateInfo m_infoOnApplicationDevice;
         XrSwapchainCreateInfo m_infoOnCompositionDevice;
 
-        std::vector<std::unique_ptr<ISwapchainImage>> m_images;
-        std::shared_ptr<IGraphicsTexture> m_bounceBufferOnApplicationDevice;
-        std::shared_ptr<IGraphicsTexture> m_bounceBufferOnCompositionDevice;
-        std::shared_ptr<IGraphicsFence> m_fenceOnApplicationDevice;
-        std::shared_ptr<IGraphicsFence> m_fenceOnCompositionDevice;
-        mutable uint64_t m_fenceValue{0};
+        std::vector<std::shared_ptr<IGraphicsTexture>> m_applicationTextures;
+        mutable std::mutex m_imagesMutex;
+        mutable std::vector<std::unique_ptr<ISwapchainImage>> m_images;
+        mutable SharedTexture m_bounceBuffer;
+        std::vector<XrSwapchainSubImage> m_copyRegions;
 
         std::mutex m_mutex;
         std::deque<uint32_t> m_acquiredImages;
         std::optional<uint32_t> m_lastReleasedImage{};
     };
 
+    void FenceTimeline::completeDeferredCommits() {
+        TraceLocalActivity(local);
+        TraceLoggingWriteStart(local, "FenceTimeline_CompleteDeferredCommits", TLPArg(this, "Timeline"));
+
+        std::unique_lock lock(m_commitsMutex);
+
+        const size_t count = m_deferredCommits.size();
+        std::vector<SubmittableSwapchain*> swapchains;
+        swapchains.swap(m_deferredCommits);
+        for (SubmittableSwapchain* swapchain : swapchains) {
+            swapchain->completeCommit();
+        }
+
+        TraceLoggingWriteStop(local, "FenceTimeline_CompleteDeferredCommits", TLArg(count, "Count"));
+    }
+
     // A non-submittable swapchain must be accessible on both the application & composition device, however because it
     // does not need to be submitted, we can create the textures ourselves to ensure shareability and avoid extra
     // copies.
@@ -422,40 +888,67 @@ namespace {
         NonSubmittableSwapchain(const XrSwapchainCreateInfo& infoOnApplicationDevice,
                                 IGraphicsDevice* applicationDevice,
                                 IGraphicsDevice* compositionDevice,
-                                SwapchainMode mode)
+                                std::shared_ptr<ITexturePool> texturePool,
+                                std::shared_ptr<FenceTimeline> timeline,
+                                SwapchainMode mode,
+                                uint32_t imageCount)
             : m_infoOnCompositionDevice(infoOnApplicationDevice),
-              m_formatOnApplicationDevice(infoOnApplicationDevice.format),
+              m_formatOnApplicationDevice(infoOnApplicationDevice.format), m_texturePool(texturePool),
+              m_timeline(timeline),
               m_accessForRead((mode & SwapchainMode::Read) == SwapchainMode::Read),
               m_accessForWrite((mode & SwapchainMode::Write) == SwapchainMode::Write) {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(local, "Swapchain_Create", TLArg("Non-Submittable", "Type"));
+            TraceLoggingWriteStart(
+                local, "Swapchain_Create", TLArg("Non-Submittable", "Type"), TLArg(imageCount, "ImageCount"));
+
+            if (imageCount < 2 || imageCount > 4) {
+                throw std::runtime_error("Invalid image count");
+            }
 
             // Translate from the app device format to the composition device format.
             m_infoOnCompositionDevice.format = compositionDevice->translateFromGenericFormat(
                 applicationDevice->translateToGenericFormat(infoOnApplicationDevice.format));
 
-            // We only need 2 textures since OpenXR only allows for 1 frame in-flight and we won't submit textures to a
-            // compositor that might need >2 images of history.
+            // 2 textures are enough since OpenXR only allows for 1 frame in-flight and we won't submit textures to a
+            // compositor that might need >2 images of history. More textures let the application render the next
+            // frames while the composition device still reads a previous one.
             // Make the textures available on the composition device.
-            for (uint32_t i = 0; i < 2; i++) {
-                const std::shared_ptr<IGraphicsTexture> textureOnCompositionDevice =
-                    compositionDevice->createTexture(m_infoOnCompositionDevice, true /* shareable */);
-                const std::shared_ptr<IGraphicsTexture> textureOnApplicationDevice = applicationDevice->openTexture(
-                    textureOnCompositionDevice->getTextureHandle(), infoOnApplicationDevice);
+            for (uint32_t i = 0; i < imageCount; i++) {
+                m_textures.push_back(
+                    m_texturePool->acquire(applicationDevice, infoOnApplicationDevice, m_infoOnCompositionDevice));
                 std::unique_ptr<SwapchainImage> image =
-                    std::make_unique<SwapchainImage>(textureOnApplicationDevice, textureOnCompositionDevice, i);
+                    std::make_unique<SwapchainImage>(m_textures.back().onApplicationDevice,
+                                                     m_textures.back().onCompositionDevice,
+                                                     i,
+                                                     m_timeline.get());
 
                 TraceLoggingWriteTagged(local, "Swapchain_Create", TLPArg(image.get(), "Image"));
 
                 m_images.push_back(std::move(image));
             }
+            m_memoryFootprint =
+                imageCount * getTextureMemorySize(m_infoOnCompositionDevice,
+                                                  compositionDevice->translateToGenericFormat(
+                                                      m_infoOnCompositionDevice.format));
 
-            TraceLoggingWriteStop(local, "Swapchain_Create", TLPArg(this, "Swapchain"));
+            TraceLoggingWriteStop(local,
+                                  "Swapchain_Create",
+                                  TLPArg(this, "Swapchain"),
+                                  TLArg(m_memoryFootprint, "MemoryFootprint"));
         }
 
         ~NonSubmittableSwapchain() override {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_Destroy", TLPArg(this, "Swapchain"));
+
+            if (m_timeline) {
+                m_timeline->waitForIdle();
+            }
+            m_images.clear();
+            for (SharedTexture& texture : m_textures) {
+                m_texturePool->release(std::move(texture), m_memoryFootprint / m_textures.size());
+            }
+
             TraceLoggingWriteStop(local, "Swapchain_Destroy");
         }
 
@@ -466,13 +959,25 @@ namespace {
             std::unique_lock lock(m_mutex);
 
             if (m_acquiredImages.size() == m_images.size()) {
-                throw std::runtime_error("No image available to acquire");
+                // Another thread might be holding all the images, but the caller might also be holding them itself.
+                if (!wait || !m_imageReleased.wait_for(lock, ImageReleaseTimeout, [&] {
+                        return m_acquiredImages.size() < m_images.size();
+                    })) {
+                    throw std::runtime_error("No image available to acquire");
+                }
             }
 
-            const uint32_t index = m_nextImage++;
+            // Images are acquired and released in order, so the next image in the ring is never held.
+            const uint32_t index = m_nextImage;
+            m_nextImage = (m_nextImage + 1) % (uint32_t)m_images.size();
             m_acquiredImages.push_back(index);
 
-            ISwapchainImage* const image = m_images[index].get();
+            SwapchainImage* const image = m_images[index].get();
+
+            // The composition of an earlier frame might still be reading the image on the composition device.
+            if (m_timeline) {
+                m_timeline->waitForCompositionOnApplication(image->getCompositionFenceValue());
+            }
 
             TraceLoggingWriteStop(
                 local, "Swapchain_AcquireImage", TLArg(index, "AcquiredIndex"), TLPArg(image, "Image"));
@@ -480,9 +985,10 @@ namespace {
             return image;
         }
 
-        void waitImage() override {
+        XrResult waitImage(XrDuration timeout) override {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(local, "Swapchain_WaitImage", TLPArg(this, "Swapchain"));
+            TraceLoggingWriteStart(
+                local, "Swapchain_WaitImage", TLPArg(this, "Swapchain"), TLArg(timeout, "Timeout"));
 
             std::unique_lock lock(m_mutex);
 
@@ -491,6 +997,9 @@ namespace {
             }
 
             TraceLoggingWriteStop(local, "Swapchain_WaitImage");
+
+            // The acquisition already waited for the composition to complete.
+            return XR_SUCCESS;
         }
 
         void releaseImage() override {
@@ -505,6 +1014,12 @@ namespace {
 
             m_lastReleasedImage = m_acquiredImages.front();
             m_acquiredImages.pop_front();
+            m_imageReleased.notify_all();
+
+            // The application might have written to the image.
+            if (m_timeline) {
+                m_timeline->markApplicationWork();
+            }
 
             TraceLoggingWriteStop(local, "Swapchain_ReleaseImage", TLArg(m_lastReleasedImage, "ReleasedIndex"));
         }
@@ -538,6 +1053,11 @@ namespace {
                 throw std::runtime_error("Not a writable swapchain");
             }
 
+            // The application might read the image.
+            if (m_timeline) {
+                m_timeline->markCompositionWork();
+            }
+
             TraceLoggingWriteStop(local, "Swapchain_CommitLastReleasedImage");
         }
 
@@ -557,6 +1077,10 @@ namespace {
             return (uint32_t)m_images.size();
         }
 
+        uint64_t getMemoryFootprint() const override {
+            return m_memoryFootprint;
+        }
+
         XrSwapchain getSwapchainHandle() const override {
             throw std::runtime_error("Not a submittable swapchain");
         }
@@ -565,28 +1089,128 @@ namespace {
             throw std::runtime_error("Not a submittable swapchain");
         }
 
+        void setSubmittedSubImages(const std::vector<XrSwapchainSubImage>& subImages) override {
+            throw std::runtime_error("Not a submittable swapchain");
+        }
+
         const int64_t m_formatOnApplicationDevice;
+        const std::shared_ptr<ITexturePool> m_texturePool;
+        const std::shared_ptr<FenceTimeline> m_timeline;
         const bool m_accessForRead;
         const bool m_accessForWrite;
 
         XrSwapchainCreateInfo m_infoOnCompositionDevice;
 
-        std::vector<std::unique_ptr<ISwapchainImage>> m_images;
+        std::vector<SharedTexture> m_textures;
+        std::vector<std::unique_ptr<SwapchainImage>> m_images;
+        uint64_t m_memoryFootprint{0};
 
         std::mutex m_mutex;
+        std::condition_variable m_imageReleased;
         uint32_t m_nextImage{0};
         std::deque<uint32_t> m_acquiredImages;
         uint32_t m_lastReleasedImage{};
     };
 
+    // Vulkan applications are composed on their own device, which avoids exporting their images and translating the
+    // fences. The other applications are composed on a Direct3D 11 device.
+    CompositionApi chooseCompositionApi(Api applicationApi) {
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+        if (applicationApi == Api::Vulkan) {
+            return CompositionApi::Vulkan;
+        }
+#endif
+#ifdef XR_USE_GRAPHICS_API_D3D11
+        return CompositionApi::D3D11;
+#else
+        throw std::runtime_error("Composition graphics API is not supported");
+#endif
+    }
+
+    // The formats preferred by the runtime for the swapchains of the application, in the generic (DXGI) namespace.
+    struct PreferredFormats {
+        DXGI_FORMAT color{DXGI_FORMAT_UNKNOWN};
+        DXGI_FORMAT srgbColor{DXGI_FORMAT_UNKNOWN};
+        DXGI_FORMAT depth{DXGI_FORMAT_UNKNOWN};
+    };
+
+    // The preferred formats only depend on the runtime, the application's graphics API and its adapter. The cache is
+    // owned by the factory, which lives as long as the instance (hence the runtime), so that the sessions re-created by
+    // the application do not enumerate the formats again.
+    struct PreferredFormatsCache {
+        struct Entry {
+            Api api;
+            LUID adapterLuid;
+            PreferredFormats formats;
+        };
+
+        std::optional<PreferredFormats> find(Api api, const LUID& adapterLuid) const {
+            std::unique_lock lock(mutex);
+            for (const Entry& entry : entries) {
+                if (entry.api == api && entry.adapterLuid.LowPart == adapterLuid.LowPart &&
+                    entry.adapterLuid.HighPart == adapterLuid.HighPart) {
+                    return entry.formats;
+                }
+            }
+            return {};
+        }
+
+        void insert(Api api, const LUID& adapterLuid, const PreferredFormats& formats) {
+            std::unique_lock lock(mutex);
+            entries.push_back({api, adapterLuid, formats});
+        }
+
+        mutable std::mutex mutex;
+        std::vector<Entry> entries;
+    };
+
+    // The composition devices created by the layer, with the textures allocated on them. Like the preferred formats,
+    // they are owned by the factory, so that the sessions re-created by the application on the same adapter reuse the
+    // device and the bounce buffers of the previous session.
+    struct CompositionDeviceCache {
+        struct Entry {
+            CompositionApi api;
+            LUID adapterLuid;
+            std::shared_ptr<IGraphicsDevice> device;
+            std::shared_ptr<ITexturePool> texturePool;
+        };
+
+        Entry getOrCreate(CompositionApi api,
+                          const LUID& adapterLuid,
+                          const std::function<std::shared_ptr<IGraphicsDevice>()>& createDevice) {
+            std::unique_lock lock(mutex);
+            for (const Entry& entry : entries) {
+                if (entry.api == api && entry.adapterLuid.LowPart == adapterLuid.LowPart &&
+                    entry.adapterLuid.HighPart == adapterLuid.HighPart) {
+                    return entry;
+                }
+            }
+
+            Entry entry{api, adapterLuid, createDevice()};
+            entry.texturePool = createTexturePool(entry.device.get(), TexturePoolMemoryBudget);
+            entries.push_back(entry);
+            return entry;
+        }
+
+        std::mutex mutex;
+        std::vector<Entry> entries;
+    };
+
     struct CompositionFramework : ICompositionFramework {
         CompositionFramework(const XrInstanceCreateInfo& instanceInfo,
                              XrInstance instance,
                              PFN_xrGetInstanceProcAddr xrGetInstanceProcAddr_,
                              const XrSessionCreateInfo& sessionInfo,
                              XrSession session,
-                             CompositionApi compositionApi)
-            : m_instance(instance), xrGetInstanceProcAddr(xrGetInstanceProcAddr_), m_session(session) {
+                             CompositionApi compositionApi,
+                             bool shareApplicationDevice,
+                             std::shared_ptr<PreferredFormatsCache> preferredFormatsCache,
+                             std::shared_ptr<CompositionDeviceCache> compositionDeviceCache,
+                             std::atomic<bool>& hasFailedSession)
+            : m_instance(instance), xrGetInstanceProcAddr(xrGetInstanceProcAddr_), m_session(session),
+              m_compositionApi(compositionApi), m_shareApplicationDevice(shareApplicationDevice),
+              m_preferredFormatsCache(std::move(preferredFormatsCache)),
+              m_compositionDeviceCache(std::move(compositionDeviceCache)), m_hasFailedSession(hasFailedSession) {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "CompositionFramework_Create", TLXArg(session, "Session"));
 
@@ -599,6 +1223,12 @@ namespace {
 #endif
 #ifdef XR_USE_GRAPHICS_API_D3D12
             bool has_XR_KHR_D3D12_enable = false;
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+            bool has_XR_KHR_vulkan_enable = false;
+#endif
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+            bool has_XR_KHR_opengl_enable = false;
 #endif
             for (uint32_t i = 0; i < instanceInfo.enabledExtensionCount; i++) {
                 const std::string_view extensionName(instanceInfo.enabledExtensionNames[i]);
@@ -612,6 +1242,17 @@ namespace {
                 if (extensionName == XR_KHR_D3D12_ENABLE_EXTENSION_NAME) {
                     has_XR_KHR_D3D12_enable = true;
                 }
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+                if (extensionName == XR_KHR_VULKAN_ENABLE_EXTENSION_NAME ||
+                    extensionName == XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME) {
+                    has_XR_KHR_vulkan_enable = true;
+                }
+#endif
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+                if (extensionName == XR_KHR_OPENGL_ENABLE_EXTENSION_NAME) {
+                    has_XR_KHR_opengl_enable = true;
+                }
 #endif
             }
 
@@ -631,6 +1272,21 @@ namespace {
                         internal::wrapApplicationDevice(*reinterpret_cast<const XrGraphicsBindingD3D12KHR*>(entry));
                     break;
                 }
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+                // XrGraphicsBindingVulkan2KHR is an alias of XrGraphicsBindingVulkanKHR.
+                if (has_XR_KHR_vulkan_enable && entry->type == XR_TYPE_GRAPHICS_BINDING_VULKAN_KHR) {
+                    m_applicationDevice =
+                        internal::wrapApplicationDevice(*reinterpret_cast<const XrGraphicsBindingVulkanKHR*>(entry));
+                    break;
+                }
+#endif
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+                if (has_XR_KHR_opengl_enable && entry->type == XR_TYPE_GRAPHICS_BINDING_OPENGL_WIN32_KHR) {
+                    m_applicationDevice = internal::wrapApplicationDevice(
+                        *reinterpret_cast<const XrGraphicsBindingOpenGLWin32KHR*>(entry));
+                    break;
+                }
 #endif
                 entry = entry->next;
             }
@@ -639,20 +1295,33 @@ namespace {
                 throw std::runtime_error("Application graphics API is not supported");
             }
 
-            // Create the device for composition according to the API layer's request.
-            switch (compositionApi) {
+            if (m_compositionApi == CompositionApi::Automatic) {
+                m_compositionApi = chooseCompositionApi(m_applicationDevice->getApi());
+            }
+            TraceLoggingWriteTagged(local,
+                                    "CompositionFramework_Create",
+                                    TLArg(xr::ToString(m_applicationDevice->getApi()).c_str(), "ApplicationApi"),
+                                    TLArg(xr::ToString(m_compositionApi).c_str(), "CompositionApi"));
+
+            // The composition device is created upon first use, so that sessions that never compose do not pay for a
+            // second device and its fences.
+            switch (m_compositionApi) {
 #ifdef XR_USE_GRAPHICS_API_D3D11
             case CompositionApi::D3D11:
-                m_compositionDevice = internal::createD3D11CompositionDevice(m_applicationDevice->getAdapterLuid());
+                break;
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+            case CompositionApi::Vulkan:
+                // Composing on the application's images avoids exporting them and translating the fences.
+                if (m_applicationDevice->getApi() != Api::Vulkan) {
+                    throw std::runtime_error("Vulkan composition requires a Vulkan application");
+                }
                 break;
 #endif
             default:
                 throw std::runtime_error("Composition graphics API is not supported");
             }
 
-            m_fenceOnCompositionDevice = m_compositionDevice->createFence();
-            m_fenceOnApplicationDevice = m_applicationDevice->openFence(m_fenceOnCompositionDevice->getFenceHandle());
-
             // Check for quirks.
             PFN_xrGetInstanceProperties xrGetInstanceProperties;
             CHECK_XRCMD(xrGetInstanceProcAddr(m_instance,
@@ -670,37 +1339,6 @@ namespace {
             }
 #endif
 
-            // Get the preferred formats for swapchains.
-            PFN_xrEnumerateSwapchainFormats xrEnumerateSwapchainFormats;
-            CHECK_XRCMD(xrGetInstanceProcAddr(m_instance,
-                                              "xrEnumerateSwapchainFormats",
-                                              reinterpret_cast<PFN_xrVoidFunction*>(&xrEnumerateSwapchainFormats)));
-            uint32_t formatsCount;
-            CHECK_XRCMD(xrEnumerateSwapchainFormats(m_session, 0, &formatsCount, nullptr));
-            std::vector<int64_t> formats(formatsCount);
-            CHECK_XRCMD(xrEnumerateSwapchainFormats(m_session, formatsCount, &formatsCount, formats.data()));
-            for (const int64_t formatOnApplicationDevice : formats) {
-                const DXGI_FORMAT format = m_applicationDevice->translateToGenericFormat(formatOnApplicationDevice);
-                const bool isDepth = isDepthFormat(format);
-                const bool isColor = !isDepth;
-                const bool isSRGB = isColor && isSRGBFormat(format);
-
-                if (m_preferredColorFormat == DXGI_FORMAT_UNKNOWN && isColor && !isSRGB) {
-                    m_preferredColorFormat = format;
-                }
-                if (m_preferredSRGBColorFormat == DXGI_FORMAT_UNKNOWN && isColor && isSRGB) {
-                    m_preferredSRGBColorFormat = format;
-                }
-                if (m_preferredDepthFormat == DXGI_FORMAT_UNKNOWN && isDepth) {
-                    m_preferredDepthFormat = format;
-                }
-            }
-            TraceLoggingWriteTagged(local,
-                                    "CompositionFramework_Create",
-                                    TLArg((int64_t)m_preferredColorFormat, "PreferredColorFormat"),
-                                    TLArg((int64_t)m_preferredSRGBColorFormat, "PreferredSRGBColorFormat"),
-                                    TLArg((int64_t)m_preferredDepthFormat, "PreferredDepthFormat"));
-
             TraceLoggingWriteStop(local, "CompositionFramework_Create", TLPArg(this, "CompositionFramework"));
         }
 
@@ -708,8 +1346,24 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "CompositionFramework_Destroy", TLXArg(m_session, "Session"));
 
-            if (m_fenceOnCompositionDevice) {
-                m_fenceOnCompositionDevice->waitOnCpu(m_fenceValue);
+            // Complete the queued compositions, which use the session data.
+            std::shared_ptr<ICompositionWorker> compositionWorker;
+            {
+                std::unique_lock lock(m_compositionWorkerMutex);
+                compositionWorker = std::move(m_compositionWorker);
+            }
+            compositionWorker.reset();
+
+            // The session data may hold swapchains, which must be destroyed while the devices are alive.
+            m_sessionData.reset();
+
+            if (isCompositionDeviceReady()) {
+                if (m_timeline) {
+                    m_timeline->waitForIdle();
+                }
+
+                // The textures outlive the session when the composition device is kept for the next sessions.
+                m_texturePool->forgetApplicationDevice(m_applicationDevice.get());
             }
 
             TraceLoggingWriteStop(local, "CompositionFramework_Destroy");
@@ -736,7 +1390,8 @@ namespace {
         }
 
         std::shared_ptr<ISwapchain> createSwapchain(const XrSwapchainCreateInfo& infoOnApplicationDevice,
-                                                    SwapchainMode mode) override {
+                                                    SwapchainMode mode,
+                                                    uint32_t imageCount) override {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "CompositionFramework_CreateSwapchain",
@@ -750,7 +1405,10 @@ namespace {
                                    TLArg(infoOnApplicationDevice.mipCount, "MipCount"),
                                    TLArg(infoOnApplicationDevice.sampleCount, "SampleCount"),
                                    TLArg(infoOnApplicationDevice.usageFlags, "UsageFlags"),
-                                   TLArg((int)mode, "Mode"));
+                                   TLArg((int)mode, "Mode"),
+                                   TLArg(imageCount, "ImageCount"));
+
+            ensureCompositionDevice();
 
             std::shared_ptr<ISwapchain> result;
             if ((mode & SwapchainMode::Submit) == SwapchainMode::Submit) {
@@ -764,14 +1422,24 @@ namespace {
                                                                 infoOnApplicationDevice,
                                                                 m_applicationDevice.get(),
                                                                 m_compositionDevice.get(),
+                                                                m_texturePool,
+                                                                m_timeline,
                                                                 mode,
                                                                 m_overrideShareable);
             } else {
-                result = std::make_shared<NonSubmittableSwapchain>(
-                    infoOnApplicationDevice, m_applicationDevice.get(), m_compositionDevice.get(), mode);
+                result = std::make_shared<NonSubmittableSwapchain>(infoOnApplicationDevice,
+                                                                   m_applicationDevice.get(),
+                                                                   m_compositionDevice.get(),
+                                                                   m_texturePool,
+                                                                   m_timeline,
+                                                                   mode,
+                                                                   imageCount);
             }
 
-            TraceLoggingWriteStop(local, "CompositionFramework_CreateSwapchain", TLPArg(result.get(), "Swapchain"));
+            TraceLoggingWriteStop(local,
+                                  "CompositionFramework_CreateSwapchain",
+                                  TLPArg(result.get(), "Swapchain"),
+                                  TLArg(result->getMemoryFootprint(), "MemoryFootprint"));
 
             return result;
         }
@@ -780,11 +1448,10 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "CompositionFramework_SerializePreComposition", TLXArg(m_session, "Session"));
 
-            std::unique_lock lock(m_fenceMutex);
-
-            m_fenceValue++;
-            m_fenceOnApplicationDevice->signal(m_fenceValue);
-            m_fenceOnCompositionDevice->waitOnDevice(m_fenceValue);
+            // The synchronization happens when the first swapchain texture is accessed on the composition device.
+            if (isCompositionDeviceReady() && m_timeline) {
+                m_timeline->markApplicationWork();
+            }
 
             TraceLoggingWriteStop(local, "CompositionFramework_SerializePreComposition");
         }
@@ -794,50 +1461,283 @@ namespace {
             TraceLoggingWriteStart(
                 local, "CompositionFramework_SerializePostComposition", TLXArg(m_session, "Session"));
 
-            std::unique_lock lock(m_fenceMutex);
-
-            m_fenceValue++;
-            m_fenceOnCompositionDevice->signal(m_fenceValue);
-            m_fenceOnApplicationDevice->waitOnDevice(m_fenceValue);
+            if (isCompositionDeviceReady() && m_timeline) {
+                m_timeline->syncCompositionToApplication();
+                m_timeline->completeDeferredCommits();
+            }
 
             TraceLoggingWriteStop(local, "CompositionFramework_SerializePostComposition");
         }
 
+        void enableCompositionWorker(uint32_t maxQueuedFrames) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "CompositionFramework_EnableCompositionWorker",
+                                   TLXArg(m_session, "Session"),
+                                   TLArg(maxQueuedFrames, "MaxQueuedFrames"));
+
+            ensureCompositionDevice();
+            if (m_isSameDevice) {
+                // Composition would interleave with the application's commands on the same context.
+                throw std::runtime_error("Composition worker is not supported on the application device");
+            }
+            if (m_applicationDevice->getApi() == Api::Vulkan) {
+                // The application's VkQueue must be externally synchronized, and the layer cannot lock it.
+                throw std::runtime_error("Composition worker is not supported with Vulkan");
+            }
+            if (m_applicationDevice->getApi() == Api::OpenGL) {
+                // The application's GL context is current on the application's thread only.
+                throw std::runtime_error("Composition worker is not supported with OpenGL");
+            }
+
+            std::unique_lock lock(m_compositionWorkerMutex);
+            if (m_compositionWorker) {
+                throw std::runtime_error("Composition worker is already enabled");
+            }
+
+#ifdef XR_USE_GRAPHICS_API_D3D11
+            if (m_applicationDevice->getApi() == Api::D3D11) {
+                // The copies and fence operations on the application's context will happen on the worker thread.
+                Microsoft::WRL::ComPtr<ID3D11Multithread> multithread;
+                CHECK_HRCMD(m_applicationDevice->getNativeContext<D3D11>()->QueryInterface(
+                    IID_PPV_ARGS(multithread.ReleaseAndGetAddressOf())));
+                multithread->SetMultithreadProtected(TRUE);
+            }
+#endif
+
+            m_compositionWorker = createCompositionWorker(maxQueuedFrames);
+
+            TraceLoggingWriteStop(local, "CompositionFramework_EnableCompositionWorker");
+        }
+
+        bool isCompositionWorkerEnabled() const override {
+            std::unique_lock lock(m_compositionWorkerMutex);
+            return m_compositionWorker != nullptr;
+        }
+
+        XrResult queueComposition(std::function<XrResult()> job) override {
+            std::shared_ptr<ICompositionWorker> compositionWorker;
+            {
+                std::unique_lock lock(m_compositionWorkerMutex);
+                compositionWorker = m_compositionWorker;
+            }
+            if (compositionWorker) {
+                return compositionWorker->queue(std::move(job));
+            }
+
+            try {
+                return job();
+            } catch (std::exception& exc) {
+                TraceLoggingWrite(
+                    g_traceProvider, "CompositionFramework_Composition_Error", TLArg(exc.what(), "Error"));
+                ErrorLog(fmt::format("Composition: {}\n", exc.what()));
+                return XR_ERROR_RUNTIME_FAILURE;
+            }
+        }
+
+        void waitForComposition() override {
+            std::shared_ptr<ICompositionWorker> compositionWorker;
+            {
+                std::unique_lock lock(m_compositionWorkerMutex);
+                compositionWorker = m_compositionWorker;
+            }
+            if (compositionWorker) {
+                compositionWorker->waitForIdle();
+            }
+        }
+
+        SynchronizationStatistics getSynchronizationStatistics() const override {
+            return isCompositionDeviceReady() && m_timeline ? m_timeline->getStatistics()
+                                                            : SynchronizationStatistics{};
+        }
+
+        TexturePoolStatistics getTexturePoolStatistics() const override {
+            return isCompositionDeviceReady() ? m_texturePool->getStatistics() : TexturePoolStatistics{};
+        }
+
         IGraphicsDevice* getCompositionDevice() const override {
+            ensureCompositionDevice();
             return m_compositionDevice.get();
         }
 
+        bool isCompositionDeviceAvailable() const override {
+            createCompositionDevice();
+            return isCompositionDeviceReady();
+        }
+
         IGraphicsDevice* getApplicationDevice() const override {
             return m_applicationDevice.get();
         }
 
         int64_t getPreferredSwapchainFormatOnApplicationDevice(XrSwapchainUsageFlags usageFlags,
                                                                bool preferSRGB) const override {
+            ensurePreferredFormats();
+
             DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
             if (usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT) {
-                format = preferSRGB ? m_preferredSRGBColorFormat : m_preferredColorFormat;
+                format = preferSRGB ? m_preferredFormats.srgbColor : m_preferredFormats.color;
             } else if (usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
-                format = m_preferredDepthFormat;
+                format = m_preferredFormats.depth;
             }
             return m_applicationDevice->translateFromGenericFormat(format);
         }
 
+        // Create the device for composition according to the API layer's request, and the objects depending on it.
+        void ensureCompositionDevice() const {
+            createCompositionDevice();
+            if (!isCompositionDeviceReady()) {
+                throw std::runtime_error("Composition device is not available");
+            }
+        }
+
+        // The creation is attempted once. A failure is reported to the factory, and the session is not composed.
+        void createCompositionDevice() const {
+            std::call_once(m_compositionDeviceCreated, [&] {
+                TraceLocalActivity(local);
+                TraceLoggingWriteStart(
+                    local, "CompositionFramework_CreateCompositionDevice", TLXArg(m_session, "Session"));
+
+                try {
+                    switch (m_compositionApi) {
+#ifdef XR_USE_GRAPHICS_API_D3D11
+                    case CompositionApi::D3D11:
+                        if (m_shareApplicationDevice && m_applicationDevice->getApi() == Api::D3D11) {
+                            m_compositionDevice = m_applicationDevice;
+                        } else {
+                            const LUID adapterLuid = m_applicationDevice->getAdapterLuid();
+                            const CompositionDeviceCache::Entry entry = m_compositionDeviceCache->getOrCreate(
+                                m_compositionApi, adapterLuid, [&] {
+                                    return internal::createD3D11CompositionDevice(adapterLuid);
+                                });
+                            m_compositionDevice = entry.device;
+                            m_texturePool = entry.texturePool;
+                        }
+                        break;
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+                    case CompositionApi::Vulkan:
+                        m_compositionDevice = m_applicationDevice;
+                        break;
+#endif
+                    default:
+                        throw std::runtime_error("Composition graphics API is not supported");
+                    }
+                    m_isSameDevice = m_compositionDevice == m_applicationDevice;
+
+                    if (!m_isSameDevice) {
+                        m_timeline =
+                            std::make_shared<FenceTimeline>(m_applicationDevice.get(), m_compositionDevice.get());
+                    }
+                    if (!m_texturePool) {
+                        // The application's device might not outlive the session.
+                        m_texturePool = createTexturePool(m_compositionDevice.get(), TexturePoolMemoryBudget);
+                    }
+
+                    m_isCompositionDeviceReady.store(true, std::memory_order_release);
+                } catch (std::exception& exc) {
+                    TraceLoggingWriteTagged(
+                        local, "CompositionFramework_CreateCompositionDevice_Error", TLArg(exc.what(), "Error"));
+                    ErrorLog(fmt::format("Failed to create the composition device: {}\n", exc.what()));
+                    m_timeline.reset();
+                    m_texturePool.reset();
+                    m_compositionDevice.reset();
+                    m_hasFailedSession = true;
+                }
+
+                TraceLoggingWriteStop(local,
+                                      "CompositionFramework_CreateCompositionDevice",
+                                      TLArg(isCompositionDeviceReady(), "Ready"),
+                                      TLArg(m_isSameDevice, "SharesApplicationDevice"));
+            });
+        }
+
+        // Whether there might be composition work to serialize.
+        bool isCompositionDeviceReady() const {
+            return m_isCompositionDeviceReady.load(std::memory_order_acquire);
+        }
+
+        void ensurePreferredFormats() const {
+            std::call_once(m_preferredFormatsProbed, [&] {
+                TraceLocalActivity(local);
+                TraceLoggingWriteStart(
+                    local, "CompositionFramework_ProbePreferredFormats", TLXArg(m_session, "Session"));
+
+                const Api api = m_applicationDevice->getApi();
+                const LUID adapterLuid = m_applicationDevice->getAdapterLuid();
+                const std::optional<PreferredFormats> cachedFormats = m_preferredFormatsCache->find(api, adapterLuid);
+                if (cachedFormats.has_value()) {
+                    m_preferredFormats = cachedFormats.value();
+                    TraceLoggingWriteStop(local,
+                                          "CompositionFramework_ProbePreferredFormats",
+                                          TLArg(true, "Cached"),
+                                          TLArg((int64_t)m_preferredFormats.color, "PreferredColorFormat"),
+                                          TLArg((int64_t)m_preferredFormats.srgbColor, "PreferredSRGBColorFormat"),
+                                          TLArg((int64_t)m_preferredFormats.depth, "PreferredDepthFormat"));
+                    return;
+                }
+
+                PFN_xrEnumerateSwapchainFormats xrEnumerateSwapchainFormats;
+                CHECK_XRCMD(
+                    xrGetInstanceProcAddr(m_instance,
+                                          "xrEnumerateSwapchainFormats",
+                                          reinterpret_cast<PFN_xrVoidFunction*>(&xrEnumerateSwapchainFormats)));
+                uint32_t formatsCount;
+                CHECK_XRCMD(xrEnumerateSwapchainFormats(m_session, 0, &formatsCount, nullptr));
+                std::vector<int64_t> formats(formatsCount);
+                CHECK_XRCMD(xrEnumerateSwapchainFormats(m_session, formatsCount, &formatsCount, formats.data()));
+                for (const int64_t formatOnApplicationDevice : formats) {
+                    const DXGI_FORMAT format =
+                        m_applicationDevice->translateToGenericFormat(formatOnApplicationDevice);
+                    const FormatInfo& info = getFormatInfo(format);
+                    const bool isColor = !info.isDepth;
+
+                    if (m_preferredFormats.color == DXGI_FORMAT_UNKNOWN && isColor && !info.isSRGB) {
+                        m_preferredFormats.color = format;
+                    }
+                    if (m_preferredFormats.srgbColor == DXGI_FORMAT_UNKNOWN && isColor && info.isSRGB) {
+                        m_preferredFormats.srgbColor = format;
+                    }
+                    if (m_preferredFormats.depth == DXGI_FORMAT_UNKNOWN && info.isDepth) {
+                        m_preferredFormats.depth = format;
+                    }
+                }
+                m_preferredFormatsCache->insert(api, adapterLuid, m_preferredFormats);
+
+                TraceLoggingWriteStop(local,
+                                      "CompositionFramework_ProbePreferredFormats",
+                                      TLArg(false, "Cached"),
+                                      TLArg((int64_t)m_preferredFormats.color, "PreferredColorFormat"),
+                                      TLArg((int64_t)m_preferredFormats.srgbColor, "PreferredSRGBColorFormat"),
+                                      TLArg((int64_t)m_preferredFormats.depth, "PreferredDepthFormat"));
+            });
+        }
+
         const XrInstance m_instance;
         const PFN_xrGetInstanceProcAddr xrGetInstanceProcAddr;
         const XrSession m_session;
+        CompositionApi m_compositionApi;
+        const bool m_shareApplicationDevice;
 
         std::unique_ptr<ICompositionSessionData> m_sessionData;
 
-        std::shared_ptr<IGraphicsDevice> m_compositionDevice;
         std::shared_ptr<IGraphicsDevice> m_applicationDevice;
-        DXGI_FORMAT m_preferredColorFormat{DXGI_FORMAT_UNKNOWN};
-        DXGI_FORMAT m_preferredSRGBColorFormat{DXGI_FORMAT_UNKNOWN};
-        DXGI_FORMAT m_preferredDepthFormat{DXGI_FORMAT_UNKNOWN};
 
-        std::mutex m_fenceMutex;
-        std::shared_ptr<IGraphicsFence> m_fenceOnApplicationDevice;
-        std::shared_ptr<IGraphicsFence> m_fenceOnCompositionDevice;
-        uint64_t m_fenceValue{0};
+        // Created upon first use.
+        mutable std::once_flag m_compositionDeviceCreated;
+        mutable std::atomic<bool> m_isCompositionDeviceReady{false};
+        mutable std::shared_ptr<IGraphicsDevice> m_compositionDevice;
+        mutable bool m_isSameDevice{false};
+        mutable std::shared_ptr<ITexturePool> m_texturePool;
+        mutable std::shared_ptr<FenceTimeline> m_timeline;
+
+        mutable std::mutex m_compositionWorkerMutex;
+        std::shared_ptr<ICompositionWorker> m_compositionWorker;
+
+        const std::shared_ptr<PreferredFormatsCache> m_preferredFormatsCache;
+        const std::shared_ptr<CompositionDeviceCache> m_compositionDeviceCache;
+        std::atomic<bool>& m_hasFailedSession;
+        mutable std::once_flag m_preferredFormatsProbed;
+        mutable PreferredFormats m_preferredFormats;
 
 #ifdef XR_USE_GRAPHICS_API_D3D12
         std::optional<bool> m_overrideShareable;
@@ -850,13 +1750,15 @@ namespace {
         CompositionFrameworkFactory(const XrInstanceCreateInfo& instanceInfo,
                                     XrInstance instance,
                                     PFN_xrGetInstanceProcAddr xrGetInstanceProcAddr_,
-                                    CompositionApi compositionApi)
+                                    CompositionApi compositionApi,
+                                    bool shareApplicationDevice)
             : m_instanceInfo(instanceInfo), m_instance(instance), xrGetInstanceProcAddr(xrGetInstanceProcAddr_),
-              m_compositionApi(compositionApi) {
+              m_compositionApi(compositionApi), m_shareApplicationDevice(shareApplicationDevice) {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "CompositionFrameworkFactory_Create",
-                                   TLArg(xr::ToString(compositionApi).c_str(), "CompositionApi"));
+                                   TLArg(xr::ToString(compositionApi).c_str(), "CompositionApi"),
+                                   TLArg(shareApplicationDevice, "ShareApplicationDevice"));
 
             {
                 std::unique_lock lock(factoryMutex);
@@ -874,6 +1776,22 @@ namespace {
             }
             m_instanceInfo.enabledExtensionNames = m_instanceExtensionsArray.data();
 
+            for (const auto& extensionName : m_instanceExtensions) {
+#ifdef XR_USE_GRAPHICS_API_D3D11
+                m_hasSupportedGraphicsApi |= extensionName == XR_KHR_D3D11_ENABLE_EXTENSION_NAME;
+#endif
+#ifdef XR_USE_GRAPHICS_API_D3D12
+                m_hasSupportedGraphicsApi |= extensionName == XR_KHR_D3D12_ENABLE_EXTENSION_NAME;
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+                m_hasSupportedGraphicsApi |= extensionName == XR_KHR_VULKAN_ENABLE_EXTENSION_NAME ||
+                                             extensionName == XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME;
+#endif
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+                m_hasSupportedGraphicsApi |= extensionName == XR_KHR_OPENGL_ENABLE_EXTENSION_NAME;
+#endif
+            }
+
             // xrCreateSession() and xrDestroySession() function pointers are chained.
 
             TraceLoggingWriteStop(
@@ -899,6 +1817,9 @@ namespace {
             } else if (functionName == "xrDestroySession") {
                 xrDestroySession = reinterpret_cast<PFN_xrDestroySession>(*function);
                 *function = reinterpret_cast<PFN_xrVoidFunction>(hookDestroySession);
+            } else if (functionName == "xrBeginFrame") {
+                xrBeginFrame = reinterpret_cast<PFN_xrBeginFrame>(*function);
+                *function = reinterpret_cast<PFN_xrVoidFunction>(hookBeginFrame);
             }
         }
 
@@ -914,6 +1835,10 @@ namespace {
             return it->second.get();
         }
 
+        bool isCompositionSupported() const override {
+            return m_hasSupportedGraphicsApi && !m_hasFailedSession;
+        }
+
         XrResult xrCreateSession_subst(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session) {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "CompositionFrameworkFactory_CreateSession");
@@ -924,16 +1849,21 @@ namespace {
 
                 try {
                     m_sessions.insert_or_assign(*session,
-                                                std::move(std::make_unique<CompositionFramework>(m_instanceInfo,
-                                                                                                 m_instance,
-                                                                                                 xrGetInstanceProcAddr,
-                                                                                                 *createInfo,
-                                                                                                 *session,
-                                                                                                 m_compositionApi)));
+                                                std::make_unique<CompositionFramework>(m_instanceInfo,
+                                                                                       m_instance,
+                                                                                       xrGetInstanceProcAddr,
+                                                                                       *createInfo,
+                                                                                       *session,
+                                                                                       m_compositionApi,
+                                                                                       m_shareApplicationDevice,
+                                                                                       m_preferredFormatsCache,
+                                                                                       m_compositionDeviceCache,
+                                                                                       m_hasFailedSession));
                 } catch (std::exception& exc) {
                     TraceLoggingWriteTagged(
                         local, "CompositionFrameworkFactory_CreateSession_Error", TLArg(exc.what(), "Error"));
                     ErrorLog(fmt::format("xrCreateSession: {}\n", exc.what()));
+                    m_hasFailedSession = true;
                 }
             }
 
@@ -949,14 +1879,18 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "CompositionFrameworkFactory_DestroySession", TLXArg(session, "Session"));
 
+            // The composition worker might query the factory: destroy the framework outside of the lock.
+            std::unique_ptr<CompositionFramework> compositionFramework;
             {
                 std::unique_lock lock(m_sessionsMutex);
 
                 auto it = m_sessions.find(session);
                 if (it != m_sessions.end()) {
+                    compositionFramework = std::move(it->second);
                     m_sessions.erase(it);
                 }
             }
+            compositionFramework.reset();
             const XrResult result = xrDestroySession(session);
 
             TraceLoggingWriteStop(
@@ -965,18 +1899,43 @@ namespace {
             return result;
         }
 
+        XrResult xrBeginFrame_subst(XrSession session, const XrFrameBeginInfo* frameBeginInfo) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "CompositionFrameworkFactory_BeginFrame", TLXArg(session, "Session"));
+
+            // The upstream xrEndFrame() of the previous frame must happen before xrBeginFrame().
+            ICompositionFramework* const compositionFramework = getCompositionFramework(session);
+            if (compositionFramework) {
+                compositionFramework->waitForComposition();
+            }
+            const XrResult result = xrBeginFrame(session, frameBeginInfo);
+
+            TraceLoggingWriteStop(
+                local, "CompositionFrameworkFactory_BeginFrame", TLArg(xr::ToCString(result), "Result"));
+
+            return result;
+        }
+
         const XrInstance m_instance;
         const PFN_xrGetInstanceProcAddr xrGetInstanceProcAddr;
         const CompositionApi m_compositionApi;
+        const bool m_shareApplicationDevice;
         XrInstanceCreateInfo m_instanceInfo;
         std::vector<std::string> m_instanceExtensions;
         std::vector<const char*> m_instanceExtensionsArray;
+        bool m_hasSupportedGraphicsApi{false};
 
         std::mutex m_sessionsMutex;
+        std::atomic<bool> m_hasFailedSession{false};
         std::unordered_map<XrSession, std::unique_ptr<CompositionFramework>> m_sessions;
 
+        const std::shared_ptr<PreferredFormatsCache> m_preferredFormatsCache{std::make_shared<PreferredFormatsCache>()};
+        const std::shared_ptr<CompositionDeviceCache> m_compositionDeviceCache{
+            std::make_shared<CompositionDeviceCache>()};
+
         PFN_xrCreateSession xrCreateSession{nullptr};
         PFN_xrDestroySession xrDestroySession{nullptr};
+        PFN_xrBeginFrame xrBeginFrame{nullptr};
 
         static inline std::mutex factoryMutex;
         static inline CompositionFrameworkFactory* factory{nullptr};
@@ -990,6 +1949,10 @@ namespace {
         static XrResult XRAPI_CALL hookDestroySession(XrSession session) {
             return factory->xrDestroySession_subst(session);
         }
+
+        static XrResult XRAPI_CALL hookBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo) {
+            return factory->xrBeginFrame_subst(session, frameBeginInfo);
+        }
     };
 
 } // namespace
@@ -1000,9 +1963,10 @@ namespace openxr_api_layer::utils::graphics {
     createCompositionFrameworkFactory(const XrInstanceCreateInfo& instanceInfo,
                                       XrInstance instance,
                                       PFN_xrGetInstanceProcAddr xrGetInstanceProcAddr,
-                                      CompositionApi compositionApi) {
+                                      CompositionApi compositionApi,
+                                      bool shareApplicationDevice) {
         return std::make_shared<CompositionFrameworkFactory>(
-            instanceInfo, instance, xrGetInstanceProcAddr, compositionApi);
+            instanceInfo, instance, xrGetInstanceProcAddr, compositionApi, shareApplicationDevice);
     }
 
 } // namespace openxr_api_layer::utils::graphics
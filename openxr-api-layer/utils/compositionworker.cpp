@@ -0,0 +1,142 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "graphics.h"
+#include <log.h>
+
+namespace {
+
+    using namespace openxr_api_layer::log;
+    using namespace openxr_api_layer::utils::graphics;
+
+    struct CompositionWorker : ICompositionWorker {
+        CompositionWorker(uint32_t maxQueuedJobs) : m_maxQueuedJobs(std::max(maxQueuedJobs, 1u)) {
+            m_thread = std::thread([&] { workerThread(); });
+        }
+
+        ~CompositionWorker() override {
+            {
+                std::unique_lock lock(m_mutex);
+                m_stop = true;
+            }
+            m_queueChanged.notify_all();
+            m_thread.join();
+        }
+
+        XrResult queue(std::function<XrResult()> job) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "CompositionWorker_Queue", TLPArg(this, "Worker"));
+
+            std::unique_lock lock(m_mutex);
+
+            // Report the failures of earlier jobs with the next submission.
+            const XrResult result = m_deferredResult;
+            m_deferredResult = XR_SUCCESS;
+
+            m_queueChanged.wait(lock, [&] { return m_queue.size() < m_maxQueuedJobs; });
+            m_queue.push_back(std::move(job));
+            lock.unlock();
+            m_queueChanged.notify_all();
+
+            TraceLoggingWriteStop(local, "CompositionWorker_Queue", TLArg(xr::ToCString(result), "Result"));
+
+            return result;
+        }
+
+        void waitForIdle() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "CompositionWorker_WaitForIdle", TLPArg(this, "Worker"));
+
+            std::unique_lock lock(m_mutex);
+            m_queueChanged.wait(lock, [&] { return m_queue.empty() && !m_isRunning; });
+
+            TraceLoggingWriteStop(local, "CompositionWorker_WaitForIdle");
+        }
+
+        XrResult run(const std::function<XrResult()>& job) {
+            try {
+                return job();
+            } catch (std::exception& exc) {
+                TraceLoggingWrite(g_traceProvider, "CompositionWorker_Error", TLArg(exc.what(), "Error"));
+                ErrorLog(fmt::format("Composition: {}\n", exc.what()));
+                return XR_ERROR_RUNTIME_FAILURE;
+            }
+        }
+
+        void workerThread() {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "CompositionWorker_Thread", TLPArg(this, "Worker"));
+
+            while (true) {
+                std::function<XrResult()> job;
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_queueChanged.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+                    if (m_queue.empty()) {
+                        break;
+                    }
+
+                    job = std::move(m_queue.front());
+                    m_queue.pop_front();
+                    m_isRunning = true;
+                }
+                m_queueChanged.notify_all();
+
+                const XrResult result = run(job);
+
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_isRunning = false;
+                    if (XR_FAILED(result) && XR_SUCCEEDED(m_deferredResult)) {
+                        m_deferredResult = result;
+                    }
+                }
+                m_queueChanged.notify_all();
+            }
+
+            TraceLoggingWriteStop(local, "CompositionWorker_Thread");
+        }
+
+        const uint32_t m_maxQueuedJobs;
+
+        std::mutex m_mutex;
+        std::condition_variable m_queueChanged;
+        std::deque<std::function<XrResult()>> m_queue;
+        bool m_isRunning{false};
+        bool m_stop{false};
+        XrResult m_deferredResult{XR_SUCCESS};
+
+        std::thread m_thread;
+    };
+
+} // namespace
+
+namespace openxr_api_layer::utils::graphics {
+
+    std::shared_ptr<ICompositionWorker> createCompositionWorker(uint32_t maxQueuedJobs) {
+        return std::make_shared<CompositionWorker>(maxQueuedJobs);
+    }
+
+} // namespace openxr_api_layer::utils::graphics
@@ -29,6 +29,9 @@
 
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+
+#include <d3dcompiler.h>
 
 namespace {
 
@@ -37,6 +40,133 @@ namespace {
 
     constexpr bool PreferNtHandle = false;
 
+    // The shaders for scaleTextureRegion(), compiled upon first use. All filters clamp to the source region, since
+    // views are often packed side by side in one texture.
+    const char* const ScalingShaders = R"_(
+cbuffer Parameters : register(b0) {
+    float2 SourceOffset;
+    float2 SourceExtent;
+    float2 InvTextureSize;
+};
+
+Texture2DArray Source : register(t0);
+SamplerState LinearClamp : register(s0);
+
+void vsMain(uint id : SV_VertexID, out float4 position : SV_Position, out float2 uv : TEXCOORD0) {
+    uv = float2((id << 1) & 2, id & 2);
+    position = float4(uv * float2(2, -2) + float2(-1, 1), 0, 1);
+}
+
+float4 loadClamped(int2 texel) {
+    const int2 minTexel = int2(SourceOffset);
+    const int2 maxTexel = int2(SourceOffset + SourceExtent) - 1;
+    return Source.Load(int4(clamp(texel, minTexel, maxTexel), 0, 0));
+}
+
+float lanczos2(float x) {
+    x = abs(x);
+    if (x < 1e-5) {
+        return 1;
+    }
+    if (x >= 2) {
+        return 0;
+    }
+    const float pix = 3.14159265 * x;
+    return 2 * sin(pix) * sin(pix * 0.5) / (pix * pix);
+}
+
+float luma(float4 color) {
+    return dot(color.rgb, float3(0.299, 0.587, 0.114));
+}
+
+float4 psBilinear(float4 position : SV_Position, float2 uv : TEXCOORD0) : SV_Target {
+    const float2 p =
+        clamp(SourceOffset + uv * SourceExtent, SourceOffset + 0.5, SourceOffset + SourceExtent - 0.5);
+    return Source.SampleLevel(LinearClamp, float3(p * InvTextureSize, 0), 0);
+}
+
+float4 psLanczos(float4 position : SV_Position, float2 uv : TEXCOORD0) : SV_Target {
+    const float2 p = SourceOffset + uv * SourceExtent - 0.5;
+    const int2 base = int2(floor(p));
+    const float2 f = p - base;
+
+    float4 color = 0;
+    float weightSum = 0;
+    float4 minColor = 1e30;
+    float4 maxColor = -1e30;
+    [unroll] for (int y = -1; y <= 2; y++) {
+        const float wy = lanczos2(y - f.y);
+        [unroll] for (int x = -1; x <= 2; x++) {
+            const float4 texel = loadClamped(base + int2(x, y));
+            const float w = lanczos2(x - f.x) * wy;
+            color += texel * w;
+            weightSum += w;
+            if (x >= 0 && x <= 1 && y >= 0 && y <= 1) {
+                minColor = min(minColor, texel);
+                maxColor = max(maxColor, texel);
+            }
+        }
+    }
+    return clamp(color / weightSum, minColor, maxColor);
+}
+
+float4 psEdgeAdaptive(float4 position : SV_Position, float2 uv : TEXCOORD0) : SV_Target {
+    const float2 p = SourceOffset + uv * SourceExtent - 0.5;
+    const int2 base = int2(floor(p));
+    const float2 f = p - base;
+
+    float4 texels[4][4];
+    [unroll] for (int ty = 0; ty < 4; ty++) {
+        [unroll] for (int tx = 0; tx < 4; tx++) {
+            texels[ty][tx] = loadClamped(base + int2(tx - 1, ty - 1));
+        }
+    }
+
+    // Luma gradient at the sample position, interpolated from the central 2x2 texels.
+    float2 gradient = 0;
+    [unroll] for (int gy = 1; gy <= 2; gy++) {
+        [unroll] for (int gx = 1; gx <= 2; gx++) {
+            const float w = (gx == 1 ? 1 - f.x : f.x) * (gy == 1 ? 1 - f.y : f.y);
+            gradient += w * float2(luma(texels[gy][gx + 1]) - luma(texels[gy][gx - 1]),
+                                   luma(texels[gy + 1][gx]) - luma(texels[gy - 1][gx]));
+        }
+    }
+    const float gradientLength = length(gradient);
+    const float edge = saturate(gradientLength * 4);
+    const float2 across = gradientLength > 1e-5 ? gradient / gradientLength : float2(1, 0);
+    const float2 along = float2(-across.y, across.x);
+
+    // Widen the kernel along the edge and narrow it across the edge.
+    const float scaleAlong = lerp(1, 0.5, edge);
+    const float scaleAcross = lerp(1, 1.4, edge);
+
+    float4 color = 0;
+    float weightSum = 0;
+    float4 minColor = 1e30;
+    float4 maxColor = -1e30;
+    [unroll] for (int y = 0; y < 4; y++) {
+        [unroll] for (int x = 0; x < 4; x++) {
+            const float2 d = float2(x - 1, y - 1) - f;
+            const float w = lanczos2(length(float2(dot(d, along) * scaleAlong, dot(d, across) * scaleAcross)));
+            color += texels[y][x] * w;
+            weightSum += w;
+            if (x >= 1 && x <= 2 && y >= 1 && y <= 2) {
+                minColor = min(minColor, texels[y][x]);
+                maxColor = max(maxColor, texels[y][x]);
+            }
+        }
+    }
+    return clamp(color / max(weightSum, 1e-5), minColor, maxColor);
+}
+)_";
+
+    struct ScalingConstants {
+        float sourceOffset[2];
+        float sourceExtent[2];
+        float invTextureSize[2];
+        float padding[2];
+    };
+
     struct D3D11Timer : IGraphicsTimer {
         D3D11Timer(ID3D11Device* device) {
             TraceLocalActivity(local);
@@ -119,6 +249,125 @@ namespace {
         mutable bool m_valid{false};
     };
 
+    struct D3D11TimerPool : IGraphicsTimerPool {
+        D3D11TimerPool(ID3D11Device* device, uint32_t frameLatency) : m_slots(std::max(frameLatency, 1u)) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D11TimerPool_Create", TLArg(frameLatency, "FrameLatency"));
+
+            device->GetImmediateContext(m_context.ReleaseAndGetAddressOf());
+
+            for (Slot& slot : m_slots) {
+                D3D11_QUERY_DESC queryDesc;
+                ZeroMemory(&queryDesc, sizeof(D3D11_QUERY_DESC));
+                queryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+                CHECK_HRCMD(device->CreateQuery(&queryDesc, slot.timeStampDis.ReleaseAndGetAddressOf()));
+                queryDesc.Query = D3D11_QUERY_TIMESTAMP;
+                CHECK_HRCMD(device->CreateQuery(&queryDesc, slot.timeStampStart.ReleaseAndGetAddressOf()));
+                CHECK_HRCMD(device->CreateQuery(&queryDesc, slot.timeStampEnd.ReleaseAndGetAddressOf()));
+            }
+
+            TraceLoggingWriteStop(local, "D3D11TimerPool_Create", TLPArg(this, "TimerPool"));
+        }
+
+        ~D3D11TimerPool() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D11TimerPool_Destroy", TLPArg(this, "TimerPool"));
+            TraceLoggingWriteStop(local, "D3D11TimerPool_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::D3D11;
+        }
+
+        void start(uint64_t frameId) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "D3D11TimerPool_Start", TLPArg(this, "TimerPool"), TLArg(frameId, "FrameId"));
+
+            // Restarting the queries discards any measurement that was not collected.
+            Slot& slot = m_slots[frameId % m_slots.size()];
+            m_context->Begin(slot.timeStampDis.Get());
+            m_context->End(slot.timeStampStart.Get());
+            slot.frameId = frameId;
+            slot.state = SlotState::Started;
+
+            TraceLoggingWriteStop(local, "D3D11TimerPool_Start");
+        }
+
+        void stop(uint64_t frameId) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "D3D11TimerPool_Stop", TLPArg(this, "TimerPool"), TLArg(frameId, "FrameId"));
+
+            Slot& slot = m_slots[frameId % m_slots.size()];
+            if (slot.state == SlotState::Started && slot.frameId == frameId) {
+                m_context->End(slot.timeStampEnd.Get());
+                m_context->End(slot.timeStampDis.Get());
+                slot.state = SlotState::Stopped;
+            }
+
+            TraceLoggingWriteStop(local, "D3D11TimerPool_Stop");
+        }
+
+        std::vector<TimerMeasurement> resolve() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D11TimerPool_Resolve", TLPArg(this, "TimerPool"));
+
+            std::vector<Slot*> stoppedSlots;
+            for (Slot& slot : m_slots) {
+                if (slot.state == SlotState::Stopped) {
+                    stoppedSlots.push_back(&slot);
+                }
+            }
+            std::sort(stoppedSlots.begin(), stoppedSlots.end(), [](const Slot* a, const Slot* b) {
+                return a->frameId < b->frameId;
+            });
+
+            std::vector<TimerMeasurement> measurements;
+            for (Slot* slot : stoppedSlots) {
+                // Queries complete in order: stop at the first one that is not ready. Do not flush, so that polling
+                // does not disturb the application's submissions.
+                D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disData{};
+                if (m_context->GetData(slot->timeStampDis.Get(),
+                                       &disData,
+                                       sizeof(D3D11_QUERY_DATA_TIMESTAMP_DISJOINT),
+                                       D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+                    break;
+                }
+
+                UINT64 startime = 0, endtime = 0;
+                if (m_context->GetData(slot->timeStampStart.Get(),
+                                       &startime,
+                                       sizeof(UINT64),
+                                       D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK &&
+                    m_context->GetData(
+                        slot->timeStampEnd.Get(), &endtime, sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK &&
+                    !disData.Disjoint) {
+                    measurements.push_back(
+                        {slot->frameId, static_cast<uint64_t>(((endtime - startime) * 1e6) / disData.Frequency)});
+                }
+                slot->state = SlotState::Idle;
+            }
+
+            TraceLoggingWriteStop(local, "D3D11TimerPool_Resolve", TLArg(measurements.size(), "Count"));
+
+            return measurements;
+        }
+
+        enum class SlotState { Idle, Started, Stopped };
+
+        struct Slot {
+            ComPtr<ID3D11Query> timeStampDis;
+            ComPtr<ID3D11Query> timeStampStart;
+            ComPtr<ID3D11Query> timeStampEnd;
+            uint64_t frameId{0};
+            SlotState state{SlotState::Idle};
+        };
+
+        ComPtr<ID3D11DeviceContext> m_context;
+        std::vector<Slot> m_slots;
+    };
+
     struct D3D11Fence : IGraphicsFence {
         D3D11Fence(ID3D11Fence* fence, bool shareable) : m_fence(fence), m_isShareable(shareable) {
             TraceLocalActivity(local);
@@ -187,20 +436,26 @@ namespace {
             TraceLoggingWriteStop(local, "D3D11Fence_Wait");
         }
 
-        void waitOnCpu(uint64_t value) override {
+        bool waitOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            signal(value);
+            return waitForValueOnCpu(value, policy);
+        }
+
+        bool waitForValueOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(
-                local, "D3D11Fence_Wait", TLPArg(this, "Fence"), TLArg("Host", "WaitType"), TLArg(value, "Value"));
+            TraceLoggingWriteStart(local,
+                                   "D3D11Fence_Wait",
+                                   TLPArg(this, "Fence"),
+                                   TLArg("Host", "WaitType"),
+                                   TLArg(value, "Value"),
+                                   TLArg(policy.spinCount, "SpinCount"),
+                                   TLArg(policy.timeoutMs, "TimeoutMs"));
 
-            wil::unique_handle eventHandle;
-            CHECK_HRCMD(m_context->Signal(m_fence.Get(), value));
-            m_context->Flush();
-            *eventHandle.put() = CreateEventEx(nullptr, L"D3D Fence", 0, EVENT_ALL_ACCESS);
-            CHECK_HRCMD(m_fence->SetEventOnCompletion(value, eventHandle.get()));
-            WaitForSingleObject(eventHandle.get(), INFINITE);
-            ResetEvent(eventHandle.get());
+            const bool completed = internal::waitForFenceOnCpu(m_fence.Get(), value, policy);
 
-            TraceLoggingWriteStop(local, "D3D11Fence_Wait");
+            TraceLoggingWriteStop(local, "D3D11Fence_Wait", TLArg(completed, "Completed"));
+
+            return completed;
         }
 
         bool isShareable() const override {
@@ -324,6 +579,138 @@ namespace {
         bool m_useNtHandle{false};
     };
 
+    // Readback through staging textures, whose completion is tracked with event queries.
+    struct D3D11Readback : IGraphicsReadback {
+        D3D11Readback(ID3D11Device* device, DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t depth)
+            : m_format(format), m_slots(std::max(depth, 1u)) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "D3D11Readback_Create",
+                                   TLArg((int)format, "Format"),
+                                   TLArg(width, "Width"),
+                                   TLArg(height, "Height"),
+                                   TLArg(depth, "Depth"));
+
+            device->GetImmediateContext(m_context.ReleaseAndGetAddressOf());
+
+            D3D11_TEXTURE2D_DESC desc{};
+            desc.Format = format;
+            desc.Width = width;
+            desc.Height = height;
+            desc.ArraySize = 1;
+            desc.MipLevels = 1;
+            desc.SampleDesc.Count = 1;
+            desc.Usage = D3D11_USAGE_STAGING;
+            desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+            D3D11_QUERY_DESC queryDesc{};
+            queryDesc.Query = D3D11_QUERY_EVENT;
+            for (Slot& slot : m_slots) {
+                CHECK_HRCMD(device->CreateTexture2D(&desc, nullptr, slot.staging.ReleaseAndGetAddressOf()));
+                CHECK_HRCMD(device->CreateQuery(&queryDesc, slot.completion.ReleaseAndGetAddressOf()));
+            }
+
+            TraceLoggingWriteStop(local, "D3D11Readback_Create", TLPArg(this, "Readback"));
+        }
+
+        bool enqueue(IGraphicsTexture* texture, const XrRect2Di& rect, uint32_t arraySlice, uint64_t tag) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "D3D11Readback_Enqueue",
+                                   TLPArg(this, "Readback"),
+                                   TLPArg(texture, "Texture"),
+                                   TLArg(rect.offset.x, "X"),
+                                   TLArg(rect.offset.y, "Y"),
+                                   TLArg(rect.extent.width, "Width"),
+                                   TLArg(rect.extent.height, "Height"),
+                                   TLArg(arraySlice, "ArraySlice"),
+                                   TLArg(tag, "Tag"));
+
+            Slot& slot = m_slots[m_nextSlot % m_slots.size()];
+            if (slot.isPending) {
+                TraceLoggingWriteStop(local, "D3D11Readback_Enqueue", TLArg(false, "Enqueued"));
+                return false;
+            }
+
+            D3D11_BOX box{};
+            box.left = rect.offset.x;
+            box.top = rect.offset.y;
+            box.front = 0;
+            box.right = rect.offset.x + rect.extent.width;
+            box.bottom = rect.offset.y + rect.extent.height;
+            box.back = 1;
+            m_context->CopySubresourceRegion(
+                slot.staging.Get(),
+                0,
+                0,
+                0,
+                0,
+                texture->getNativeTexture<D3D11>(),
+                D3D11CalcSubresource(0, arraySlice, texture->getInfo().mipCount),
+                &box);
+            m_context->End(slot.completion.Get());
+            slot.tag = tag;
+            slot.extent = rect.extent;
+            slot.isPending = true;
+            m_nextSlot++;
+
+            TraceLoggingWriteStop(local, "D3D11Readback_Enqueue", TLArg(true, "Enqueued"));
+
+            return true;
+        }
+
+        bool poll(const std::function<void(uint64_t tag, const ReadbackImage& image)>& callback) override {
+            Slot& slot = m_slots[m_oldestSlot % m_slots.size()];
+            // Do not flush, so that polling does not disturb the application's submissions.
+            if (!slot.isPending ||
+                m_context->GetData(slot.completion.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+                return false;
+            }
+
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D11Readback_Poll", TLPArg(this, "Readback"), TLArg(slot.tag, "Tag"));
+
+            D3D11_MAPPED_SUBRESOURCE mapped{};
+            const HRESULT hr =
+                m_context->Map(slot.staging.Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+            if (hr == DXGI_ERROR_WAS_STILL_DRAWING) {
+                TraceLoggingWriteStop(local, "D3D11Readback_Poll", TLArg(false, "Collected"));
+                return false;
+            }
+            CHECK_HRCMD(hr);
+
+            // Release the slot even if the callback throws.
+            auto release = wil::scope_exit([&] {
+                m_context->Unmap(slot.staging.Get(), 0);
+                slot.isPending = false;
+                m_oldestSlot++;
+            });
+            callback(slot.tag,
+                     ReadbackImage{reinterpret_cast<const uint8_t*>(mapped.pData),
+                                   (uint32_t)slot.extent.width,
+                                   (uint32_t)slot.extent.height,
+                                   mapped.RowPitch,
+                                   (int64_t)m_format});
+
+            TraceLoggingWriteStop(local, "D3D11Readback_Poll", TLArg(true, "Collected"));
+
+            return true;
+        }
+
+        struct Slot {
+            ComPtr<ID3D11Texture2D> staging;
+            ComPtr<ID3D11Query> completion;
+            uint64_t tag{0};
+            XrExtent2Di extent{};
+            bool isPending{false};
+        };
+
+        const DXGI_FORMAT m_format;
+        ComPtr<ID3D11DeviceContext> m_context;
+        std::vector<Slot> m_slots;
+        uint64_t m_nextSlot{0};
+        uint64_t m_oldestSlot{0};
+    };
+
     struct D3D11GraphicsDevice : IGraphicsDevice {
         D3D11GraphicsDevice(ID3D11Device* device) : m_device(device) {
             TraceLocalActivity(local);
@@ -374,6 +761,10 @@ namespace {
             return std::make_shared<D3D11Timer>(m_device.Get());
         }
 
+        std::shared_ptr<IGraphicsTimerPool> createTimerPool(uint32_t frameLatency) override {
+            return std::make_shared<D3D11TimerPool>(m_device.Get(), frameLatency);
+        }
+
         std::shared_ptr<IGraphicsFence> createFence(bool shareable) override {
             ComPtr<ID3D11Fence> fence;
             CHECK_HRCMD(
@@ -474,6 +865,13 @@ namespace {
             return result;
         }
 
+        std::shared_ptr<IGraphicsReadback> createReadback(int64_t format,
+                                                          uint32_t width,
+                                                          uint32_t height,
+                                                          uint32_t depth) override {
+            return std::make_shared<D3D11Readback>(m_device.Get(), (DXGI_FORMAT)format, width, height, depth);
+        }
+
         void copyTexture(IGraphicsTexture* from, IGraphicsTexture* to) override {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "D3D11Texture_Copy", TLPArg(from, "Source"), TLPArg(to, "Destination"));
@@ -483,6 +881,176 @@ namespace {
             TraceLoggingWriteStop(local, "D3D11Texture_Copy");
         }
 
+        void copyTextureRegion(IGraphicsTexture* from,
+                               const XrRect2Di& fromRect,
+                               uint32_t fromArraySlice,
+                               IGraphicsTexture* to,
+                               const XrOffset2Di& toOffset,
+                               uint32_t toArraySlice,
+                               uint32_t mipLevel) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "D3D11Texture_CopyRegion",
+                                   TLPArg(from, "Source"),
+                                   TLArg(fromRect.offset.x, "SourceX"),
+                                   TLArg(fromRect.offset.y, "SourceY"),
+                                   TLArg(fromRect.extent.width, "Width"),
+                                   TLArg(fromRect.extent.height, "Height"),
+                                   TLArg(fromArraySlice, "SourceArraySlice"),
+                                   TLPArg(to, "Destination"),
+                                   TLArg(toOffset.x, "DestinationX"),
+                                   TLArg(toOffset.y, "DestinationY"),
+                                   TLArg(toArraySlice, "DestinationArraySlice"),
+                                   TLArg(mipLevel, "MipLevel"));
+
+            D3D11_BOX box{};
+            box.left = fromRect.offset.x;
+            box.top = fromRect.offset.y;
+            box.front = 0;
+            box.right = fromRect.offset.x + fromRect.extent.width;
+            box.bottom = fromRect.offset.y + fromRect.extent.height;
+            box.back = 1;
+            m_context->CopySubresourceRegion(
+                to->getNativeTexture<D3D11>(),
+                D3D11CalcSubresource(mipLevel, toArraySlice, to->getInfo().mipCount),
+                toOffset.x,
+                toOffset.y,
+                0,
+                from->getNativeTexture<D3D11>(),
+                D3D11CalcSubresource(mipLevel, fromArraySlice, from->getInfo().mipCount),
+                &box);
+
+            TraceLoggingWriteStop(local, "D3D11Texture_CopyRegion");
+        }
+
+        // The draw runs in its own context state, so that the application's pipeline state is preserved when the
+        // composition device is the application's device.
+        void scaleTextureRegion(IGraphicsTexture* from,
+                                const XrRect2Di& fromRect,
+                                uint32_t fromArraySlice,
+                                int64_t fromFormat,
+                                IGraphicsTexture* to,
+                                const XrRect2Di& toRect,
+                                uint32_t toArraySlice,
+                                int64_t toFormat,
+                                ScalingFilter filter) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "D3D11Texture_ScaleRegion",
+                                   TLPArg(from, "Source"),
+                                   TLArg(fromRect.offset.x, "SourceX"),
+                                   TLArg(fromRect.offset.y, "SourceY"),
+                                   TLArg(fromRect.extent.width, "SourceWidth"),
+                                   TLArg(fromRect.extent.height, "SourceHeight"),
+                                   TLArg(fromArraySlice, "SourceArraySlice"),
+                                   TLPArg(to, "Destination"),
+                                   TLArg(toRect.offset.x, "DestinationX"),
+                                   TLArg(toRect.offset.y, "DestinationY"),
+                                   TLArg(toRect.extent.width, "DestinationWidth"),
+                                   TLArg(toRect.extent.height, "DestinationHeight"),
+                                   TLArg(toArraySlice, "DestinationArraySlice"),
+                                   TLArg((int)filter, "Filter"));
+
+            if (!m_scalingVertexShader) {
+                initializeScaling();
+            }
+
+            // Views are created for each call: swapchain textures come and go with the application's swapchains.
+            ComPtr<ID3D11ShaderResourceView> srv;
+            {
+                D3D11_SHADER_RESOURCE_VIEW_DESC desc{};
+                desc.Format = (DXGI_FORMAT)fromFormat;
+                desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.MostDetailedMip = 0;
+                desc.Texture2DArray.MipLevels = 1;
+                desc.Texture2DArray.FirstArraySlice = fromArraySlice;
+                desc.Texture2DArray.ArraySize = 1;
+                CHECK_HRCMD(m_device->CreateShaderResourceView(
+                    from->getNativeTexture<D3D11>(), &desc, srv.ReleaseAndGetAddressOf()));
+            }
+            ComPtr<ID3D11RenderTargetView> rtv;
+            {
+                D3D11_RENDER_TARGET_VIEW_DESC desc{};
+                desc.Format = (DXGI_FORMAT)toFormat;
+                desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.MipSlice = 0;
+                desc.Texture2DArray.FirstArraySlice = toArraySlice;
+                desc.Texture2DArray.ArraySize = 1;
+                CHECK_HRCMD(m_device->CreateRenderTargetView(
+                    to->getNativeTexture<D3D11>(), &desc, rtv.ReleaseAndGetAddressOf()));
+            }
+
+            {
+                D3D11_MAPPED_SUBRESOURCE mappedConstants;
+                CHECK_HRCMD(m_context->Map(m_scalingConstants.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedConstants));
+                ScalingConstants* const constants = reinterpret_cast<ScalingConstants*>(mappedConstants.pData);
+                constants->sourceOffset[0] = (float)fromRect.offset.x;
+                constants->sourceOffset[1] = (float)fromRect.offset.y;
+                constants->sourceExtent[0] = (float)fromRect.extent.width;
+                constants->sourceExtent[1] = (float)fromRect.extent.height;
+                constants->invTextureSize[0] = 1.f / from->getInfo().width;
+                constants->invTextureSize[1] = 1.f / from->getInfo().height;
+                m_context->Unmap(m_scalingConstants.Get(), 0);
+            }
+
+            D3D11_VIEWPORT viewport{};
+            viewport.TopLeftX = (float)toRect.offset.x;
+            viewport.TopLeftY = (float)toRect.offset.y;
+            viewport.Width = (float)toRect.extent.width;
+            viewport.Height = (float)toRect.extent.height;
+            viewport.MaxDepth = 1.f;
+
+            ComPtr<ID3DDeviceContextState> applicationState;
+            m_context1->SwapDeviceContextState(m_scalingState.Get(), applicationState.ReleaseAndGetAddressOf());
+
+            m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            m_context->VSSetShader(m_scalingVertexShader.Get(), nullptr, 0);
+            m_context->PSSetShader(m_scalingPixelShaders[(size_t)filter].Get(), nullptr, 0);
+            m_context->PSSetConstantBuffers(0, 1, m_scalingConstants.GetAddressOf());
+            m_context->PSSetShaderResources(0, 1, srv.GetAddressOf());
+            m_context->PSSetSamplers(0, 1, m_linearClampSampler.GetAddressOf());
+            m_context->RSSetViewports(1, &viewport);
+            m_context->OMSetRenderTargets(1, rtv.GetAddressOf(), nullptr);
+            m_context->Draw(3, 0);
+
+            // Unbind the views so the textures can be used as copy sources or render targets afterwards.
+            m_context->ClearState();
+            m_context1->SwapDeviceContextState(applicationState.Get(), nullptr);
+
+            TraceLoggingWriteStop(local, "D3D11Texture_ScaleRegion");
+        }
+
+        void clearTexture(IGraphicsTexture* texture,
+                          uint32_t arraySlice,
+                          int64_t format,
+                          const XrColor4f& color) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "D3D11Texture_Clear",
+                                   TLPArg(texture, "Texture"),
+                                   TLArg(arraySlice, "ArraySlice"),
+                                   TLArg(color.r, "R"),
+                                   TLArg(color.g, "G"),
+                                   TLArg(color.b, "B"),
+                                   TLArg(color.a, "A"));
+
+            ComPtr<ID3D11RenderTargetView> rtv;
+            {
+                D3D11_RENDER_TARGET_VIEW_DESC desc{};
+                desc.Format = (DXGI_FORMAT)format;
+                desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.MipSlice = 0;
+                desc.Texture2DArray.FirstArraySlice = arraySlice;
+                desc.Texture2DArray.ArraySize = 1;
+                CHECK_HRCMD(m_device->CreateRenderTargetView(
+                    texture->getNativeTexture<D3D11>(), &desc, rtv.ReleaseAndGetAddressOf()));
+            }
+            const float clearColor[] = {color.r, color.g, color.b, color.a};
+            m_context->ClearRenderTargetView(rtv.Get(), clearColor);
+
+            TraceLoggingWriteStop(local, "D3D11Texture_Clear");
+        }
+
         GenericFormat translateToGenericFormat(int64_t format) const override {
             return (DXGI_FORMAT)format;
         }
@@ -495,11 +1063,98 @@ namespace {
             return m_adapterLuid;
         }
 
+        CommandListStatistics getCommandListStatistics() const override {
+            return {};
+        }
+
+        ComPtr<ID3DBlob> compileScalingShader(const char* entryPoint, const char* target) const {
+            ComPtr<ID3DBlob> code;
+            ComPtr<ID3DBlob> errors;
+            const HRESULT hr = D3DCompile(ScalingShaders,
+                                          strlen(ScalingShaders),
+                                          "scaling.hlsl",
+                                          nullptr,
+                                          nullptr,
+                                          entryPoint,
+                                          target,
+                                          D3DCOMPILE_OPTIMIZATION_LEVEL3,
+                                          0,
+                                          code.ReleaseAndGetAddressOf(),
+                                          errors.ReleaseAndGetAddressOf());
+            if (FAILED(hr) && errors) {
+                ErrorLog(fmt::format("Failed to compile {}: {}\n",
+                                     entryPoint,
+                                     std::string_view(reinterpret_cast<const char*>(errors->GetBufferPointer()),
+                                                      errors->GetBufferSize())));
+            }
+            CHECK_HRCMD(hr);
+            return code;
+        }
+
+        void initializeScaling() {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D11GraphicsDevice_InitializeScaling", TLPArg(this, "Device"));
+
+            {
+                const ComPtr<ID3DBlob> code = compileScalingShader("vsMain", "vs_5_0");
+                CHECK_HRCMD(m_device->CreateVertexShader(code->GetBufferPointer(),
+                                                         code->GetBufferSize(),
+                                                         nullptr,
+                                                         m_scalingVertexShader.ReleaseAndGetAddressOf()));
+            }
+            const char* const pixelShaders[] = {"psBilinear", "psLanczos", "psEdgeAdaptive"};
+            static_assert(ARRAYSIZE(pixelShaders) == ARRAYSIZE(m_scalingPixelShaders));
+            for (size_t i = 0; i < ARRAYSIZE(pixelShaders); i++) {
+                const ComPtr<ID3DBlob> code = compileScalingShader(pixelShaders[i], "ps_5_0");
+                CHECK_HRCMD(m_device->CreatePixelShader(code->GetBufferPointer(),
+                                                        code->GetBufferSize(),
+                                                        nullptr,
+                                                        m_scalingPixelShaders[i].ReleaseAndGetAddressOf()));
+            }
+            {
+                D3D11_SAMPLER_DESC desc{};
+                desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+                desc.AddressU = desc.AddressV = desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+                desc.MaxLOD = D3D11_FLOAT32_MAX;
+                CHECK_HRCMD(m_device->CreateSamplerState(&desc, m_linearClampSampler.ReleaseAndGetAddressOf()));
+            }
+            {
+                D3D11_BUFFER_DESC desc{};
+                desc.ByteWidth = sizeof(ScalingConstants);
+                desc.Usage = D3D11_USAGE_DYNAMIC;
+                desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+                CHECK_HRCMD(m_device->CreateBuffer(&desc, nullptr, m_scalingConstants.ReleaseAndGetAddressOf()));
+            }
+            {
+                ComPtr<ID3D11Device1> device1;
+                CHECK_HRCMD(m_device->QueryInterface(IID_PPV_ARGS(device1.ReleaseAndGetAddressOf())));
+                CHECK_HRCMD(m_context->QueryInterface(IID_PPV_ARGS(m_context1.ReleaseAndGetAddressOf())));
+                const D3D_FEATURE_LEVEL featureLevel = m_device->GetFeatureLevel();
+                CHECK_HRCMD(device1->CreateDeviceContextState(0,
+                                                              &featureLevel,
+                                                              1,
+                                                              D3D11_SDK_VERSION,
+                                                              __uuidof(ID3D11Device),
+                                                              nullptr,
+                                                              m_scalingState.ReleaseAndGetAddressOf()));
+            }
+
+            TraceLoggingWriteStop(local, "D3D11GraphicsDevice_InitializeScaling");
+        }
+
         const ComPtr<ID3D11Device> m_device;
         LUID m_adapterLuid{};
 
         ComPtr<ID3D11Device5> m_deviceForFencesAndNtHandles;
         ComPtr<ID3D11DeviceContext> m_context;
+
+        ComPtr<ID3D11VertexShader> m_scalingVertexShader;
+        ComPtr<ID3D11PixelShader> m_scalingPixelShaders[3];
+        ComPtr<ID3D11SamplerState> m_linearClampSampler;
+        ComPtr<ID3D11Buffer> m_scalingConstants;
+        ComPtr<ID3D11DeviceContext1> m_context1;
+        ComPtr<ID3DDeviceContextState> m_scalingState;
     };
 
 } // namespace
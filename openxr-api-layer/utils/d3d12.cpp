@@ -163,6 +163,190 @@ namespace {
         mutable bool m_valid{false};
     };
 
+    struct D3D12TimerPool : IGraphicsTimerPool {
+        D3D12TimerPool(ID3D12Device* device, ID3D12CommandQueue* queue, uint32_t frameLatency)
+            : m_queue(queue), m_slots(std::max(frameLatency, 1u)) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D12TimerPool_Create", TLArg(frameLatency, "FrameLatency"));
+
+            // Create the command contexts.
+            for (Slot& slot : m_slots) {
+                for (uint32_t i = 0; i < 2; i++) {
+                    CHECK_HRCMD(device->CreateCommandAllocator(
+                        D3D12_COMMAND_LIST_TYPE_DIRECT,
+                        IID_PPV_ARGS(slot.commandAllocator[i].ReleaseAndGetAddressOf())));
+                    slot.commandAllocator[i]->SetName(L"Timer Pool Command Allocator");
+                    CHECK_HRCMD(
+                        device->CreateCommandList(0,
+                                                  D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                  slot.commandAllocator[i].Get(),
+                                                  nullptr,
+                                                  IID_PPV_ARGS(slot.commandList[i].ReleaseAndGetAddressOf())));
+                    slot.commandList[i]->SetName(L"Timer Pool Command List");
+                    CHECK_HRCMD(slot.commandList[i]->Close());
+                }
+            }
+            CHECK_HRCMD(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+            m_fence->SetName(L"Timer Pool Readback Fence");
+
+            // Create the query heap and readback resources, with 2 timestamps per slot.
+            D3D12_QUERY_HEAP_DESC heapDesc{};
+            heapDesc.Count = static_cast<UINT>(2 * m_slots.size());
+            heapDesc.NodeMask = 0;
+            heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+            CHECK_HRCMD(device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(m_queryHeap.ReleaseAndGetAddressOf())));
+            m_queryHeap->SetName(L"Timestamp Pool Query Heap");
+
+            D3D12_HEAP_PROPERTIES heapType{};
+            heapType.Type = D3D12_HEAP_TYPE_READBACK;
+            heapType.CreationNodeMask = heapType.VisibleNodeMask = 1;
+            D3D12_RESOURCE_DESC readbackDesc{};
+            readbackDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+            readbackDesc.Width = heapDesc.Count * sizeof(uint64_t);
+            readbackDesc.Height = readbackDesc.DepthOrArraySize = readbackDesc.MipLevels =
+                readbackDesc.SampleDesc.Count = 1;
+            readbackDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+            CHECK_HRCMD(device->CreateCommittedResource(&heapType,
+                                                        D3D12_HEAP_FLAG_NONE,
+                                                        &readbackDesc,
+                                                        D3D12_RESOURCE_STATE_COPY_DEST,
+                                                        nullptr,
+                                                        IID_PPV_ARGS(m_queryReadbackBuffer.ReleaseAndGetAddressOf())));
+            m_queryReadbackBuffer->SetName(L"Query Pool Readback Buffer");
+
+            TraceLoggingWriteStop(local, "D3D12TimerPool_Create", TLPArg(this, "TimerPool"));
+        }
+
+        ~D3D12TimerPool() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D12TimerPool_Destroy", TLPArg(this, "TimerPool"));
+
+            // The command allocators must not be released while the GPU still uses them.
+            if (m_fenceValue) {
+                internal::waitForFenceOnCpu(m_fence.Get(), m_fenceValue, {});
+            }
+
+            TraceLoggingWriteStop(local, "D3D12TimerPool_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::D3D12;
+        }
+
+        void start(uint64_t frameId) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "D3D12TimerPool_Start", TLPArg(this, "TimerPool"), TLArg(frameId, "FrameId"));
+
+            const size_t index = frameId % m_slots.size();
+            Slot& slot = m_slots[index];
+
+            // Never wait for the GPU: if the slot's previous measurement is still in flight, skip this frame.
+            const bool isSkipped = slot.state != SlotState::Idle && m_fence->GetCompletedValue() < slot.fenceValue;
+            if (!isSkipped) {
+                CHECK_HRCMD(slot.commandAllocator[0]->Reset());
+                CHECK_HRCMD(slot.commandList[0]->Reset(slot.commandAllocator[0].Get(), nullptr));
+                slot.commandList[0]->EndQuery(
+                    m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, static_cast<UINT>(2 * index));
+                CHECK_HRCMD(slot.commandList[0]->Close());
+                ID3D12CommandList* const lists[] = {slot.commandList[0].Get()};
+                m_queue->ExecuteCommandLists(1, lists);
+                slot.fenceValue = ++m_fenceValue;
+                CHECK_HRCMD(m_queue->Signal(m_fence.Get(), slot.fenceValue));
+
+                slot.frameId = frameId;
+                slot.state = SlotState::Started;
+            }
+
+            TraceLoggingWriteStop(local, "D3D12TimerPool_Start", TLArg(isSkipped, "Skipped"));
+        }
+
+        void stop(uint64_t frameId) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "D3D12TimerPool_Stop", TLPArg(this, "TimerPool"), TLArg(frameId, "FrameId"));
+
+            const size_t index = frameId % m_slots.size();
+            Slot& slot = m_slots[index];
+            if (slot.state == SlotState::Started && slot.frameId == frameId) {
+                CHECK_HRCMD(slot.commandAllocator[1]->Reset());
+                CHECK_HRCMD(slot.commandList[1]->Reset(slot.commandAllocator[1].Get(), nullptr));
+                slot.commandList[1]->EndQuery(
+                    m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, static_cast<UINT>(2 * index + 1));
+                slot.commandList[1]->ResolveQueryData(m_queryHeap.Get(),
+                                                      D3D12_QUERY_TYPE_TIMESTAMP,
+                                                      static_cast<UINT>(2 * index),
+                                                      2,
+                                                      m_queryReadbackBuffer.Get(),
+                                                      2 * index * sizeof(uint64_t));
+                CHECK_HRCMD(slot.commandList[1]->Close());
+                ID3D12CommandList* const lists[] = {slot.commandList[1].Get()};
+                m_queue->ExecuteCommandLists(1, lists);
+
+                // Signal a fence for completion.
+                slot.fenceValue = ++m_fenceValue;
+                CHECK_HRCMD(m_queue->Signal(m_fence.Get(), slot.fenceValue));
+                slot.state = SlotState::Stopped;
+            }
+
+            TraceLoggingWriteStop(local, "D3D12TimerPool_Stop");
+        }
+
+        std::vector<TimerMeasurement> resolve() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D12TimerPool_Resolve", TLPArg(this, "TimerPool"));
+
+            // Collect all the completed slots at once, with a single map of the readback buffer.
+            const uint64_t completedFenceValue = m_fence->GetCompletedValue();
+            std::vector<size_t> completedSlots;
+            for (size_t i = 0; i < m_slots.size(); i++) {
+                if (m_slots[i].state == SlotState::Stopped && m_slots[i].fenceValue <= completedFenceValue) {
+                    completedSlots.push_back(i);
+                }
+            }
+            std::sort(completedSlots.begin(), completedSlots.end(), [&](size_t a, size_t b) {
+                return m_slots[a].frameId < m_slots[b].frameId;
+            });
+
+            std::vector<TimerMeasurement> measurements;
+            uint64_t gpuTickFrequency;
+            if (!completedSlots.empty() && SUCCEEDED(m_queue->GetTimestampFrequency(&gpuTickFrequency))) {
+                uint64_t* mappedBuffer;
+                D3D12_RANGE range{0, 2 * m_slots.size() * sizeof(uint64_t)};
+                CHECK_HRCMD(m_queryReadbackBuffer->Map(0, &range, reinterpret_cast<void**>(&mappedBuffer)));
+                for (const size_t index : completedSlots) {
+                    const uint64_t duration =
+                        ((mappedBuffer[2 * index + 1] - mappedBuffer[2 * index]) * 1000000) / gpuTickFrequency;
+                    measurements.push_back({m_slots[index].frameId, duration});
+                    m_slots[index].state = SlotState::Idle;
+                }
+                D3D12_RANGE emptyRange{0, 0};
+                m_queryReadbackBuffer->Unmap(0, &emptyRange);
+            }
+
+            TraceLoggingWriteStop(local, "D3D12TimerPool_Resolve", TLArg(measurements.size(), "Count"));
+
+            return measurements;
+        }
+
+        enum class SlotState { Idle, Started, Stopped };
+
+        struct Slot {
+            ComPtr<ID3D12CommandAllocator> commandAllocator[2];
+            ComPtr<ID3D12GraphicsCommandList> commandList[2];
+            uint64_t fenceValue{0};
+            uint64_t frameId{0};
+            SlotState state{SlotState::Idle};
+        };
+
+        ComPtr<ID3D12CommandQueue> m_queue;
+        std::vector<Slot> m_slots;
+        ComPtr<ID3D12Fence> m_fence;
+        uint64_t m_fenceValue{0};
+        ComPtr<ID3D12QueryHeap> m_queryHeap;
+        ComPtr<ID3D12Resource> m_queryReadbackBuffer;
+    };
+
     struct D3D12Fence : IGraphicsFence {
         D3D12Fence(ID3D12Fence* fence, ID3D12CommandQueue* commandQueue, bool shareable)
             : m_fence(fence), m_commandQueue(commandQueue), m_isShareable(shareable) {
@@ -227,19 +411,26 @@ namespace {
             TraceLoggingWriteStop(local, "D3D12Fence_Wait");
         }
 
-        void waitOnCpu(uint64_t value) override {
+        bool waitOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            signal(value);
+            return waitForValueOnCpu(value, policy);
+        }
+
+        bool waitForValueOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(
-                local, "D3D12Fence_Wait", TLPArg(this, "Fence"), TLArg("Host", "WaitType"), TLArg(value, "Value"));
+            TraceLoggingWriteStart(local,
+                                   "D3D12Fence_Wait",
+                                   TLPArg(this, "Fence"),
+                                   TLArg("Host", "WaitType"),
+                                   TLArg(value, "Value"),
+                                   TLArg(policy.spinCount, "SpinCount"),
+                                   TLArg(policy.timeoutMs, "TimeoutMs"));
 
-            wil::unique_handle eventHandle;
-            CHECK_HRCMD(m_commandQueue->Signal(m_fence.Get(), value));
-            *eventHandle.put() = CreateEventEx(nullptr, L"D3D Fence", 0, EVENT_ALL_ACCESS);
-            CHECK_HRCMD(m_fence->SetEventOnCompletion(value, eventHandle.get()));
-            WaitForSingleObject(eventHandle.get(), INFINITE);
-            ResetEvent(eventHandle.get());
+            const bool completed = internal::waitForFenceOnCpu(m_fence.Get(), value, policy);
 
-            TraceLoggingWriteStop(local, "D3D12Fence_Wait");
+            TraceLoggingWriteStop(local, "D3D12Fence_Wait", TLArg(completed, "Completed"));
+
+            return completed;
         }
 
         bool isShareable() const override {
@@ -350,15 +541,249 @@ namespace {
         bool m_isShareable{false};
     };
 
+    // Readback through buffers in a readback heap, whose completion is tracked with a fence.
+    struct D3D12Readback : IGraphicsReadback {
+        D3D12Readback(ID3D12Device* device,
+                      ID3D12CommandQueue* queue,
+                      DXGI_FORMAT format,
+                      uint32_t width,
+                      uint32_t height,
+                      uint32_t depth)
+            : m_queue(queue), m_format(format), m_slots(std::max(depth, 1u)) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "D3D12Readback_Create",
+                                   TLArg((int)format, "Format"),
+                                   TLArg(width, "Width"),
+                                   TLArg(height, "Height"),
+                                   TLArg(depth, "Depth"));
+
+            // The layout of the copies in the buffers.
+            D3D12_RESOURCE_DESC textureDesc{};
+            textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+            textureDesc.Format = format;
+            textureDesc.Width = width;
+            textureDesc.Height = height;
+            textureDesc.DepthOrArraySize = textureDesc.MipLevels = textureDesc.SampleDesc.Count = 1;
+            UINT64 bufferSize = 0;
+            device->GetCopyableFootprints(&textureDesc, 0, 1, 0, &m_footprint, nullptr, nullptr, &bufferSize);
+
+            D3D12_HEAP_PROPERTIES heapType{};
+            heapType.Type = D3D12_HEAP_TYPE_READBACK;
+            heapType.CreationNodeMask = heapType.VisibleNodeMask = 1;
+            D3D12_RESOURCE_DESC bufferDesc{};
+            bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+            bufferDesc.Width = bufferSize;
+            bufferDesc.Height = bufferDesc.DepthOrArraySize = bufferDesc.MipLevels = bufferDesc.SampleDesc.Count = 1;
+            bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+            for (Slot& slot : m_slots) {
+                CHECK_HRCMD(device->CreateCommandAllocator(
+                    D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(slot.commandAllocator.ReleaseAndGetAddressOf())));
+                slot.commandAllocator->SetName(L"Readback Command Allocator");
+                CHECK_HRCMD(device->CreateCommandList(0,
+                                                      D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                      slot.commandAllocator.Get(),
+                                                      nullptr,
+                                                      IID_PPV_ARGS(slot.commandList.ReleaseAndGetAddressOf())));
+                slot.commandList->SetName(L"Readback Command List");
+                CHECK_HRCMD(slot.commandList->Close());
+                CHECK_HRCMD(device->CreateCommittedResource(&heapType,
+                                                            D3D12_HEAP_FLAG_NONE,
+                                                            &bufferDesc,
+                                                            D3D12_RESOURCE_STATE_COPY_DEST,
+                                                            nullptr,
+                                                            IID_PPV_ARGS(slot.buffer.ReleaseAndGetAddressOf())));
+                slot.buffer->SetName(L"Readback Buffer");
+            }
+            CHECK_HRCMD(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+            m_fence->SetName(L"Readback Fence");
+
+            TraceLoggingWriteStop(local, "D3D12Readback_Create", TLPArg(this, "Readback"));
+        }
+
+        ~D3D12Readback() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D12Readback_Destroy", TLPArg(this, "Readback"));
+
+            // The command allocators must not be released while the GPU still uses them.
+            if (m_fenceValue) {
+                internal::waitForFenceOnCpu(m_fence.Get(), m_fenceValue, {});
+            }
+
+            TraceLoggingWriteStop(local, "D3D12Readback_Destroy");
+        }
+
+        bool enqueue(IGraphicsTexture* texture, const XrRect2Di& rect, uint32_t arraySlice, uint64_t tag) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "D3D12Readback_Enqueue",
+                                   TLPArg(this, "Readback"),
+                                   TLPArg(texture, "Texture"),
+                                   TLArg(rect.offset.x, "X"),
+                                   TLArg(rect.offset.y, "Y"),
+                                   TLArg(rect.extent.width, "Width"),
+                                   TLArg(rect.extent.height, "Height"),
+                                   TLArg(arraySlice, "ArraySlice"),
+                                   TLArg(tag, "Tag"));
+
+            Slot& slot = m_slots[m_nextSlot % m_slots.size()];
+            if (slot.isPending) {
+                TraceLoggingWriteStop(local, "D3D12Readback_Enqueue", TLArg(false, "Enqueued"));
+                return false;
+            }
+
+            // Equivalent to D3D12CalcSubresource() for single-plane formats.
+            D3D12_TEXTURE_COPY_LOCATION source{};
+            source.pResource = texture->getNativeTexture<D3D12>();
+            source.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            source.SubresourceIndex = arraySlice * texture->getInfo().mipCount;
+            D3D12_TEXTURE_COPY_LOCATION destination{};
+            destination.pResource = slot.buffer.Get();
+            destination.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            destination.PlacedFootprint = m_footprint;
+
+            D3D12_BOX box{};
+            box.left = rect.offset.x;
+            box.top = rect.offset.y;
+            box.front = 0;
+            box.right = rect.offset.x + rect.extent.width;
+            box.bottom = rect.offset.y + rect.extent.height;
+            box.back = 1;
+
+            // The slot is idle, so the GPU is done with its command allocator.
+            CHECK_HRCMD(slot.commandAllocator->Reset());
+            CHECK_HRCMD(slot.commandList->Reset(slot.commandAllocator.Get(), nullptr));
+            slot.commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, &box);
+            CHECK_HRCMD(slot.commandList->Close());
+            ID3D12CommandList* const lists[] = {slot.commandList.Get()};
+            m_queue->ExecuteCommandLists(1, lists);
+            slot.fenceValue = ++m_fenceValue;
+            CHECK_HRCMD(m_queue->Signal(m_fence.Get(), slot.fenceValue));
+
+            slot.tag = tag;
+            slot.extent = rect.extent;
+            slot.isPending = true;
+            m_nextSlot++;
+
+            TraceLoggingWriteStop(local, "D3D12Readback_Enqueue", TLArg(true, "Enqueued"));
+
+            return true;
+        }
+
+        bool poll(const std::function<void(uint64_t tag, const ReadbackImage& image)>& callback) override {
+            Slot& slot = m_slots[m_oldestSlot % m_slots.size()];
+            if (!slot.isPending || m_fence->GetCompletedValue() < slot.fenceValue) {
+                return false;
+            }
+
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "D3D12Readback_Poll", TLPArg(this, "Readback"), TLArg(slot.tag, "Tag"));
+
+            const D3D12_RANGE readRange{(SIZE_T)m_footprint.Offset,
+                                        (SIZE_T)(m_footprint.Offset + (UINT64)m_footprint.Footprint.RowPitch *
+                                                                          m_footprint.Footprint.Height)};
+            void* data = nullptr;
+            CHECK_HRCMD(slot.buffer->Map(0, &readRange, &data));
+
+            // Release the slot even if the callback throws.
+            auto release = wil::scope_exit([&] {
+                const D3D12_RANGE writtenRange{0, 0};
+                slot.buffer->Unmap(0, &writtenRange);
+                slot.isPending = false;
+                m_oldestSlot++;
+            });
+            callback(slot.tag,
+                     ReadbackImage{reinterpret_cast<const uint8_t*>(data) + m_footprint.Offset,
+                                   (uint32_t)slot.extent.width,
+                                   (uint32_t)slot.extent.height,
+                                   m_footprint.Footprint.RowPitch,
+                                   (int64_t)m_format});
+
+            TraceLoggingWriteStop(local, "D3D12Readback_Poll", TLArg(true, "Collected"));
+
+            return true;
+        }
+
+        struct Slot {
+            ComPtr<ID3D12CommandAllocator> commandAllocator;
+            ComPtr<ID3D12GraphicsCommandList> commandList;
+            ComPtr<ID3D12Resource> buffer;
+            uint64_t fenceValue{0};
+            uint64_t tag{0};
+            XrExtent2Di extent{};
+            bool isPending{false};
+        };
+
+        const ComPtr<ID3D12CommandQueue> m_queue;
+        const DXGI_FORMAT m_format;
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_footprint{};
+        std::vector<Slot> m_slots;
+        ComPtr<ID3D12Fence> m_fence;
+        uint64_t m_fenceValue{0};
+        uint64_t m_nextSlot{0};
+        uint64_t m_oldestSlot{0};
+    };
+
+    // Maximum number of command lists (and their allocators) in flight. Beyond that, acquiring a command list waits
+    // for the oldest submission to complete.
+    constexpr size_t MaxCommandListPoolSize = 8;
+
     struct D3D12ReusableCommandList {
         ComPtr<ID3D12CommandAllocator> allocator;
         ComPtr<ID3D12GraphicsCommandList> commandList;
-        uint32_t completedFenceValue{0};
+    };
+
+    // The direct queue of a device, with a fence marking the completion of the command lists recycled by the device.
+    struct D3D12CommandListQueue : ICommandListQueue<D3D12ReusableCommandList> {
+        D3D12CommandListQueue(ID3D12Device* device, ID3D12CommandQueue* commandQueue)
+            : m_device(device), m_commandQueue(commandQueue) {
+            CHECK_HRCMD(
+                m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+        }
+
+        D3D12ReusableCommandList create() override {
+            D3D12ReusableCommandList commandList;
+            CHECK_HRCMD(m_device->CreateCommandAllocator(
+                D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(commandList.allocator.ReleaseAndGetAddressOf())));
+            CHECK_HRCMD(m_device->CreateCommandList(0,
+                                                    D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                    commandList.allocator.Get(),
+                                                    nullptr,
+                                                    IID_PPV_ARGS(commandList.commandList.ReleaseAndGetAddressOf())));
+            return commandList;
+        }
+
+        void reset(D3D12ReusableCommandList& commandList) override {
+            CHECK_HRCMD(commandList.allocator->Reset());
+            CHECK_HRCMD(commandList.commandList->Reset(commandList.allocator.Get(), nullptr));
+        }
+
+        void submit(D3D12ReusableCommandList& commandList, uint64_t fenceValue) override {
+            CHECK_HRCMD(commandList.commandList->Close());
+            m_commandQueue->ExecuteCommandLists(
+                1, reinterpret_cast<ID3D12CommandList**>(commandList.commandList.GetAddressOf()));
+            CHECK_HRCMD(m_commandQueue->Signal(m_fence.Get(), fenceValue));
+        }
+
+        uint64_t getCompletedFenceValue() const override {
+            return m_fence->GetCompletedValue();
+        }
+
+        void waitForFenceValue(uint64_t fenceValue) override {
+            TraceLoggingWrite(
+                g_traceProvider, "D3D12CommandListQueue_WaitForFenceValue", TLArg(fenceValue, "FenceValue"));
+            internal::waitForFenceOnCpu(m_fence.Get(), fenceValue, {});
+        }
+
+        const ComPtr<ID3D12Device> m_device;
+        const ComPtr<ID3D12CommandQueue> m_commandQueue;
+        ComPtr<ID3D12Fence> m_fence;
     };
 
     struct D3D12GraphicsDevice : IGraphicsDevice {
         D3D12GraphicsDevice(ID3D12Device* device, ID3D12CommandQueue* commandQueue)
-            : m_device(device), m_commandQueue(commandQueue) {
+            : m_device(device), m_commandQueue(commandQueue), m_commandListQueue(device, commandQueue),
+              m_commandLists(m_commandListQueue, MaxCommandListPoolSize) {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(
                 local, "D3D12GraphicsDevice_Create", TLPArg(device, "D3D12Device"), TLPArg(commandQueue, "Queue"));
@@ -387,15 +812,20 @@ namespace {
                 }
             }
 
-            CHECK_HRCMD(m_device->CreateFence(
-                0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_commandListPoolFence.ReleaseAndGetAddressOf())));
-
             TraceLoggingWriteStop(local, "D3D12GraphicsDevice_Create", TLPArg(this, "Device"));
         }
 
         ~D3D12GraphicsDevice() override {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(local, "D3D12GraphicsDevice_Destroy", TLPArg(this, "Device"));
+            const CommandListStatistics statistics = m_commandLists.getStatistics();
+            TraceLoggingWriteStart(local,
+                                   "D3D12GraphicsDevice_Destroy",
+                                   TLPArg(this, "Device"),
+                                   TLArg(statistics.submissions, "CommandListSubmissions"),
+                                   TLArg(statistics.allocations, "CommandListAllocations"),
+                                   TLArg(statistics.reuses, "CommandListReuses"),
+                                   TLArg(statistics.stalls, "CommandListStalls"));
+
             TraceLoggingWriteStop(local, "D3D12GraphicsDevice_Destroy");
         }
 
@@ -415,6 +845,10 @@ namespace {
             return std::make_shared<D3D12Timer>(m_device.Get(), m_commandQueue.Get());
         }
 
+        std::shared_ptr<IGraphicsTimerPool> createTimerPool(uint32_t frameLatency) override {
+            return std::make_shared<D3D12TimerPool>(m_device.Get(), m_commandQueue.Get(), frameLatency);
+        }
+
         std::shared_ptr<IGraphicsFence> createFence(bool shareable) override {
             ComPtr<ID3D12Fence> fence;
             CHECK_HRCMD(m_device->CreateFence(0,
@@ -517,17 +951,91 @@ namespace {
             return result;
         }
 
+        std::shared_ptr<IGraphicsReadback> createReadback(int64_t format,
+                                                          uint32_t width,
+                                                          uint32_t height,
+                                                          uint32_t depth) override {
+            return std::make_shared<D3D12Readback>(
+                m_device.Get(), m_commandQueue.Get(), (DXGI_FORMAT)format, width, height, depth);
+        }
+
         void copyTexture(IGraphicsTexture* from, IGraphicsTexture* to) override {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "D3D12Texture_Copy", TLPArg(from, "Source"), TLPArg(to, "Destination"));
 
-            D3D12ReusableCommandList commandList = getCommandList();
+            D3D12ReusableCommandList commandList = m_commandLists.acquire();
             commandList.commandList->CopyResource(to->getNativeTexture<D3D12>(), from->getNativeTexture<D3D12>());
-            submitCommandList(std::move(commandList));
+            m_commandLists.submit(std::move(commandList));
 
             TraceLoggingWriteStop(local, "D3D12Texture_Copy");
         }
 
+        void copyTextureRegion(IGraphicsTexture* from,
+                               const XrRect2Di& fromRect,
+                               uint32_t fromArraySlice,
+                               IGraphicsTexture* to,
+                               const XrOffset2Di& toOffset,
+                               uint32_t toArraySlice,
+                               uint32_t mipLevel) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "D3D12Texture_CopyRegion",
+                                   TLPArg(from, "Source"),
+                                   TLArg(fromRect.offset.x, "SourceX"),
+                                   TLArg(fromRect.offset.y, "SourceY"),
+                                   TLArg(fromRect.extent.width, "Width"),
+                                   TLArg(fromRect.extent.height, "Height"),
+                                   TLArg(fromArraySlice, "SourceArraySlice"),
+                                   TLPArg(to, "Destination"),
+                                   TLArg(toOffset.x, "DestinationX"),
+                                   TLArg(toOffset.y, "DestinationY"),
+                                   TLArg(toArraySlice, "DestinationArraySlice"),
+                                   TLArg(mipLevel, "MipLevel"));
+
+            // Equivalent to D3D12CalcSubresource() for single-plane formats.
+            D3D12_TEXTURE_COPY_LOCATION source{};
+            source.pResource = from->getNativeTexture<D3D12>();
+            source.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            source.SubresourceIndex = mipLevel + fromArraySlice * from->getInfo().mipCount;
+            D3D12_TEXTURE_COPY_LOCATION destination{};
+            destination.pResource = to->getNativeTexture<D3D12>();
+            destination.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            destination.SubresourceIndex = mipLevel + toArraySlice * to->getInfo().mipCount;
+
+            D3D12_BOX box{};
+            box.left = fromRect.offset.x;
+            box.top = fromRect.offset.y;
+            box.front = 0;
+            box.right = fromRect.offset.x + fromRect.extent.width;
+            box.bottom = fromRect.offset.y + fromRect.extent.height;
+            box.back = 1;
+
+            D3D12ReusableCommandList commandList = m_commandLists.acquire();
+            commandList.commandList->CopyTextureRegion(&destination, toOffset.x, toOffset.y, 0, &source, &box);
+            m_commandLists.submit(std::move(commandList));
+
+            TraceLoggingWriteStop(local, "D3D12Texture_CopyRegion");
+        }
+
+        void scaleTextureRegion(IGraphicsTexture* from,
+                                const XrRect2Di& fromRect,
+                                uint32_t fromArraySlice,
+                                int64_t fromFormat,
+                                IGraphicsTexture* to,
+                                const XrRect2Di& toRect,
+                                uint32_t toArraySlice,
+                                int64_t toFormat,
+                                ScalingFilter filter) override {
+            throw std::runtime_error("Scaling is not supported on D3D12");
+        }
+
+        void clearTexture(IGraphicsTexture* texture,
+                          uint32_t arraySlice,
+                          int64_t format,
+                          const XrColor4f& color) override {
+            throw std::runtime_error("Clearing is not supported on D3D12");
+        }
+
         GenericFormat translateToGenericFormat(int64_t format) const override {
             return (DXGI_FORMAT)format;
         }
@@ -540,58 +1048,16 @@ namespace {
             return m_device->GetAdapterLuid();
         }
 
-        D3D12ReusableCommandList getCommandList() {
-            std::unique_lock lock(m_commandListPoolMutex);
-
-            if (m_availableCommandList.empty()) {
-                // Recycle completed command lists.
-                while (!m_pendingCommandList.empty() && m_commandListPoolFence->GetCompletedValue() >=
-                                                            m_pendingCommandList.front().completedFenceValue) {
-                    m_availableCommandList.push_back(std::move(m_pendingCommandList.front()));
-                    m_pendingCommandList.pop_front();
-                }
-            }
-
-            D3D12ReusableCommandList commandList;
-            if (m_availableCommandList.empty()) {
-                // Allocate a new command list if needed.
-                CHECK_HRCMD(m_device->CreateCommandAllocator(
-                    D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(commandList.allocator.ReleaseAndGetAddressOf())));
-                CHECK_HRCMD(
-                    m_device->CreateCommandList(0,
-                                                D3D12_COMMAND_LIST_TYPE_DIRECT,
-                                                commandList.allocator.Get(),
-                                                nullptr,
-                                                IID_PPV_ARGS(commandList.commandList.ReleaseAndGetAddressOf())));
-            } else {
-                commandList = m_availableCommandList.front();
-                m_availableCommandList.pop_front();
-
-                // Reset the command list before reuse.
-                CHECK_HRCMD(commandList.commandList->Reset(commandList.allocator.Get(), nullptr));
-            }
-            return commandList;
-        }
-
-        void submitCommandList(D3D12ReusableCommandList commandList) {
-            std::unique_lock lock(m_commandListPoolMutex);
-
-            CHECK_HRCMD(commandList.commandList->Close());
-            m_commandQueue->ExecuteCommandLists(
-                1, reinterpret_cast<ID3D12CommandList**>(commandList.commandList.GetAddressOf()));
-            commandList.completedFenceValue = m_commandListPoolFenceValue + 1;
-            m_commandQueue->Signal(m_commandListPoolFence.Get(), commandList.completedFenceValue);
-            m_pendingCommandList.push_back(std::move(commandList));
+        CommandListStatistics getCommandListStatistics() const override {
+            return m_commandLists.getStatistics();
         }
 
         const ComPtr<ID3D12Device> m_device;
         const ComPtr<ID3D12CommandQueue> m_commandQueue;
 
-        std::mutex m_commandListPoolMutex;
-        std::deque<D3D12ReusableCommandList> m_availableCommandList;
-        std::deque<D3D12ReusableCommandList> m_pendingCommandList;
-        ComPtr<ID3D12Fence> m_commandListPoolFence;
-        uint32_t m_commandListPoolFenceValue{0};
+        // The ring waits for the GPU to be done with its command lists when destroyed.
+        D3D12CommandListQueue m_commandListQueue;
+        CommandListRing<D3D12ReusableCommandList> m_commandLists;
     };
 
 } // namespace
@@ -0,0 +1,327 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "executor.h"
+#include <log.h>
+
+namespace {
+
+    using namespace openxr_api_layer::log;
+    using namespace openxr_api_layer::utils::executor;
+    using namespace openxr_api_layer::utils::graphics;
+
+    class Executor;
+
+    class Job : public IJob {
+      public:
+        Job(Executor& executor,
+            std::function<void(uint32_t)> task,
+            uint32_t count,
+            std::shared_ptr<IGraphicsFence> fence,
+            uint64_t fenceValue)
+            : m_executor(executor), m_task(std::move(task)), m_count(count), m_fence(std::move(fence)),
+              m_fenceValue(fenceValue), m_remaining(count) {
+        }
+
+        bool isComplete() const override {
+            return m_remaining.load(std::memory_order_acquire) == 0;
+        }
+
+        void wait() override;
+
+        void run(uint32_t index) {
+            try {
+                m_task(index);
+            } catch (...) {
+                setError(std::current_exception());
+            }
+            complete(1);
+        }
+
+        // Returns false if the wait failed, in which case the job is completed with the error.
+        bool waitForFence() {
+            try {
+                // The producer of the data signals the value. Only wait for it, since the device's context may not be
+                // used from a worker.
+                m_fence->waitForValueOnCpu(m_fenceValue);
+                return true;
+            } catch (...) {
+                setError(std::current_exception());
+                complete(m_count);
+                return false;
+            }
+        }
+
+        void waitForCompletion() {
+            std::unique_lock lock(m_mutex);
+            m_completed.wait(lock, [&] { return isComplete(); });
+        }
+
+        uint32_t getCount() const {
+            return m_count;
+        }
+
+      private:
+        void setError(std::exception_ptr error) {
+            std::unique_lock lock(m_mutex);
+            if (!m_error) {
+                m_error = error;
+            }
+        }
+
+        void complete(uint32_t count) {
+            if (m_remaining.fetch_sub(count, std::memory_order_acq_rel) == count) {
+                std::unique_lock lock(m_mutex);
+                m_completed.notify_all();
+            }
+        }
+
+        Executor& m_executor;
+        const std::function<void(uint32_t)> m_task;
+        const uint32_t m_count;
+        const std::shared_ptr<IGraphicsFence> m_fence;
+        const uint64_t m_fenceValue;
+
+        std::atomic<uint32_t> m_remaining;
+        std::mutex m_mutex;
+        std::condition_variable m_completed;
+        std::exception_ptr m_error;
+    };
+
+    struct Task {
+        // The index of the task waiting for the fence of a job.
+        static constexpr uint32_t GateIndex = UINT32_MAX;
+
+        std::shared_ptr<Job> job;
+        uint32_t index;
+    };
+
+    class Executor : public IExecutor {
+      public:
+        Executor(uint32_t workerCount, uint64_t affinityMask) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "Executor_Create", TLArg(workerCount, "WorkerCount"), TLArg(affinityMask, "AffinityMask"));
+
+            for (uint32_t i = 0; i < workerCount; i++) {
+                m_queues.push_back(std::make_unique<Queue>());
+            }
+            uint32_t processor = 0;
+            for (uint32_t i = 0; i < workerCount; i++) {
+                m_workers.emplace_back([this, i] { workerThread(i); });
+
+                if (affinityMask) {
+                    // Pick the next processor of the mask, wrapping around.
+                    while (!(affinityMask & (1ull << (processor % 64)))) {
+                        processor++;
+                    }
+                    SetThreadAffinityMask(m_workers.back().native_handle(), (DWORD_PTR)1 << (processor % 64));
+                    processor++;
+                }
+            }
+
+            Log(fmt::format("Executor running {} workers\n", workerCount));
+
+            TraceLoggingWriteStop(local, "Executor_Create");
+        }
+
+        ~Executor() override {
+            {
+                std::unique_lock lock(m_sleepMutex);
+                m_isStopping = true;
+            }
+            m_wakeUp.notify_all();
+            for (std::thread& worker : m_workers) {
+                worker.join();
+            }
+        }
+
+        uint32_t getWorkerCount() const override {
+            return (uint32_t)m_workers.size();
+        }
+
+        std::shared_ptr<IJob> parallelFor(uint32_t count, std::function<void(uint32_t)> task) override {
+            auto job = std::make_shared<Job>(*this, std::move(task), count, nullptr, 0);
+            submit(job);
+            return job;
+        }
+
+        std::shared_ptr<IJob> parallelForAfter(std::shared_ptr<IGraphicsFence> fence,
+                                               uint64_t value,
+                                               uint32_t count,
+                                               std::function<void(uint32_t)> task) override {
+            auto job = std::make_shared<Job>(*this, std::move(task), count, std::move(fence), value);
+            if (count) {
+                enqueue({{job, Task::GateIndex}});
+            }
+            return job;
+        }
+
+        // Spread the tasks of a job across the queues of the workers.
+        void submit(const std::shared_ptr<Job>& job) {
+            std::vector<Task> tasks;
+            tasks.reserve(job->getCount());
+            for (uint32_t i = 0; i < job->getCount(); i++) {
+                tasks.push_back({job, i});
+            }
+            enqueue(std::move(tasks));
+        }
+
+        // Run one pending task, preferably from the given queue. Returns false if there were no pending tasks.
+        // A thread waiting for a job must not run the gate of another job: the fence may only be signaled once that
+        // thread returns, and it would block forever.
+        bool tryRunTask(size_t queueIndex, bool canRunGates = true) {
+            std::optional<Task> task;
+            if (queueIndex < m_queues.size()) {
+                task = popTask(*m_queues[queueIndex], true /* fromBack */, canRunGates);
+            }
+            for (size_t i = 1; i <= m_queues.size() && !task; i++) {
+                task = popTask(*m_queues[(queueIndex + i) % m_queues.size()], false /* fromBack */, canRunGates);
+            }
+            if (!task) {
+                return false;
+            }
+
+            m_pendingTasks.fetch_sub(1, std::memory_order_relaxed);
+            if (task->index == Task::GateIndex) {
+                if (task->job->waitForFence()) {
+                    submit(task->job);
+                }
+            } else {
+                task->job->run(task->index);
+            }
+            return true;
+        }
+
+      private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        // Take the task at the back or the front of the queue, or the nearest one that is not a gate.
+        std::optional<Task> popTask(Queue& queue, bool fromBack, bool canRunGates) {
+            std::unique_lock lock(queue.mutex);
+            const auto isRunnable = [&](const Task& task) { return canRunGates || task.index != Task::GateIndex; };
+            if (fromBack) {
+                const auto it = std::find_if(queue.tasks.rbegin(), queue.tasks.rend(), isRunnable);
+                if (it == queue.tasks.rend()) {
+                    return {};
+                }
+                Task task = std::move(*it);
+                queue.tasks.erase(std::next(it).base());
+                return task;
+            }
+            const auto it = std::find_if(queue.tasks.begin(), queue.tasks.end(), isRunnable);
+            if (it == queue.tasks.end()) {
+                return {};
+            }
+            Task task = std::move(*it);
+            queue.tasks.erase(it);
+            return task;
+        }
+
+        void enqueue(std::vector<Task> tasks) {
+            if (tasks.empty()) {
+                return;
+            }
+
+            const size_t count = tasks.size();
+            {
+                // Counted before they are pushed, since a busy worker may take them immediately and the count must not
+                // wrap around. Under the lock, so that a worker going to sleep cannot miss the new tasks.
+                std::unique_lock lock(m_sleepMutex);
+                m_pendingTasks.fetch_add(count, std::memory_order_relaxed);
+            }
+            const size_t first = m_nextQueue.fetch_add(1, std::memory_order_relaxed);
+            for (size_t i = 0; i < count; i++) {
+                Queue& queue = *m_queues[(first + i) % m_queues.size()];
+                std::unique_lock lock(queue.mutex);
+                queue.tasks.push_back(std::move(tasks[i]));
+            }
+            if (count == 1) {
+                m_wakeUp.notify_one();
+            } else {
+                m_wakeUp.notify_all();
+            }
+        }
+
+        void workerThread(uint32_t index) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "Executor_Worker", TLArg(index, "Index"));
+
+            while (true) {
+                if (tryRunTask(index)) {
+                    continue;
+                }
+
+                std::unique_lock lock(m_sleepMutex);
+                m_wakeUp.wait(lock, [&] { return m_pendingTasks.load(std::memory_order_relaxed) > 0 || m_isStopping; });
+                // The remaining tasks are completed before stopping.
+                if (m_isStopping && m_pendingTasks.load(std::memory_order_relaxed) == 0) {
+                    break;
+                }
+            }
+
+            TraceLoggingWriteStop(local, "Executor_Worker", TLArg(index, "Index"));
+        }
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::atomic<size_t> m_nextQueue{0};
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wakeUp;
+        std::atomic<size_t> m_pendingTasks{0};
+        bool m_isStopping{false};
+    };
+
+    void Job::wait() {
+        while (!isComplete()) {
+            // Help with the pending tasks (of any job, but never a gate), then block until the tasks running on the
+            // workers complete.
+            if (!m_executor.tryRunTask(SIZE_MAX, false /* canRunGates */)) {
+                waitForCompletion();
+            }
+        }
+
+        std::unique_lock lock(m_mutex);
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+} // namespace
+
+namespace openxr_api_layer::utils::executor {
+
+    std::shared_ptr<IExecutor> createExecutor(uint32_t workerCount, uint64_t affinityMask) {
+        if (!workerCount) {
+            workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        }
+        return std::make_shared<Executor>(workerCount, affinityMask);
+    }
+
+} // namespace openxr_api_layer::utils::executor
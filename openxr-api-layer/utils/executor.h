@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+namespace openxr_api_layer::utils::executor {
+
+    // A batch of tasks submitted together. The tasks run in any order, on any worker.
+    struct IJob {
+        virtual ~IJob() = default;
+
+        virtual bool isComplete() const = 0;
+
+        // The calling thread runs pending tasks until the job completes, but never waits for the fence of another job.
+        // Rethrows the first exception thrown by a task.
+        virtual void wait() = 0;
+    };
+
+    // A pool of worker threads. Each worker has its own queue of tasks, which it runs from the back, and steals from
+    // the front of the queues of the other workers once it is empty.
+    // All jobs must be complete before the executor is destroyed.
+    struct IExecutor {
+        virtual ~IExecutor() = default;
+
+        virtual uint32_t getWorkerCount() const = 0;
+
+        // Run task(index) for every index within [0, count).
+        virtual std::shared_ptr<IJob> parallelFor(uint32_t count, std::function<void(uint32_t)> task) = 0;
+
+        // Same as parallelFor(), once the fence reaches the value. The caller (or the GPU) must signal the value, the
+        // executor only waits for it with IGraphicsFence::waitForValueOnCpu(). The wait occupies one worker.
+        virtual std::shared_ptr<IJob> parallelForAfter(std::shared_ptr<graphics::IGraphicsFence> fence,
+                                                       uint64_t value,
+                                                       uint32_t count,
+                                                       std::function<void(uint32_t)> task) = 0;
+    };
+
+    // With 0 workers, use one per logical processor, except one left for the application's threads. With an affinity
+    // mask, the workers are pinned in turn to each of the logical processors of the mask.
+    std::shared_ptr<IExecutor> createExecutor(uint32_t workerCount = 0, uint64_t affinityMask = 0);
+
+} // namespace openxr_api_layer::utils::executor
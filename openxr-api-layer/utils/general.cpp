@@ -53,6 +53,60 @@ namespace {
         mutable clock::duration m_duration{0};
     };
 
+    class CpuTimerPool : public general::ITimerPool {
+        using clock = std::chrono::high_resolution_clock;
+
+      public:
+        CpuTimerPool(uint32_t frameLatency) : m_slots(std::max(frameLatency, 1u)) {
+        }
+
+        void start(uint64_t frameId) override {
+            Slot& slot = m_slots[frameId % m_slots.size()];
+            slot.frameId = frameId;
+            slot.timeStart = clock::now();
+            slot.isStarted = true;
+            slot.isStopped = false;
+        }
+
+        void stop(uint64_t frameId) override {
+            Slot& slot = m_slots[frameId % m_slots.size()];
+            if (slot.isStarted && slot.frameId == frameId) {
+                slot.duration = clock::now() - slot.timeStart;
+                slot.isStarted = false;
+                slot.isStopped = true;
+            }
+        }
+
+        std::vector<general::TimerMeasurement> resolve() override {
+            std::vector<general::TimerMeasurement> measurements;
+            for (Slot& slot : m_slots) {
+                if (slot.isStopped) {
+                    measurements.push_back(
+                        {slot.frameId,
+                         (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(slot.duration).count()});
+                    slot.isStopped = false;
+                }
+            }
+            std::sort(measurements.begin(),
+                      measurements.end(),
+                      [](const general::TimerMeasurement& a, const general::TimerMeasurement& b) {
+                          return a.frameId < b.frameId;
+                      });
+            return measurements;
+        }
+
+      private:
+        struct Slot {
+            uint64_t frameId{0};
+            clock::time_point timeStart;
+            clock::duration duration{0};
+            bool isStarted{false};
+            bool isStopped{false};
+        };
+
+        std::vector<Slot> m_slots;
+    };
+
     // Taken from
     // https://github.com/microsoft/OpenXR-MixedReality/blob/main/samples/SceneUnderstandingUwp/Scene_Placement.cpp
     bool XM_CALLCONV rayIntersectQuad(DirectX::FXMVECTOR rayPosition,
@@ -93,6 +147,10 @@ namespace openxr_api_layer::utils::general {
         return std::make_shared<CpuTimer>();
     }
 
+    std::shared_ptr<ITimerPool> createTimerPool(uint32_t frameLatency) {
+        return std::make_shared<CpuTimerPool>(frameLatency);
+    }
+
     bool hitTest(const XrPosef& ray, const XrPosef& quadCenter, const XrExtent2Df& quadSize, XrPosef& hitPose) {
         using namespace DirectX;
 
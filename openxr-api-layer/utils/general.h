@@ -47,6 +47,196 @@ namespace openxr_api_layer::utils::general {
 
     std::shared_ptr<ITimer> createTimer();
 
+    struct TimerMeasurement {
+        uint64_t frameId;
+        uint64_t duration; // In microseconds.
+    };
+
+    // A ring of timers for measuring several frames in flight. Measurements are identified by a frame ID and collected
+    // in batches once complete, without waiting. Frame N uses the same timer as frame N + frameLatency: a measurement
+    // not collected by then is discarded.
+    struct ITimerPool {
+        virtual ~ITimerPool() = default;
+
+        virtual void start(uint64_t frameId) = 0;
+        virtual void stop(uint64_t frameId) = 0;
+
+        // Returns the measurements completed since the previous call, in frame order.
+        virtual std::vector<TimerMeasurement> resolve() = 0;
+    };
+
+    std::shared_ptr<ITimerPool> createTimerPool(uint32_t frameLatency);
+
+    // Publishes immutable snapshots of a value. Readers pin the current snapshot with a hazard pointer: claiming a free
+    // slot, storing the pointer and checking that it is still current takes a few atomic operations and never waits
+    // for a writer or another reader. Writers are serialized. A replaced snapshot is retired, and freed by a later
+    // writer once no reader slot points to it anymore.
+    template <typename T>
+    class SnapshotPublisher {
+        // Concurrent readers beyond this count wait for a slot to be released.
+        static constexpr size_t MaxReaders = 64;
+
+        struct alignas(64) ReaderSlot {
+            std::atomic<bool> claimed{false};
+            std::atomic<const T*> hazard{nullptr};
+        };
+
+      public:
+        // A pinned snapshot. The value must not be modified and the snapshot must be released on the thread that
+        // holds it, before the publisher is destroyed.
+        class Snapshot {
+          public:
+            Snapshot() = default;
+            Snapshot(const Snapshot&) = delete;
+            Snapshot& operator=(const Snapshot&) = delete;
+
+            Snapshot(Snapshot&& other) noexcept : m_slot(std::exchange(other.m_slot, nullptr)), m_value(other.m_value) {
+            }
+
+            Snapshot& operator=(Snapshot&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    m_slot = std::exchange(other.m_slot, nullptr);
+                    m_value = other.m_value;
+                }
+                return *this;
+            }
+
+            ~Snapshot() {
+                reset();
+            }
+
+            void reset() {
+                if (m_slot) {
+                    m_slot->hazard.store(nullptr, std::memory_order_release);
+                    m_slot->claimed.store(false, std::memory_order_release);
+                    m_slot = nullptr;
+                    m_value = nullptr;
+                }
+            }
+
+            const T* get() const {
+                return m_value;
+            }
+
+            const T& operator*() const {
+                return *m_value;
+            }
+
+            const T* operator->() const {
+                return m_value;
+            }
+
+          private:
+            Snapshot(ReaderSlot* slot, const T* value) : m_slot(slot), m_value(value) {
+            }
+
+            ReaderSlot* m_slot{nullptr};
+            const T* m_value{nullptr};
+
+            friend class SnapshotPublisher;
+        };
+
+        SnapshotPublisher(const T& initialValue = {}) : m_current(new T(initialValue)) {
+        }
+
+        SnapshotPublisher(const SnapshotPublisher&) = delete;
+        SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+        ~SnapshotPublisher() {
+            delete m_current.load(std::memory_order_relaxed);
+            for (const T* retired : m_retired) {
+                delete retired;
+            }
+        }
+
+        Snapshot load() const {
+            ReaderSlot& slot = claimSlot();
+
+            // The hazard must be visible before the pointer is checked again, so that a writer retiring the snapshot
+            // after this check sees it.
+            const T* value = m_current.load(std::memory_order_seq_cst);
+            while (true) {
+                slot.hazard.store(value, std::memory_order_seq_cst);
+                const T* current = m_current.load(std::memory_order_seq_cst);
+                if (current == value) {
+                    break;
+                }
+                value = current;
+            }
+            return Snapshot(&slot, value);
+        }
+
+        // Invoke updater(T&) on a copy of the current value, and publish the copy if the updater returns true.
+        // Returns whether a new snapshot was published.
+        template <typename Updater>
+        bool update(Updater&& updater) {
+            std::unique_lock lock(m_writerMutex);
+
+            // Only writers replace the current snapshot, so it cannot be freed while the lock is held.
+            T next = *m_current.load(std::memory_order_relaxed);
+            if (!updater(next)) {
+                return false;
+            }
+            publishLocked(std::move(next));
+            return true;
+        }
+
+        void publish(T value) {
+            std::unique_lock lock(m_writerMutex);
+            publishLocked(std::move(value));
+        }
+
+        // The number of replaced snapshots that readers still held during the last publication.
+        size_t getRetiredCount() const {
+            std::unique_lock lock(m_writerMutex);
+            return m_retired.size();
+        }
+
+      private:
+        ReaderSlot& claimSlot() const {
+            // Threads start probing at different slots to avoid contending on the first ones.
+            static thread_local const size_t firstSlot = std::hash<std::thread::id>{}(std::this_thread::get_id());
+            while (true) {
+                for (size_t i = 0; i < MaxReaders; i++) {
+                    ReaderSlot& slot = m_readerSlots[(firstSlot + i) % MaxReaders];
+                    if (!slot.claimed.load(std::memory_order_relaxed) &&
+                        !slot.claimed.exchange(true, std::memory_order_acquire)) {
+                        return slot;
+                    }
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        void publishLocked(T value) {
+            m_retired.push_back(m_current.exchange(new T(std::move(value)), std::memory_order_seq_cst));
+
+            // Free the retired snapshots that no reader points to. A reader that loaded a retired pointer but has not
+            // published its hazard yet will see the new pointer when checking again.
+            std::vector<const T*> hazards;
+            for (const ReaderSlot& slot : m_readerSlots) {
+                const T* hazard = slot.hazard.load(std::memory_order_seq_cst);
+                if (hazard) {
+                    hazards.push_back(hazard);
+                }
+            }
+            const auto end = std::partition(m_retired.begin(), m_retired.end(), [&](const T* retired) {
+                return std::find(hazards.cbegin(), hazards.cend(), retired) != hazards.cend();
+            });
+            for (auto it = end; it != m_retired.end(); ++it) {
+                delete *it;
+            }
+            m_retired.erase(end, m_retired.end());
+        }
+
+        std::atomic<const T*> m_current;
+        mutable ReaderSlot m_readerSlots[MaxReaders];
+
+        mutable std::mutex m_writerMutex;
+        std::vector<const T*> m_retired;
+    };
+
     static inline bool startsWith(const std::string& str, const std::string& substr) {
         return str.find(substr) == 0;
     }
@@ -32,11 +32,24 @@ namespace openxr_api_layer::utils::graphics {
 #endif
 #ifdef XR_USE_GRAPHICS_API_D3D12
         D3D12,
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+        Vulkan,
+#endif
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+        OpenGL,
 #endif
     };
     enum class CompositionApi {
+        // Chosen for each session from the application's graphics API: Vulkan for Vulkan applications, Direct3D 11
+        // otherwise.
+        Automatic,
 #ifdef XR_USE_GRAPHICS_API_D3D11
         D3D11,
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+        // Composition always happens on the application's Vulkan device, which must be a Vulkan application.
+        Vulkan,
 #endif
     };
 
@@ -64,6 +77,51 @@ namespace openxr_api_layer::utils::graphics {
     };
 #endif
 
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+    struct Vulkan {
+        static constexpr Api Api = Api::Vulkan;
+
+        using Device = VkDevice;
+        using Context = VkQueue;
+        using Texture = VkImage;
+        using Fence = VkSemaphore;
+    };
+#endif
+
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+    struct OpenGL {
+        static constexpr Api Api = Api::OpenGL;
+
+        using Device = HGLRC;
+        using Context = HDC;
+        using Texture = GLuint;
+        using Fence = GLuint;
+    };
+#endif
+
+    namespace internal {
+
+        // Native handles are pointers, except for OpenGL object names.
+        template <typename NativeHandle>
+        NativeHandle fromNativePtr(void* nativePtr) {
+            if constexpr (std::is_pointer_v<NativeHandle>) {
+                return reinterpret_cast<NativeHandle>(nativePtr);
+            } else {
+                return static_cast<NativeHandle>(reinterpret_cast<uintptr_t>(nativePtr));
+            }
+        }
+
+        template <typename NativeHandle>
+        void* toNativePtr(NativeHandle nativeHandle) {
+            if constexpr (std::is_pointer_v<NativeHandle>) {
+                return reinterpret_cast<void*>(nativeHandle);
+            } else {
+                return reinterpret_cast<void*>(static_cast<uintptr_t>(nativeHandle));
+            }
+        }
+
+    } // namespace internal
+
     // We (arbitrarily) use DXGI as a common conversion point for all graphics APIs.
     using GenericFormat = DXGI_FORMAT;
 
@@ -81,6 +139,24 @@ namespace openxr_api_layer::utils::graphics {
         virtual Api getApi() const = 0;
     };
 
+    using TimerMeasurement = openxr_api_layer::utils::general::TimerMeasurement;
+
+    // A ring of timers on the GPU, see ITimerPool. Measurements are collected without waiting for the GPU or flushing
+    // the device's context.
+    struct IGraphicsTimerPool : openxr_api_layer::utils::general::ITimerPool {
+        virtual ~IGraphicsTimerPool() = default;
+
+        virtual Api getApi() const = 0;
+    };
+
+    // How to wait for a fence on the CPU.
+    struct FenceWaitPolicy {
+        // Number of times to poll the fence before blocking. Worth it only when the wait is expected to be short.
+        uint32_t spinCount{0};
+        // Maximum time to block, in milliseconds.
+        DWORD timeoutMs{INFINITE};
+    };
+
     // A fence.
     struct IGraphicsFence {
         virtual ~IGraphicsFence() = default;
@@ -91,7 +167,13 @@ namespace openxr_api_layer::utils::graphics {
 
         virtual void signal(uint64_t value) = 0;
         virtual void waitOnDevice(uint64_t value) = 0;
-        virtual void waitOnCpu(uint64_t value) = 0;
+        // Signal the value, then wait for it. Returns false if the policy's timeout expired before the fence reached
+        // the value.
+        virtual bool waitOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) = 0;
+        // Wait for a value signaled elsewhere, without signaling it. Unlike the other methods, it does not use the
+        // device's context or queue and may be called from any thread. OpenGL fences only support it on the thread
+        // owning the context, and not at all for the semaphores imported from D3D.
+        virtual bool waitForValueOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) = 0;
 
         virtual bool isShareable() const = 0;
 
@@ -100,7 +182,7 @@ namespace openxr_api_layer::utils::graphics {
             if (ApiTraits::Api != getApi()) {
                 throw std::runtime_error("Api mismatch");
             }
-            return reinterpret_cast<typename ApiTraits::Fence>(getNativeFencePtr());
+            return internal::fromNativePtr<typename ApiTraits::Fence>(getNativeFencePtr());
         }
     };
 
@@ -120,8 +202,141 @@ namespace openxr_api_layer::utils::graphics {
             if (ApiTraits::Api != getApi()) {
                 throw std::runtime_error("Api mismatch");
             }
-            return reinterpret_cast<typename ApiTraits::Texture>(getNativeTexturePtr());
+            return internal::fromNativePtr<typename ApiTraits::Texture>(getNativeTexturePtr());
+        }
+    };
+
+    // Pixels read back from a texture.
+    struct ReadbackImage {
+        const uint8_t* data;
+        uint32_t width;
+        uint32_t height;
+        uint32_t rowPitch;
+        int64_t format;
+    };
+
+    // A ring of staging resources for copying textures to the CPU without stalling the frame. Copies complete in
+    // order, and are collected once the GPU is done with them.
+    struct IGraphicsReadback {
+        virtual ~IGraphicsReadback() = default;
+
+        // Queue the copy of a rectangle of the first mip level, identified by the tag. Returns false if all the staging
+        // resources are in use.
+        virtual bool enqueue(IGraphicsTexture* texture, const XrRect2Di& rect, uint32_t arraySlice, uint64_t tag) = 0;
+
+        // Invoke the callback with the oldest copy if the GPU completed it, without waiting. The pixels are only valid
+        // during the callback. Returns whether a copy was collected.
+        virtual bool poll(const std::function<void(uint64_t tag, const ReadbackImage& image)>& callback) = 0;
+    };
+
+    // The filters for resampling textures.
+    enum class ScalingFilter {
+        Bilinear,
+        // 2-lobe Lanczos, clamped to the neighborhood to avoid ringing.
+        Lanczos,
+        // Lanczos stretched along the local edge direction, sharper on edges and smoother elsewhere.
+        EdgeAdaptive,
+    };
+
+    // The recycling of the command lists recorded by a device since it was created.
+    struct CommandListStatistics {
+        uint64_t submissions{0};
+
+        // A command list is allocated when none of the submitted ones has completed.
+        uint64_t allocations{0};
+        uint64_t reuses{0};
+
+        // Waits for the oldest submission when the maximum number of command lists are in flight.
+        uint64_t stalls{0};
+    };
+
+    // The queue and fence that a CommandListRing submits to.
+    template <typename CommandList>
+    struct ICommandListQueue {
+        virtual ~ICommandListQueue() = default;
+
+        // Returns a new command list, open for recording.
+        virtual CommandList create() = 0;
+        // Reopen a command list for recording, once the GPU is done with it.
+        virtual void reset(CommandList& commandList) = 0;
+        // Close and execute the command list, then signal the fence with the value.
+        virtual void submit(CommandList& commandList, uint64_t fenceValue) = 0;
+
+        virtual uint64_t getCompletedFenceValue() const = 0;
+        virtual void waitForFenceValue(uint64_t fenceValue) = 0;
+    };
+
+    // A bounded ring of command lists. Each submission signals the next value of the fence, and since submissions
+    // complete in order, the command lists are recycled from the oldest one once the fence reaches its value. Past
+    // maxInFlight submissions, acquire() waits for the oldest one rather than allocating yet another command list.
+    template <typename CommandList>
+    class CommandListRing {
+      public:
+        CommandListRing(ICommandListQueue<CommandList>& queue, size_t maxInFlight)
+            : m_queue(queue), m_maxInFlight(std::max(maxInFlight, size_t{1})) {
+        }
+
+        // The command lists must not be released while the GPU still uses them.
+        ~CommandListRing() {
+            if (m_lastFenceValue) {
+                m_queue.waitForFenceValue(m_lastFenceValue);
+            }
+        }
+
+        CommandList acquire() {
+            std::unique_lock lock(m_mutex);
+
+            const uint64_t completedFenceValue = m_queue.getCompletedFenceValue();
+            while (!m_pending.empty() && completedFenceValue >= m_pending.front().second) {
+                m_available.push_back(std::move(m_pending.front().first));
+                m_pending.pop_front();
+            }
+
+            if (m_available.empty() && m_pending.size() >= m_maxInFlight) {
+                m_queue.waitForFenceValue(m_pending.front().second);
+                m_available.push_back(std::move(m_pending.front().first));
+                m_pending.pop_front();
+                m_statistics.stalls++;
+            }
+
+            if (m_available.empty()) {
+                m_statistics.allocations++;
+                return m_queue.create();
+            }
+
+            CommandList commandList = std::move(m_available.front());
+            m_available.pop_front();
+            m_queue.reset(commandList);
+            m_statistics.reuses++;
+            return commandList;
+        }
+
+        // Returns the fence value signaled upon completion.
+        uint64_t submit(CommandList commandList) {
+            std::unique_lock lock(m_mutex);
+
+            const uint64_t fenceValue = m_lastFenceValue + 1;
+            m_queue.submit(commandList, fenceValue);
+            m_lastFenceValue = fenceValue;
+            m_pending.emplace_back(std::move(commandList), fenceValue);
+            m_statistics.submissions++;
+            return fenceValue;
         }
+
+        CommandListStatistics getStatistics() const {
+            std::unique_lock lock(m_mutex);
+            return m_statistics;
+        }
+
+      private:
+        ICommandListQueue<CommandList>& m_queue;
+        const size_t m_maxInFlight;
+
+        mutable std::mutex m_mutex;
+        std::deque<CommandList> m_available;
+        std::deque<std::pair<CommandList, uint64_t>> m_pending;
+        uint64_t m_lastFenceValue{0};
+        CommandListStatistics m_statistics;
     };
 
     // A graphics device and execution context.
@@ -133,6 +348,8 @@ namespace openxr_api_layer::utils::graphics {
         virtual void* getNativeContextPtr() const = 0;
 
         virtual std::shared_ptr<IGraphicsTimer> createTimer() = 0;
+        // Only D3D11 and D3D12 devices support timer pools.
+        virtual std::shared_ptr<IGraphicsTimerPool> createTimerPool(uint32_t frameLatency = 3) = 0;
         virtual std::shared_ptr<IGraphicsFence> createFence(bool shareable = true) = 0;
         virtual std::shared_ptr<IGraphicsFence> openFence(const ShareableHandle& handle) = 0;
         virtual std::shared_ptr<IGraphicsTexture> createTexture(const XrSwapchainCreateInfo& info,
@@ -141,14 +358,48 @@ namespace openxr_api_layer::utils::graphics {
                                                               const XrSwapchainCreateInfo& info) = 0;
         virtual std::shared_ptr<IGraphicsTexture> openTexturePtr(void* nativeTexturePtr,
                                                                  const XrSwapchainCreateInfo& info) = 0;
+        // A ring of `depth` staging resources, for rectangles of up to width x height pixels of the given format.
+        virtual std::shared_ptr<IGraphicsReadback> createReadback(int64_t format,
+                                                                  uint32_t width,
+                                                                  uint32_t height,
+                                                                  uint32_t depth = 3) = 0;
 
         virtual void copyTexture(IGraphicsTexture* from, IGraphicsTexture* to) = 0;
+        // Copy a rectangle of one array slice and mip level. The rectangle must be within the bounds of both textures.
+        virtual void copyTextureRegion(IGraphicsTexture* from,
+                                       const XrRect2Di& fromRect,
+                                       uint32_t fromArraySlice,
+                                       IGraphicsTexture* to,
+                                       const XrOffset2Di& toOffset,
+                                       uint32_t toArraySlice,
+                                       uint32_t mipLevel = 0) = 0;
+        // Resample a region of the first mip level into a region of another texture. The views are created with the
+        // given formats, since swapchain textures are often typeless. The destination needs the color attachment usage
+        // and the source the sampled usage.
+        virtual void scaleTextureRegion(IGraphicsTexture* from,
+                                        const XrRect2Di& fromRect,
+                                        uint32_t fromArraySlice,
+                                        int64_t fromFormat,
+                                        IGraphicsTexture* to,
+                                        const XrRect2Di& toRect,
+                                        uint32_t toArraySlice,
+                                        int64_t toFormat,
+                                        ScalingFilter filter) = 0;
+        // Clear one array slice of the first mip level. The view is created with the given format and the texture needs
+        // the color attachment usage.
+        virtual void clearTexture(IGraphicsTexture* texture,
+                                  uint32_t arraySlice,
+                                  int64_t format,
+                                  const XrColor4f& color) = 0;
 
         virtual GenericFormat translateToGenericFormat(int64_t format) const = 0;
         virtual int64_t translateFromGenericFormat(GenericFormat format) const = 0;
 
         virtual LUID getAdapterLuid() const = 0;
 
+        // Only D3D12 devices record their own command lists, other devices return no statistics.
+        virtual CommandListStatistics getCommandListStatistics() const = 0;
+
         template <typename ApiTraits>
         typename ApiTraits::Device getNativeDevice() const {
             if (ApiTraits::Api != getApi()) {
@@ -171,7 +422,7 @@ namespace openxr_api_layer::utils::graphics {
             if (ApiTraits::Api != getApi()) {
                 throw std::runtime_error("Api mismatch");
             }
-            return openTexturePtr(reinterpret_cast<void*>(nativeTexture), info);
+            return openTexturePtr(internal::toNativePtr(nativeTexture), info);
         }
     };
 
@@ -199,10 +450,13 @@ namespace openxr_api_layer::utils::graphics {
 
         // Only for manipulating swapchains created through createSwapchain().
         virtual ISwapchainImage* acquireImage(bool wait = true) = 0;
-        virtual void waitImage() = 0;
+        // Returns XR_TIMEOUT_EXPIRED when the image is not available within the timeout.
+        virtual XrResult waitImage(XrDuration timeout = XR_INFINITE_DURATION) = 0;
         virtual void releaseImage() = 0;
 
         virtual ISwapchainImage* getLastReleasedImage() const = 0;
+        // For submittable swapchains, the image is released to the runtime by serializePostComposition(). Readable
+        // submittable swapchains hold their last released image until it is committed.
         virtual void commitLastReleasedImage() = 0;
 
         virtual const XrSwapchainCreateInfo& getInfoOnCompositionDevice() const = 0;
@@ -210,9 +464,16 @@ namespace openxr_api_layer::utils::graphics {
         virtual ISwapchainImage* getImage(uint32_t index) const = 0;
         virtual uint32_t getLength() const = 0;
 
+        // Estimated video memory allocated by the layer for this swapchain, excluding the runtime's images.
+        virtual uint64_t getMemoryFootprint() const = 0;
+
         // Can only be called if the swapchain is submittable.
         virtual XrSwapchain getSwapchainHandle() const = 0;
         virtual XrSwapchainSubImage getSubImage() const = 0;
+
+        // The regions of the swapchain images referenced by the application's submissions. When set, only these
+        // regions are copied between the application and composition device. An empty list restores full copies.
+        virtual void setSubmittedSubImages(const std::vector<XrSwapchainSubImage>& subImages) = 0;
     };
 
     // A swapchain image.
@@ -233,6 +494,93 @@ namespace openxr_api_layer::utils::graphics {
         virtual ~ICompositionSessionData() = default;
     };
 
+    // The synchronization between the application and composition device since the session was created.
+    struct SynchronizationStatistics {
+        uint64_t applicationToCompositionSyncs{0};
+        uint64_t compositionToApplicationSyncs{0};
+
+        // Synchronization requests that were satisfied without a fence operation.
+        uint64_t coalescedSyncs{0};
+
+        uint64_t fenceSignals{0};
+        uint64_t fenceDeviceWaits{0};
+        uint64_t fenceCpuWaits{0};
+    };
+
+    // The reuse of the textures allocated on a composition device for swapchains since the device was created.
+    struct TexturePoolStatistics {
+        // A miss allocates a texture on the composition device.
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t evictions{0};
+
+        // Textures opened on an application device, which happens for each allocation, and when a texture is reused by
+        // another session.
+        uint64_t opens{0};
+
+        // Copies between swapchain images and the textures of the pool.
+        uint64_t copies{0};
+
+        // Memory held by released textures waiting for reuse.
+        uint64_t freeMemorySize{0};
+    };
+
+    // A texture accessible on both an application device and the composition device.
+    struct SharedTexture {
+        std::shared_ptr<IGraphicsTexture> onCompositionDevice;
+        std::shared_ptr<IGraphicsTexture> onApplicationDevice;
+        IGraphicsDevice* applicationDevice{nullptr};
+    };
+
+    // The textures allocated on a composition device for the swapchains of all the sessions using it: the bounce
+    // buffers of swapchains whose images are not shareable with the composition device, and the images of
+    // non-submittable swapchains.
+    // A texture belongs to one swapchain at a time: a swapchain copies into its bounce buffer between the application's
+    // release and the composition, and another swapchain using the same texture in the same frame would overwrite it.
+    // Instead, the textures of destroyed swapchains are kept and handed to the next swapchain with the same
+    // description, including in the next session. The least recently released textures are evicted past the memory
+    // budget.
+    struct ITexturePool {
+        virtual ~ITexturePool() = default;
+
+        // When the application device is the composition device, the texture is not shareable.
+        virtual SharedTexture acquire(IGraphicsDevice* applicationDevice,
+                                      const XrSwapchainCreateInfo& infoOnApplicationDevice,
+                                      const XrSwapchainCreateInfo& infoOnCompositionDevice) = 0;
+
+        // The caller must ensure that the texture is no longer in use on either device.
+        virtual void release(SharedTexture texture, uint64_t memorySize) = 0;
+
+        // Close the released textures opened on an application device before it is destroyed.
+        virtual void forgetApplicationDevice(IGraphicsDevice* applicationDevice) = 0;
+
+        // Copy on the application device, limited to the sub-images when there are any.
+        virtual void copy(IGraphicsDevice* applicationDevice,
+                          IGraphicsTexture* from,
+                          IGraphicsTexture* to,
+                          const std::vector<XrSwapchainSubImage>& subImages) = 0;
+
+        virtual TexturePoolStatistics getStatistics() const = 0;
+    };
+
+    std::shared_ptr<ITexturePool> createTexturePool(IGraphicsDevice* compositionDevice, uint64_t memoryBudget);
+
+    // A thread running the compositions of a session in submission order, so that the composition and the upstream
+    // xrEndFrame() of a frame overlap with the application's next frame.
+    struct ICompositionWorker {
+        virtual ~ICompositionWorker() = default;
+
+        // Blocks while maxQueuedJobs jobs are already waiting. Returns the first failure of an earlier job that was not
+        // reported yet, or XR_SUCCESS. A job throwing an exception fails with XR_ERROR_RUNTIME_FAILURE.
+        virtual XrResult queue(std::function<XrResult()> job) = 0;
+
+        // Wait for all queued jobs to complete.
+        virtual void waitForIdle() = 0;
+    };
+
+    // The queued jobs are completed before the worker is destroyed.
+    std::shared_ptr<ICompositionWorker> createCompositionWorker(uint32_t maxQueuedJobs);
+
     // A collection of hooks and utilities to perform composition in the layer.
     struct ICompositionFramework {
         virtual ~ICompositionFramework() = default;
@@ -243,18 +591,48 @@ namespace openxr_api_layer::utils::graphics {
         virtual ICompositionSessionData* getSessionDataPtr() const = 0;
 
         // Create a swapchain without an XrSwapchain handle.
+        // imageCount (2 to 4) is only used for swapchains that are not submittable: more images let the composition
+        // device read an earlier frame while the application renders the next ones.
         virtual std::shared_ptr<ISwapchain> createSwapchain(const XrSwapchainCreateInfo& infoOnApplicationDevice,
-                                                            SwapchainMode mode) = 0;
+                                                            SwapchainMode mode,
+                                                            uint32_t imageCount = 2) = 0;
 
         // Must be called at the beginning of the layer's xrEndFrame() implementation to serialize application commands
-        // prior to composition.
+        // prior to composition. The synchronization is deferred until a swapchain texture is first accessed on the
+        // composition device, so that it covers the copies of all swapchains at once.
         virtual void serializePreComposition() = 0;
 
         // Must be called before chaining to the upstream xrEndFrame() implementation to serialize composition commands
-        // prior to submission.
+        // prior to submission. Completes the commitLastReleasedImage() requests of all swapchains.
         virtual void serializePostComposition() = 0;
 
+        // Run the composition and the upstream xrEndFrame() on a worker thread, overlapping with the application's
+        // next frame. The application device is then accessed concurrently from the worker thread (D3D11 devices are
+        // made multithread-protected). Not supported when composition shares the application's device, nor for Vulkan
+        // and OpenGL applications.
+        virtual void enableCompositionWorker(uint32_t maxQueuedFrames = 1) = 0;
+        virtual bool isCompositionWorkerEnabled() const = 0;
+
+        // Queue the composition of a frame. serializePreComposition() and getLastReleasedImage() must be called before
+        // queuing, since the application may reuse its swapchain images once xrEndFrame() returns. The job must
+        // perform the composition, call serializePostComposition() and chain to the upstream xrEndFrame(), and it
+        // must not reference the application's structures. Without a worker, the job runs immediately.
+        // Returns the first failure of an earlier job that was not reported yet, or otherwise the result of the job
+        // if it ran immediately, or XR_SUCCESS.
+        virtual XrResult queueComposition(std::function<XrResult()> job) = 0;
+
+        // Wait for all queued compositions to complete. Called before xrBeginFrame() and xrDestroySession(), and before
+        // the layer accesses the swapchains that the compositions use.
+        virtual void waitForComposition() = 0;
+
+        virtual SynchronizationStatistics getSynchronizationStatistics() const = 0;
+        virtual TexturePoolStatistics getTexturePoolStatistics() const = 0;
+
+        // Creates the composition device upon first use, and throws if it could not be created.
         virtual IGraphicsDevice* getCompositionDevice() const = 0;
+        // Creates the composition device upon first use. When it could not be created, the session must not be composed
+        // and ICompositionFrameworkFactory::isCompositionSupported() returns false.
+        virtual bool isCompositionDeviceAvailable() const = 0;
         virtual IGraphicsDevice* getApplicationDevice() const = 0;
         virtual int64_t getPreferredSwapchainFormatOnApplicationDevice(XrSwapchainUsageFlags usageFlags,
                                                                        bool preferSRGB = true) const = 0;
@@ -275,13 +653,22 @@ namespace openxr_api_layer::utils::graphics {
                                                 PFN_xrVoidFunction* function) = 0;
 
         virtual ICompositionFramework* getCompositionFramework(XrSession session) = 0;
+
+        // Whether the application enabled a graphics API that can be composed, and no session failed to be wrapped.
+        virtual bool isCompositionSupported() const = 0;
     };
 
+    // When shareApplicationDevice is true and the application uses the composition API, composition happens directly on
+    // the application's device and swapchain images: no copies or fences are needed, but the composition code must
+    // save and restore any state it modifies on the application's context.
+    // Otherwise, the composition device is kept along with its texture pool for the sessions that the application
+    // creates later on the same adapter.
     std::shared_ptr<ICompositionFrameworkFactory>
     createCompositionFrameworkFactory(const XrInstanceCreateInfo& info,
                                       XrInstance instance,
                                       PFN_xrGetInstanceProcAddr xrGetInstanceProcAddr,
-                                      CompositionApi compositionApi);
+                                      CompositionApi compositionApi,
+                                      bool shareApplicationDevice = false);
 
     namespace internal {
 
@@ -294,6 +681,43 @@ namespace openxr_api_layer::utils::graphics {
         std::shared_ptr<IGraphicsDevice> wrapApplicationDevice(const XrGraphicsBindingD3D12KHR& bindings);
 #endif
 
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+        std::shared_ptr<IGraphicsDevice> wrapApplicationDevice(const XrGraphicsBindingVulkanKHR& bindings);
+#endif
+
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+        std::shared_ptr<IGraphicsDevice> wrapApplicationDevice(const XrGraphicsBindingOpenGLWin32KHR& bindings);
+#endif
+
+        // Common implementation of IGraphicsFence::waitForValueOnCpu() for ID3D11Fence and ID3D12Fence.
+        // Each thread reuses one auto-reset event. A completion event left over from a wait that timed out may wake a
+        // later wait early, hence the completed value is re-checked after each wake up.
+        template <typename NativeFence>
+        bool waitForFenceOnCpu(NativeFence* fence, uint64_t value, const FenceWaitPolicy& policy) {
+            for (uint32_t i = 0; i < policy.spinCount; i++) {
+                if (fence->GetCompletedValue() >= value) {
+                    return true;
+                }
+                YieldProcessor();
+            }
+
+            thread_local wil::unique_event waitEvent(wil::EventOptions::None);
+            const ULONGLONG deadline = policy.timeoutMs != INFINITE ? GetTickCount64() + policy.timeoutMs : 0;
+            while (fence->GetCompletedValue() < value) {
+                CHECK_HRCMD(fence->SetEventOnCompletion(value, waitEvent.get()));
+
+                DWORD timeoutMs = INFINITE;
+                if (policy.timeoutMs != INFINITE) {
+                    const ULONGLONG now = GetTickCount64();
+                    timeoutMs = now < deadline ? static_cast<DWORD>(deadline - now) : 0;
+                }
+                if (WaitForSingleObject(waitEvent.get(), timeoutMs) == WAIT_TIMEOUT) {
+                    return fence->GetCompletedValue() >= value;
+                }
+            }
+            return true;
+        }
+
     } // namespace internal
 
 } // namespace openxr_api_layer::utils::graphics
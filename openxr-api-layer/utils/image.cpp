@@ -0,0 +1,1115 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "image.h"
+#include <log.h>
+
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace {
+
+    using namespace openxr_api_layer::log;
+    using namespace openxr_api_layer::utils;
+    using namespace openxr_api_layer::utils::image;
+
+    // Set to true to always use the scalar kernels, for comparing them with the vectorized kernels.
+    constexpr bool ForceScalarKernels = false;
+
+    enum class Encoding {
+        Unorm8,
+        SRGB8,
+        Unorm10,
+        Half,
+        Float,
+        Depth16,
+        Depth24,
+        Depth32,
+    };
+
+    struct FormatInfo {
+        DXGI_FORMAT format;
+        uint32_t bytesPerPixel;
+        Encoding encoding;
+        bool isBGRA;
+        bool hasAlpha;
+    };
+
+    constexpr FormatInfo FormatTable[] = {
+        {DXGI_FORMAT_R8G8B8A8_TYPELESS, 4, Encoding::Unorm8, false, true},
+        {DXGI_FORMAT_R8G8B8A8_UNORM, 4, Encoding::Unorm8, false, true},
+        {DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4, Encoding::SRGB8, false, true},
+        {DXGI_FORMAT_B8G8R8A8_TYPELESS, 4, Encoding::Unorm8, true, true},
+        {DXGI_FORMAT_B8G8R8A8_UNORM, 4, Encoding::Unorm8, true, true},
+        {DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, 4, Encoding::SRGB8, true, true},
+        {DXGI_FORMAT_B8G8R8X8_TYPELESS, 4, Encoding::Unorm8, true, false},
+        {DXGI_FORMAT_B8G8R8X8_UNORM, 4, Encoding::Unorm8, true, false},
+        {DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, 4, Encoding::SRGB8, true, false},
+        {DXGI_FORMAT_R10G10B10A2_TYPELESS, 4, Encoding::Unorm10, false, true},
+        {DXGI_FORMAT_R10G10B10A2_UNORM, 4, Encoding::Unorm10, false, true},
+        {DXGI_FORMAT_R16G16B16A16_TYPELESS, 8, Encoding::Half, false, true},
+        {DXGI_FORMAT_R16G16B16A16_FLOAT, 8, Encoding::Half, false, true},
+        {DXGI_FORMAT_R32G32B32A32_TYPELESS, 16, Encoding::Float, false, true},
+        {DXGI_FORMAT_R32G32B32A32_FLOAT, 16, Encoding::Float, false, true},
+        {DXGI_FORMAT_R16_TYPELESS, 2, Encoding::Depth16, false, false},
+        {DXGI_FORMAT_D16_UNORM, 2, Encoding::Depth16, false, false},
+        {DXGI_FORMAT_R24G8_TYPELESS, 4, Encoding::Depth24, false, false},
+        {DXGI_FORMAT_D24_UNORM_S8_UINT, 4, Encoding::Depth24, false, false},
+        {DXGI_FORMAT_R32_TYPELESS, 4, Encoding::Depth32, false, false},
+        {DXGI_FORMAT_D32_FLOAT, 4, Encoding::Depth32, false, false},
+        {DXGI_FORMAT_R32G8X24_TYPELESS, 8, Encoding::Depth32, false, false},
+        {DXGI_FORMAT_D32_FLOAT_S8X24_UINT, 8, Encoding::Depth32, false, false},
+    };
+
+    const FormatInfo& getFormatInfo(DXGI_FORMAT format) {
+        for (const FormatInfo& info : FormatTable) {
+            if (info.format == format) {
+                return info;
+            }
+        }
+        throw std::runtime_error(fmt::format("Unsupported format for image kernels: {}", (int)format));
+    }
+
+    bool isDepthEncoding(Encoding encoding) {
+        return encoding == Encoding::Depth16 || encoding == Encoding::Depth24 || encoding == Encoding::Depth32;
+    }
+
+    void checkRect(const Image& image, const XrRect2Di& rect) {
+        if (rect.offset.x < 0 || rect.offset.y < 0 || rect.extent.width < 0 || rect.extent.height < 0 ||
+            (uint32_t)(rect.offset.x + rect.extent.width) > image.width ||
+            (uint32_t)(rect.offset.y + rect.extent.height) > image.height) {
+            throw std::runtime_error("Rectangle is out of the image bounds");
+        }
+    }
+
+    uint8_t* getPixel(const Image& image, int32_t x, int32_t y, uint32_t bytesPerPixel) {
+        return image.data + (size_t)y * image.rowPitch + (size_t)x * bytesPerPixel;
+    }
+
+    // The sRGB transfer function tables. Encoding goes through a 16-bit quantization of the linear value, which is
+    // within 1 of the exact result.
+    constexpr uint32_t SRGBEncodingTableSize = 1 << 16;
+
+    struct Tables {
+        float srgbToLinear[256];
+        // Padded so that 32-bit gathers may read past the last entry.
+        uint8_t linearToSRGB[SRGBEncodingTableSize + 3];
+    };
+
+    const Tables& getTables() {
+        static const std::unique_ptr<Tables> tables = [] {
+            auto tables = std::make_unique<Tables>();
+            for (uint32_t i = 0; i < 256; i++) {
+                const float c = i / 255.f;
+                tables->srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (uint32_t i = 0; i < SRGBEncodingTableSize; i++) {
+                const float v = i / (float)(SRGBEncodingTableSize - 1);
+                const float c = v <= 0.0031308f ? v * 12.92f : 1.055f * powf(v, 1.f / 2.4f) - 0.055f;
+                tables->linearToSRGB[i] = (uint8_t)std::clamp((int)(c * 255.f + 0.5f), 0, 255);
+            }
+            tables->linearToSRGB[SRGBEncodingTableSize] = tables->linearToSRGB[SRGBEncodingTableSize + 1] =
+                tables->linearToSRGB[SRGBEncodingTableSize + 2] = 0;
+            return tables;
+        }();
+        return *tables;
+    }
+
+    // The steps of a bilinear resampling along one axis, with 7-bit weights so that the interpolation of 8-bit values
+    // fits 16-bit lanes.
+    struct ScaleStep {
+        uint32_t index0;
+        uint32_t index1;
+        uint32_t weight1;
+    };
+
+    // The sample positions of the shaders, clamped to the centers of the first and last texels of the source.
+    std::vector<ScaleStep> getScaleSteps(int32_t sourceOffset, int32_t sourceExtent, int32_t destinationExtent) {
+        std::vector<ScaleStep> steps(destinationExtent);
+        const float ratio = (float)sourceExtent / destinationExtent;
+        for (int32_t i = 0; i < destinationExtent; i++) {
+            const float position = std::clamp((i + 0.5f) * ratio - 0.5f, 0.f, (float)(sourceExtent - 1));
+            const int32_t index0 = (int32_t)position;
+            steps[i].index0 = sourceOffset + index0;
+            steps[i].index1 = sourceOffset + std::min(index0 + 1, sourceExtent - 1);
+            steps[i].weight1 = (uint32_t)std::lround((position - index0) * 128.f);
+        }
+        return steps;
+    }
+
+    // The kernels for each instruction set, processing contiguous values.
+    struct Kernels {
+        // Swap the first and third channels of 8-bit pixels.
+        void (*swizzleRB)(const uint32_t* in, uint32_t* out, size_t pixelCount);
+        void (*fill32)(uint32_t* out, uint32_t value, size_t pixelCount);
+        void (*unorm8ToFloat)(const uint8_t* in, float* out, size_t count);
+        void (*floatToUnorm8)(const float* in, uint8_t* out, size_t count);
+        // Encode every value, including alpha.
+        void (*floatToSRGB8)(const float* in, uint8_t* out, size_t count);
+        void (*halfToFloat)(const uint16_t* in, float* out, size_t count);
+        void (*floatToHalf)(const float* in, uint16_t* out, size_t count);
+        // One row of bilinear resampling of 8-bit pixels, between two source rows.
+        void (*scaleRow8)(const uint32_t* row0,
+                          const uint32_t* row1,
+                          uint32_t weight1,
+                          const ScaleStep* steps,
+                          uint32_t* out,
+                          size_t pixelCount);
+    };
+
+    namespace scalar {
+
+        void swizzleRB(const uint32_t* in, uint32_t* out, size_t pixelCount) {
+            for (size_t i = 0; i < pixelCount; i++) {
+                const uint32_t p = in[i];
+                out[i] = (p & 0xff00ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+            }
+        }
+
+        void fill32(uint32_t* out, uint32_t value, size_t pixelCount) {
+            std::fill_n(out, pixelCount, value);
+        }
+
+        void unorm8ToFloat(const uint8_t* in, float* out, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = in[i] * (1.f / 255.f);
+            }
+        }
+
+        uint8_t toUnorm8(float value) {
+            // Written so that NaN becomes 0.
+            const float scaled = value * 255.f + 0.5f;
+            return (uint8_t)(scaled > 0.f ? std::min(scaled, 255.f) : 0.f);
+        }
+
+        void floatToUnorm8(const float* in, uint8_t* out, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = toUnorm8(in[i]);
+            }
+        }
+
+        uint32_t getSRGBEncodingIndex(float value) {
+            const float scaled = value * (SRGBEncodingTableSize - 1) + 0.5f;
+            return (uint32_t)(scaled > 0.f ? std::min(scaled, (float)(SRGBEncodingTableSize - 1)) : 0.f);
+        }
+
+        void floatToSRGB8(const float* in, uint8_t* out, size_t count) {
+            const uint8_t* const table = getTables().linearToSRGB;
+            for (size_t i = 0; i < count; i++) {
+                out[i] = table[getSRGBEncodingIndex(in[i])];
+            }
+        }
+
+        float halfToFloat(uint16_t value) {
+            const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+            const uint32_t exponent = (value >> 10) & 0x1f;
+            uint32_t mantissa = value & 0x3ff;
+            uint32_t bits;
+            if (exponent == 0) {
+                if (mantissa == 0) {
+                    bits = sign;
+                } else {
+                    // Normalize the subnormal value.
+                    int32_t shift = 0;
+                    while (!(mantissa & 0x400)) {
+                        mantissa <<= 1;
+                        shift++;
+                    }
+                    bits = sign | ((uint32_t)(127 - 14 - shift) << 23) | ((mantissa & 0x3ff) << 13);
+                }
+            } else if (exponent == 31) {
+                // NaNs are quieted, like the F16C instructions do.
+                bits = sign | 0x7f800000 | (mantissa ? 0x400000 : 0) | (mantissa << 13);
+            } else {
+                bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+            }
+            float result;
+            memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        // Rounds to nearest even, like the F16C instructions.
+        uint16_t floatToHalf(float value) {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+            const uint32_t absBits = bits & 0x7fffffff;
+            if (absBits > 0x7f800000) {
+                // Quiet the NaN and keep the top of its payload.
+                return sign | 0x7e00 | ((absBits >> 13) & 0x3ff);
+            }
+            if (absBits >= 0x477ff000) {
+                return sign | 0x7c00;
+            }
+            if (absBits < 0x38800000) {
+                // Subnormal (or zero) half.
+                const uint32_t exponent = absBits >> 23;
+                if (exponent < 102) {
+                    return sign;
+                }
+                const uint32_t mantissa = (absBits & 0x7fffff) | 0x800000;
+                const uint32_t shift = 126 - exponent;
+                uint32_t result = mantissa >> shift;
+                const uint32_t remainder = mantissa & ((1u << shift) - 1);
+                const uint32_t half = 1u << (shift - 1);
+                if (remainder > half || (remainder == half && (result & 1))) {
+                    result++;
+                }
+                return sign | (uint16_t)result;
+            }
+            uint32_t result = (absBits - 0x38000000) >> 13;
+            const uint32_t remainder = absBits & 0x1fff;
+            if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1))) {
+                result++;
+            }
+            return sign | (uint16_t)result;
+        }
+
+        void halfToFloat(const uint16_t* in, float* out, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = halfToFloat(in[i]);
+            }
+        }
+
+        void floatToHalf(const float* in, uint16_t* out, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = floatToHalf(in[i]);
+            }
+        }
+
+        void scaleRow8(const uint32_t* row0,
+                       const uint32_t* row1,
+                       uint32_t weight1,
+                       const ScaleStep* steps,
+                       uint32_t* out,
+                       size_t pixelCount) {
+            const uint32_t weight0 = 128 - weight1;
+            for (size_t i = 0; i < pixelCount; i++) {
+                const ScaleStep& step = steps[i];
+                const uint32_t p00 = row0[step.index0], p01 = row0[step.index1];
+                const uint32_t p10 = row1[step.index0], p11 = row1[step.index1];
+                uint32_t result = 0;
+                for (uint32_t shift = 0; shift < 32; shift += 8) {
+                    const uint32_t top =
+                        ((p00 >> shift) & 0xff) * (128 - step.weight1) + ((p01 >> shift) & 0xff) * step.weight1;
+                    const uint32_t bottom =
+                        ((p10 >> shift) & 0xff) * (128 - step.weight1) + ((p11 >> shift) & 0xff) * step.weight1;
+                    result |= ((top * weight0 + bottom * weight1 + (1 << 13)) >> 14) << shift;
+                }
+                out[i] = result;
+            }
+        }
+
+        // The pixels of the source rectangle as normalized RGBA values, clamped to the rectangle like the shaders do.
+        struct ClampedSource {
+            std::array<float, 4> load(int32_t x, int32_t y) const {
+                const uint8_t* const pixel =
+                    getPixel(image,
+                             std::clamp(x, rect.offset.x, rect.offset.x + rect.extent.width - 1),
+                             std::clamp(y, rect.offset.y, rect.offset.y + rect.extent.height - 1),
+                             4);
+                return {
+                    pixel[isBGRA ? 2 : 0] / 255.f, pixel[1] / 255.f, pixel[isBGRA ? 0 : 2] / 255.f, pixel[3] / 255.f};
+            }
+
+            const Image& image;
+            const XrRect2Di& rect;
+            const bool isBGRA;
+        };
+
+        float lanczos2(float x) {
+            x = std::abs(x);
+            if (x < 1e-5f) {
+                return 1.f;
+            }
+            if (x >= 2.f) {
+                return 0.f;
+            }
+            const float pix = 3.14159265f * x;
+            return 2.f * sin(pix) * sin(pix * 0.5f) / (pix * pix);
+        }
+
+        float luma(const std::array<float, 4>& color) {
+            return color[0] * 0.299f + color[1] * 0.587f + color[2] * 0.114f;
+        }
+
+        // The normalized weighted sum of the texels, clamped to the 2x2 texels around the sample to avoid ringing.
+        struct Accumulator {
+            void add(const std::array<float, 4>& texel, float weight, bool isCentral) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    color[c] += texel[c] * weight;
+                    if (isCentral) {
+                        minColor[c] = std::min(minColor[c], texel[c]);
+                        maxColor[c] = std::max(maxColor[c], texel[c]);
+                    }
+                }
+                weightSum += weight;
+            }
+
+            std::array<float, 4> resolve(float minWeightSum) const {
+                std::array<float, 4> result;
+                for (uint32_t c = 0; c < 4; c++) {
+                    result[c] = std::clamp(color[c] / std::max(weightSum, minWeightSum), minColor[c], maxColor[c]);
+                }
+                return result;
+            }
+
+            std::array<float, 4> color{};
+            std::array<float, 4> minColor{1e30f, 1e30f, 1e30f, 1e30f};
+            std::array<float, 4> maxColor{-1e30f, -1e30f, -1e30f, -1e30f};
+            float weightSum{0.f};
+        };
+
+        // psLanczos() at the source position (x, y), in texels.
+        std::array<float, 4> sampleLanczos(const ClampedSource& source, float x, float y) {
+            const int32_t baseX = (int32_t)floor(x);
+            const int32_t baseY = (int32_t)floor(y);
+            const float fx = x - baseX;
+            const float fy = y - baseY;
+
+            Accumulator accumulator;
+            for (int32_t ty = -1; ty <= 2; ty++) {
+                const float wy = lanczos2(ty - fy);
+                for (int32_t tx = -1; tx <= 2; tx++) {
+                    accumulator.add(source.load(baseX + tx, baseY + ty),
+                                    lanczos2(tx - fx) * wy,
+                                    tx >= 0 && tx <= 1 && ty >= 0 && ty <= 1);
+                }
+            }
+            return accumulator.resolve(0.f);
+        }
+
+        // psEdgeAdaptive() at the source position (x, y), in texels.
+        std::array<float, 4> sampleEdgeAdaptive(const ClampedSource& source, float x, float y) {
+            const int32_t baseX = (int32_t)floor(x);
+            const int32_t baseY = (int32_t)floor(y);
+            const float fx = x - baseX;
+            const float fy = y - baseY;
+
+            std::array<float, 4> texels[4][4];
+            for (int32_t ty = 0; ty < 4; ty++) {
+                for (int32_t tx = 0; tx < 4; tx++) {
+                    texels[ty][tx] = source.load(baseX + tx - 1, baseY + ty - 1);
+                }
+            }
+
+            // Luma gradient at the sample position, interpolated from the central 2x2 texels.
+            float gradientX = 0.f;
+            float gradientY = 0.f;
+            for (int32_t gy = 1; gy <= 2; gy++) {
+                for (int32_t gx = 1; gx <= 2; gx++) {
+                    const float w = (gx == 1 ? 1.f - fx : fx) * (gy == 1 ? 1.f - fy : fy);
+                    gradientX += w * (luma(texels[gy][gx + 1]) - luma(texels[gy][gx - 1]));
+                    gradientY += w * (luma(texels[gy + 1][gx]) - luma(texels[gy - 1][gx]));
+                }
+            }
+            const float gradientLength = sqrt(gradientX * gradientX + gradientY * gradientY);
+            const float edge = std::clamp(gradientLength * 4.f, 0.f, 1.f);
+            const float acrossX = gradientLength > 1e-5f ? gradientX / gradientLength : 1.f;
+            const float acrossY = gradientLength > 1e-5f ? gradientY / gradientLength : 0.f;
+            const float alongX = -acrossY;
+            const float alongY = acrossX;
+
+            // Widen the kernel along the edge and narrow it across the edge.
+            const float scaleAlong = 1.f + (0.5f - 1.f) * edge;
+            const float scaleAcross = 1.f + (1.4f - 1.f) * edge;
+
+            Accumulator accumulator;
+            for (int32_t ty = 0; ty < 4; ty++) {
+                for (int32_t tx = 0; tx < 4; tx++) {
+                    const float dx = tx - 1 - fx;
+                    const float dy = ty - 1 - fy;
+                    const float u = (dx * alongX + dy * alongY) * scaleAlong;
+                    const float v = (dx * acrossX + dy * acrossY) * scaleAcross;
+                    accumulator.add(
+                        texels[ty][tx], lanczos2(sqrt(u * u + v * v)), tx >= 1 && tx <= 2 && ty >= 1 && ty <= 2);
+                }
+            }
+            return accumulator.resolve(1e-5f);
+        }
+
+    } // namespace scalar
+
+    namespace sse2 {
+
+        void swizzleRB(const uint32_t* in, uint32_t* out, size_t pixelCount) {
+            const __m128i keepMask = _mm_set1_epi32(0xff00ff00);
+            const __m128i lowMask = _mm_set1_epi32(0xff);
+            size_t i = 0;
+            for (; i + 4 <= pixelCount; i += 4) {
+                const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                const __m128i r = _mm_slli_epi32(_mm_and_si128(p, lowMask), 16);
+                const __m128i b = _mm_and_si128(_mm_srli_epi32(p, 16), lowMask);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                                 _mm_or_si128(_mm_and_si128(p, keepMask), _mm_or_si128(r, b)));
+            }
+            scalar::swizzleRB(in + i, out + i, pixelCount - i);
+        }
+
+        void fill32(uint32_t* out, uint32_t value, size_t pixelCount) {
+            const __m128i v = _mm_set1_epi32(value);
+            size_t i = 0;
+            for (; i + 4 <= pixelCount; i += 4) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+            }
+            scalar::fill32(out + i, value, pixelCount - i);
+        }
+
+        void unorm8ToFloat(const uint8_t* in, float* out, size_t count) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128 scale = _mm_set1_ps(1.f / 255.f);
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                const __m128i words[] = {_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero)};
+                for (uint32_t j = 0; j < 2; j++) {
+                    const __m128i lo = _mm_unpacklo_epi16(words[j], zero);
+                    const __m128i hi = _mm_unpackhi_epi16(words[j], zero);
+                    _mm_storeu_ps(out + i + j * 8, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+                    _mm_storeu_ps(out + i + j * 8 + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+                }
+            }
+            scalar::unorm8ToFloat(in + i, out + i, count - i);
+        }
+
+        __m128i toUnorm8(__m128 value) {
+            // The maximum returns its second operand for NaN.
+            const __m128 scaled = _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f));
+            return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()), _mm_set1_ps(255.f)));
+        }
+
+        void floatToUnorm8(const float* in, uint8_t* out, size_t count) {
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                const __m128i a = _mm_packs_epi32(toUnorm8(_mm_loadu_ps(in + i)), toUnorm8(_mm_loadu_ps(in + i + 4)));
+                const __m128i b =
+                    _mm_packs_epi32(toUnorm8(_mm_loadu_ps(in + i + 8)), toUnorm8(_mm_loadu_ps(in + i + 12)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+            }
+            scalar::floatToUnorm8(in + i, out + i, count - i);
+        }
+
+        void floatToSRGB8(const float* in, uint8_t* out, size_t count) {
+            // Without gathers, only the computation of the table indices is vectorized.
+            const uint8_t* const table = getTables().linearToSRGB;
+            const __m128 scale = _mm_set1_ps((float)(SRGBEncodingTableSize - 1));
+            alignas(16) int32_t indices[4];
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m128 scaled = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), _mm_set1_ps(0.5f));
+                _mm_store_si128(reinterpret_cast<__m128i*>(indices),
+                                _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()), scale)));
+                out[i] = table[indices[0]];
+                out[i + 1] = table[indices[1]];
+                out[i + 2] = table[indices[2]];
+                out[i + 3] = table[indices[3]];
+            }
+            scalar::floatToSRGB8(in + i, out + i, count - i);
+        }
+
+        void halfToFloat(const uint16_t* in, float* out, size_t count) {
+            // Rebias the exponent with a multiplication, which also normalizes the subnormal values.
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i noSignMask = _mm_set1_epi32(0x7fff);
+            const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+            const __m128i infNanThreshold = _mm_set1_epi32(0x7bff);
+            const __m128 infNanExponent = _mm_castsi128_ps(_mm_set1_epi32(255 << 23));
+            const __m128i infinity = _mm_set1_epi32(0x7c00);
+            const __m128 quietNan = _mm_castsi128_ps(_mm_set1_epi32(0x400000));
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m128i h =
+                    _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)), zero);
+                const __m128i exponentMantissa = _mm_and_si128(h, noSignMask);
+                const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, exponentMantissa), 16);
+                const __m128 scaled =
+                    _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), magic);
+                const __m128 infNan =
+                    _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(exponentMantissa, infNanThreshold)), infNanExponent);
+                const __m128 quiet =
+                    _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(exponentMantissa, infinity)), quietNan);
+                _mm_storeu_ps(out + i,
+                              _mm_or_ps(_mm_or_ps(scaled, _mm_castsi128_ps(sign)), _mm_or_ps(infNan, quiet)));
+            }
+            scalar::halfToFloat(in + i, out + i, count - i);
+        }
+
+        void scaleRow8(const uint32_t* row0,
+                       const uint32_t* row1,
+                       uint32_t weight1,
+                       const ScaleStep* steps,
+                       uint32_t* out,
+                       size_t pixelCount) {
+            const __m128i zero = _mm_setzero_si128();
+            // Pairs of (top, bottom) weights for interleaved top and bottom values.
+            const __m128i verticalWeights = _mm_set1_epi32((int)((weight1 << 16) | (128 - weight1)));
+            const __m128i rounding = _mm_set1_epi32(1 << 13);
+            for (size_t i = 0; i < pixelCount; i++) {
+                const ScaleStep& step = steps[i];
+                const __m128i horizontalWeight0 = _mm_set1_epi16((short)(128 - step.weight1));
+                const __m128i horizontalWeight1 = _mm_set1_epi16((short)step.weight1);
+                const __m128i p00 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(row0[step.index0]), zero);
+                const __m128i p01 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(row0[step.index1]), zero);
+                const __m128i p10 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(row1[step.index0]), zero);
+                const __m128i p11 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(row1[step.index1]), zero);
+                const __m128i top =
+                    _mm_add_epi16(_mm_mullo_epi16(p00, horizontalWeight0), _mm_mullo_epi16(p01, horizontalWeight1));
+                const __m128i bottom =
+                    _mm_add_epi16(_mm_mullo_epi16(p10, horizontalWeight0), _mm_mullo_epi16(p11, horizontalWeight1));
+                // The horizontal results are at most 255 * 128, within the signed 16-bit range of the multiply-add.
+                const __m128i sum = _mm_srli_epi32(
+                    _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(top, bottom), verticalWeights), rounding), 14);
+                const __m128i words = _mm_packs_epi32(sum, sum);
+                out[i] = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+            }
+        }
+
+    } // namespace sse2
+
+    namespace avx2 {
+
+        void swizzleRB(const uint32_t* in, uint32_t* out, size_t pixelCount) {
+            const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                     2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+            size_t i = 0;
+            for (; i + 8 <= pixelCount; i += 8) {
+                const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_shuffle_epi8(p, shuffle));
+            }
+            sse2::swizzleRB(in + i, out + i, pixelCount - i);
+        }
+
+        void fill32(uint32_t* out, uint32_t value, size_t pixelCount) {
+            const __m256i v = _mm256_set1_epi32(value);
+            size_t i = 0;
+            for (; i + 8 <= pixelCount; i += 8) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+            }
+            sse2::fill32(out + i, value, pixelCount - i);
+        }
+
+        void unorm8ToFloat(const uint8_t* in, float* out, size_t count) {
+            const __m256 scale = _mm256_set1_ps(1.f / 255.f);
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                const __m256i values =
+                    _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+                _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(values), scale));
+            }
+            sse2::unorm8ToFloat(in + i, out + i, count - i);
+        }
+
+        // Pack 8 values in the 0-255 range to bytes.
+        void storeBytes(uint8_t* out, __m256i values) {
+            const __m256i words = _mm256_packus_epi32(values, values);
+            const __m256i bytes = _mm256_packus_epi16(words, words);
+            const uint32_t lo = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(bytes));
+            const uint32_t hi = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+            memcpy(out, &lo, sizeof(lo));
+            memcpy(out + 4, &hi, sizeof(hi));
+        }
+
+        void floatToUnorm8(const float* in, uint8_t* out, size_t count) {
+            const __m256 scale = _mm256_set1_ps(255.f);
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                const __m256 scaled =
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), _mm256_set1_ps(0.5f));
+                storeBytes(out + i,
+                           _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(scaled, _mm256_setzero_ps()), scale)));
+            }
+            sse2::floatToUnorm8(in + i, out + i, count - i);
+        }
+
+        void floatToSRGB8(const float* in, uint8_t* out, size_t count) {
+            const uint8_t* const table = getTables().linearToSRGB;
+            const __m256 scale = _mm256_set1_ps((float)(SRGBEncodingTableSize - 1));
+            const __m256i byteMask = _mm256_set1_epi32(0xff);
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                const __m256 scaled =
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), _mm256_set1_ps(0.5f));
+                const __m256i indices =
+                    _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(scaled, _mm256_setzero_ps()), scale));
+                const __m256i values = _mm256_and_si256(
+                    _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), indices, 1), byteMask);
+                storeBytes(out + i, values);
+            }
+            sse2::floatToSRGB8(in + i, out + i, count - i);
+        }
+
+        void halfToFloat(const uint16_t* in, float* out, size_t count) {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(out + i,
+                                 _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+            }
+            sse2::halfToFloat(in + i, out + i, count - i);
+        }
+
+        void floatToHalf(const float* in, uint16_t* out, size_t count) {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                                 _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+            }
+            scalar::floatToHalf(in + i, out + i, count - i);
+        }
+
+    } // namespace avx2
+
+    InstructionSet detectInstructionSet() {
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool hasSSE2 = info[3] & (1 << 26);
+        const bool hasOSXSAVE = info[2] & (1 << 27);
+        const bool hasAVX = info[2] & (1 << 28);
+        const bool hasF16C = info[2] & (1 << 29);
+        bool hasAVX2 = false;
+        // The OS must also save the AVX registers.
+        if (maxLeaf >= 7 && hasOSXSAVE && hasAVX && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(info, 7, 0);
+            hasAVX2 = info[1] & (1 << 5);
+        }
+
+        if (hasAVX2 && hasF16C) {
+            return InstructionSet::AVX2;
+        }
+        return hasSSE2 ? InstructionSet::SSE2 : InstructionSet::Scalar;
+    }
+
+    const Kernels& getKernels(InstructionSet instructionSet) {
+        static const Kernels scalarKernels{scalar::swizzleRB,
+                                           scalar::fill32,
+                                           scalar::unorm8ToFloat,
+                                           scalar::floatToUnorm8,
+                                           scalar::floatToSRGB8,
+                                           scalar::halfToFloat,
+                                           scalar::floatToHalf,
+                                           scalar::scaleRow8};
+        static const Kernels sse2Kernels{sse2::swizzleRB,
+                                         sse2::fill32,
+                                         sse2::unorm8ToFloat,
+                                         sse2::floatToUnorm8,
+                                         sse2::floatToSRGB8,
+                                         sse2::halfToFloat,
+                                         scalar::floatToHalf,
+                                         sse2::scaleRow8};
+        // The gathers of the bilinear resampling are not faster with AVX2.
+        static const Kernels avx2Kernels{avx2::swizzleRB,
+                                         avx2::fill32,
+                                         avx2::unorm8ToFloat,
+                                         avx2::floatToUnorm8,
+                                         avx2::floatToSRGB8,
+                                         avx2::halfToFloat,
+                                         avx2::floatToHalf,
+                                         sse2::scaleRow8};
+
+        // Never run instructions that the CPU does not support.
+        switch (std::min(instructionSet, getInstructionSet())) {
+        case InstructionSet::AVX2:
+            return avx2Kernels;
+        case InstructionSet::SSE2:
+            return sse2Kernels;
+        default:
+            return scalarKernels;
+        }
+    }
+
+    // The sRGB transfer functions on interleaved RGBA pixels. Alpha is always linear.
+    void srgbToLinear(const uint8_t* rgba, float* linear, size_t pixelCount) {
+        const float* const table = getTables().srgbToLinear;
+        for (size_t i = 0; i < pixelCount; i++) {
+            linear[i * 4] = table[rgba[i * 4]];
+            linear[i * 4 + 1] = table[rgba[i * 4 + 1]];
+            linear[i * 4 + 2] = table[rgba[i * 4 + 2]];
+            linear[i * 4 + 3] = rgba[i * 4 + 3] * (1.f / 255.f);
+        }
+    }
+
+    void linearToSRGB(const Kernels& kernels, const float* linear, uint8_t* rgba, size_t pixelCount) {
+        kernels.floatToSRGB8(linear, rgba, pixelCount * 4);
+        for (size_t i = 0; i < pixelCount; i++) {
+            rgba[i * 4 + 3] = scalar::toUnorm8(linear[i * 4 + 3]);
+        }
+    }
+
+    // Decode a row to linear RGBA values. The scratch buffer holds one row of 8-bit pixels.
+    void decodeRow(const Kernels& kernels,
+                   const FormatInfo& info,
+                   const uint8_t* row,
+                   float* rgba,
+                   uint32_t width,
+                   uint32_t* scratch) {
+        switch (info.encoding) {
+        case Encoding::Unorm8:
+        case Encoding::SRGB8: {
+            const uint8_t* pixels = row;
+            if (info.isBGRA) {
+                kernels.swizzleRB(reinterpret_cast<const uint32_t*>(row), scratch, width);
+                pixels = reinterpret_cast<const uint8_t*>(scratch);
+            }
+            if (info.encoding == Encoding::SRGB8) {
+                srgbToLinear(pixels, rgba, width);
+            } else {
+                kernels.unorm8ToFloat(pixels, rgba, (size_t)width * 4);
+            }
+            if (!info.hasAlpha) {
+                for (uint32_t x = 0; x < width; x++) {
+                    rgba[x * 4 + 3] = 1.f;
+                }
+            }
+            break;
+        }
+        case Encoding::Unorm10:
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t p;
+                memcpy(&p, row + x * 4, sizeof(p));
+                rgba[x * 4] = (p & 0x3ff) / 1023.f;
+                rgba[x * 4 + 1] = ((p >> 10) & 0x3ff) / 1023.f;
+                rgba[x * 4 + 2] = ((p >> 20) & 0x3ff) / 1023.f;
+                rgba[x * 4 + 3] = (p >> 30) / 3.f;
+            }
+            break;
+        case Encoding::Half:
+            kernels.halfToFloat(reinterpret_cast<const uint16_t*>(row), rgba, (size_t)width * 4);
+            break;
+        case Encoding::Float:
+            memcpy(rgba, row, (size_t)width * 16);
+            break;
+        case Encoding::Depth16:
+        case Encoding::Depth24:
+        case Encoding::Depth32:
+            for (uint32_t x = 0; x < width; x++) {
+                float depth;
+                if (info.encoding == Encoding::Depth16) {
+                    uint16_t d;
+                    memcpy(&d, row + x * 2, sizeof(d));
+                    depth = d / 65535.f;
+                } else if (info.encoding == Encoding::Depth24) {
+                    uint32_t d;
+                    memcpy(&d, row + x * 4, sizeof(d));
+                    depth = (d & 0xffffff) / 16777215.f;
+                } else {
+                    memcpy(&depth, row + x * info.bytesPerPixel, sizeof(depth));
+                }
+                rgba[x * 4] = rgba[x * 4 + 1] = rgba[x * 4 + 2] = depth;
+                rgba[x * 4 + 3] = 1.f;
+            }
+            break;
+        }
+    }
+
+    // Encode a row of linear RGBA values.
+    void encodeRow(const Kernels& kernels, const FormatInfo& info, const float* rgba, uint8_t* row, uint32_t width) {
+        switch (info.encoding) {
+        case Encoding::Unorm8:
+        case Encoding::SRGB8:
+            if (info.encoding == Encoding::SRGB8) {
+                linearToSRGB(kernels, rgba, row, width);
+            } else {
+                kernels.floatToUnorm8(rgba, row, (size_t)width * 4);
+            }
+            if (info.isBGRA) {
+                kernels.swizzleRB(reinterpret_cast<const uint32_t*>(row), reinterpret_cast<uint32_t*>(row), width);
+            }
+            break;
+        case Encoding::Unorm10:
+            for (uint32_t x = 0; x < width; x++) {
+                const auto quantize = [](float value, float max) {
+                    const float scaled = value * max + 0.5f;
+                    return (uint32_t)(scaled > 0.f ? std::min(scaled, max) : 0.f);
+                };
+                const uint32_t p = quantize(rgba[x * 4], 1023.f) | (quantize(rgba[x * 4 + 1], 1023.f) << 10) |
+                                   (quantize(rgba[x * 4 + 2], 1023.f) << 20) | (quantize(rgba[x * 4 + 3], 3.f) << 30);
+                memcpy(row + x * 4, &p, sizeof(p));
+            }
+            break;
+        case Encoding::Half:
+            kernels.floatToHalf(rgba, reinterpret_cast<uint16_t*>(row), (size_t)width * 4);
+            break;
+        case Encoding::Float:
+            memcpy(row, rgba, (size_t)width * 16);
+            break;
+        default:
+            throw std::runtime_error("Cannot convert to a depth format");
+        }
+    }
+
+    // Run an operation on bands of rows [begin, end), in parallel with an executor.
+    template <typename Operation>
+    void forEachBand(executor::IExecutor* executor, uint32_t height, size_t rowSize, Operation&& operation) {
+        if (!height) {
+            return;
+        }
+        const uint32_t rowsPerBand =
+            (uint32_t)std::clamp(TileSize / std::max(rowSize, (size_t)1), (size_t)1, (size_t)height);
+        const uint32_t bandCount = (height + rowsPerBand - 1) / rowsPerBand;
+        if (!executor || bandCount <= 1) {
+            operation(0u, height);
+            return;
+        }
+
+        executor
+            ->parallelFor(bandCount,
+                          [&](uint32_t band) {
+                              const uint32_t begin = band * rowsPerBand;
+                              operation(begin, std::min(begin + rowsPerBand, height));
+                          })
+            ->wait();
+    }
+
+    // Replicate one pixel over a span of pixels of the same row.
+    void replicatePixel(
+        const Kernels& kernels, const uint8_t* pixel, uint8_t* out, uint32_t count, uint32_t bytesPerPixel) {
+        if (bytesPerPixel == 4) {
+            uint32_t value;
+            memcpy(&value, pixel, sizeof(value));
+            kernels.fill32(reinterpret_cast<uint32_t*>(out), value, count);
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                memcpy(out + (size_t)i * bytesPerPixel, pixel, bytesPerPixel);
+            }
+        }
+    }
+
+} // namespace
+
+namespace openxr_api_layer::utils::image {
+
+    InstructionSet getInstructionSet() {
+        static const InstructionSet instructionSet = [] {
+            const InstructionSet instructionSet = ForceScalarKernels ? InstructionSet::Scalar : detectInstructionSet();
+            Log(fmt::format("Image kernels use {}\n",
+                            instructionSet == InstructionSet::AVX2   ? "AVX2"
+                            : instructionSet == InstructionSet::SSE2 ? "SSE2"
+                                                                     : "scalar code"));
+            return instructionSet;
+        }();
+        return instructionSet;
+    }
+
+    uint32_t getBytesPerPixel(DXGI_FORMAT format) {
+        for (const FormatInfo& info : FormatTable) {
+            if (info.format == format) {
+                return info.bytesPerPixel;
+            }
+        }
+        return 0;
+    }
+
+    void blit(const Image& source,
+              const XrRect2Di& sourceRect,
+              const Image& destination,
+              const XrOffset2Di& destinationOffset,
+              executor::IExecutor* executor) {
+        const uint32_t bytesPerPixel = getFormatInfo(source.format).bytesPerPixel;
+        if (getFormatInfo(destination.format).bytesPerPixel != bytesPerPixel) {
+            throw std::runtime_error("Cannot blit between formats of different sizes");
+        }
+        checkRect(source, sourceRect);
+        checkRect(destination, {destinationOffset, sourceRect.extent});
+
+        const size_t rowSize = (size_t)sourceRect.extent.width * bytesPerPixel;
+        forEachBand(executor, sourceRect.extent.height, rowSize, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t y = begin; y < end; y++) {
+                memcpy(getPixel(destination, destinationOffset.x, destinationOffset.y + y, bytesPerPixel),
+                       getPixel(source, sourceRect.offset.x, sourceRect.offset.y + y, bytesPerPixel),
+                       rowSize);
+            }
+        });
+    }
+
+    void fill(const Image& destination,
+              const XrRect2Di& rect,
+              const XrColor4f& color,
+              executor::IExecutor* executor,
+              InstructionSet instructionSet) {
+        const FormatInfo& info = getFormatInfo(destination.format);
+        checkRect(destination, rect);
+
+        const Kernels& kernels = getKernels(instructionSet);
+        alignas(16) uint8_t pixel[16];
+        const float rgba[4] = {color.r, color.g, color.b, color.a};
+        encodeRow(kernels, info, rgba, pixel, 1);
+        forEachBand(executor,
+                    rect.extent.height,
+                    (size_t)rect.extent.width * info.bytesPerPixel,
+                    [&](uint32_t begin, uint32_t end) {
+                        for (uint32_t y = begin; y < end; y++) {
+                            replicatePixel(kernels,
+                                           pixel,
+                                           getPixel(destination, rect.offset.x, rect.offset.y + y, info.bytesPerPixel),
+                                           rect.extent.width,
+                                           info.bytesPerPixel);
+                        }
+                    });
+    }
+
+    void padEdges(const Image& image, const XrRect2Di& contentRect, InstructionSet instructionSet) {
+        const uint32_t bytesPerPixel = getFormatInfo(image.format).bytesPerPixel;
+        checkRect(image, contentRect);
+        if (contentRect.extent.width == 0 || contentRect.extent.height == 0) {
+            return;
+        }
+
+        const Kernels& kernels = getKernels(instructionSet);
+        const int32_t left = contentRect.offset.x;
+        const int32_t right = contentRect.offset.x + contentRect.extent.width;
+        const int32_t top = contentRect.offset.y;
+        const int32_t bottom = contentRect.offset.y + contentRect.extent.height;
+        for (int32_t y = top; y < bottom; y++) {
+            replicatePixel(kernels,
+                           getPixel(image, left, y, bytesPerPixel),
+                           getPixel(image, 0, y, bytesPerPixel),
+                           left,
+                           bytesPerPixel);
+            replicatePixel(kernels,
+                           getPixel(image, right - 1, y, bytesPerPixel),
+                           getPixel(image, right, y, bytesPerPixel),
+                           image.width - right,
+                           bytesPerPixel);
+        }
+
+        // The rows above and below are copies of the first and last rows, now complete.
+        const size_t rowSize = (size_t)image.width * bytesPerPixel;
+        for (int32_t y = 0; y < top; y++) {
+            memcpy(getPixel(image, 0, y, bytesPerPixel), getPixel(image, 0, top, bytesPerPixel), rowSize);
+        }
+        for (int32_t y = bottom; y < (int32_t)image.height; y++) {
+            memcpy(getPixel(image, 0, y, bytesPerPixel), getPixel(image, 0, bottom - 1, bytesPerPixel), rowSize);
+        }
+    }
+
+    void scale(const Image& source,
+               const XrRect2Di& sourceRect,
+               const Image& destination,
+               const XrRect2Di& destinationRect,
+               graphics::ScalingFilter filter,
+               executor::IExecutor* executor,
+               InstructionSet instructionSet) {
+        const FormatInfo& sourceInfo = getFormatInfo(source.format);
+        const FormatInfo& destinationInfo = getFormatInfo(destination.format);
+        const auto is8Bit = [](const FormatInfo& info) {
+            return info.encoding == Encoding::Unorm8 || info.encoding == Encoding::SRGB8;
+        };
+        if (!is8Bit(sourceInfo) || !is8Bit(destinationInfo) || sourceInfo.isBGRA != destinationInfo.isBGRA) {
+            throw std::runtime_error("Scaling is only supported between 8-bit formats with the same channel order");
+        }
+        checkRect(source, sourceRect);
+        checkRect(destination, destinationRect);
+        if (sourceRect.extent.width == 0 || sourceRect.extent.height == 0 || destinationRect.extent.width == 0) {
+            return;
+        }
+
+        const size_t rowSize = (size_t)destinationRect.extent.width * 4;
+        if (filter == graphics::ScalingFilter::Bilinear) {
+            const std::vector<ScaleStep> columns =
+                getScaleSteps(sourceRect.offset.x, sourceRect.extent.width, destinationRect.extent.width);
+            const std::vector<ScaleStep> rows =
+                getScaleSteps(sourceRect.offset.y, sourceRect.extent.height, destinationRect.extent.height);
+            const Kernels& kernels = getKernels(instructionSet);
+            forEachBand(executor, destinationRect.extent.height, rowSize, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t y = begin; y < end; y++) {
+                    kernels.scaleRow8(
+                        reinterpret_cast<const uint32_t*>(getPixel(source, 0, rows[y].index0, 4)),
+                        reinterpret_cast<const uint32_t*>(getPixel(source, 0, rows[y].index1, 4)),
+                        rows[y].weight1,
+                        columns.data(),
+                        reinterpret_cast<uint32_t*>(
+                            getPixel(destination, destinationRect.offset.x, destinationRect.offset.y + y, 4)),
+                        columns.size());
+                }
+            });
+            return;
+        }
+
+        // The shaders sample at the center of each destination pixel, mapped to the source rectangle.
+        const scalar::ClampedSource clampedSource{source, sourceRect, sourceInfo.isBGRA};
+        const float ratioX = (float)sourceRect.extent.width / destinationRect.extent.width;
+        const float ratioY = (float)sourceRect.extent.height / destinationRect.extent.height;
+        forEachBand(executor, destinationRect.extent.height, rowSize, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t y = begin; y < end; y++) {
+                const float sourceY = sourceRect.offset.y + (y + 0.5f) * ratioY - 0.5f;
+                uint8_t* const row = getPixel(destination, destinationRect.offset.x, destinationRect.offset.y + y, 4);
+                for (int32_t x = 0; x < destinationRect.extent.width; x++) {
+                    const float sourceX = sourceRect.offset.x + (x + 0.5f) * ratioX - 0.5f;
+                    const std::array<float, 4> color =
+                        filter == graphics::ScalingFilter::Lanczos
+                            ? scalar::sampleLanczos(clampedSource, sourceX, sourceY)
+                            : scalar::sampleEdgeAdaptive(clampedSource, sourceX, sourceY);
+                    uint8_t* const pixel = row + (size_t)x * 4;
+                    pixel[sourceInfo.isBGRA ? 2 : 0] = scalar::toUnorm8(color[0]);
+                    pixel[1] = scalar::toUnorm8(color[1]);
+                    pixel[sourceInfo.isBGRA ? 0 : 2] = scalar::toUnorm8(color[2]);
+                    pixel[3] = scalar::toUnorm8(color[3]);
+                }
+            }
+        });
+    }
+
+    void convert(const Image& source,
+                 const Image& destination,
+                 executor::IExecutor* executor,
+                 InstructionSet instructionSet) {
+        const FormatInfo& sourceInfo = getFormatInfo(source.format);
+        const FormatInfo& destinationInfo = getFormatInfo(destination.format);
+        if (source.width != destination.width || source.height != destination.height) {
+            throw std::runtime_error("Cannot convert between images of different sizes");
+        }
+
+        const Kernels& kernels = getKernels(instructionSet);
+        // Rows are copied as-is when only the typeless-ness or the channel order differ.
+        const bool isSameEncoding = sourceInfo.encoding == destinationInfo.encoding &&
+                                    sourceInfo.bytesPerPixel == destinationInfo.bytesPerPixel &&
+                                    (sourceInfo.hasAlpha || !destinationInfo.hasAlpha) &&
+                                    !isDepthEncoding(sourceInfo.encoding);
+        const size_t rowSize = (size_t)source.width * std::max(sourceInfo.bytesPerPixel, destinationInfo.bytesPerPixel);
+        forEachBand(executor, source.height, rowSize, [&](uint32_t begin, uint32_t end) {
+            std::vector<float> rgba;
+            std::vector<uint32_t> scratch;
+            if (!isSameEncoding) {
+                rgba.resize((size_t)source.width * 4);
+                scratch.resize(source.width);
+            }
+            for (uint32_t y = begin; y < end; y++) {
+                const uint8_t* const in = source.data + (size_t)y * source.rowPitch;
+                uint8_t* const out = destination.data + (size_t)y * destination.rowPitch;
+                if (isSameEncoding && sourceInfo.isBGRA == destinationInfo.isBGRA) {
+                    memcpy(out, in, (size_t)source.width * sourceInfo.bytesPerPixel);
+                } else if (isSameEncoding) {
+                    kernels.swizzleRB(
+                        reinterpret_cast<const uint32_t*>(in), reinterpret_cast<uint32_t*>(out), source.width);
+                } else {
+                    decodeRow(kernels, sourceInfo, in, rgba.data(), source.width, scratch.data());
+                    encodeRow(kernels, destinationInfo, rgba.data(), out, destination.width);
+                }
+            }
+        });
+    }
+
+} // namespace openxr_api_layer::utils::image
@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "executor.h"
+
+namespace openxr_api_layer::utils::image {
+
+    // Pixels in CPU-accessible memory, with rows rowPitch bytes apart.
+    struct Image {
+        uint8_t* data{nullptr};
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t rowPitch{0};
+        DXGI_FORMAT format{DXGI_FORMAT_UNKNOWN};
+    };
+
+    // The kernels come in several variants, and the best one supported by the CPU is selected upon first use.
+    enum class InstructionSet {
+        Scalar,
+        SSE2,
+        AVX2,
+    };
+
+    InstructionSet getInstructionSet();
+
+    // Returns 0 for the formats that the kernels do not handle. Supported are the 8-bit RGBA/BGRA formats (UNORM and
+    // sRGB), R10G10B10A2, R16G16B16A16_FLOAT, R32G32B32A32_FLOAT, and as conversion sources only, the depth formats.
+    // Typeless formats are handled like their UNORM (or FLOAT) counterpart.
+    uint32_t getBytesPerPixel(DXGI_FORMAT format);
+
+    // With an executor, the image is split into bands of rows of about TileSize bytes, which are processed in parallel.
+    constexpr size_t TileSize = 256 * 1024;
+
+    // In all kernels, the instruction set is capped to the one supported by the CPU, and a lower one is only useful to
+    // compare the kernel variants. Rectangles must lie within their image.
+
+    // Copy a rectangle between two distinct images with the same pixel size. Cropping is the copy of a sub-rectangle.
+    void blit(const Image& source,
+              const XrRect2Di& sourceRect,
+              const Image& destination,
+              const XrOffset2Di& destinationOffset,
+              executor::IExecutor* executor = nullptr);
+
+    // Fill a rectangle with a color given in linear space, like the black borders of the padding.
+    void fill(const Image& destination,
+              const XrRect2Di& rect,
+              const XrColor4f& color,
+              executor::IExecutor* executor = nullptr,
+              InstructionSet instructionSet = InstructionSet::AVX2);
+
+    // Extend a rectangle to the rest of the image by replicating its outermost pixels, like the edge-clamped borders of
+    // the padding.
+    void padEdges(const Image& image,
+                  const XrRect2Di& contentRect,
+                  InstructionSet instructionSet = InstructionSet::AVX2);
+
+    // Resample a rectangle between two images of 8-bit formats with the same channel order, with the filters of
+    // IGraphicsDevice::scaleTextureRegion() and the same clamping to the source rectangle. Like a GPU sampling through
+    // a UNORM view, sRGB values are filtered without linearization. Only the bilinear filter is vectorized (with 7-bit
+    // weights): the Lanczos and edge-adaptive filters are scalar references for the shaders.
+    void scale(const Image& source,
+               const XrRect2Di& sourceRect,
+               const Image& destination,
+               const XrRect2Di& destinationRect,
+               graphics::ScalingFilter filter = graphics::ScalingFilter::Bilinear,
+               executor::IExecutor* executor = nullptr,
+               InstructionSet instructionSet = InstructionSet::AVX2);
+
+    // Convert between two images of the same size and of any formats, through linear values.
+    void convert(const Image& source,
+                 const Image& destination,
+                 executor::IExecutor* executor = nullptr,
+                 InstructionSet instructionSet = InstructionSet::AVX2);
+
+} // namespace openxr_api_layer::utils::image
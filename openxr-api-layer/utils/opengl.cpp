@@ -0,0 +1,1089 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+
+#include "log.h"
+#include "graphics.h"
+
+#pragma comment(lib, "dxgi.lib")
+
+// The Windows SDK only declares OpenGL 1.1. Declare the few newer types, constants and entry points that are needed,
+// rather than depending on glext.h.
+#ifndef GL_VERSION_3_2
+typedef struct __GLsync* GLsync;
+typedef uint64_t GLuint64;
+#endif
+
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#define GL_TEXTURE_2D_MULTISAMPLE 0x9100
+#define GL_TEXTURE_2D_MULTISAMPLE_ARRAY 0x9102
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_WAIT_FAILED 0x911D
+#define GL_TIMESTAMP 0x8E28
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_DEDICATED_MEMORY_OBJECT_EXT 0x9581
+#define GL_HANDLE_TYPE_D3D12_RESOURCE_EXT 0x958A
+#define GL_HANDLE_TYPE_D3D11_IMAGE_EXT 0x958B
+#define GL_HANDLE_TYPE_D3D11_IMAGE_KMT_EXT 0x958C
+#define GL_HANDLE_TYPE_D3D12_FENCE_EXT 0x9594
+#define GL_D3D12_FENCE_VALUE_EXT 0x9595
+
+#define GL_RGBA8 0x8058
+#define GL_RGB10_A2 0x8059
+#define GL_RGBA16 0x805B
+#define GL_SRGB8_ALPHA8 0x8C43
+#define GL_R11F_G11F_B10F 0x8C3A
+#define GL_RGBA16F 0x881A
+#define GL_RGBA32F 0x8814
+#define GL_DEPTH_COMPONENT16 0x81A5
+#define GL_DEPTH24_STENCIL8 0x88F0
+#define GL_DEPTH_COMPONENT32F 0x8CAC
+#define GL_DEPTH32F_STENCIL8 0x8CAD
+
+typedef void(APIENTRY* PFNGLCOPYIMAGESUBDATAPROC)(GLuint srcName,
+                                                  GLenum srcTarget,
+                                                  GLint srcLevel,
+                                                  GLint srcX,
+                                                  GLint srcY,
+                                                  GLint srcZ,
+                                                  GLuint dstName,
+                                                  GLenum dstTarget,
+                                                  GLint dstLevel,
+                                                  GLint dstX,
+                                                  GLint dstY,
+                                                  GLint dstZ,
+                                                  GLsizei srcWidth,
+                                                  GLsizei srcHeight,
+                                                  GLsizei srcDepth);
+typedef GLsync(APIENTRY* PFNGLFENCESYNCPROC)(GLenum condition, GLbitfield flags);
+typedef void(APIENTRY* PFNGLDELETESYNCPROC)(GLsync sync);
+typedef GLenum(APIENTRY* PFNGLCLIENTWAITSYNCPROC)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void(APIENTRY* PFNGLWAITSYNCPROC)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void(APIENTRY* PFNGLGENQUERIESPROC)(GLsizei n, GLuint* ids);
+typedef void(APIENTRY* PFNGLDELETEQUERIESPROC)(GLsizei n, const GLuint* ids);
+typedef void(APIENTRY* PFNGLQUERYCOUNTERPROC)(GLuint id, GLenum target);
+typedef void(APIENTRY* PFNGLGETQUERYOBJECTIVPROC)(GLuint id, GLenum pname, GLint* params);
+typedef void(APIENTRY* PFNGLGETQUERYOBJECTUI64VPROC)(GLuint id, GLenum pname, GLuint64* params);
+typedef void(APIENTRY* PFNGLCREATETEXTURESPROC)(GLenum target, GLsizei n, GLuint* textures);
+typedef void(APIENTRY* PFNGLTEXTURESTORAGE2DPROC)(
+    GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void(APIENTRY* PFNGLTEXTURESTORAGE3DPROC)(
+    GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+typedef void(APIENTRY* PFNGLCREATEMEMORYOBJECTSEXTPROC)(GLsizei n, GLuint* memoryObjects);
+typedef void(APIENTRY* PFNGLDELETEMEMORYOBJECTSEXTPROC)(GLsizei n, const GLuint* memoryObjects);
+typedef void(APIENTRY* PFNGLMEMORYOBJECTPARAMETERIVEXTPROC)(GLuint memoryObject, GLenum pname, const GLint* params);
+typedef void(APIENTRY* PFNGLIMPORTMEMORYWIN32HANDLEEXTPROC)(GLuint memory,
+                                                            GLuint64 size,
+                                                            GLenum handleType,
+                                                            void* handle);
+typedef void(APIENTRY* PFNGLTEXTURESTORAGEMEM2DEXTPROC)(GLuint texture,
+                                                        GLsizei levels,
+                                                        GLenum internalFormat,
+                                                        GLsizei width,
+                                                        GLsizei height,
+                                                        GLuint memory,
+                                                        GLuint64 offset);
+typedef void(APIENTRY* PFNGLTEXTURESTORAGEMEM3DEXTPROC)(GLuint texture,
+                                                        GLsizei levels,
+                                                        GLenum internalFormat,
+                                                        GLsizei width,
+                                                        GLsizei height,
+                                                        GLsizei depth,
+                                                        GLuint memory,
+                                                        GLuint64 offset);
+typedef void(APIENTRY* PFNGLGENSEMAPHORESEXTPROC)(GLsizei n, GLuint* semaphores);
+typedef void(APIENTRY* PFNGLDELETESEMAPHORESEXTPROC)(GLsizei n, const GLuint* semaphores);
+typedef void(APIENTRY* PFNGLSEMAPHOREPARAMETERUI64VEXTPROC)(GLuint semaphore, GLenum pname, const GLuint64* params);
+typedef void(APIENTRY* PFNGLIMPORTSEMAPHOREWIN32HANDLEEXTPROC)(GLuint semaphore, GLenum handleType, void* handle);
+typedef void(APIENTRY* PFNGLSIGNALSEMAPHOREEXTPROC)(GLuint semaphore,
+                                                    GLuint numBufferBarriers,
+                                                    const GLuint* buffers,
+                                                    GLuint numTextureBarriers,
+                                                    const GLuint* textures,
+                                                    const GLenum* dstLayouts);
+typedef void(APIENTRY* PFNGLWAITSEMAPHOREEXTPROC)(GLuint semaphore,
+                                                  GLuint numBufferBarriers,
+                                                  const GLuint* buffers,
+                                                  GLuint numTextureBarriers,
+                                                  const GLuint* textures,
+                                                  const GLenum* srcLayouts);
+
+namespace {
+
+    using namespace openxr_api_layer::log;
+    using namespace openxr_api_layer::utils::graphics;
+
+    struct FormatEntry {
+        GLenum glFormat;
+        DXGI_FORMAT dxgiFormat;
+        uint32_t bytesPerPixel;
+    };
+
+    // The formats commonly offered by runtimes for OpenGL swapchains.
+    constexpr FormatEntry FormatTable[] = {
+        {GL_RGBA8, DXGI_FORMAT_R8G8B8A8_UNORM, 4},
+        {GL_SRGB8_ALPHA8, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4},
+        {GL_RGB10_A2, DXGI_FORMAT_R10G10B10A2_UNORM, 4},
+        {GL_R11F_G11F_B10F, DXGI_FORMAT_R11G11B10_FLOAT, 4},
+        {GL_RGBA16, DXGI_FORMAT_R16G16B16A16_UNORM, 8},
+        {GL_RGBA16F, DXGI_FORMAT_R16G16B16A16_FLOAT, 8},
+        {GL_RGBA32F, DXGI_FORMAT_R32G32B32A32_FLOAT, 16},
+        {GL_DEPTH_COMPONENT16, DXGI_FORMAT_D16_UNORM, 2},
+        {GL_DEPTH24_STENCIL8, DXGI_FORMAT_D24_UNORM_S8_UINT, 4},
+        {GL_DEPTH_COMPONENT32F, DXGI_FORMAT_D32_FLOAT, 4},
+        {GL_DEPTH32F_STENCIL8, DXGI_FORMAT_D32_FLOAT_S8X24_UINT, 8},
+    };
+
+    GLenum getTextureTarget(const XrSwapchainCreateInfo& info) {
+        if (info.sampleCount > 1) {
+            return info.arraySize > 1 ? GL_TEXTURE_2D_MULTISAMPLE_ARRAY : GL_TEXTURE_2D_MULTISAMPLE;
+        }
+        return info.arraySize > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+    }
+
+    // The size of the memory backing a texture, needed when importing it.
+    uint64_t getTextureMemorySize(const XrSwapchainCreateInfo& info) {
+        uint32_t bytesPerPixel = 4;
+        for (const FormatEntry& entry : FormatTable) {
+            if (entry.glFormat == (GLenum)info.format) {
+                bytesPerPixel = entry.bytesPerPixel;
+                break;
+            }
+        }
+
+        uint64_t size = 0;
+        for (uint32_t mipLevel = 0; mipLevel < info.mipCount; mipLevel++) {
+            size += (uint64_t)std::max(info.width >> mipLevel, 1u) * std::max(info.height >> mipLevel, 1u);
+        }
+        return size * info.arraySize * info.sampleCount * bytesPerPixel;
+    }
+
+    // The OpenGL 1.1 and WGL entry points, from the opengl32.dll loaded by the application. The layer does not link
+    // with opengl32.lib, so that loading the layer does not load OpenGL into the applications of other graphics APIs.
+    struct OpenGL32Dispatch {
+        decltype(&::wglGetProcAddress) wglGetProcAddress{};
+        decltype(&::wglGetCurrentContext) wglGetCurrentContext{};
+        decltype(&::wglGetCurrentDC) wglGetCurrentDC{};
+        decltype(&::wglMakeCurrent) wglMakeCurrent{};
+        decltype(&::glGetError) glGetError{};
+        decltype(&::glGetString) glGetString{};
+        decltype(&::glFlush) glFlush{};
+        decltype(&::glFinish) glFinish{};
+        decltype(&::glDeleteTextures) glDeleteTextures{};
+    };
+
+    const OpenGL32Dispatch& getOpenGL32() {
+        static const OpenGL32Dispatch dispatch = [] {
+            const HMODULE module = GetModuleHandle(L"opengl32.dll");
+            if (!module) {
+                throw std::runtime_error("opengl32.dll is not loaded");
+            }
+
+            OpenGL32Dispatch dispatch;
+#define GET_PROC(name) dispatch.name = reinterpret_cast<decltype(dispatch.name)>(GetProcAddress(module, #name))
+            GET_PROC(wglGetProcAddress);
+            GET_PROC(wglGetCurrentContext);
+            GET_PROC(wglGetCurrentDC);
+            GET_PROC(wglMakeCurrent);
+            GET_PROC(glGetError);
+            GET_PROC(glGetString);
+            GET_PROC(glFlush);
+            GET_PROC(glFinish);
+            GET_PROC(glDeleteTextures);
+#undef GET_PROC
+
+            if (!dispatch.wglGetProcAddress || !dispatch.wglGetCurrentContext || !dispatch.wglGetCurrentDC ||
+                !dispatch.wglMakeCurrent || !dispatch.glGetError || !dispatch.glGetString || !dispatch.glFlush ||
+                !dispatch.glFinish || !dispatch.glDeleteTextures) {
+                throw std::runtime_error("Failed to resolve the entry points of opengl32.dll");
+            }
+            return dispatch;
+        }();
+        return dispatch;
+    }
+
+    void checkGLError(const char* what) {
+        const GLenum error = getOpenGL32().glGetError();
+        if (error != GL_NO_ERROR) {
+            throw std::runtime_error(fmt::format("{} failed with OpenGL error {}", what, error));
+        }
+    }
+
+    // Make the application's OpenGL context current for the scope, unless it already is.
+    class ScopedContext {
+      public:
+        ScopedContext(HDC dc, HGLRC glrc) : m_opengl32(getOpenGL32()) {
+            if (m_opengl32.wglGetCurrentContext() == glrc) {
+                m_isValid = true;
+                return;
+            }
+
+            m_previousDC = m_opengl32.wglGetCurrentDC();
+            m_previousGLRC = m_opengl32.wglGetCurrentContext();
+            // Fails if the context is current on another thread.
+            m_isValid = m_needRestore = m_opengl32.wglMakeCurrent(dc, glrc);
+        }
+
+        ~ScopedContext() {
+            if (m_needRestore) {
+                m_opengl32.wglMakeCurrent(m_previousDC, m_previousGLRC);
+            }
+        }
+
+        ScopedContext(const ScopedContext&) = delete;
+        ScopedContext& operator=(const ScopedContext&) = delete;
+
+        bool isValid() const {
+            return m_isValid;
+        }
+
+      private:
+        const OpenGL32Dispatch& m_opengl32;
+        bool m_isValid{false};
+        bool m_needRestore{false};
+        HDC m_previousDC{nullptr};
+        HGLRC m_previousGLRC{nullptr};
+    };
+
+    // The entry points used by the backend, beyond OpenGL 1.1.
+    struct OpenGLDispatch {
+        PFNGLCOPYIMAGESUBDATAPROC glCopyImageSubData{};
+        PFNGLFENCESYNCPROC glFenceSync{};
+        PFNGLDELETESYNCPROC glDeleteSync{};
+        PFNGLCLIENTWAITSYNCPROC glClientWaitSync{};
+        PFNGLWAITSYNCPROC glWaitSync{};
+        PFNGLGENQUERIESPROC glGenQueries{};
+        PFNGLDELETEQUERIESPROC glDeleteQueries{};
+        PFNGLQUERYCOUNTERPROC glQueryCounter{};
+        PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv{};
+        PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v{};
+        PFNGLCREATETEXTURESPROC glCreateTextures{};
+        PFNGLTEXTURESTORAGE2DPROC glTextureStorage2D{};
+        PFNGLTEXTURESTORAGE3DPROC glTextureStorage3D{};
+
+        // Only available with EXT_memory_object_win32 and EXT_semaphore_win32.
+        PFNGLCREATEMEMORYOBJECTSEXTPROC glCreateMemoryObjectsEXT{};
+        PFNGLDELETEMEMORYOBJECTSEXTPROC glDeleteMemoryObjectsEXT{};
+        PFNGLMEMORYOBJECTPARAMETERIVEXTPROC glMemoryObjectParameterivEXT{};
+        PFNGLIMPORTMEMORYWIN32HANDLEEXTPROC glImportMemoryWin32HandleEXT{};
+        PFNGLTEXTURESTORAGEMEM2DEXTPROC glTextureStorageMem2DEXT{};
+        PFNGLTEXTURESTORAGEMEM3DEXTPROC glTextureStorageMem3DEXT{};
+        PFNGLGENSEMAPHORESEXTPROC glGenSemaphoresEXT{};
+        PFNGLDELETESEMAPHORESEXTPROC glDeleteSemaphoresEXT{};
+        PFNGLSEMAPHOREPARAMETERUI64VEXTPROC glSemaphoreParameterui64vEXT{};
+        PFNGLIMPORTSEMAPHOREWIN32HANDLEEXTPROC glImportSemaphoreWin32HandleEXT{};
+        PFNGLSIGNALSEMAPHOREEXTPROC glSignalSemaphoreEXT{};
+        PFNGLWAITSEMAPHOREEXTPROC glWaitSemaphoreEXT{};
+
+        // Must be called with the context current.
+        void load() {
+            const auto wglGetProcAddress = getOpenGL32().wglGetProcAddress;
+#define GET_PROC(name, type) name = reinterpret_cast<type>(wglGetProcAddress(#name))
+            GET_PROC(glCopyImageSubData, PFNGLCOPYIMAGESUBDATAPROC);
+            GET_PROC(glFenceSync, PFNGLFENCESYNCPROC);
+            GET_PROC(glDeleteSync, PFNGLDELETESYNCPROC);
+            GET_PROC(glClientWaitSync, PFNGLCLIENTWAITSYNCPROC);
+            GET_PROC(glWaitSync, PFNGLWAITSYNCPROC);
+            GET_PROC(glGenQueries, PFNGLGENQUERIESPROC);
+            GET_PROC(glDeleteQueries, PFNGLDELETEQUERIESPROC);
+            GET_PROC(glQueryCounter, PFNGLQUERYCOUNTERPROC);
+            GET_PROC(glGetQueryObjectiv, PFNGLGETQUERYOBJECTIVPROC);
+            GET_PROC(glGetQueryObjectui64v, PFNGLGETQUERYOBJECTUI64VPROC);
+            GET_PROC(glCreateTextures, PFNGLCREATETEXTURESPROC);
+            GET_PROC(glTextureStorage2D, PFNGLTEXTURESTORAGE2DPROC);
+            GET_PROC(glTextureStorage3D, PFNGLTEXTURESTORAGE3DPROC);
+            GET_PROC(glCreateMemoryObjectsEXT, PFNGLCREATEMEMORYOBJECTSEXTPROC);
+            GET_PROC(glDeleteMemoryObjectsEXT, PFNGLDELETEMEMORYOBJECTSEXTPROC);
+            GET_PROC(glMemoryObjectParameterivEXT, PFNGLMEMORYOBJECTPARAMETERIVEXTPROC);
+            GET_PROC(glImportMemoryWin32HandleEXT, PFNGLIMPORTMEMORYWIN32HANDLEEXTPROC);
+            GET_PROC(glTextureStorageMem2DEXT, PFNGLTEXTURESTORAGEMEM2DEXTPROC);
+            GET_PROC(glTextureStorageMem3DEXT, PFNGLTEXTURESTORAGEMEM3DEXTPROC);
+            GET_PROC(glGenSemaphoresEXT, PFNGLGENSEMAPHORESEXTPROC);
+            GET_PROC(glDeleteSemaphoresEXT, PFNGLDELETESEMAPHORESEXTPROC);
+            GET_PROC(glSemaphoreParameterui64vEXT, PFNGLSEMAPHOREPARAMETERUI64VEXTPROC);
+            GET_PROC(glImportSemaphoreWin32HandleEXT, PFNGLIMPORTSEMAPHOREWIN32HANDLEEXTPROC);
+            GET_PROC(glSignalSemaphoreEXT, PFNGLSIGNALSEMAPHOREEXTPROC);
+            GET_PROC(glWaitSemaphoreEXT, PFNGLWAITSEMAPHOREEXTPROC);
+#undef GET_PROC
+
+            if (!glCopyImageSubData || !glFenceSync || !glQueryCounter || !glCreateTextures) {
+                throw std::runtime_error("OpenGL 4.5 is required");
+            }
+        }
+
+        bool hasExternalObjects() const {
+            return glCreateMemoryObjectsEXT && glImportMemoryWin32HandleEXT && glTextureStorageMem2DEXT &&
+                   glGenSemaphoresEXT && glImportSemaphoreWin32HandleEXT && glSemaphoreParameterui64vEXT;
+        }
+    };
+
+    // The state shared by the device and all the objects it creates.
+    struct OpenGLContext {
+        OpenGLContext(const XrGraphicsBindingOpenGLWin32KHR& bindings) : dc(bindings.hDC), glrc(bindings.hGLRC) {
+            ScopedContext scope(dc, glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+            gl.load();
+            renderer = reinterpret_cast<const char*>(getOpenGL32().glGetString(GL_RENDERER));
+        }
+
+        OpenGLDispatch gl;
+        const HDC dc;
+        const HGLRC glrc;
+        std::string renderer;
+    };
+
+    struct OpenGLTimer : IGraphicsTimer {
+        OpenGLTimer(std::shared_ptr<OpenGLContext> context) : m_context(context) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLTimer_Create");
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+            m_context->gl.glGenQueries(2, m_queries);
+
+            TraceLoggingWriteStop(local, "OpenGLTimer_Create", TLPArg(this, "Timer"));
+        }
+
+        ~OpenGLTimer() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLTimer_Destroy", TLPArg(this, "Timer"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (scope.isValid()) {
+                m_context->gl.glDeleteQueries(2, m_queries);
+            }
+
+            TraceLoggingWriteStop(local, "OpenGLTimer_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::OpenGL;
+        }
+
+        void start() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLTimer_Start", TLPArg(this, "Timer"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (scope.isValid()) {
+                m_context->gl.glQueryCounter(m_queries[0], GL_TIMESTAMP);
+            }
+            m_valid = false;
+
+            TraceLoggingWriteStop(local, "OpenGLTimer_Start");
+        }
+
+        void stop() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLTimer_Stop", TLPArg(this, "Timer"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (scope.isValid()) {
+                m_context->gl.glQueryCounter(m_queries[1], GL_TIMESTAMP);
+                m_valid = true;
+            }
+
+            TraceLoggingWriteStop(local, "OpenGLTimer_Stop");
+        }
+
+        uint64_t query() const override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLTimer_Query", TLPArg(this, "Timer"), TLArg(m_valid, "Valid"));
+
+            uint64_t duration = 0;
+            if (m_valid) {
+                // Never wait for the GPU: a measurement that is not ready is lost.
+                ScopedContext scope(m_context->dc, m_context->glrc);
+                GLint available = 0;
+                if (scope.isValid()) {
+                    m_context->gl.glGetQueryObjectiv(m_queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+                }
+                if (available) {
+                    GLuint64 startTime = 0, endTime = 0;
+                    m_context->gl.glGetQueryObjectui64v(m_queries[0], GL_QUERY_RESULT, &startTime);
+                    m_context->gl.glGetQueryObjectui64v(m_queries[1], GL_QUERY_RESULT, &endTime);
+                    duration = (endTime - startTime) / 1000;
+                }
+                m_valid = false;
+            }
+
+            TraceLoggingWriteStop(local, "OpenGLTimer_Query", TLArg(duration, "Duration"));
+
+            return duration;
+        }
+
+        const std::shared_ptr<OpenGLContext> m_context;
+        GLuint m_queries[2]{};
+
+        // Can the timer be queried (it might still only read 0).
+        mutable bool m_valid{false};
+    };
+
+    // A fence local to the OpenGL context, built from one GLsync per signaled value.
+    struct OpenGLSyncFence : IGraphicsFence {
+        OpenGLSyncFence(std::shared_ptr<OpenGLContext> context) : m_context(context) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLSyncFence_Create");
+            TraceLoggingWriteStop(local, "OpenGLSyncFence_Create", TLPArg(this, "Fence"));
+        }
+
+        ~OpenGLSyncFence() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLSyncFence_Destroy", TLPArg(this, "Fence"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (scope.isValid()) {
+                for (const auto& [value, sync] : m_syncs) {
+                    m_context->gl.glDeleteSync(sync);
+                }
+            }
+
+            TraceLoggingWriteStop(local, "OpenGLSyncFence_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::OpenGL;
+        }
+
+        void* getNativeFencePtr() const override {
+            return nullptr;
+        }
+
+        ShareableHandle getFenceHandle() const override {
+            throw std::runtime_error("Fence is not shareable");
+        }
+
+        void signal(uint64_t value) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLSyncFence_Signal", TLPArg(this, "Fence"), TLArg(value, "Value"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+
+            // Forget the values that are known to be reached.
+            while (m_syncs.size() > 1 && isSignaled(m_syncs.front().second)) {
+                m_context->gl.glDeleteSync(m_syncs.front().second);
+                m_syncs.pop_front();
+            }
+            m_syncs.push_back({value, m_context->gl.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+            getOpenGL32().glFlush();
+
+            TraceLoggingWriteStop(local, "OpenGLSyncFence_Signal");
+        }
+
+        void waitOnDevice(uint64_t value) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLSyncFence_Wait",
+                                   TLPArg(this, "Fence"),
+                                   TLArg("Device", "WaitType"),
+                                   TLArg(value, "Value"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+            m_context->gl.glWaitSync(getSync(value), 0, GL_TIMEOUT_IGNORED);
+
+            TraceLoggingWriteStop(local, "OpenGLSyncFence_Wait");
+        }
+
+        bool waitOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            signal(value);
+            return waitForValueOnCpu(value, policy);
+        }
+
+        bool waitForValueOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLSyncFence_Wait",
+                                   TLPArg(this, "Fence"),
+                                   TLArg("Host", "WaitType"),
+                                   TLArg(value, "Value"),
+                                   TLArg(policy.spinCount, "SpinCount"),
+                                   TLArg(policy.timeoutMs, "TimeoutMs"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+            const GLsync sync = getSync(value);
+            bool completed = false;
+            for (uint32_t i = 0; i < policy.spinCount && !completed; i++) {
+                completed = isSignaled(sync);
+                YieldProcessor();
+            }
+            if (!completed) {
+                const GLuint64 timeoutNs =
+                    policy.timeoutMs != INFINITE ? static_cast<GLuint64>(policy.timeoutMs) * 1000000 : UINT64_MAX;
+                const GLenum result = m_context->gl.glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNs);
+                if (result == GL_WAIT_FAILED) {
+                    throw std::runtime_error("glClientWaitSync() failed");
+                }
+                completed = result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+            }
+
+            TraceLoggingWriteStop(local, "OpenGLSyncFence_Wait", TLArg(completed, "Completed"));
+
+            return completed;
+        }
+
+        bool isShareable() const override {
+            return false;
+        }
+
+        bool isSignaled(GLsync sync) const {
+            const GLenum result = m_context->gl.glClientWaitSync(sync, 0, 0);
+            return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+        }
+
+        // The first sync object reaching the value. A GLsync cannot be waited on before it is created.
+        GLsync getSync(uint64_t value) const {
+            for (const auto& [syncValue, sync] : m_syncs) {
+                if (syncValue >= value) {
+                    return sync;
+                }
+            }
+            throw std::runtime_error("Fence value was not signaled");
+        }
+
+        const std::shared_ptr<OpenGLContext> m_context;
+        std::deque<std::pair<uint64_t, GLsync>> m_syncs;
+    };
+
+    // A fence shared with D3D, imported through EXT_semaphore_win32.
+    struct OpenGLSemaphoreFence : IGraphicsFence {
+        OpenGLSemaphoreFence(std::shared_ptr<OpenGLContext> context, GLuint semaphore)
+            : m_context(context), m_semaphore(semaphore) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLSemaphoreFence_Create", TLArg(semaphore, "Semaphore"));
+            TraceLoggingWriteStop(local, "OpenGLSemaphoreFence_Create", TLPArg(this, "Fence"));
+        }
+
+        ~OpenGLSemaphoreFence() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLSemaphoreFence_Destroy", TLPArg(this, "Fence"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (scope.isValid()) {
+                m_context->gl.glDeleteSemaphoresEXT(1, &m_semaphore);
+            }
+
+            TraceLoggingWriteStop(local, "OpenGLSemaphoreFence_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::OpenGL;
+        }
+
+        void* getNativeFencePtr() const override {
+            return reinterpret_cast<void*>(static_cast<uintptr_t>(m_semaphore));
+        }
+
+        ShareableHandle getFenceHandle() const override {
+            throw std::runtime_error("Fence is not shareable");
+        }
+
+        void signal(uint64_t value) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "OpenGLSemaphoreFence_Signal", TLPArg(this, "Fence"), TLArg(value, "Value"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+            m_context->gl.glSemaphoreParameterui64vEXT(m_semaphore, GL_D3D12_FENCE_VALUE_EXT, &value);
+            m_context->gl.glSignalSemaphoreEXT(m_semaphore, 0, nullptr, 0, nullptr, nullptr);
+            getOpenGL32().glFlush();
+
+            TraceLoggingWriteStop(local, "OpenGLSemaphoreFence_Signal");
+        }
+
+        void waitOnDevice(uint64_t value) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLSemaphoreFence_Wait",
+                                   TLPArg(this, "Fence"),
+                                   TLArg("Device", "WaitType"),
+                                   TLArg(value, "Value"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+            m_context->gl.glSemaphoreParameterui64vEXT(m_semaphore, GL_D3D12_FENCE_VALUE_EXT, &value);
+            m_context->gl.glWaitSemaphoreEXT(m_semaphore, 0, nullptr, 0, nullptr, nullptr);
+
+            TraceLoggingWriteStop(local, "OpenGLSemaphoreFence_Wait");
+        }
+
+        // OpenGL cannot wait for a semaphore on the CPU: drain the context instead. The wait policy does not apply.
+        bool waitOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLSemaphoreFence_Wait",
+                                   TLPArg(this, "Fence"),
+                                   TLArg("Host", "WaitType"),
+                                   TLArg(value, "Value"));
+
+            signal(value);
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+            getOpenGL32().glFinish();
+
+            TraceLoggingWriteStop(local, "OpenGLSemaphoreFence_Wait");
+
+            return true;
+        }
+
+        bool waitForValueOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            throw std::runtime_error("OpenGL cannot wait for a semaphore on the CPU");
+        }
+
+        bool isShareable() const override {
+            return false;
+        }
+
+        const std::shared_ptr<OpenGLContext> m_context;
+        const GLuint m_semaphore;
+    };
+
+    struct OpenGLTexture : IGraphicsTexture {
+        // When a memory object is provided, the texture owns the texture name and the memory object.
+        OpenGLTexture(std::shared_ptr<OpenGLContext> context,
+                      GLuint texture,
+                      bool ownsTexture,
+                      GLuint memory,
+                      const XrSwapchainCreateInfo& info)
+            : m_context(context), m_texture(texture), m_ownsTexture(ownsTexture), m_memory(memory), m_info(info),
+              m_target(getTextureTarget(info)) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLTexture_Create", TLArg(texture, "Texture"));
+            TraceLoggingWriteTagged(local,
+                                    "OpenGLTexture_Create",
+                                    TLArg(info.width, "Width"),
+                                    TLArg(info.height, "Height"),
+                                    TLArg(info.arraySize, "ArraySize"),
+                                    TLArg(info.mipCount, "MipCount"),
+                                    TLArg(info.sampleCount, "SampleCount"),
+                                    TLArg(info.format, "Format"),
+                                    TLArg(info.usageFlags, "Usage"));
+            TraceLoggingWriteStop(local, "OpenGLTexture_Create", TLPArg(this, "Texture"));
+        }
+
+        ~OpenGLTexture() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLTexture_Destroy", TLPArg(this, "Texture"));
+
+            if (m_ownsTexture) {
+                ScopedContext scope(m_context->dc, m_context->glrc);
+                if (scope.isValid()) {
+                    getOpenGL32().glDeleteTextures(1, &m_texture);
+                    if (m_memory) {
+                        m_context->gl.glDeleteMemoryObjectsEXT(1, &m_memory);
+                    }
+                }
+            }
+
+            TraceLoggingWriteStop(local, "OpenGLTexture_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::OpenGL;
+        }
+
+        void* getNativeTexturePtr() const override {
+            return reinterpret_cast<void*>(static_cast<uintptr_t>(m_texture));
+        }
+
+        ShareableHandle getTextureHandle() const override {
+            throw std::runtime_error("Texture is not shareable");
+        }
+
+        const XrSwapchainCreateInfo& getInfo() const override {
+            return m_info;
+        }
+
+        bool isShareable() const override {
+            return false;
+        }
+
+        const std::shared_ptr<OpenGLContext> m_context;
+        const GLuint m_texture;
+        const bool m_ownsTexture;
+        const GLuint m_memory;
+        const XrSwapchainCreateInfo m_info;
+        const GLenum m_target;
+    };
+
+    // Textures shared with D3D are not flipped: OpenGL's bottom-left origin means that the composition device sees
+    // the images upside down.
+    struct OpenGLGraphicsDevice : IGraphicsDevice {
+        OpenGLGraphicsDevice(const XrGraphicsBindingOpenGLWin32KHR& bindings)
+            : m_context(std::make_shared<OpenGLContext>(bindings)) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLGraphicsDevice_Create",
+                                   TLPArg(bindings.hDC, "DC"),
+                                   TLPArg(bindings.hGLRC, "GLRC"));
+
+            TraceLoggingWriteTagged(local,
+                                    "OpenGLGraphicsDevice_Create",
+                                    TLArg(m_context->renderer.c_str(), "Adapter"),
+                                    TLArg(m_context->gl.hasExternalObjects(), "ExternalObjects"));
+
+            TraceLoggingWriteStop(local, "OpenGLGraphicsDevice_Create", TLPArg(this, "Device"));
+        }
+
+        ~OpenGLGraphicsDevice() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLGraphicsDevice_Destroy", TLPArg(this, "Device"));
+            TraceLoggingWriteStop(local, "OpenGLGraphicsDevice_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::OpenGL;
+        }
+
+        void* getNativeDevicePtr() const override {
+            return m_context->glrc;
+        }
+
+        void* getNativeContextPtr() const override {
+            return m_context->dc;
+        }
+
+        std::shared_ptr<IGraphicsTimer> createTimer() override {
+            return std::make_shared<OpenGLTimer>(m_context);
+        }
+
+        std::shared_ptr<IGraphicsTimerPool> createTimerPool(uint32_t frameLatency) override {
+            throw std::runtime_error("Timer pools are not supported on OpenGL");
+        }
+
+        std::shared_ptr<IGraphicsFence> createFence(bool shareable) override {
+            if (shareable) {
+                throw std::runtime_error("Exporting OpenGL fences is not supported");
+            }
+            return std::make_shared<OpenGLSyncFence>(m_context);
+        }
+
+        std::shared_ptr<IGraphicsFence> openFence(const ShareableHandle& handle) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLFence_Import",
+                                   TLArg(!handle.isNtHandle ? handle.handle : handle.ntHandle.get(), "Handle"),
+                                   TLArg(handle.isNtHandle, "IsNTHandle"));
+
+            if (!handle.isNtHandle) {
+                throw std::runtime_error("Must be NTHANDLE");
+            }
+            if (!m_context->gl.hasExternalObjects()) {
+                throw std::runtime_error("OpenGL context does not support EXT_semaphore_win32");
+            }
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+
+            // D3D11 and D3D12 fences are both shared as D3D12 fences.
+            GLuint semaphore;
+            m_context->gl.glGenSemaphoresEXT(1, &semaphore);
+            std::shared_ptr<IGraphicsFence> result = std::make_shared<OpenGLSemaphoreFence>(m_context, semaphore);
+            m_context->gl.glImportSemaphoreWin32HandleEXT(
+                semaphore, GL_HANDLE_TYPE_D3D12_FENCE_EXT, handle.ntHandle.get());
+            checkGLError("glImportSemaphoreWin32HandleEXT()");
+
+            TraceLoggingWriteStop(local, "OpenGLFence_Import", TLPArg(result.get(), "Fence"));
+
+            return result;
+        }
+
+        std::shared_ptr<IGraphicsTexture> createTexture(const XrSwapchainCreateInfo& info, bool shareable) override {
+            if (shareable) {
+                throw std::runtime_error("Exporting OpenGL textures is not supported");
+            }
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+
+            const GLenum target = getTextureTarget(info);
+            GLuint texture;
+            m_context->gl.glCreateTextures(target, 1, &texture);
+            if (target == GL_TEXTURE_2D_ARRAY) {
+                m_context->gl.glTextureStorage3D(
+                    texture, info.mipCount, (GLenum)info.format, info.width, info.height, info.arraySize);
+            } else {
+                m_context->gl.glTextureStorage2D(texture, info.mipCount, (GLenum)info.format, info.width, info.height);
+            }
+            checkGLError("glTextureStorage()");
+
+            return std::make_shared<OpenGLTexture>(m_context, texture, true /* ownsTexture */, 0, info);
+        }
+
+        std::shared_ptr<IGraphicsTexture> openTexture(const ShareableHandle& handle,
+                                                      const XrSwapchainCreateInfo& info) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLTexture_Import",
+                                   TLArg(!handle.isNtHandle ? handle.handle : handle.ntHandle.get(), "Handle"),
+                                   TLArg(handle.isNtHandle, "IsNTHandle"));
+
+            if (!m_context->gl.hasExternalObjects()) {
+                throw std::runtime_error("OpenGL context does not support EXT_memory_object_win32");
+            }
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+
+#ifdef XR_USE_GRAPHICS_API_D3D12
+            const bool isD3D12Resource = handle.origin == Api::D3D12;
+#else
+            const bool isD3D12Resource = false;
+#endif
+            const GLenum handleType = isD3D12Resource      ? GL_HANDLE_TYPE_D3D12_RESOURCE_EXT
+                                      : handle.isNtHandle ? GL_HANDLE_TYPE_D3D11_IMAGE_EXT
+                                                          : GL_HANDLE_TYPE_D3D11_IMAGE_KMT_EXT;
+
+            GLuint memory;
+            m_context->gl.glCreateMemoryObjectsEXT(1, &memory);
+            const GLint dedicated = GL_TRUE;
+            m_context->gl.glMemoryObjectParameterivEXT(memory, GL_DEDICATED_MEMORY_OBJECT_EXT, &dedicated);
+            m_context->gl.glImportMemoryWin32HandleEXT(memory,
+                                                       getTextureMemorySize(info),
+                                                       handleType,
+                                                       handle.isNtHandle ? handle.ntHandle.get() : handle.handle);
+
+            const GLenum target = getTextureTarget(info);
+            GLuint texture;
+            m_context->gl.glCreateTextures(target, 1, &texture);
+            if (target == GL_TEXTURE_2D_ARRAY) {
+                m_context->gl.glTextureStorageMem3DEXT(
+                    texture, info.mipCount, (GLenum)info.format, info.width, info.height, info.arraySize, memory, 0);
+            } else {
+                m_context->gl.glTextureStorageMem2DEXT(
+                    texture, info.mipCount, (GLenum)info.format, info.width, info.height, memory, 0);
+            }
+            std::shared_ptr<IGraphicsTexture> result =
+                std::make_shared<OpenGLTexture>(m_context, texture, true /* ownsTexture */, memory, info);
+            checkGLError("glImportMemoryWin32HandleEXT()");
+
+            TraceLoggingWriteStop(local, "OpenGLTexture_Import", TLPArg(result.get(), "Texture"));
+
+            return result;
+        }
+
+        std::shared_ptr<IGraphicsTexture> openTexturePtr(void* nativeTexturePtr,
+                                                         const XrSwapchainCreateInfo& info) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "OpenGLTexture_Import", TLPArg(nativeTexturePtr, "Texture"));
+
+            const GLuint texture = static_cast<GLuint>(reinterpret_cast<uintptr_t>(nativeTexturePtr));
+            std::shared_ptr<IGraphicsTexture> result =
+                std::make_shared<OpenGLTexture>(m_context, texture, false /* ownsTexture */, 0, info);
+
+            TraceLoggingWriteStop(local, "OpenGLTexture_Import", TLPArg(result.get(), "Texture"));
+
+            return result;
+        }
+
+        std::shared_ptr<IGraphicsReadback> createReadback(int64_t format,
+                                                          uint32_t width,
+                                                          uint32_t height,
+                                                          uint32_t depth) override {
+            throw std::runtime_error("Readback is not supported on OpenGL");
+        }
+
+        void copyTexture(IGraphicsTexture* from, IGraphicsTexture* to) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLGraphicsDevice_CopyTexture",
+                                   TLPArg(this, "Device"),
+                                   TLPArg(from, "Source"),
+                                   TLPArg(to, "Destination"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+
+            const OpenGLTexture* const source = static_cast<OpenGLTexture*>(from);
+            const OpenGLTexture* const destination = static_cast<OpenGLTexture*>(to);
+            const XrSwapchainCreateInfo& info = source->getInfo();
+            for (uint32_t mipLevel = 0; mipLevel < info.mipCount; mipLevel++) {
+                m_context->gl.glCopyImageSubData(source->m_texture,
+                                                 source->m_target,
+                                                 mipLevel,
+                                                 0,
+                                                 0,
+                                                 0,
+                                                 destination->m_texture,
+                                                 destination->m_target,
+                                                 mipLevel,
+                                                 0,
+                                                 0,
+                                                 0,
+                                                 std::max(info.width >> mipLevel, 1u),
+                                                 std::max(info.height >> mipLevel, 1u),
+                                                 info.arraySize);
+            }
+
+            TraceLoggingWriteStop(local, "OpenGLGraphicsDevice_CopyTexture");
+        }
+
+        void copyTextureRegion(IGraphicsTexture* from,
+                               const XrRect2Di& fromRect,
+                               uint32_t fromArraySlice,
+                               IGraphicsTexture* to,
+                               const XrOffset2Di& toOffset,
+                               uint32_t toArraySlice,
+                               uint32_t mipLevel) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "OpenGLGraphicsDevice_CopyTextureRegion",
+                                   TLPArg(this, "Device"),
+                                   TLPArg(from, "Source"),
+                                   TLArg(fromRect.offset.x, "SourceX"),
+                                   TLArg(fromRect.offset.y, "SourceY"),
+                                   TLArg(fromRect.extent.width, "Width"),
+                                   TLArg(fromRect.extent.height, "Height"),
+                                   TLArg(fromArraySlice, "SourceArraySlice"),
+                                   TLPArg(to, "Destination"),
+                                   TLArg(toOffset.x, "DestinationX"),
+                                   TLArg(toOffset.y, "DestinationY"),
+                                   TLArg(toArraySlice, "DestinationArraySlice"),
+                                   TLArg(mipLevel, "MipLevel"));
+
+            ScopedContext scope(m_context->dc, m_context->glrc);
+            if (!scope.isValid()) {
+                throw std::runtime_error("Failed to make the OpenGL context current");
+            }
+
+            const OpenGLTexture* const source = static_cast<OpenGLTexture*>(from);
+            const OpenGLTexture* const destination = static_cast<OpenGLTexture*>(to);
+            m_context->gl.glCopyImageSubData(source->m_texture,
+                                             source->m_target,
+                                             mipLevel,
+                                             fromRect.offset.x,
+                                             fromRect.offset.y,
+                                             fromArraySlice,
+                                             destination->m_texture,
+                                             destination->m_target,
+                                             mipLevel,
+                                             toOffset.x,
+                                             toOffset.y,
+                                             toArraySlice,
+                                             fromRect.extent.width,
+                                             fromRect.extent.height,
+                                             1);
+
+            TraceLoggingWriteStop(local, "OpenGLGraphicsDevice_CopyTextureRegion");
+        }
+
+        void scaleTextureRegion(IGraphicsTexture* from,
+                                const XrRect2Di& fromRect,
+                                uint32_t fromArraySlice,
+                                int64_t fromFormat,
+                                IGraphicsTexture* to,
+                                const XrRect2Di& toRect,
+                                uint32_t toArraySlice,
+                                int64_t toFormat,
+                                ScalingFilter filter) override {
+            throw std::runtime_error("Scaling is not supported on OpenGL");
+        }
+
+        void clearTexture(IGraphicsTexture* texture,
+                          uint32_t arraySlice,
+                          int64_t format,
+                          const XrColor4f& color) override {
+            throw std::runtime_error("Clearing is not supported on OpenGL");
+        }
+
+        GenericFormat translateToGenericFormat(int64_t format) const override {
+            for (const FormatEntry& entry : FormatTable) {
+                if (entry.glFormat == (GLenum)format) {
+                    return entry.dxgiFormat;
+                }
+            }
+            return DXGI_FORMAT_UNKNOWN;
+        }
+
+        int64_t translateFromGenericFormat(GenericFormat format) const override {
+            for (const FormatEntry& entry : FormatTable) {
+                if (entry.dxgiFormat == format) {
+                    return (int64_t)entry.glFormat;
+                }
+            }
+            return 0;
+        }
+
+        // OpenGL does not expose the adapter. Use the primary adapter, which is what runtimes render OpenGL on.
+        LUID getAdapterLuid() const override {
+            ComPtr<IDXGIFactory1> dxgiFactory;
+            CHECK_HRCMD(CreateDXGIFactory1(IID_PPV_ARGS(dxgiFactory.ReleaseAndGetAddressOf())));
+            ComPtr<IDXGIAdapter1> dxgiAdapter;
+            CHECK_HRCMD(dxgiFactory->EnumAdapters1(0, dxgiAdapter.ReleaseAndGetAddressOf()));
+            DXGI_ADAPTER_DESC1 desc;
+            CHECK_HRCMD(dxgiAdapter->GetDesc1(&desc));
+            return desc.AdapterLuid;
+        }
+
+        CommandListStatistics getCommandListStatistics() const override {
+            return {};
+        }
+
+        const std::shared_ptr<OpenGLContext> m_context;
+    };
+
+} // namespace
+
+namespace openxr_api_layer::utils::graphics::internal {
+
+    std::shared_ptr<IGraphicsDevice> wrapApplicationDevice(const XrGraphicsBindingOpenGLWin32KHR& bindings) {
+        return std::make_shared<OpenGLGraphicsDevice>(bindings);
+    }
+
+} // namespace openxr_api_layer::utils::graphics::internal
+
+#endif
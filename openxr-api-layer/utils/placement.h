@@ -0,0 +1,102 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#pragma once
+
+// The placement of the upscaled and padded views in the submitted swapchains. Kept apart from the layer so that the
+// rounding can be tested to the pixel.
+
+namespace openxr_api_layer::utils::placement {
+
+    // Stay away from the singularity of the tangent.
+    constexpr float MaxAngle = 1.5f;
+
+    // The native FOV of a view submitted with the up/down angles scaled by fovUp and fovDown.
+    inline XrFovf getNativeFov(const XrFovf& fov, float fovUp, float fovDown) {
+        XrFovf nativeFov = fov;
+        if (fovUp > 0.f) {
+            nativeFov.angleUp = std::clamp(fov.angleUp / fovUp, -MaxAngle, MaxAngle);
+        }
+        if (fovDown > 0.f) {
+            nativeFov.angleDown = std::clamp(fov.angleDown / fovDown, -MaxAngle, MaxAngle);
+        }
+        return nativeFov;
+    }
+
+    // The ratio of the tangent spans of two FOVs, ie: the height needed for the native FOV at the same density.
+    inline float getPaddingRatio(const XrFovf& fov, const XrFovf& nativeFov) {
+        const float span = tan(fov.angleUp) - tan(fov.angleDown);
+        return span > 0.f ? std::max((tan(nativeFov.angleUp) - tan(nativeFov.angleDown)) / span, 1.f) : 1.f;
+    }
+
+    // The size of the submitted swapchain for an application swapchain of the given size. The height is rounded up so
+    // that the padded views always fit.
+    inline XrExtent2Di getSubmittedSize(const XrExtent2Di& size, float upscalingFactor, float paddingRatio) {
+        return {std::max((int32_t)std::lround(size.width / upscalingFactor), 1),
+                std::max((int32_t)std::ceil(size.height / upscalingFactor * paddingRatio), 1)};
+    }
+
+    // The borders (above, below) in pixels that extend a view of the given height to the native FOV.
+    inline std::pair<int32_t, int32_t> getPadding(const XrFovf& fov, const XrFovf& nativeFov, int32_t height) {
+        const float span = tan(fov.angleUp) - tan(fov.angleDown);
+        if (span <= 0.f) {
+            return {0, 0};
+        }
+        const float pixelsPerTangent = height / span;
+        return {std::max((int32_t)std::lround(pixelsPerTangent * (tan(nativeFov.angleUp) - tan(fov.angleUp))), 0),
+                std::max((int32_t)std::lround(pixelsPerTangent * (tan(fov.angleDown) - tan(nativeFov.angleDown))), 0)};
+    }
+
+    // The rectangle of a view in a submitted swapchain of the given size. Views keep their horizontal layout, while
+    // their vertical position is stretched by the padding ratio and shifted by the top border to leave room for the
+    // borders.
+    inline XrRect2Di getUpscaledRect(const XrRect2Di& rect,
+                                     float upscalingFactor,
+                                     float paddingRatio,
+                                     const XrExtent2Di& size,
+                                     int32_t topPadding) {
+        const int32_t left = std::clamp((int32_t)std::lround(rect.offset.x / upscalingFactor), 0, size.width);
+        const int32_t top = std::clamp(
+            (int32_t)std::lround(rect.offset.y / upscalingFactor * paddingRatio) + topPadding, 0, size.height);
+        const int32_t right =
+            std::clamp((int32_t)std::lround((rect.offset.x + rect.extent.width) / upscalingFactor), left, size.width);
+        const int32_t bottom =
+            std::clamp(top + (int32_t)std::lround(rect.extent.height / upscalingFactor), top, size.height);
+        return {{left, top}, {right - left, bottom - top}};
+    }
+
+    // The FOV covered once the borders are added, which is the native FOV up to the rounding of the borders.
+    inline XrFovf getPaddedFov(const XrFovf& fov, int32_t height, int32_t topPadding, int32_t bottomPadding) {
+        const float span = tan(fov.angleUp) - tan(fov.angleDown);
+        if (span <= 0.f || height <= 0) {
+            return fov;
+        }
+        const float tangentsPerPixel = span / height;
+        XrFovf paddedFov = fov;
+        paddedFov.angleUp = atan(tan(fov.angleUp) + topPadding * tangentsPerPixel);
+        paddedFov.angleDown = atan(tan(fov.angleDown) - bottomPadding * tangentsPerPixel);
+        return paddedFov;
+    }
+
+} // namespace openxr_api_layer::utils::placement
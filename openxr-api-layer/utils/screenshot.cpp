@@ -0,0 +1,335 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "screenshot.h"
+#include <log.h>
+
+namespace {
+
+    using namespace openxr_api_layer::log;
+    using namespace openxr_api_layer::utils::screenshot;
+
+    // Images beyond this are dropped rather than piling up in memory.
+    constexpr size_t MaxQueuedImages = 8;
+
+    // The largest payload of a stored deflate block.
+    constexpr size_t MaxStoredBlockSize = 65535;
+
+    constexpr std::array<uint32_t, 256> makeCrc32Table() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> Crc32Table = makeCrc32Table();
+
+    uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) {
+            crc = Crc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void appendBigEndian32(std::vector<uint8_t>& output, uint32_t value) {
+        output.push_back((uint8_t)(value >> 24));
+        output.push_back((uint8_t)(value >> 16));
+        output.push_back((uint8_t)(value >> 8));
+        output.push_back((uint8_t)value);
+    }
+
+    void appendPNGChunk(std::vector<uint8_t>& output, const char type[4], const std::vector<uint8_t>& data) {
+        appendBigEndian32(output, (uint32_t)data.size());
+        const size_t typeOffset = output.size();
+        output.insert(output.end(), type, type + 4);
+        output.insert(output.end(), data.begin(), data.end());
+        // The CRC covers the type and the data.
+        appendBigEndian32(output, crc32(output.data() + typeOffset, output.size() - typeOffset));
+    }
+
+    // Which images are converted before encoding. Other 8-bit formats only need their channels reordered.
+    DXGI_FORMAT getEncodingFormat(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+
+        default:
+            return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+        }
+    }
+
+} // namespace
+
+namespace openxr_api_layer::utils::screenshot {
+
+    std::vector<uint8_t> encodePNG(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t rowPitch) {
+        // Each row is prefixed with its filter type (none).
+        const size_t rowSize = 1 + (size_t)width * 3;
+        std::vector<uint8_t> scanlines;
+        scanlines.reserve(rowSize * height);
+        for (uint32_t y = 0; y < height; y++) {
+            const uint8_t* const row = rgba + (size_t)y * rowPitch;
+            scanlines.push_back(0);
+            for (uint32_t x = 0; x < width; x++) {
+                scanlines.insert(scanlines.end(), row + x * 4, row + x * 4 + 3);
+            }
+        }
+
+        // A zlib stream of stored deflate blocks.
+        std::vector<uint8_t> compressed;
+        compressed.reserve(2 + scanlines.size() + (scanlines.size() / MaxStoredBlockSize + 1) * 5 + 4);
+        compressed.push_back(0x78);
+        compressed.push_back(0x01);
+        size_t offset = 0;
+        do {
+            const size_t blockSize = std::min(scanlines.size() - offset, MaxStoredBlockSize);
+            const bool isFinal = offset + blockSize == scanlines.size();
+            compressed.push_back(isFinal ? 1 : 0);
+            compressed.push_back((uint8_t)blockSize);
+            compressed.push_back((uint8_t)(blockSize >> 8));
+            compressed.push_back((uint8_t)~blockSize);
+            compressed.push_back((uint8_t)(~blockSize >> 8));
+            compressed.insert(compressed.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+            offset += blockSize;
+        } while (offset < scanlines.size());
+
+        // Adler-32 of the uncompressed data, with the sums reduced often enough not to overflow.
+        uint32_t a = 1, b = 0;
+        for (size_t i = 0; i < scanlines.size();) {
+            const size_t end = std::min(i + 5552, scanlines.size());
+            for (; i < end; i++) {
+                a += scanlines[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        appendBigEndian32(compressed, (b << 16) | a);
+
+        std::vector<uint8_t> output{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        std::vector<uint8_t> header;
+        appendBigEndian32(header, width);
+        appendBigEndian32(header, height);
+        // 8-bit truecolor, deflate, adaptive filtering, no interlacing.
+        header.insert(header.end(), {8, 2, 0, 0, 0});
+        appendPNGChunk(output, "IHDR", header);
+        // The pixels are treated as sRGB-encoded, with perceptual rendering intent.
+        appendPNGChunk(output, "sRGB", {0});
+        appendPNGChunk(output, "IDAT", compressed);
+        appendPNGChunk(output, "IEND", {});
+        return output;
+    }
+
+    std::vector<uint8_t> encodeQOI(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t rowPitch) {
+        constexpr uint8_t OpIndex = 0x00;
+        constexpr uint8_t OpDiff = 0x40;
+        constexpr uint8_t OpLuma = 0x80;
+        constexpr uint8_t OpRun = 0xC0;
+        constexpr uint8_t OpRGB = 0xFE;
+
+        std::vector<uint8_t> output{'q', 'o', 'i', 'f'};
+        // The worst case is one RGB operation per pixel.
+        output.reserve(14 + (size_t)width * height * 4 + 8);
+        appendBigEndian32(output, width);
+        appendBigEndian32(output, height);
+        // 3 channels, sRGB.
+        output.push_back(3);
+        output.push_back(0);
+
+        struct Pixel {
+            uint8_t r, g, b, a;
+
+            bool operator==(const Pixel& other) const {
+                return r == other.r && g == other.g && b == other.b && a == other.a;
+            }
+        };
+        // Like the decoder's, the index starts with transparent black pixels and the previous pixel is opaque black.
+        // Alpha stays opaque with 3 channels, but an opaque black pixel must not match an unwritten index entry.
+        Pixel index[64]{};
+        Pixel previous{0, 0, 0, 255};
+        uint32_t run = 0;
+
+        const uint64_t pixelCount = (uint64_t)width * height;
+        uint64_t pixelIndex = 0;
+        for (uint32_t y = 0; y < height; y++) {
+            const uint8_t* const row = rgba + (size_t)y * rowPitch;
+            for (uint32_t x = 0; x < width; x++, pixelIndex++) {
+                const Pixel pixel{row[x * 4], row[x * 4 + 1], row[x * 4 + 2], 255};
+                if (pixel == previous) {
+                    run++;
+                    if (run == 62 || pixelIndex + 1 == pixelCount) {
+                        output.push_back(OpRun | (uint8_t)(run - 1));
+                        run = 0;
+                    }
+                    continue;
+                }
+
+                if (run > 0) {
+                    output.push_back(OpRun | (uint8_t)(run - 1));
+                    run = 0;
+                }
+
+                const uint32_t hash = (pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) % 64;
+                Pixel& entry = index[hash];
+                if (entry == pixel) {
+                    output.push_back(OpIndex | (uint8_t)hash);
+                } else {
+                    entry = pixel;
+
+                    const int8_t dr = (int8_t)(pixel.r - previous.r);
+                    const int8_t dg = (int8_t)(pixel.g - previous.g);
+                    const int8_t db = (int8_t)(pixel.b - previous.b);
+                    const int drg = dr - dg;
+                    const int dbg = db - dg;
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        output.push_back(OpDiff | (uint8_t)((dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                    } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                        output.push_back(OpLuma | (uint8_t)(dg + 32));
+                        output.push_back((uint8_t)((drg + 8) << 4 | (dbg + 8)));
+                    } else {
+                        output.insert(output.end(), {OpRGB, pixel.r, pixel.g, pixel.b});
+                    }
+                }
+                previous = pixel;
+            }
+        }
+
+        output.insert(output.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+        return output;
+    }
+
+    Writer::Writer(FileFormat format, std::shared_ptr<executor::IExecutor> executor)
+        : m_format(format), m_executor(std::move(executor)) {
+        m_thread = std::thread([this] { workerThread(); });
+    }
+
+    Writer::~Writer() {
+        {
+            std::unique_lock lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeUp.notify_one();
+        m_thread.join();
+    }
+
+    void Writer::write(const std::filesystem::path& path,
+                       std::vector<uint8_t> pixels,
+                       uint32_t width,
+                       uint32_t height,
+                       uint32_t rowPitch,
+                       DXGI_FORMAT format) {
+        {
+            std::unique_lock lock(m_mutex);
+            if (m_queue.size() >= MaxQueuedImages) {
+                Log(fmt::format("Dropping frame capture {}: too many pending\n", path.string()));
+                return;
+            }
+            m_queue.push_back(Request{path, std::move(pixels), width, height, rowPitch, format});
+        }
+        m_wakeUp.notify_one();
+    }
+
+    void Writer::workerThread() {
+        while (true) {
+            Request request;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wakeUp.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+                // Pending images are still written upon destruction.
+                if (m_queue.empty()) {
+                    return;
+                }
+                request = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            try {
+                process(request);
+            } catch (std::exception& exc) {
+                ErrorLog(fmt::format("Failed to write frame capture {}: {}\n", request.path.string(), exc.what()));
+            }
+        }
+    }
+
+    void Writer::process(const Request& request) {
+        TraceLocalActivity(local);
+        TraceLoggingWriteStart(local,
+                               "Screenshot_Write",
+                               TLArg(request.path.string().c_str(), "Path"),
+                               TLArg(request.width, "Width"),
+                               TLArg(request.height, "Height"),
+                               TLArg((int)request.format, "Format"));
+
+        const DXGI_FORMAT encodingFormat = getEncodingFormat(request.format);
+        if (!image::getBytesPerPixel(request.format)) {
+            throw std::runtime_error(fmt::format("Unsupported format {}", (int)request.format));
+        }
+
+        const uint8_t* pixels = request.pixels.data();
+        uint32_t rowPitch = request.rowPitch;
+        std::vector<uint8_t> converted;
+        if (request.format != encodingFormat && request.format != DXGI_FORMAT_R8G8B8A8_TYPELESS) {
+            rowPitch = request.width * 4;
+            converted.resize((size_t)rowPitch * request.height);
+            image::convert(image::Image{const_cast<uint8_t*>(pixels),
+                                        request.width,
+                                        request.height,
+                                        request.rowPitch,
+                                        request.format},
+                           image::Image{converted.data(), request.width, request.height, rowPitch, encodingFormat},
+                           m_executor.get());
+            pixels = converted.data();
+        }
+
+        std::filesystem::path path = request.path;
+        std::vector<uint8_t> file;
+        if (m_format == FileFormat::QOI) {
+            path += ".qoi";
+            file = encodeQOI(pixels, request.width, request.height, rowPitch);
+        } else {
+            path += ".png";
+            file = encodePNG(pixels, request.width, request.height, rowPitch);
+        }
+
+        std::ofstream output(path, std::ios::binary);
+        output.write(reinterpret_cast<const char*>(file.data()), file.size());
+        if (!output) {
+            throw std::runtime_error("Failed to write the file");
+        }
+        Log(fmt::format("Frame captured to {}\n", path.string()));
+
+        TraceLoggingWriteStop(local, "Screenshot_Write", TLArg(file.size(), "Size"));
+    }
+
+} // namespace openxr_api_layer::utils::screenshot
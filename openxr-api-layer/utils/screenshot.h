@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "image.h"
+
+namespace openxr_api_layer::utils::screenshot {
+
+    enum class FileFormat {
+        PNG,
+        QOI,
+    };
+
+    // Encode 8-bit RGBA pixels into a file image. The alpha channel is dropped, since the alpha of eye buffers is
+    // rarely meaningful. PNG images are not compressed (stored deflate blocks), QOI images are.
+    std::vector<uint8_t> encodePNG(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t rowPitch);
+    std::vector<uint8_t> encodeQOI(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t rowPitch);
+
+    // Converts and encodes images on a background thread, so that the frame thread only copies the pixels.
+    class Writer {
+      public:
+        // The conversions are split among the workers of the executor, if any.
+        Writer(FileFormat format, std::shared_ptr<executor::IExecutor> executor = nullptr);
+        ~Writer();
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        // The extension of the file format is appended to the path. Images are dropped while too many are queued.
+        void write(const std::filesystem::path& path,
+                   std::vector<uint8_t> pixels,
+                   uint32_t width,
+                   uint32_t height,
+                   uint32_t rowPitch,
+                   DXGI_FORMAT format);
+
+        FileFormat getFileFormat() const {
+            return m_format;
+        }
+
+      private:
+        struct Request {
+            std::filesystem::path path;
+            std::vector<uint8_t> pixels;
+            uint32_t width;
+            uint32_t height;
+            uint32_t rowPitch;
+            DXGI_FORMAT format;
+        };
+
+        void workerThread();
+        void process(const Request& request);
+
+        const FileFormat m_format;
+        const std::shared_ptr<executor::IExecutor> m_executor;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        std::deque<Request> m_queue;
+        bool m_stop{false};
+        std::thread m_thread;
+    };
+
+} // namespace openxr_api_layer::utils::screenshot
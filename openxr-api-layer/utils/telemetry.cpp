@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "telemetry.h"
+#include <log.h>
+
+namespace openxr_api_layer::utils::telemetry {
+
+    using namespace openxr_api_layer::log;
+
+    Writer::Writer(const std::string& applicationName) {
+        // Try the well-known name first, so that overlays do not need to know the process ID of the application.
+        for (const uint32_t processId : {0u, (uint32_t)GetCurrentProcessId()}) {
+            m_name = getPageName(processId);
+            m_mapping =
+                CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(Page), m_name.c_str());
+            if (m_mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+                CloseHandle(m_mapping);
+                m_mapping = nullptr;
+                continue;
+            }
+            break;
+        }
+
+        if (!m_mapping) {
+            ErrorLog(fmt::format("Failed to create telemetry page: {}\n", GetLastError()));
+            return;
+        }
+
+        m_page = reinterpret_cast<Page*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Page)));
+        if (!m_page) {
+            ErrorLog(fmt::format("Failed to map telemetry page: {}\n", GetLastError()));
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+            return;
+        }
+
+        // The page is zero-initialized by the system.
+        m_page->counters.processId = GetCurrentProcessId();
+        strncpy_s(m_page->counters.applicationName, applicationName.c_str(), _TRUNCATE);
+        m_page->size = sizeof(Page);
+        m_page->version = PageVersion;
+        m_page->sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_page->magic = PageMagic;
+
+        Log(fmt::format("Publishing telemetry to {}\n", m_name));
+    }
+
+    Writer::~Writer() {
+        if (m_page) {
+            UnmapViewOfFile(m_page);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+    }
+
+    Counters* Writer::beginUpdate() {
+        if (!m_page) {
+            return nullptr;
+        }
+
+        m_mutex.lock();
+        const uint32_t sequence = m_page->sequence.load(std::memory_order_relaxed);
+        m_page->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        return &m_page->counters;
+    }
+
+    void Writer::endUpdate() {
+        m_page->counters.droppedLogCount = GetDroppedErrorCount();
+
+        const uint32_t sequence = m_page->sequence.load(std::memory_order_relaxed);
+        m_page->sequence.store(sequence + 1, std::memory_order_release);
+        m_mutex.unlock();
+    }
+
+} // namespace openxr_api_layer::utils::telemetry
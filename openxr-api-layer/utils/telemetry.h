@@ -0,0 +1,242 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+// This header is shared with external readers (overlays, monitoring tools, the telemetry-sampler) and must not depend
+// on the layer's precompiled header.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+namespace openxr_api_layer::utils::telemetry {
+
+    constexpr uint32_t PageMagic = 0x564F4643; // "CFOV"
+    constexpr uint32_t PageVersion = 2;
+
+    struct Fov {
+        float angleLeft;
+        float angleRight;
+        float angleUp;
+        float angleDown;
+    };
+
+    struct ImageSize {
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // All durations are in microseconds.
+    struct CallLatency {
+        uint64_t count;
+        uint64_t lastUs;
+        uint64_t maxUs;
+        uint64_t totalUs;
+    };
+
+    // The counters published by the layer. Fixed layout: only append new fields and bump PageVersion.
+    struct Counters {
+        uint32_t processId;
+        char applicationName[128];
+
+        // The FOV returned by the runtime and the FOV after customization, per eye, in radians.
+        Fov nativeFov[2];
+        Fov customizedFov[2];
+
+        // The recommended image sizes returned by the runtime and after customization, per eye.
+        ImageSize nativeImageSize[2];
+        ImageSize recommendedImageSize[2];
+        uint64_t nativePixelCount;
+        uint64_t recommendedPixelCount;
+
+        // Intervals between two consecutive xrEndFrame() calls.
+        uint64_t frameCount;
+        uint64_t lastFrameIntervalUs;
+        uint64_t minFrameIntervalUs;
+        uint64_t maxFrameIntervalUs;
+        uint64_t averageFrameIntervalUs;
+
+        // Time spent in the layer's entry points, including the upstream implementation.
+        CallLatency locateViews;
+        CallLatency enumerateViewConfigurationViews;
+        CallLatency endFrame;
+
+        // Number of error messages that were not written to the log file.
+        uint64_t droppedLogCount;
+
+        // GPU time of the layer's composition commands (resampling and padding), per frame. Since version 2.
+        CallLatency compositionGpu;
+    };
+
+    // The shared memory page. The sequence number is odd while the writer is updating the counters (seqlock).
+    struct Page {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;
+        std::atomic<uint32_t> sequence;
+        Counters counters;
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+    // The page of the first process to load the layer uses the well-known name (processId == 0), other processes
+    // append their process ID.
+    static inline std::string getPageName(uint32_t processId = 0) {
+        std::string name = "Local\\" LAYER_NAME ".Telemetry";
+        if (processId) {
+            name += "." + std::to_string(processId);
+        }
+        return name;
+    }
+
+    static inline void recordLatency(CallLatency& latency, uint64_t durationUs) {
+        latency.count++;
+        latency.lastUs = durationUs;
+        latency.maxUs = std::max(latency.maxUs, durationUs);
+        latency.totalUs += durationUs;
+    }
+
+    // Take a consistent snapshot of the counters. Returns false if the writer kept the page busy for too long.
+    static inline bool readCounters(const Page& page, Counters& counters, uint32_t maxAttempts = 1000) {
+        for (uint32_t attempt = 0; attempt < maxAttempts; attempt++) {
+            const uint32_t before = page.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                YieldProcessor();
+                continue;
+            }
+
+            std::memcpy(&counters, &page.counters, sizeof(Counters));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (page.sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A read-only view of the page of a process running the layer.
+    class Reader {
+      public:
+        Reader(uint32_t processId = 0) {
+            m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, getPageName(processId).c_str());
+            if (m_mapping) {
+                m_page = reinterpret_cast<const Page*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, sizeof(Page)));
+            }
+            if (m_page && (m_page->magic != PageMagic || m_page->version != PageVersion ||
+                           m_page->size != sizeof(Page))) {
+                close();
+            }
+        }
+
+        ~Reader() {
+            close();
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        bool isValid() const {
+            return m_page != nullptr;
+        }
+
+        bool read(Counters& counters) const {
+            return m_page && readCounters(*m_page, counters);
+        }
+
+      private:
+        void close() {
+            if (m_page) {
+                UnmapViewOfFile(m_page);
+                m_page = nullptr;
+            }
+            if (m_mapping) {
+                CloseHandle(m_mapping);
+                m_mapping = nullptr;
+            }
+        }
+
+        HANDLE m_mapping{nullptr};
+        const Page* m_page{nullptr};
+    };
+
+    // The layer-side publisher. Updates are serialized between writer threads, readers never block the writer.
+    class Writer {
+      public:
+        Writer(const std::string& applicationName);
+        ~Writer();
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        // Returns nullptr if the page could not be created, otherwise endUpdate() must be called.
+        Counters* beginUpdate();
+        void endUpdate();
+
+        const std::string& getName() const {
+            return m_name;
+        }
+
+      private:
+        std::string m_name;
+        HANDLE m_mapping{nullptr};
+        Page* m_page{nullptr};
+        std::mutex m_mutex;
+    };
+
+    // Scoped helper for Writer::beginUpdate()/endUpdate().
+    class Update {
+      public:
+        Update(Writer* writer) : m_writer(writer), m_counters(writer ? writer->beginUpdate() : nullptr) {
+        }
+
+        ~Update() {
+            if (m_counters) {
+                m_writer->endUpdate();
+            }
+        }
+
+        Counters* operator->() const {
+            return m_counters;
+        }
+
+        explicit operator bool() const {
+            return m_counters != nullptr;
+        }
+
+      private:
+        Writer* const m_writer;
+        Counters* const m_counters;
+    };
+
+} // namespace openxr_api_layer::utils::telemetry
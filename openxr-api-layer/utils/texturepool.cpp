@@ -0,0 +1,213 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "graphics.h"
+#include <log.h>
+
+namespace {
+
+    using namespace openxr_api_layer::log;
+    using namespace openxr_api_layer::utils::graphics;
+
+    bool isSameTextureInfo(const XrSwapchainCreateInfo& a, const XrSwapchainCreateInfo& b) {
+        return a.createFlags == b.createFlags && a.usageFlags == b.usageFlags && a.format == b.format &&
+               a.sampleCount == b.sampleCount && a.width == b.width && a.height == b.height &&
+               a.faceCount == b.faceCount && a.arraySize == b.arraySize && a.mipCount == b.mipCount;
+    }
+
+    struct TexturePool : ITexturePool {
+        TexturePool(IGraphicsDevice* compositionDevice, uint64_t memoryBudget)
+            : m_compositionDevice(compositionDevice), m_memoryBudget(memoryBudget) {
+        }
+
+        SharedTexture acquire(IGraphicsDevice* applicationDevice,
+                              const XrSwapchainCreateInfo& infoOnApplicationDevice,
+                              const XrSwapchainCreateInfo& infoOnCompositionDevice) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "TexturePool_Acquire", TLPArg(this, "Pool"), TLPArg(applicationDevice, "ApplicationDevice"));
+
+            const bool isSameDevice = applicationDevice == m_compositionDevice;
+
+            SharedTexture texture;
+            {
+                std::unique_lock lock(m_mutex);
+
+                // Prefer the most recently released texture, and one that is already opened on the application device.
+                auto match = m_freeTextures.rend();
+                for (auto it = m_freeTextures.rbegin(); it != m_freeTextures.rend(); ++it) {
+                    const bool isOpened = it->texture.applicationDevice == applicationDevice;
+                    if (!isSameTextureInfo(it->texture.onCompositionDevice->getInfo(), infoOnCompositionDevice) ||
+                        (!isOpened && (isSameDevice || !it->texture.onCompositionDevice->isShareable()))) {
+                        continue;
+                    }
+                    if (match == m_freeTextures.rend() || isOpened) {
+                        match = it;
+                    }
+                    if (isOpened) {
+                        break;
+                    }
+                }
+
+                if (match != m_freeTextures.rend()) {
+                    texture = std::move(match->texture);
+                    m_statistics.freeMemorySize -= match->memorySize;
+                    m_freeTextures.erase(std::next(match).base());
+                    m_statistics.hits++;
+                } else {
+                    m_statistics.misses++;
+                }
+            }
+
+            const bool isReused = texture.onCompositionDevice != nullptr;
+            if (!isReused) {
+                texture.onCompositionDevice = m_compositionDevice->createTexture(infoOnCompositionDevice, !isSameDevice);
+            }
+            if (texture.applicationDevice != applicationDevice) {
+                if (isSameDevice) {
+                    texture.onApplicationDevice = texture.onCompositionDevice;
+                } else {
+                    texture.onApplicationDevice = applicationDevice->openTexture(
+                        texture.onCompositionDevice->getTextureHandle(), infoOnApplicationDevice);
+
+                    std::unique_lock lock(m_mutex);
+                    m_statistics.opens++;
+                }
+                texture.applicationDevice = applicationDevice;
+            }
+
+            TraceLoggingWriteStop(local,
+                                  "TexturePool_Acquire",
+                                  TLArg(isReused, "Reused"),
+                                  TLPArg(texture.onCompositionDevice.get(), "Texture"));
+
+            return texture;
+        }
+
+        void release(SharedTexture texture, uint64_t memorySize) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "TexturePool_Release",
+                                   TLPArg(this, "Pool"),
+                                   TLPArg(texture.onCompositionDevice.get(), "Texture"));
+
+            std::unique_lock lock(m_mutex);
+
+            m_freeTextures.push_back({std::move(texture), memorySize});
+            m_statistics.freeMemorySize += memorySize;
+
+            while (m_statistics.freeMemorySize > m_memoryBudget) {
+                TraceLoggingWriteTagged(local,
+                                        "TexturePool_Release_Evict",
+                                        TLPArg(m_freeTextures.front().texture.onCompositionDevice.get(), "Texture"),
+                                        TLArg(m_freeTextures.front().memorySize, "MemorySize"));
+
+                m_statistics.freeMemorySize -= m_freeTextures.front().memorySize;
+                m_freeTextures.pop_front();
+                m_statistics.evictions++;
+            }
+
+            TraceLoggingWriteStop(
+                local, "TexturePool_Release", TLArg(m_statistics.freeMemorySize, "FreeMemorySize"));
+        }
+
+        void forgetApplicationDevice(IGraphicsDevice* applicationDevice) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "TexturePool_ForgetApplicationDevice",
+                                   TLPArg(this, "Pool"),
+                                   TLPArg(applicationDevice, "ApplicationDevice"));
+
+            std::unique_lock lock(m_mutex);
+
+            for (auto it = m_freeTextures.begin(); it != m_freeTextures.end();) {
+                if (it->texture.applicationDevice != applicationDevice) {
+                    ++it;
+                } else if (applicationDevice == m_compositionDevice || !it->texture.onCompositionDevice->isShareable()) {
+                    // The texture cannot be opened on another device.
+                    m_statistics.freeMemorySize -= it->memorySize;
+                    it = m_freeTextures.erase(it);
+                } else {
+                    it->texture.onApplicationDevice.reset();
+                    it->texture.applicationDevice = nullptr;
+                    ++it;
+                }
+            }
+
+            TraceLoggingWriteStop(
+                local, "TexturePool_ForgetApplicationDevice", TLArg(m_freeTextures.size(), "FreeTextures"));
+        }
+
+        void copy(IGraphicsDevice* applicationDevice,
+                  IGraphicsTexture* from,
+                  IGraphicsTexture* to,
+                  const std::vector<XrSwapchainSubImage>& subImages) override {
+            if (subImages.empty()) {
+                applicationDevice->copyTexture(from, to);
+                m_copies++;
+                return;
+            }
+
+            for (const XrSwapchainSubImage& subImage : subImages) {
+                applicationDevice->copyTextureRegion(from,
+                                                     subImage.imageRect,
+                                                     subImage.imageArrayIndex,
+                                                     to,
+                                                     subImage.imageRect.offset,
+                                                     subImage.imageArrayIndex);
+            }
+            m_copies += subImages.size();
+        }
+
+        TexturePoolStatistics getStatistics() const override {
+            std::unique_lock lock(m_mutex);
+            TexturePoolStatistics statistics = m_statistics;
+            statistics.copies = m_copies;
+            return statistics;
+        }
+
+        struct FreeTexture {
+            SharedTexture texture;
+            uint64_t memorySize;
+        };
+
+        IGraphicsDevice* const m_compositionDevice;
+        const uint64_t m_memoryBudget;
+
+        mutable std::mutex m_mutex;
+        std::deque<FreeTexture> m_freeTextures;
+        TexturePoolStatistics m_statistics;
+        std::atomic<uint64_t> m_copies{0};
+    };
+
+} // namespace
+
+namespace openxr_api_layer::utils::graphics {
+
+    std::shared_ptr<ITexturePool> createTexturePool(IGraphicsDevice* compositionDevice, uint64_t memoryBudget) {
+        return std::make_shared<TexturePool>(compositionDevice, memoryBudget);
+    }
+
+} // namespace openxr_api_layer::utils::graphics
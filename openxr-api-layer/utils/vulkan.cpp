@@ -0,0 +1,1136 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+
+#include "log.h"
+#include "graphics.h"
+
+#define CHECK_VKCMD(cmd) checkVkResult(cmd, #cmd, FILE_AND_LINE)
+
+namespace {
+
+    using namespace openxr_api_layer::log;
+    using namespace openxr_api_layer::utils::graphics;
+
+    void checkVkResult(VkResult result, const char* originator, const char* sourceLocation) {
+        if (result < VK_SUCCESS) {
+            xr::detail::_Throw(fmt::format("VkResult failure [{}]", (int)result), originator, sourceLocation);
+        }
+    }
+
+    // Maximum number of command buffers in flight. Beyond that, getCommandBuffer() waits for the oldest submission to
+    // complete.
+    constexpr size_t MaxCommandBufferPoolSize = 8;
+
+    // The formats commonly offered by runtimes for Vulkan swapchains.
+    constexpr std::pair<VkFormat, DXGI_FORMAT> FormatTable[] = {
+        {VK_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM},
+        {VK_FORMAT_R8G8B8A8_SRGB, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB},
+        {VK_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM},
+        {VK_FORMAT_B8G8R8A8_SRGB, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB},
+        {VK_FORMAT_A2B10G10R10_UNORM_PACK32, DXGI_FORMAT_R10G10B10A2_UNORM},
+        {VK_FORMAT_B10G11R11_UFLOAT_PACK32, DXGI_FORMAT_R11G11B10_FLOAT},
+        {VK_FORMAT_R16G16B16A16_UNORM, DXGI_FORMAT_R16G16B16A16_UNORM},
+        {VK_FORMAT_R16G16B16A16_SFLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT},
+        {VK_FORMAT_R32G32B32A32_SFLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT},
+        {VK_FORMAT_D16_UNORM, DXGI_FORMAT_D16_UNORM},
+        {VK_FORMAT_D24_UNORM_S8_UINT, DXGI_FORMAT_D24_UNORM_S8_UINT},
+        {VK_FORMAT_D32_SFLOAT, DXGI_FORMAT_D32_FLOAT},
+        {VK_FORMAT_D32_SFLOAT_S8_UINT, DXGI_FORMAT_D32_FLOAT_S8X24_UINT},
+    };
+
+    VkImageAspectFlags getAspectMask(VkFormat format) {
+        switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+
+    // The entry points used by the backend. The layer does not link against the Vulkan loader: the entry points are
+    // resolved through the loader already loaded by the application.
+    struct VulkanDispatch {
+        PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr{};
+        PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr{};
+        PFN_vkGetPhysicalDeviceProperties2 vkGetPhysicalDeviceProperties2{};
+        PFN_vkGetPhysicalDeviceMemoryProperties vkGetPhysicalDeviceMemoryProperties{};
+
+        PFN_vkGetDeviceQueue vkGetDeviceQueue{};
+        PFN_vkQueueSubmit vkQueueSubmit{};
+        PFN_vkCreateCommandPool vkCreateCommandPool{};
+        PFN_vkDestroyCommandPool vkDestroyCommandPool{};
+        PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers{};
+        PFN_vkFreeCommandBuffers vkFreeCommandBuffers{};
+        PFN_vkResetCommandBuffer vkResetCommandBuffer{};
+        PFN_vkBeginCommandBuffer vkBeginCommandBuffer{};
+        PFN_vkEndCommandBuffer vkEndCommandBuffer{};
+        PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier{};
+        PFN_vkCmdCopyImage vkCmdCopyImage{};
+        PFN_vkCmdBlitImage vkCmdBlitImage{};
+        PFN_vkCmdClearColorImage vkCmdClearColorImage{};
+        PFN_vkCmdResetQueryPool vkCmdResetQueryPool{};
+        PFN_vkCmdWriteTimestamp vkCmdWriteTimestamp{};
+        PFN_vkCreateQueryPool vkCreateQueryPool{};
+        PFN_vkDestroyQueryPool vkDestroyQueryPool{};
+        PFN_vkGetQueryPoolResults vkGetQueryPoolResults{};
+        PFN_vkCreateSemaphore vkCreateSemaphore{};
+        PFN_vkDestroySemaphore vkDestroySemaphore{};
+        PFN_vkGetSemaphoreCounterValue vkGetSemaphoreCounterValue{};
+        PFN_vkWaitSemaphores vkWaitSemaphores{};
+        PFN_vkCreateImage vkCreateImage{};
+        PFN_vkDestroyImage vkDestroyImage{};
+        PFN_vkGetImageMemoryRequirements vkGetImageMemoryRequirements{};
+        PFN_vkAllocateMemory vkAllocateMemory{};
+        PFN_vkFreeMemory vkFreeMemory{};
+        PFN_vkBindImageMemory vkBindImageMemory{};
+
+        // Only available when the device was created with the Win32 external memory and semaphore extensions.
+        PFN_vkGetMemoryWin32HandlePropertiesKHR vkGetMemoryWin32HandlePropertiesKHR{};
+        PFN_vkImportSemaphoreWin32HandleKHR vkImportSemaphoreWin32HandleKHR{};
+
+        void load(VkInstance instance, VkDevice device) {
+            const HMODULE loader = GetModuleHandleA("vulkan-1.dll");
+            if (!loader) {
+                throw std::runtime_error("Vulkan loader is not loaded");
+            }
+            vkGetInstanceProcAddr =
+                reinterpret_cast<PFN_vkGetInstanceProcAddr>(GetProcAddress(loader, "vkGetInstanceProcAddr"));
+
+#define GET_INSTANCE_PROC(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name))
+            GET_INSTANCE_PROC(vkGetDeviceProcAddr);
+            GET_INSTANCE_PROC(vkGetPhysicalDeviceProperties2);
+            if (!vkGetPhysicalDeviceProperties2) {
+                vkGetPhysicalDeviceProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2>(
+                    vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
+            }
+            GET_INSTANCE_PROC(vkGetPhysicalDeviceMemoryProperties);
+#undef GET_INSTANCE_PROC
+
+#define GET_DEVICE_PROC(name) name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name))
+            GET_DEVICE_PROC(vkGetDeviceQueue);
+            GET_DEVICE_PROC(vkQueueSubmit);
+            GET_DEVICE_PROC(vkCreateCommandPool);
+            GET_DEVICE_PROC(vkDestroyCommandPool);
+            GET_DEVICE_PROC(vkAllocateCommandBuffers);
+            GET_DEVICE_PROC(vkFreeCommandBuffers);
+            GET_DEVICE_PROC(vkResetCommandBuffer);
+            GET_DEVICE_PROC(vkBeginCommandBuffer);
+            GET_DEVICE_PROC(vkEndCommandBuffer);
+            GET_DEVICE_PROC(vkCmdPipelineBarrier);
+            GET_DEVICE_PROC(vkCmdCopyImage);
+            GET_DEVICE_PROC(vkCmdBlitImage);
+            GET_DEVICE_PROC(vkCmdClearColorImage);
+            GET_DEVICE_PROC(vkCmdResetQueryPool);
+            GET_DEVICE_PROC(vkCmdWriteTimestamp);
+            GET_DEVICE_PROC(vkCreateQueryPool);
+            GET_DEVICE_PROC(vkDestroyQueryPool);
+            GET_DEVICE_PROC(vkGetQueryPoolResults);
+            GET_DEVICE_PROC(vkCreateSemaphore);
+            GET_DEVICE_PROC(vkDestroySemaphore);
+            GET_DEVICE_PROC(vkGetSemaphoreCounterValue);
+            GET_DEVICE_PROC(vkWaitSemaphores);
+            GET_DEVICE_PROC(vkCreateImage);
+            GET_DEVICE_PROC(vkDestroyImage);
+            GET_DEVICE_PROC(vkGetImageMemoryRequirements);
+            GET_DEVICE_PROC(vkAllocateMemory);
+            GET_DEVICE_PROC(vkFreeMemory);
+            GET_DEVICE_PROC(vkBindImageMemory);
+            GET_DEVICE_PROC(vkGetMemoryWin32HandlePropertiesKHR);
+            GET_DEVICE_PROC(vkImportSemaphoreWin32HandleKHR);
+#undef GET_DEVICE_PROC
+
+            // Timeline semaphores are core in Vulkan 1.2, but might only be exposed through the extension.
+            if (!vkGetSemaphoreCounterValue) {
+                vkGetSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(
+                    vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+            }
+            if (!vkWaitSemaphores) {
+                vkWaitSemaphores =
+                    reinterpret_cast<PFN_vkWaitSemaphores>(vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+            }
+            if (!vkGetSemaphoreCounterValue || !vkWaitSemaphores) {
+                throw std::runtime_error("Vulkan device does not support timeline semaphores");
+            }
+        }
+    };
+
+    VkSemaphore createTimelineSemaphore(const VulkanDispatch& vk, VkDevice device) {
+        VkSemaphoreTypeCreateInfo typeInfo{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+        VkSemaphoreCreateInfo createInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        createInfo.pNext = &typeInfo;
+        VkSemaphore semaphore;
+        CHECK_VKCMD(vk.vkCreateSemaphore(device, &createInfo, nullptr, &semaphore));
+        return semaphore;
+    }
+
+    // Wait for a timeline semaphore on the CPU, see internal::waitForFenceOnCpu().
+    bool waitForSemaphoreOnCpu(const VulkanDispatch& vk,
+                               VkDevice device,
+                               VkSemaphore semaphore,
+                               uint64_t value,
+                               const FenceWaitPolicy& policy) {
+        for (uint32_t i = 0; i < policy.spinCount; i++) {
+            uint64_t completedValue = 0;
+            CHECK_VKCMD(vk.vkGetSemaphoreCounterValue(device, semaphore, &completedValue));
+            if (completedValue >= value) {
+                return true;
+            }
+            YieldProcessor();
+        }
+
+        VkSemaphoreWaitInfo waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        const uint64_t timeoutNs =
+            policy.timeoutMs != INFINITE ? static_cast<uint64_t>(policy.timeoutMs) * 1000000 : UINT64_MAX;
+        const VkResult result = vk.vkWaitSemaphores(device, &waitInfo, timeoutNs);
+        CHECK_VKCMD(result);
+        return result == VK_SUCCESS;
+    }
+
+    struct VulkanReusableCommandBuffer {
+        VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+        uint64_t completedValue{0};
+    };
+
+    // The state shared by the device and all the objects it creates.
+    struct VulkanContext {
+        VulkanContext(const XrGraphicsBindingVulkanKHR& bindings)
+            : physicalDevice(bindings.physicalDevice), device(bindings.device),
+              queueFamilyIndex(bindings.queueFamilyIndex) {
+            vk.load(bindings.instance, bindings.device);
+
+            vk.vkGetDeviceQueue(device, bindings.queueFamilyIndex, bindings.queueIndex, &queue);
+            vk.vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+            VkPhysicalDeviceIDProperties idProperties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES};
+            VkPhysicalDeviceProperties2 properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+            properties.pNext = &idProperties;
+            vk.vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+            deviceName = properties.properties.deviceName;
+            timestampPeriod = properties.properties.limits.timestampPeriod;
+            if (!idProperties.deviceLUIDValid) {
+                throw std::runtime_error("Vulkan device does not have a LUID");
+            }
+            memcpy(&adapterLuid, idProperties.deviceLUID, sizeof(LUID));
+
+            VkCommandPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            poolInfo.queueFamilyIndex = queueFamilyIndex;
+            CHECK_VKCMD(vk.vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool));
+            commandBufferPoolSemaphore = createTimelineSemaphore(vk, device);
+        }
+
+        ~VulkanContext() {
+            // The command buffers must not be freed while the GPU still uses them.
+            if (commandBufferPoolValue) {
+                waitForSemaphoreOnCpu(vk, device, commandBufferPoolSemaphore, commandBufferPoolValue, {});
+            }
+            vk.vkDestroyCommandPool(device, commandPool, nullptr);
+            vk.vkDestroySemaphore(device, commandBufferPoolSemaphore, nullptr);
+        }
+
+        // Returns a command buffer in the recording state.
+        VkCommandBuffer getCommandBuffer() {
+            std::unique_lock lock(commandBufferPoolMutex);
+
+            // Recycle completed command buffers. Submissions complete in order, so only the front needs checking.
+            uint64_t completedValue = 0;
+            CHECK_VKCMD(vk.vkGetSemaphoreCounterValue(device, commandBufferPoolSemaphore, &completedValue));
+            while (!pendingCommandBuffers.empty() && completedValue >= pendingCommandBuffers.front().completedValue) {
+                availableCommandBuffers.push_back(pendingCommandBuffers.front().commandBuffer);
+                pendingCommandBuffers.pop_front();
+            }
+
+            // Bound the pool: rather than allocating yet another command buffer, wait for the oldest one.
+            if (availableCommandBuffers.empty() && pendingCommandBuffers.size() >= MaxCommandBufferPoolSize) {
+                waitForSemaphoreOnCpu(
+                    vk, device, commandBufferPoolSemaphore, pendingCommandBuffers.front().completedValue, {});
+                availableCommandBuffers.push_back(pendingCommandBuffers.front().commandBuffer);
+                pendingCommandBuffers.pop_front();
+            }
+
+            VkCommandBuffer commandBuffer;
+            if (availableCommandBuffers.empty()) {
+                VkCommandBufferAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+                allocateInfo.commandPool = commandPool;
+                allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                allocateInfo.commandBufferCount = 1;
+                CHECK_VKCMD(vk.vkAllocateCommandBuffers(device, &allocateInfo, &commandBuffer));
+            } else {
+                commandBuffer = availableCommandBuffers.front();
+                availableCommandBuffers.pop_front();
+                CHECK_VKCMD(vk.vkResetCommandBuffer(commandBuffer, 0));
+            }
+
+            VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            CHECK_VKCMD(vk.vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+            return commandBuffer;
+        }
+
+        // Returns the value of the command buffer pool semaphore signaled upon completion.
+        uint64_t submitCommandBuffer(VkCommandBuffer commandBuffer) {
+            std::unique_lock lock(commandBufferPoolMutex);
+
+            CHECK_VKCMD(vk.vkEndCommandBuffer(commandBuffer));
+
+            const uint64_t value = ++commandBufferPoolValue;
+            VkTimelineSemaphoreSubmitInfo timelineInfo{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &value;
+            VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &commandBufferPoolSemaphore;
+            submit(submitInfo);
+
+            pendingCommandBuffers.push_back({commandBuffer, value});
+
+            return value;
+        }
+
+        uint64_t getCompletedValue() const {
+            uint64_t completedValue = 0;
+            CHECK_VKCMD(vk.vkGetSemaphoreCounterValue(device, commandBufferPoolSemaphore, &completedValue));
+            return completedValue;
+        }
+
+        // The queue is the application's. The mutex only serializes the layer's own submissions, made from the
+        // application's OpenXR calls on different threads: the application's submissions are not synchronized with
+        // them, and rely on the application not using the queue during these calls.
+        void submit(const VkSubmitInfo& submitInfo) {
+            std::unique_lock lock(queueMutex);
+            CHECK_VKCMD(vk.vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+        }
+
+        uint32_t findMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags preferredFlags) const {
+            for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+                if ((memoryTypeBits & (1u << i)) &&
+                    (memoryProperties.memoryTypes[i].propertyFlags & preferredFlags) == preferredFlags) {
+                    return i;
+                }
+            }
+            for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+                if (memoryTypeBits & (1u << i)) {
+                    return i;
+                }
+            }
+            throw std::runtime_error("No suitable Vulkan memory type");
+        }
+
+        VulkanDispatch vk;
+        const VkPhysicalDevice physicalDevice;
+        const VkDevice device;
+        const uint32_t queueFamilyIndex;
+        VkQueue queue{VK_NULL_HANDLE};
+        VkPhysicalDeviceMemoryProperties memoryProperties{};
+        std::string deviceName;
+        float timestampPeriod{1.f};
+        LUID adapterLuid{};
+
+        std::mutex queueMutex;
+
+        std::mutex commandBufferPoolMutex;
+        VkCommandPool commandPool{VK_NULL_HANDLE};
+        std::deque<VkCommandBuffer> availableCommandBuffers;
+        std::deque<VulkanReusableCommandBuffer> pendingCommandBuffers;
+        VkSemaphore commandBufferPoolSemaphore{VK_NULL_HANDLE};
+        uint64_t commandBufferPoolValue{0};
+    };
+
+    struct VulkanTimer : IGraphicsTimer {
+        VulkanTimer(std::shared_ptr<VulkanContext> context) : m_context(context) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanTimer_Create");
+
+            VkQueryPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+            poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            poolInfo.queryCount = 2;
+            CHECK_VKCMD(m_context->vk.vkCreateQueryPool(m_context->device, &poolInfo, nullptr, &m_queryPool));
+
+            TraceLoggingWriteStop(local, "VulkanTimer_Create", TLPArg(this, "Timer"));
+        }
+
+        ~VulkanTimer() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanTimer_Destroy", TLPArg(this, "Timer"));
+
+            // The query pool must not be destroyed while the GPU still uses it.
+            if (m_completedValue) {
+                waitForSemaphoreOnCpu(
+                    m_context->vk, m_context->device, m_context->commandBufferPoolSemaphore, m_completedValue, {});
+            }
+            m_context->vk.vkDestroyQueryPool(m_context->device, m_queryPool, nullptr);
+
+            TraceLoggingWriteStop(local, "VulkanTimer_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::Vulkan;
+        }
+
+        void start() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanTimer_Start", TLPArg(this, "Timer"));
+
+            const VkCommandBuffer commandBuffer = m_context->getCommandBuffer();
+            m_context->vk.vkCmdResetQueryPool(commandBuffer, m_queryPool, 0, 2);
+            m_context->vk.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 0);
+            m_completedValue = m_context->submitCommandBuffer(commandBuffer);
+            m_valid = false;
+
+            TraceLoggingWriteStop(local, "VulkanTimer_Start");
+        }
+
+        void stop() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanTimer_Stop", TLPArg(this, "Timer"));
+
+            const VkCommandBuffer commandBuffer = m_context->getCommandBuffer();
+            m_context->vk.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 1);
+            m_completedValue = m_context->submitCommandBuffer(commandBuffer);
+            m_valid = true;
+
+            TraceLoggingWriteStop(local, "VulkanTimer_Stop");
+        }
+
+        uint64_t query() const override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanTimer_Query", TLPArg(this, "Timer"), TLArg(m_valid, "Valid"));
+
+            uint64_t duration = 0;
+            if (m_valid) {
+                // Never wait for the GPU: a measurement that is not ready is lost.
+                uint64_t timestamps[2];
+                if (m_context->getCompletedValue() >= m_completedValue &&
+                    m_context->vk.vkGetQueryPoolResults(m_context->device,
+                                                        m_queryPool,
+                                                        0,
+                                                        2,
+                                                        sizeof(timestamps),
+                                                        timestamps,
+                                                        sizeof(uint64_t),
+                                                        VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+                    duration =
+                        static_cast<uint64_t>((timestamps[1] - timestamps[0]) * m_context->timestampPeriod / 1000);
+                }
+                m_valid = false;
+            }
+
+            TraceLoggingWriteStop(local, "VulkanTimer_Query", TLArg(duration, "Duration"));
+
+            return duration;
+        }
+
+        const std::shared_ptr<VulkanContext> m_context;
+        VkQueryPool m_queryPool{VK_NULL_HANDLE};
+
+        // The value of the command buffer pool semaphore once the last timestamp is written.
+        uint64_t m_completedValue{0};
+
+        // Can the timer be queried (it might still only read 0).
+        mutable bool m_valid{false};
+    };
+
+    struct VulkanFence : IGraphicsFence {
+        VulkanFence(std::shared_ptr<VulkanContext> context, VkSemaphore semaphore)
+            : m_context(context), m_semaphore(semaphore) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanFence_Create", TLPArg(semaphore, "VkSemaphore"));
+            TraceLoggingWriteStop(local, "VulkanFence_Create", TLPArg(this, "Fence"));
+        }
+
+        ~VulkanFence() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanFence_Destroy", TLPArg(this, "Fence"));
+
+            m_context->vk.vkDestroySemaphore(m_context->device, m_semaphore, nullptr);
+
+            TraceLoggingWriteStop(local, "VulkanFence_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::Vulkan;
+        }
+
+        void* getNativeFencePtr() const override {
+            return reinterpret_cast<void*>(m_semaphore);
+        }
+
+        ShareableHandle getFenceHandle() const override {
+            throw std::runtime_error("Fence is not shareable");
+        }
+
+        void signal(uint64_t value) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanFence_Signal", TLPArg(this, "Fence"), TLArg(value, "Value"));
+
+            VkTimelineSemaphoreSubmitInfo timelineInfo{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &value;
+            VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &m_semaphore;
+            m_context->submit(submitInfo);
+
+            TraceLoggingWriteStop(local, "VulkanFence_Signal");
+        }
+
+        void waitOnDevice(uint64_t value) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(
+                local, "VulkanFence_Wait", TLPArg(this, "Fence"), TLArg("Device", "WaitType"), TLArg(value, "Value"));
+
+            const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            VkTimelineSemaphoreSubmitInfo timelineInfo{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+            timelineInfo.waitSemaphoreValueCount = 1;
+            timelineInfo.pWaitSemaphoreValues = &value;
+            VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &m_semaphore;
+            submitInfo.pWaitDstStageMask = &waitStage;
+            m_context->submit(submitInfo);
+
+            TraceLoggingWriteStop(local, "VulkanFence_Wait");
+        }
+
+        bool waitOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            signal(value);
+            return waitForValueOnCpu(value, policy);
+        }
+
+        bool waitForValueOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "VulkanFence_Wait",
+                                   TLPArg(this, "Fence"),
+                                   TLArg("Host", "WaitType"),
+                                   TLArg(value, "Value"),
+                                   TLArg(policy.spinCount, "SpinCount"),
+                                   TLArg(policy.timeoutMs, "TimeoutMs"));
+
+            const bool completed =
+                waitForSemaphoreOnCpu(m_context->vk, m_context->device, m_semaphore, value, policy);
+
+            TraceLoggingWriteStop(local, "VulkanFence_Wait", TLArg(completed, "Completed"));
+
+            return completed;
+        }
+
+        bool isShareable() const override {
+            return false;
+        }
+
+        const std::shared_ptr<VulkanContext> m_context;
+        const VkSemaphore m_semaphore;
+    };
+
+    struct VulkanTexture : IGraphicsTexture {
+        // When memory is provided, the texture owns the image and its memory.
+        VulkanTexture(std::shared_ptr<VulkanContext> context,
+                      VkImage image,
+                      VkDeviceMemory memory,
+                      const XrSwapchainCreateInfo& info,
+                      VkImageLayout restingLayout)
+            : m_context(context), m_image(image), m_memory(memory), m_info(info), m_restingLayout(restingLayout),
+              m_aspectMask(getAspectMask((VkFormat)info.format)) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanTexture_Create", TLPArg(image, "VkImage"));
+            TraceLoggingWriteTagged(local,
+                                    "VulkanTexture_Create",
+                                    TLArg(info.width, "Width"),
+                                    TLArg(info.height, "Height"),
+                                    TLArg(info.arraySize, "ArraySize"),
+                                    TLArg(info.mipCount, "MipCount"),
+                                    TLArg(info.sampleCount, "SampleCount"),
+                                    TLArg(info.format, "Format"),
+                                    TLArg(info.usageFlags, "Usage"),
+                                    TLArg((int)restingLayout, "Layout"));
+            TraceLoggingWriteStop(local, "VulkanTexture_Create", TLPArg(this, "Texture"));
+        }
+
+        ~VulkanTexture() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanTexture_Destroy", TLPArg(this, "Texture"));
+
+            if (m_memory != VK_NULL_HANDLE) {
+                m_context->vk.vkDestroyImage(m_context->device, m_image, nullptr);
+                m_context->vk.vkFreeMemory(m_context->device, m_memory, nullptr);
+            }
+
+            TraceLoggingWriteStop(local, "VulkanTexture_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::Vulkan;
+        }
+
+        void* getNativeTexturePtr() const override {
+            return reinterpret_cast<void*>(m_image);
+        }
+
+        ShareableHandle getTextureHandle() const override {
+            throw std::runtime_error("Texture is not shareable");
+        }
+
+        const XrSwapchainCreateInfo& getInfo() const override {
+            return m_info;
+        }
+
+        bool isShareable() const override {
+            return false;
+        }
+
+        const std::shared_ptr<VulkanContext> m_context;
+        const VkImage m_image;
+        const VkDeviceMemory m_memory;
+        const XrSwapchainCreateInfo m_info;
+
+        // The layout the image is in whenever it is not used by the layer.
+        const VkImageLayout m_restingLayout;
+        const VkImageAspectFlags m_aspectMask;
+    };
+
+    struct VulkanGraphicsDevice : IGraphicsDevice {
+        VulkanGraphicsDevice(const XrGraphicsBindingVulkanKHR& bindings)
+            : m_context(std::make_shared<VulkanContext>(bindings)) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "VulkanGraphicsDevice_Create",
+                                   TLPArg(bindings.device, "VkDevice"),
+                                   TLArg(bindings.queueFamilyIndex, "QueueFamilyIndex"),
+                                   TLArg(bindings.queueIndex, "QueueIndex"));
+
+            TraceLoggingWriteTagged(local,
+                                    "VulkanGraphicsDevice_Create",
+                                    TLArg(m_context->deviceName.c_str(), "Adapter"),
+                                    TLArg(fmt::format("{}:{}",
+                                                      m_context->adapterLuid.HighPart,
+                                                      m_context->adapterLuid.LowPart)
+                                              .c_str(),
+                                          " Luid"),
+                                    TLArg(!!m_context->vk.vkGetMemoryWin32HandlePropertiesKHR, "ExternalMemory"),
+                                    TLArg(!!m_context->vk.vkImportSemaphoreWin32HandleKHR, "ExternalSemaphore"));
+
+            TraceLoggingWriteStop(local, "VulkanGraphicsDevice_Create", TLPArg(this, "Device"));
+        }
+
+        ~VulkanGraphicsDevice() override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanGraphicsDevice_Destroy", TLPArg(this, "Device"));
+            TraceLoggingWriteStop(local, "VulkanGraphicsDevice_Destroy");
+        }
+
+        Api getApi() const override {
+            return Api::Vulkan;
+        }
+
+        void* getNativeDevicePtr() const override {
+            return m_context->device;
+        }
+
+        void* getNativeContextPtr() const override {
+            return m_context->queue;
+        }
+
+        std::shared_ptr<IGraphicsTimer> createTimer() override {
+            return std::make_shared<VulkanTimer>(m_context);
+        }
+
+        std::shared_ptr<IGraphicsTimerPool> createTimerPool(uint32_t frameLatency) override {
+            throw std::runtime_error("Timer pools are not supported on Vulkan");
+        }
+
+        std::shared_ptr<IGraphicsFence> createFence(bool shareable) override {
+            if (shareable) {
+                throw std::runtime_error("Exporting Vulkan fences is not supported");
+            }
+            return std::make_shared<VulkanFence>(m_context, createTimelineSemaphore(m_context->vk, m_context->device));
+        }
+
+        std::shared_ptr<IGraphicsFence> openFence(const ShareableHandle& handle) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "VulkanFence_Import",
+                                   TLArg(!handle.isNtHandle ? handle.handle : handle.ntHandle.get(), "Handle"),
+                                   TLArg(handle.isNtHandle, "IsNTHandle"));
+
+            if (!handle.isNtHandle) {
+                throw std::runtime_error("Must be NTHANDLE");
+            }
+            if (!m_context->vk.vkImportSemaphoreWin32HandleKHR) {
+                throw std::runtime_error("Vulkan device does not support VK_KHR_external_semaphore_win32");
+            }
+
+            // D3D11 and D3D12 fences are both shared as D3D12 fences.
+            const VkSemaphore semaphore = createTimelineSemaphore(m_context->vk, m_context->device);
+            std::shared_ptr<IGraphicsFence> result = std::make_shared<VulkanFence>(m_context, semaphore);
+            VkImportSemaphoreWin32HandleInfoKHR importInfo{VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_WIN32_HANDLE_INFO_KHR};
+            importInfo.semaphore = semaphore;
+            importInfo.handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_D3D12_FENCE_BIT;
+            importInfo.handle = handle.ntHandle.get();
+            CHECK_VKCMD(m_context->vk.vkImportSemaphoreWin32HandleKHR(m_context->device, &importInfo));
+
+            TraceLoggingWriteStop(local, "VulkanFence_Import", TLPArg(result.get(), "Fence"));
+
+            return result;
+        }
+
+        std::shared_ptr<IGraphicsTexture> createTexture(const XrSwapchainCreateInfo& info, bool shareable) override {
+            if (shareable) {
+                throw std::runtime_error("Exporting Vulkan textures is not supported");
+            }
+
+            const VkImage image = createImage(info, nullptr);
+            VkDeviceMemory memory;
+            {
+                VkMemoryRequirements requirements;
+                m_context->vk.vkGetImageMemoryRequirements(m_context->device, image, &requirements);
+                VkMemoryAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+                allocateInfo.allocationSize = requirements.size;
+                allocateInfo.memoryTypeIndex =
+                    m_context->findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                CHECK_VKCMD(m_context->vk.vkAllocateMemory(m_context->device, &allocateInfo, nullptr, &memory));
+                CHECK_VKCMD(m_context->vk.vkBindImageMemory(m_context->device, image, memory, 0));
+            }
+
+            transitionToGeneralLayout(image, getAspectMask((VkFormat)info.format));
+
+            return std::make_shared<VulkanTexture>(m_context, image, memory, info, VK_IMAGE_LAYOUT_GENERAL);
+        }
+
+        std::shared_ptr<IGraphicsTexture> openTexture(const ShareableHandle& handle,
+                                                      const XrSwapchainCreateInfo& info) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "VulkanTexture_Import",
+                                   TLArg(!handle.isNtHandle ? handle.handle : handle.ntHandle.get(), "Handle"),
+                                   TLArg(handle.isNtHandle, "IsNTHandle"));
+
+            if (!m_context->vk.vkGetMemoryWin32HandlePropertiesKHR) {
+                throw std::runtime_error("Vulkan device does not support VK_KHR_external_memory_win32");
+            }
+
+#ifdef XR_USE_GRAPHICS_API_D3D12
+            const bool isD3D12Resource = handle.origin == Api::D3D12;
+#else
+            const bool isD3D12Resource = false;
+#endif
+            const VkExternalMemoryHandleTypeFlagBits handleType =
+                isD3D12Resource      ? VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D12_RESOURCE_BIT
+                : handle.isNtHandle ? VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT
+                                    : VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_KMT_BIT;
+            const HANDLE nativeHandle = handle.isNtHandle ? handle.ntHandle.get() : handle.handle;
+
+            VkExternalMemoryImageCreateInfo externalInfo{VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO};
+            externalInfo.handleTypes = handleType;
+            const VkImage image = createImage(info, &externalInfo);
+
+            VkDeviceMemory memory;
+            {
+                VkMemoryRequirements requirements;
+                m_context->vk.vkGetImageMemoryRequirements(m_context->device, image, &requirements);
+                VkMemoryWin32HandlePropertiesKHR handleProperties{
+                    VK_STRUCTURE_TYPE_MEMORY_WIN32_HANDLE_PROPERTIES_KHR};
+                CHECK_VKCMD(m_context->vk.vkGetMemoryWin32HandlePropertiesKHR(
+                    m_context->device, handleType, nativeHandle, &handleProperties));
+
+                // Imported textures require a dedicated allocation.
+                VkMemoryDedicatedAllocateInfo dedicatedInfo{VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+                dedicatedInfo.image = image;
+                VkImportMemoryWin32HandleInfoKHR importInfo{VK_STRUCTURE_TYPE_IMPORT_MEMORY_WIN32_HANDLE_INFO_KHR};
+                importInfo.pNext = &dedicatedInfo;
+                importInfo.handleType = handleType;
+                importInfo.handle = nativeHandle;
+                VkMemoryAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+                allocateInfo.pNext = &importInfo;
+                allocateInfo.allocationSize = requirements.size;
+                allocateInfo.memoryTypeIndex =
+                    m_context->findMemoryType(requirements.memoryTypeBits & handleProperties.memoryTypeBits,
+                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                CHECK_VKCMD(m_context->vk.vkAllocateMemory(m_context->device, &allocateInfo, nullptr, &memory));
+                CHECK_VKCMD(m_context->vk.vkBindImageMemory(m_context->device, image, memory, 0));
+            }
+
+            // Textures imported by the layer are only accessed through copies, keep them in a single layout.
+            transitionToGeneralLayout(image, getAspectMask((VkFormat)info.format));
+
+            std::shared_ptr<IGraphicsTexture> result =
+                std::make_shared<VulkanTexture>(m_context, image, memory, info, VK_IMAGE_LAYOUT_GENERAL);
+
+            TraceLoggingWriteStop(local, "VulkanTexture_Import", TLPArg(result.get(), "Texture"));
+
+            return result;
+        }
+
+        std::shared_ptr<IGraphicsTexture> openTexturePtr(void* nativeTexturePtr,
+                                                         const XrSwapchainCreateInfo& info) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "VulkanTexture_Import", TLPArg(nativeTexturePtr, "VkImage"));
+
+            // Runtime swapchain images are in the attachment layout whenever they are released by the application.
+            const VkImage image = reinterpret_cast<VkImage>(nativeTexturePtr);
+            const VkImageLayout layout = (info.usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+                                             ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+                                             : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            std::shared_ptr<IGraphicsTexture> result =
+                std::make_shared<VulkanTexture>(m_context, image, VK_NULL_HANDLE, info, layout);
+
+            TraceLoggingWriteStop(local, "VulkanTexture_Import", TLPArg(result.get(), "Texture"));
+
+            return result;
+        }
+
+        std::shared_ptr<IGraphicsReadback> createReadback(int64_t format,
+                                                          uint32_t width,
+                                                          uint32_t height,
+                                                          uint32_t depth) override {
+            throw std::runtime_error("Readback is not supported on Vulkan");
+        }
+
+        void copyTexture(IGraphicsTexture* from, IGraphicsTexture* to) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "VulkanGraphicsDevice_CopyTexture",
+                                   TLPArg(this, "Device"),
+                                   TLPArg(from, "Source"),
+                                   TLPArg(to, "Destination"));
+
+            const XrSwapchainCreateInfo& info = from->getInfo();
+            std::vector<VkImageCopy> regions;
+            for (uint32_t mipLevel = 0; mipLevel < info.mipCount; mipLevel++) {
+                VkImageCopy region{};
+                region.srcSubresource.aspectMask = static_cast<VulkanTexture*>(from)->m_aspectMask;
+                region.srcSubresource.mipLevel = mipLevel;
+                region.srcSubresource.baseArrayLayer = 0;
+                region.srcSubresource.layerCount = info.arraySize;
+                region.dstSubresource = region.srcSubresource;
+                region.extent = {std::max(info.width >> mipLevel, 1u), std::max(info.height >> mipLevel, 1u), 1};
+                regions.push_back(region);
+            }
+            copyImage(static_cast<VulkanTexture*>(from), static_cast<VulkanTexture*>(to), regions);
+
+            TraceLoggingWriteStop(local, "VulkanGraphicsDevice_CopyTexture");
+        }
+
+        void copyTextureRegion(IGraphicsTexture* from,
+                               const XrRect2Di& fromRect,
+                               uint32_t fromArraySlice,
+                               IGraphicsTexture* to,
+                               const XrOffset2Di& toOffset,
+                               uint32_t toArraySlice,
+                               uint32_t mipLevel) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "VulkanGraphicsDevice_CopyTextureRegion",
+                                   TLPArg(this, "Device"),
+                                   TLPArg(from, "Source"),
+                                   TLArg(fromRect.offset.x, "SourceX"),
+                                   TLArg(fromRect.offset.y, "SourceY"),
+                                   TLArg(fromRect.extent.width, "Width"),
+                                   TLArg(fromRect.extent.height, "Height"),
+                                   TLArg(fromArraySlice, "SourceArraySlice"),
+                                   TLPArg(to, "Destination"),
+                                   TLArg(toOffset.x, "DestinationX"),
+                                   TLArg(toOffset.y, "DestinationY"),
+                                   TLArg(toArraySlice, "DestinationArraySlice"),
+                                   TLArg(mipLevel, "MipLevel"));
+
+            VkImageCopy region{};
+            region.srcSubresource.aspectMask = static_cast<VulkanTexture*>(from)->m_aspectMask;
+            region.srcSubresource.mipLevel = mipLevel;
+            region.srcSubresource.baseArrayLayer = fromArraySlice;
+            region.srcSubresource.layerCount = 1;
+            region.srcOffset = {fromRect.offset.x, fromRect.offset.y, 0};
+            region.dstSubresource = region.srcSubresource;
+            region.dstSubresource.baseArrayLayer = toArraySlice;
+            region.dstOffset = {toOffset.x, toOffset.y, 0};
+            region.extent = {
+                static_cast<uint32_t>(fromRect.extent.width), static_cast<uint32_t>(fromRect.extent.height), 1};
+            copyImage(static_cast<VulkanTexture*>(from), static_cast<VulkanTexture*>(to), {region});
+
+            TraceLoggingWriteStop(local, "VulkanGraphicsDevice_CopyTextureRegion");
+        }
+
+        void scaleTextureRegion(IGraphicsTexture* from,
+                                const XrRect2Di& fromRect,
+                                uint32_t fromArraySlice,
+                                int64_t fromFormat,
+                                IGraphicsTexture* to,
+                                const XrRect2Di& toRect,
+                                uint32_t toArraySlice,
+                                int64_t toFormat,
+                                ScalingFilter filter) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "VulkanGraphicsDevice_ScaleTextureRegion",
+                                   TLPArg(this, "Device"),
+                                   TLPArg(from, "Source"),
+                                   TLArg(fromRect.offset.x, "SourceX"),
+                                   TLArg(fromRect.offset.y, "SourceY"),
+                                   TLArg(fromRect.extent.width, "SourceWidth"),
+                                   TLArg(fromRect.extent.height, "SourceHeight"),
+                                   TLArg(fromArraySlice, "SourceArraySlice"),
+                                   TLPArg(to, "Destination"),
+                                   TLArg(toRect.offset.x, "DestinationX"),
+                                   TLArg(toRect.offset.y, "DestinationY"),
+                                   TLArg(toRect.extent.width, "DestinationWidth"),
+                                   TLArg(toRect.extent.height, "DestinationHeight"),
+                                   TLArg(toArraySlice, "DestinationArraySlice"),
+                                   TLArg((int)filter, "Filter"));
+
+            // Vulkan images are never typeless, so the formats of the images are used. Blits only filter bilinearly:
+            // the Lanczos and edge-adaptive filters are approximated with the bilinear filter.
+            VkImageBlit region{};
+            region.srcSubresource.aspectMask = static_cast<VulkanTexture*>(from)->m_aspectMask;
+            region.srcSubresource.mipLevel = 0;
+            region.srcSubresource.baseArrayLayer = fromArraySlice;
+            region.srcSubresource.layerCount = 1;
+            region.srcOffsets[0] = {fromRect.offset.x, fromRect.offset.y, 0};
+            region.srcOffsets[1] = {
+                fromRect.offset.x + fromRect.extent.width, fromRect.offset.y + fromRect.extent.height, 1};
+            region.dstSubresource = region.srcSubresource;
+            region.dstSubresource.baseArrayLayer = toArraySlice;
+            region.dstOffsets[0] = {toRect.offset.x, toRect.offset.y, 0};
+            region.dstOffsets[1] = {toRect.offset.x + toRect.extent.width, toRect.offset.y + toRect.extent.height, 1};
+            transfer(static_cast<VulkanTexture*>(from),
+                     static_cast<VulkanTexture*>(to),
+                     [&](VkCommandBuffer commandBuffer, VkImage source, VkImage destination) {
+                         m_context->vk.vkCmdBlitImage(commandBuffer,
+                                                      source,
+                                                      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                                      destination,
+                                                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                      1,
+                                                      &region,
+                                                      VK_FILTER_LINEAR);
+                     });
+
+            TraceLoggingWriteStop(local, "VulkanGraphicsDevice_ScaleTextureRegion");
+        }
+
+        void clearTexture(IGraphicsTexture* texture,
+                          uint32_t arraySlice,
+                          int64_t format,
+                          const XrColor4f& color) override {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "VulkanGraphicsDevice_ClearTexture",
+                                   TLPArg(this, "Device"),
+                                   TLPArg(texture, "Texture"),
+                                   TLArg(arraySlice, "ArraySlice"));
+
+            // Cleared as a transfer destination rather than as an attachment, which would need a render pass.
+            const VkClearColorValue clearColor{{color.r, color.g, color.b, color.a}};
+            const VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, arraySlice, 1};
+            transfer(nullptr,
+                     static_cast<VulkanTexture*>(texture),
+                     [&](VkCommandBuffer commandBuffer, VkImage source, VkImage destination) {
+                         m_context->vk.vkCmdClearColorImage(commandBuffer,
+                                                            destination,
+                                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                            &clearColor,
+                                                            1,
+                                                            &range);
+                     });
+
+            TraceLoggingWriteStop(local, "VulkanGraphicsDevice_ClearTexture");
+        }
+
+        GenericFormat translateToGenericFormat(int64_t format) const override {
+            for (const auto& entry : FormatTable) {
+                if (entry.first == (VkFormat)format) {
+                    return entry.second;
+                }
+            }
+            return DXGI_FORMAT_UNKNOWN;
+        }
+
+        int64_t translateFromGenericFormat(GenericFormat format) const override {
+            for (const auto& entry : FormatTable) {
+                if (entry.second == format) {
+                    return (int64_t)entry.first;
+                }
+            }
+            return (int64_t)VK_FORMAT_UNDEFINED;
+        }
+
+        LUID getAdapterLuid() const override {
+            return m_context->adapterLuid;
+        }
+
+        CommandListStatistics getCommandListStatistics() const override {
+            return {};
+        }
+
+        VkImage createImage(const XrSwapchainCreateInfo& info, const void* next) const {
+            VkImageCreateInfo createInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+            createInfo.pNext = next;
+            if (info.usageFlags & XR_SWAPCHAIN_USAGE_MUTABLE_FORMAT_BIT) {
+                createInfo.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+            }
+            createInfo.imageType = VK_IMAGE_TYPE_2D;
+            createInfo.format = (VkFormat)info.format;
+            createInfo.extent = {info.width, info.height, 1};
+            createInfo.mipLevels = info.mipCount;
+            createInfo.arrayLayers = info.arraySize;
+            createInfo.samples = (VkSampleCountFlagBits)info.sampleCount;
+            createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            createInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            if (info.usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT) {
+                createInfo.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            }
+            if (info.usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+                createInfo.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            }
+            if (info.usageFlags & XR_SWAPCHAIN_USAGE_SAMPLED_BIT) {
+                createInfo.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+            }
+            if (info.usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) {
+                createInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+            }
+            createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            VkImage image;
+            CHECK_VKCMD(m_context->vk.vkCreateImage(m_context->device, &createInfo, nullptr, &image));
+            return image;
+        }
+
+        void transitionToGeneralLayout(VkImage image, VkImageAspectFlags aspectMask) {
+            VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image;
+            barrier.subresourceRange = {aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+
+            const VkCommandBuffer commandBuffer = m_context->getCommandBuffer();
+            m_context->vk.vkCmdPipelineBarrier(commandBuffer,
+                                               VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                               0,
+                                               0,
+                                               nullptr,
+                                               0,
+                                               nullptr,
+                                               1,
+                                               &barrier);
+            m_context->submitCommandBuffer(commandBuffer);
+        }
+
+        void copyImage(VulkanTexture* from, VulkanTexture* to, const std::vector<VkImageCopy>& regions) {
+            transfer(from, to, [&](VkCommandBuffer commandBuffer, VkImage source, VkImage destination) {
+                m_context->vk.vkCmdCopyImage(commandBuffer,
+                                             source,
+                                             VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                             destination,
+                                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                             static_cast<uint32_t>(regions.size()),
+                                             regions.data());
+            });
+        }
+
+        // Record transfer commands from an image (optional) to another one, transitioning them from and back to their
+        // resting layout.
+        void transfer(VulkanTexture* from,
+                      VulkanTexture* to,
+                      const std::function<void(VkCommandBuffer, VkImage, VkImage)>& record) {
+            VkImageMemoryBarrier barriers[2]{};
+            uint32_t barrierCount = 0;
+            for (uint32_t i = from ? 0 : 1; i < 2; i++) {
+                VulkanTexture* const texture = i == 0 ? from : to;
+                VkImageMemoryBarrier& barrier = barriers[barrierCount++];
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                barrier.dstAccessMask = i == 0 ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.oldLayout = texture->m_restingLayout;
+                barrier.newLayout =
+                    i == 0 ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = texture->m_image;
+                barrier.subresourceRange = {
+                    texture->m_aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+            }
+
+            const VkCommandBuffer commandBuffer = m_context->getCommandBuffer();
+            m_context->vk.vkCmdPipelineBarrier(commandBuffer,
+                                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                               VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                               0,
+                                               0,
+                                               nullptr,
+                                               0,
+                                               nullptr,
+                                               barrierCount,
+                                               barriers);
+            record(commandBuffer, from ? from->m_image : VK_NULL_HANDLE, to->m_image);
+            for (uint32_t i = 0; i < barrierCount; i++) {
+                std::swap(barriers[i].oldLayout, barriers[i].newLayout);
+                barriers[i].srcAccessMask = barriers[i].dstAccessMask;
+                barriers[i].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            }
+            m_context->vk.vkCmdPipelineBarrier(commandBuffer,
+                                               VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                               0,
+                                               0,
+                                               nullptr,
+                                               0,
+                                               nullptr,
+                                               barrierCount,
+                                               barriers);
+            m_context->submitCommandBuffer(commandBuffer);
+        }
+
+        const std::shared_ptr<VulkanContext> m_context;
+    };
+
+} // namespace
+
+namespace openxr_api_layer::utils::graphics::internal {
+
+    std::shared_ptr<IGraphicsDevice> wrapApplicationDevice(const XrGraphicsBindingVulkanKHR& bindings) {
+        return std::make_shared<VulkanGraphicsDevice>(bindings);
+    }
+
+} // namespace openxr_api_layer::utils::graphics::internal
+
+#endif
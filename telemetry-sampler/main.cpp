@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Command-line sampler for the layer's telemetry page. Prints one CSV line per sample.
+//
+// Usage: telemetry-sampler [-p <process id>] [-i <interval in ms>] [-n <number of samples>]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <utils/telemetry.h>
+
+using namespace openxr_api_layer::utils::telemetry;
+
+namespace {
+
+    double averageUs(const CallLatency& latency) {
+        return latency.count ? (double)latency.totalUs / latency.count : 0.0;
+    }
+
+    // RFC 4180 field: quoted, with the quotes inside doubled.
+    std::string quoteCsv(const char* value, size_t maxLength) {
+        std::string quoted = "\"";
+        for (size_t i = 0; i < maxLength && value[i]; i++) {
+            if (value[i] == '"') {
+                quoted += '"';
+            }
+            quoted += value[i];
+        }
+        quoted += '"';
+        return quoted;
+    }
+
+    void printHeader() {
+        printf("time_ms,pid,application,frame_count,frame_interval_us,frame_interval_avg_us,frame_interval_min_us,"
+               "frame_interval_max_us,fov_l_up,fov_l_down,fov_r_up,fov_r_down,native_fov_l_up,native_fov_l_down,"
+               "native_fov_r_up,native_fov_r_down,native_pixels,recommended_pixels,locate_views_avg_us,"
+               "locate_views_max_us,end_frame_avg_us,end_frame_max_us,dropped_logs,composition_gpu_avg_us,"
+               "composition_gpu_max_us\n");
+    }
+
+    void printSample(uint64_t timeMs, const Counters& c) {
+        printf("%llu,%u,%s,%llu,%llu,%llu,%llu,%llu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%llu,%llu,%.1f,%llu,%.1f,%llu,"
+               "%llu,%.1f,%llu\n",
+               timeMs,
+               c.processId,
+               quoteCsv(c.applicationName, sizeof(c.applicationName)).c_str(),
+               c.frameCount,
+               c.lastFrameIntervalUs,
+               c.averageFrameIntervalUs,
+               c.minFrameIntervalUs,
+               c.maxFrameIntervalUs,
+               c.customizedFov[0].angleUp,
+               c.customizedFov[0].angleDown,
+               c.customizedFov[1].angleUp,
+               c.customizedFov[1].angleDown,
+               c.nativeFov[0].angleUp,
+               c.nativeFov[0].angleDown,
+               c.nativeFov[1].angleUp,
+               c.nativeFov[1].angleDown,
+               c.nativePixelCount,
+               c.recommendedPixelCount,
+               averageUs(c.locateViews),
+               c.locateViews.maxUs,
+               averageUs(c.endFrame),
+               c.endFrame.maxUs,
+               c.droppedLogCount,
+               averageUs(c.compositionGpu),
+               c.compositionGpu.maxUs);
+        fflush(stdout);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t processId = 0;
+    uint32_t intervalMs = 1000;
+    uint64_t samples = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string option(argv[i]);
+        if (option == "-p") {
+            processId = std::strtoul(argv[i + 1], nullptr, 10);
+        } else if (option == "-i") {
+            intervalMs = std::max(1ul, std::strtoul(argv[i + 1], nullptr, 10));
+        } else if (option == "-n") {
+            samples = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [-p <process id>] [-i <interval in ms>] [-n <number of samples>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const Reader reader(processId);
+    if (!reader.isValid()) {
+        fprintf(stderr, "Telemetry page %s is not available\n", getPageName(processId).c_str());
+        return 1;
+    }
+
+    printHeader();
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; !samples || i < samples; i++) {
+        Counters counters;
+        if (reader.read(counters)) {
+            const auto now = std::chrono::steady_clock::now();
+            printSample(std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count(), counters);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Unit tests for the CPU-side utilities of the layer.
+//
+// Usage: tests [<name filter>]
+//        tests benchmark [<name filter>]
+//        tests replay <capture> [<layer>]
+
+#include "pch.h"
+
+#include "replay.h"
+#include "test.h"
+
+namespace openxr_api_layer::log {
+    // Normally opened by the layer's entry point.
+    std::ofstream logStream;
+} // namespace openxr_api_layer::log
+
+namespace {
+
+    std::vector<std::pair<const char*, openxr_api_layer::test::TestFunction>>& getTests() {
+        static std::vector<std::pair<const char*, openxr_api_layer::test::TestFunction>> tests;
+        return tests;
+    }
+
+    std::vector<std::pair<const char*, openxr_api_layer::test::TestFunction>>& getBenchmarks() {
+        static std::vector<std::pair<const char*, openxr_api_layer::test::TestFunction>> benchmarks;
+        return benchmarks;
+    }
+
+    int benchmarkCommand(std::string_view filter) {
+        for (const auto& [name, function] : getBenchmarks()) {
+            if (std::string_view(name).find(filter) == std::string_view::npos) {
+                continue;
+            }
+            printf("[ BENCH ] %s\n", name);
+            try {
+                function();
+            } catch (std::exception& exc) {
+                printf("[ FAIL ] %s: %s\n", name, exc.what());
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+} // namespace
+
+namespace openxr_api_layer::test {
+
+    void registerTest(const char* name, TestFunction function) {
+        getTests().emplace_back(name, function);
+    }
+
+    void registerBenchmark(const char* name, TestFunction function) {
+        getBenchmarks().emplace_back(name, function);
+    }
+
+    void fail(const char* file, int line, const char* expression) {
+        throw std::runtime_error(fmt::format("{}({}): CHECK({}) failed", file, line, expression));
+    }
+
+} // namespace openxr_api_layer::test
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string_view(argv[1]) == "replay") {
+        return openxr_api_layer::test::replay::replayCommand(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "benchmark") {
+        return benchmarkCommand(argc > 2 ? argv[2] : "");
+    }
+
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+
+    uint32_t passed = 0;
+    uint32_t failed = 0;
+    for (const auto& [name, function] : getTests()) {
+        if (std::string_view(name).find(filter) == std::string_view::npos) {
+            continue;
+        }
+        try {
+            function();
+            printf("[ PASS ] %s\n", name);
+            passed++;
+        } catch (std::exception& exc) {
+            printf("[ FAIL ] %s: %s\n", name, exc.what());
+            failed++;
+        }
+    }
+    printf("%u passed, %u failed\n", passed, failed);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,809 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "replay.h"
+#include <utils/general.h>
+
+namespace {
+
+    using namespace openxr_api_layer;
+    using namespace openxr_api_layer::test::replay;
+    using namespace openxr_api_layer::utils;
+    using clock = std::chrono::steady_clock;
+
+    // Only the first differences are described.
+    constexpr size_t MaxDifferences = 16;
+
+    // The runtime below the layer, answering with the outputs of the record being replayed.
+    struct StubRuntime {
+        const capture::FileHeader* header{nullptr};
+        const capture::Record* record{nullptr};
+        clock::duration runtimeTime{};
+    };
+    StubRuntime g_runtime;
+
+    struct RuntimeScope {
+        ~RuntimeScope() {
+            g_runtime.runtimeTime += clock::now() - start;
+        }
+
+        const clock::time_point start{clock::now()};
+    };
+
+    // The layer must call the runtime function of the record being replayed, at most once.
+    const capture::Record* takeRecord(capture::RecordType type) {
+        const capture::Record* record = g_runtime.record;
+        if (!record || record->type != type) {
+            return nullptr;
+        }
+        g_runtime.record = nullptr;
+        return record;
+    }
+
+    XrFovf toFov(const telemetry::Fov& fov) {
+        return {fov.angleLeft, fov.angleRight, fov.angleUp, fov.angleDown};
+    }
+
+    XrResult XRAPI_CALL stubCreateApiLayerInstance(const XrInstanceCreateInfo* info,
+                                                   const XrApiLayerCreateInfo* apiLayerInfo,
+                                                   XrInstance* instance) {
+        *instance = (XrInstance)1;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL stubDestroyInstance(XrInstance instance) {
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL stubEnumerateInstanceExtensionProperties(const char* layerName,
+                                                                 uint32_t propertyCapacityInput,
+                                                                 uint32_t* propertyCountOutput,
+                                                                 XrExtensionProperties* properties) {
+        *propertyCountOutput = 0;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL stubGetInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties) {
+        strncpy_s(instanceProperties->runtimeName, g_runtime.header->runtimeName, _TRUNCATE);
+        instanceProperties->runtimeVersion = g_runtime.header->runtimeVersion;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL stubGetSystemProperties(XrInstance instance,
+                                                XrSystemId systemId,
+                                                XrSystemProperties* properties) {
+        RuntimeScope scope;
+        properties->systemId = systemId;
+        strncpy_s(properties->systemName, "Replay", _TRUNCATE);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL stubGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::GetSystem);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        *systemId = record->handle;
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubCreateSession(XrInstance instance,
+                                          const XrSessionCreateInfo* createInfo,
+                                          XrSession* session) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::CreateSession);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        *session = (XrSession)record->handle;
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubDestroySession(XrSession session) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::DestroySession);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubEnumerateViewConfigurationViews(XrInstance instance,
+                                                            XrSystemId systemId,
+                                                            XrViewConfigurationType viewConfigurationType,
+                                                            uint32_t viewCapacityInput,
+                                                            uint32_t* viewCountOutput,
+                                                            XrViewConfigurationView* views) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::EnumerateViewConfigurationViews);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        if (XR_FAILED(record->result)) {
+            return (XrResult)record->result;
+        }
+
+        const auto& payload = record->as<capture::EnumerateViewConfigurationViewsPayload>();
+        *viewCountOutput = payload.viewCount;
+        if (viewCapacityInput) {
+            if (viewCapacityInput < payload.viewCount) {
+                return XR_ERROR_SIZE_INSUFFICIENT;
+            }
+            for (uint32_t i = 0; i < std::min(payload.viewCount, capture::MaxViews); i++) {
+                views[i].recommendedImageRectWidth = views[i].maxImageRectWidth = payload.nativeImageSize[i].width;
+                views[i].recommendedImageRectHeight = views[i].maxImageRectHeight = payload.nativeImageSize[i].height;
+                views[i].recommendedSwapchainSampleCount = views[i].maxSwapchainSampleCount = 1;
+            }
+        }
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubLocateViews(XrSession session,
+                                        const XrViewLocateInfo* viewLocateInfo,
+                                        XrViewState* viewState,
+                                        uint32_t viewCapacityInput,
+                                        uint32_t* viewCountOutput,
+                                        XrView* views) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::LocateViews);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        if (XR_FAILED(record->result)) {
+            return (XrResult)record->result;
+        }
+
+        const auto& payload = record->as<capture::LocateViewsPayload>();
+        *viewCountOutput = payload.viewCount;
+        if (viewCapacityInput) {
+            if (viewCapacityInput < payload.viewCount) {
+                return XR_ERROR_SIZE_INSUFFICIENT;
+            }
+            viewState->viewStateFlags =
+                XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT |
+                XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+            for (uint32_t i = 0; i < std::min(payload.viewCount, capture::MaxViews); i++) {
+                views[i].pose = xr::math::Pose::Identity();
+                views[i].fov = toFov(payload.nativeFov[i]);
+            }
+        }
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::EndFrame);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubCreateSwapchain(XrSession session,
+                                            const XrSwapchainCreateInfo* createInfo,
+                                            XrSwapchain* swapchain) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::CreateSwapchain);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        *swapchain = (XrSwapchain)record->as<capture::CreateSwapchainPayload>().swapchain;
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubDestroySwapchain(XrSwapchain swapchain) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::DestroySwapchain);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubAcquireSwapchainImage(XrSwapchain swapchain,
+                                                  const XrSwapchainImageAcquireInfo* acquireInfo,
+                                                  uint32_t* index) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::AcquireSwapchainImage);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        *index = record->as<capture::AcquireSwapchainImagePayload>().index;
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::WaitSwapchainImage);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        // The runtime must see the application's timeout.
+        if (waitInfo->timeout != record->as<capture::WaitSwapchainImagePayload>().timeout) {
+            return XR_ERROR_VALIDATION_FAILURE;
+        }
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubReleaseSwapchainImage(XrSwapchain swapchain,
+                                                  const XrSwapchainImageReleaseInfo* releaseInfo) {
+        RuntimeScope scope;
+        const capture::Record* record = takeRecord(capture::RecordType::ReleaseSwapchainImage);
+        if (!record) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        return (XrResult)record->result;
+    }
+
+    XrResult XRAPI_CALL stubGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
+        static const std::pair<std::string_view, PFN_xrVoidFunction> functions[] = {
+            {"xrDestroyInstance", reinterpret_cast<PFN_xrVoidFunction>(stubDestroyInstance)},
+            {"xrEnumerateInstanceExtensionProperties",
+             reinterpret_cast<PFN_xrVoidFunction>(stubEnumerateInstanceExtensionProperties)},
+            {"xrGetInstanceProperties", reinterpret_cast<PFN_xrVoidFunction>(stubGetInstanceProperties)},
+            {"xrGetSystemProperties", reinterpret_cast<PFN_xrVoidFunction>(stubGetSystemProperties)},
+            {"xrGetSystem", reinterpret_cast<PFN_xrVoidFunction>(stubGetSystem)},
+            {"xrCreateSession", reinterpret_cast<PFN_xrVoidFunction>(stubCreateSession)},
+            {"xrDestroySession", reinterpret_cast<PFN_xrVoidFunction>(stubDestroySession)},
+            {"xrEnumerateViewConfigurationViews",
+             reinterpret_cast<PFN_xrVoidFunction>(stubEnumerateViewConfigurationViews)},
+            {"xrLocateViews", reinterpret_cast<PFN_xrVoidFunction>(stubLocateViews)},
+            {"xrEndFrame", reinterpret_cast<PFN_xrVoidFunction>(stubEndFrame)},
+            {"xrCreateSwapchain", reinterpret_cast<PFN_xrVoidFunction>(stubCreateSwapchain)},
+            {"xrDestroySwapchain", reinterpret_cast<PFN_xrVoidFunction>(stubDestroySwapchain)},
+            {"xrAcquireSwapchainImage", reinterpret_cast<PFN_xrVoidFunction>(stubAcquireSwapchainImage)},
+            {"xrWaitSwapchainImage", reinterpret_cast<PFN_xrVoidFunction>(stubWaitSwapchainImage)},
+            {"xrReleaseSwapchainImage", reinterpret_cast<PFN_xrVoidFunction>(stubReleaseSwapchainImage)},
+        };
+
+        for (const auto& [functionName, pointer] : functions) {
+            if (functionName == name) {
+                *function = pointer;
+                return XR_SUCCESS;
+            }
+        }
+        *function = nullptr;
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+
+    // The settings of the capture, in a registry key standing for HKEY_CURRENT_USER, and a %LOCALAPPDATA% folder for
+    // the log and the capture of the replay.
+    class Sandbox {
+      public:
+        Sandbox(const capture::FileHeader& header, bool captureReplay) {
+            const std::string name = fmt::format("{}-replay-{}", LAYER_NAME, GetCurrentProcessId());
+            m_keyPath = "SOFTWARE\\" + name;
+            CHECK_HRCMD(HRESULT_FROM_WIN32(RegCreateKeyExA(HKEY_CURRENT_USER,
+                                                           m_keyPath.c_str(),
+                                                           0,
+                                                           nullptr,
+                                                           REG_OPTION_NON_VOLATILE,
+                                                           KEY_ALL_ACCESS,
+                                                           nullptr,
+                                                           m_key.put(),
+                                                           nullptr)));
+            CHECK_HRCMD(HRESULT_FROM_WIN32(RegOverridePredefKey(HKEY_CURRENT_USER, m_key.get())));
+
+            m_localAppData = std::filesystem::temp_directory_path() / name;
+            std::filesystem::create_directories(m_localAppData);
+            if (const char* localAppData = getenv("LOCALAPPDATA")) {
+                m_previousLocalAppData = localAppData;
+            }
+            setLocalAppData(m_localAppData.string());
+
+            // The stub runtime has no graphics API to compose with.
+            general::setSetting("fov_up", header.fovUpSetting);
+            general::setSetting("fov_down", header.fovDownSetting);
+            general::setSetting("angle_up", header.angleUpSetting);
+            general::setSetting("angle_down", header.angleDownSetting);
+            general::setSetting("upscaling", 1000);
+            general::setSetting("padding", 0);
+            general::setSetting("frame_capture", 0);
+            general::setSetting("telemetry", 0);
+            general::setSetting("capture", captureReplay ? 1 : 0);
+        }
+
+        ~Sandbox() {
+            RegOverridePredefKey(HKEY_CURRENT_USER, nullptr);
+            m_key.reset();
+            RegDeleteTreeA(HKEY_CURRENT_USER, m_keyPath.c_str());
+            RegDeleteKeyA(HKEY_CURRENT_USER, m_keyPath.c_str());
+
+            setLocalAppData(m_previousLocalAppData);
+            std::error_code error;
+            std::filesystem::remove_all(m_localAppData, error);
+        }
+
+        Sandbox(const Sandbox&) = delete;
+        Sandbox& operator=(const Sandbox&) = delete;
+
+        // Where the layer writes its files.
+        std::filesystem::path getLayerFolder() const {
+            return m_localAppData / LAYER_NAME;
+        }
+
+      private:
+        static void setLocalAppData(const std::string& path) {
+            SetEnvironmentVariableA("LOCALAPPDATA", path.c_str());
+            _putenv_s("LOCALAPPDATA", path.c_str());
+        }
+
+        std::string m_keyPath;
+        wil::unique_hkey m_key;
+        std::filesystem::path m_localAppData;
+        std::string m_previousLocalAppData;
+    };
+
+    // An instance of the layer on top of the stub runtime, created like the loader does.
+    class LayerInstance {
+      public:
+        LayerInstance(const std::filesystem::path& path, const capture::FileHeader& header) {
+            m_module.reset(LoadLibraryW(path.c_str()));
+            if (!m_module) {
+                throw std::runtime_error(fmt::format("Failed to load {}: {}", path.string(), GetLastError()));
+            }
+            const auto xrNegotiateLoaderApiLayerInterface = reinterpret_cast<PFN_xrNegotiateLoaderApiLayerInterface>(
+                GetProcAddress(m_module.get(), "xrNegotiateLoaderApiLayerInterface"));
+            if (!xrNegotiateLoaderApiLayerInterface) {
+                throw std::runtime_error(fmt::format("{} is not an API layer", path.string()));
+            }
+
+            XrNegotiateLoaderInfo loaderInfo{XR_LOADER_INTERFACE_STRUCT_LOADER_INFO,
+                                             XR_LOADER_INFO_STRUCT_VERSION,
+                                             sizeof(XrNegotiateLoaderInfo)};
+            loaderInfo.minInterfaceVersion = 1;
+            loaderInfo.maxInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+            loaderInfo.minApiVersion = XR_MAKE_VERSION(1, 0, 0);
+            loaderInfo.maxApiVersion = XR_CURRENT_API_VERSION;
+            XrNegotiateApiLayerRequest layerRequest{XR_LOADER_INTERFACE_STRUCT_API_LAYER_REQUEST,
+                                                    XR_API_LAYER_INFO_STRUCT_VERSION,
+                                                    sizeof(XrNegotiateApiLayerRequest)};
+            CHECK_XRCMD(xrNegotiateLoaderApiLayerInterface(&loaderInfo, LAYER_NAME, &layerRequest));
+
+            XrApiLayerNextInfo nextInfo{XR_LOADER_INTERFACE_STRUCT_API_LAYER_NEXT_INFO,
+                                        XR_API_LAYER_NEXT_INFO_STRUCT_VERSION,
+                                        sizeof(XrApiLayerNextInfo)};
+            strncpy_s(nextInfo.layerName, LAYER_NAME, _TRUNCATE);
+            nextInfo.nextGetInstanceProcAddr = stubGetInstanceProcAddr;
+            nextInfo.nextCreateApiLayerInstance = stubCreateApiLayerInstance;
+            XrApiLayerCreateInfo apiLayerInfo{XR_LOADER_INTERFACE_STRUCT_API_LAYER_CREATE_INFO,
+                                              XR_API_LAYER_CREATE_INFO_STRUCT_VERSION,
+                                              sizeof(XrApiLayerCreateInfo)};
+            apiLayerInfo.nextInfo = &nextInfo;
+
+            XrInstanceCreateInfo createInfo{XR_TYPE_INSTANCE_CREATE_INFO};
+            strncpy_s(createInfo.applicationInfo.applicationName, header.applicationName, _TRUNCATE);
+            createInfo.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+            CHECK_XRCMD(layerRequest.createApiLayerInstance(&createInfo, &apiLayerInfo, &m_instance));
+            m_xrGetInstanceProcAddr = layerRequest.getInstanceProcAddr;
+
+            resolve("xrDestroyInstance", xrDestroyInstance);
+            resolve("xrGetSystem", xrGetSystem);
+            resolve("xrCreateSession", xrCreateSession);
+            resolve("xrDestroySession", xrDestroySession);
+            resolve("xrEnumerateViewConfigurationViews", xrEnumerateViewConfigurationViews);
+            resolve("xrLocateViews", xrLocateViews);
+            resolve("xrEndFrame", xrEndFrame);
+            resolve("xrCreateSwapchain", xrCreateSwapchain);
+            resolve("xrDestroySwapchain", xrDestroySwapchain);
+            resolve("xrAcquireSwapchainImage", xrAcquireSwapchainImage);
+            resolve("xrWaitSwapchainImage", xrWaitSwapchainImage);
+            resolve("xrReleaseSwapchainImage", xrReleaseSwapchainImage);
+        }
+
+        ~LayerInstance() {
+            // Destroying the instance closes the layer's capture.
+            if (xrDestroyInstance) {
+                xrDestroyInstance(m_instance);
+            }
+        }
+
+        LayerInstance(const LayerInstance&) = delete;
+        LayerInstance& operator=(const LayerInstance&) = delete;
+
+        XrInstance getInstance() const {
+            return m_instance;
+        }
+
+        PFN_xrDestroyInstance xrDestroyInstance{nullptr};
+        PFN_xrGetSystem xrGetSystem{nullptr};
+        PFN_xrCreateSession xrCreateSession{nullptr};
+        PFN_xrDestroySession xrDestroySession{nullptr};
+        PFN_xrEnumerateViewConfigurationViews xrEnumerateViewConfigurationViews{nullptr};
+        PFN_xrLocateViews xrLocateViews{nullptr};
+        PFN_xrEndFrame xrEndFrame{nullptr};
+        PFN_xrCreateSwapchain xrCreateSwapchain{nullptr};
+        PFN_xrDestroySwapchain xrDestroySwapchain{nullptr};
+        PFN_xrAcquireSwapchainImage xrAcquireSwapchainImage{nullptr};
+        PFN_xrWaitSwapchainImage xrWaitSwapchainImage{nullptr};
+        PFN_xrReleaseSwapchainImage xrReleaseSwapchainImage{nullptr};
+
+      private:
+        template <typename T>
+        void resolve(const char* name, T& function) {
+            CHECK_XRCMD(m_xrGetInstanceProcAddr(m_instance, name, reinterpret_cast<PFN_xrVoidFunction*>(&function)));
+        }
+
+        wil::unique_hmodule m_module;
+        XrInstance m_instance{XR_NULL_HANDLE};
+        PFN_xrGetInstanceProcAddr m_xrGetInstanceProcAddr{nullptr};
+    };
+
+    std::filesystem::path getDefaultLayerPath() {
+        char path[_MAX_PATH];
+        GetModuleFileNameA(nullptr, path, sizeof(path));
+#ifdef _WIN64
+        return std::filesystem::path(path).parent_path() / (LAYER_NAME ".dll");
+#else
+        return std::filesystem::path(path).parent_path() / (LAYER_NAME "-32.dll");
+#endif
+    }
+
+    bool isSameFov(const telemetry::Fov& a, const telemetry::Fov& b) {
+        constexpr float Tolerance = 1e-6f;
+        return std::abs(a.angleLeft - b.angleLeft) <= Tolerance && std::abs(a.angleRight - b.angleRight) <= Tolerance &&
+               std::abs(a.angleUp - b.angleUp) <= Tolerance && std::abs(a.angleDown - b.angleDown) <= Tolerance;
+    }
+
+    class Replayer {
+      public:
+        Replayer(const capture::Capture& capture, const Options& options, LayerInstance& layer, Report& report)
+            : m_capture(capture), m_options(options), m_layer(layer), m_report(report) {
+        }
+
+        void run() {
+            for (size_t i = 0; i < m_capture.records.size(); i++) {
+                replay(i, m_capture.records[i]);
+            }
+        }
+
+      private:
+        void replay(size_t index, const capture::Record& record) {
+            g_runtime.record = &record;
+            g_runtime.runtimeTime = {};
+
+            const auto callStart = clock::now();
+            XrResult result;
+            switch (record.type) {
+            case capture::RecordType::GetSystem:
+                result = replayGetSystem(record);
+                break;
+            case capture::RecordType::CreateSession:
+                result = replayCreateSession(record);
+                break;
+            case capture::RecordType::DestroySession:
+                result = m_layer.xrDestroySession((XrSession)record.handle);
+                break;
+            case capture::RecordType::EnumerateViewConfigurationViews:
+                result = replayEnumerateViewConfigurationViews(index, record);
+                break;
+            case capture::RecordType::LocateViews:
+                result = replayLocateViews(index, record);
+                break;
+            case capture::RecordType::EndFrame:
+                result = replayEndFrame(record);
+                break;
+            case capture::RecordType::CreateSwapchain:
+                result = replayCreateSwapchain(index, record);
+                break;
+            case capture::RecordType::DestroySwapchain:
+                result = m_layer.xrDestroySwapchain((XrSwapchain)record.handle);
+                break;
+            case capture::RecordType::AcquireSwapchainImage:
+                result = replayAcquireSwapchainImage(index, record);
+                break;
+            case capture::RecordType::WaitSwapchainImage:
+                result = replayWaitSwapchainImage(record);
+                break;
+            case capture::RecordType::ReleaseSwapchainImage: {
+                XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+                result = m_layer.xrReleaseSwapchainImage((XrSwapchain)record.handle, &releaseInfo);
+                break;
+            }
+            default:
+                g_runtime.record = nullptr;
+                return;
+            }
+            const auto callEnd = clock::now();
+            g_runtime.record = nullptr;
+
+            CallStatistics& statistics = m_report.calls[(size_t)record.type];
+            statistics.count++;
+            statistics.layerNs.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(callEnd - callStart - g_runtime.runtimeTime)
+                    .count());
+            m_report.replayedCalls++;
+
+            if (result != (XrResult)record.result) {
+                addDifference(index,
+                              record,
+                              fmt::format("returned {} instead of {}",
+                                          xr::ToCString(result),
+                                          xr::ToCString((XrResult)record.result)));
+            }
+        }
+
+        XrResult replayGetSystem(const capture::Record& record) {
+            const auto& payload = record.as<capture::GetSystemPayload>();
+            XrSystemGetInfo getInfo{XR_TYPE_SYSTEM_GET_INFO};
+            getInfo.formFactor = (XrFormFactor)payload.formFactor;
+            XrSystemId systemId = XR_NULL_SYSTEM_ID;
+            return m_layer.xrGetSystem(m_layer.getInstance(), &getInfo, &systemId);
+        }
+
+        XrResult replayCreateSession(const capture::Record& record) {
+            const auto& payload = record.as<capture::CreateSessionPayload>();
+            XrSessionCreateInfo createInfo{XR_TYPE_SESSION_CREATE_INFO};
+            createInfo.systemId = payload.systemId;
+            XrSession session = XR_NULL_HANDLE;
+            return m_layer.xrCreateSession(m_layer.getInstance(), &createInfo, &session);
+        }
+
+        XrResult replayEnumerateViewConfigurationViews(size_t index, const capture::Record& record) {
+            const auto& payload = record.as<capture::EnumerateViewConfigurationViewsPayload>();
+            std::vector<XrViewConfigurationView> views(payload.viewCount, {XR_TYPE_VIEW_CONFIGURATION_VIEW});
+            uint32_t viewCount = 0;
+            const XrResult result =
+                m_layer.xrEnumerateViewConfigurationViews(m_layer.getInstance(),
+                                                          record.handle,
+                                                          (XrViewConfigurationType)payload.viewConfigurationType,
+                                                          payload.viewCount,
+                                                          &viewCount,
+                                                          views.data());
+            if (XR_FAILED(result) || !m_options.compareOutputs) {
+                return result;
+            }
+            if (m_capture.header.upscalingSetting != 1000) {
+                m_report.skippedComparisons++;
+                return result;
+            }
+
+            for (uint32_t i = 0; i < std::min(viewCount, capture::MaxViews); i++) {
+                const telemetry::ImageSize& expected = payload.recommendedImageSize[i];
+                if (views[i].recommendedImageRectWidth != expected.width ||
+                    views[i].recommendedImageRectHeight != expected.height) {
+                    addDifference(index,
+                                  record,
+                                  fmt::format("recommended {}x{} instead of {}x{} for view {}",
+                                              views[i].recommendedImageRectWidth,
+                                              views[i].recommendedImageRectHeight,
+                                              expected.width,
+                                              expected.height,
+                                              i));
+                    break;
+                }
+            }
+            return result;
+        }
+
+        XrResult replayLocateViews(size_t index, const capture::Record& record) {
+            const auto& payload = record.as<capture::LocateViewsPayload>();
+            XrViewLocateInfo locateInfo{XR_TYPE_VIEW_LOCATE_INFO};
+            locateInfo.viewConfigurationType = (XrViewConfigurationType)payload.viewConfigurationType;
+            locateInfo.displayTime = payload.displayTime;
+            XrViewState viewState{XR_TYPE_VIEW_STATE};
+            std::vector<XrView> views(payload.viewCount, {XR_TYPE_VIEW});
+            uint32_t viewCount = 0;
+            const XrResult result = m_layer.xrLocateViews(
+                (XrSession)record.handle, &locateInfo, &viewState, payload.viewCount, &viewCount, views.data());
+            if (XR_FAILED(result) || !m_options.compareOutputs) {
+                return result;
+            }
+
+            for (uint32_t i = 0; i < std::min(viewCount, capture::MaxViews); i++) {
+                const telemetry::Fov fov{
+                    views[i].fov.angleLeft, views[i].fov.angleRight, views[i].fov.angleUp, views[i].fov.angleDown};
+                const telemetry::Fov& expected = payload.customizedFov[i];
+                if (!isSameFov(fov, expected)) {
+                    addDifference(index,
+                                  record,
+                                  fmt::format("FOV up/down {}/{} instead of {}/{} for view {}",
+                                              fov.angleUp,
+                                              fov.angleDown,
+                                              expected.angleUp,
+                                              expected.angleDown,
+                                              i));
+                    break;
+                }
+            }
+            return result;
+        }
+
+        XrResult replayEndFrame(const capture::Record& record) {
+            // The composition layers are not captured.
+            const auto& payload = record.as<capture::EndFramePayload>();
+            XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
+            frameEndInfo.displayTime = payload.displayTime;
+            frameEndInfo.environmentBlendMode = (XrEnvironmentBlendMode)payload.environmentBlendMode;
+            return m_layer.xrEndFrame((XrSession)record.handle, &frameEndInfo);
+        }
+
+        XrResult replayCreateSwapchain(size_t index, const capture::Record& record) {
+            const auto& payload = record.as<capture::CreateSwapchainPayload>();
+            XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+            createInfo.createFlags = payload.createFlags;
+            createInfo.usageFlags = payload.usageFlags;
+            createInfo.format = payload.format;
+            createInfo.sampleCount = payload.sampleCount;
+            createInfo.width = payload.width;
+            createInfo.height = payload.height;
+            createInfo.faceCount = payload.faceCount;
+            createInfo.arraySize = payload.arraySize;
+            createInfo.mipCount = payload.mipCount;
+            XrSwapchain swapchain = XR_NULL_HANDLE;
+            const XrResult result = m_layer.xrCreateSwapchain((XrSession)record.handle, &createInfo, &swapchain);
+            if (XR_SUCCEEDED(result) && m_options.compareOutputs && (uint64_t)swapchain != payload.swapchain) {
+                addDifference(index,
+                              record,
+                              fmt::format("created swapchain {} instead of {}",
+                                          (uint64_t)swapchain,
+                                          payload.swapchain));
+            }
+            return result;
+        }
+
+        XrResult replayAcquireSwapchainImage(size_t index, const capture::Record& record) {
+            const auto& payload = record.as<capture::AcquireSwapchainImagePayload>();
+            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+            uint32_t imageIndex = 0;
+            const XrResult result =
+                m_layer.xrAcquireSwapchainImage((XrSwapchain)record.handle, &acquireInfo, &imageIndex);
+            if (XR_SUCCEEDED(result) && m_options.compareOutputs && imageIndex != payload.index) {
+                addDifference(
+                    index, record, fmt::format("acquired image {} instead of {}", imageIndex, payload.index));
+            }
+            return result;
+        }
+
+        XrResult replayWaitSwapchainImage(const capture::Record& record) {
+            const auto& payload = record.as<capture::WaitSwapchainImagePayload>();
+            XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+            waitInfo.timeout = payload.timeout;
+            return m_layer.xrWaitSwapchainImage((XrSwapchain)record.handle, &waitInfo);
+        }
+
+        void addDifference(size_t index, const capture::Record& record, const std::string& difference) {
+            m_report.mismatches++;
+            if (m_report.differences.size() < MaxDifferences) {
+                m_report.differences.push_back(
+                    fmt::format("record {}: {} {}", index, capture::getRecordTypeName(record.type), difference));
+            }
+        }
+
+        const capture::Capture& m_capture;
+        const Options& m_options;
+        LayerInstance& m_layer;
+        Report& m_report;
+    };
+
+    uint64_t percentile(std::vector<uint64_t> values, double p) {
+        if (values.empty()) {
+            return 0;
+        }
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+    }
+
+} // namespace
+
+namespace openxr_api_layer::test::replay {
+
+    Report replay(const capture::Capture& capture, const Options& options) {
+        Report report;
+        Sandbox sandbox(capture.header, options.captureReplay);
+        g_runtime.header = &capture.header;
+        {
+            LayerInstance layer(options.layerPath.empty() ? getDefaultLayerPath() : options.layerPath,
+                                capture.header);
+            Replayer(capture, options, layer, report).run();
+        }
+        g_runtime = {};
+
+        if (options.captureReplay) {
+            for (const auto& entry : std::filesystem::directory_iterator(sandbox.getLayerFolder())) {
+                if (entry.path().extension() != ".capture") {
+                    continue;
+                }
+                std::ifstream file(entry.path(), std::ios::binary);
+                capture::Capture& replayCapture = report.capture.emplace();
+                replayCapture.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                if (!capture::parse(replayCapture)) {
+                    throw std::runtime_error(fmt::format("{} is not a capture file", entry.path().string()));
+                }
+                break;
+            }
+        }
+
+        return report;
+    }
+
+    int replayCommand(int argc, char** argv) {
+        if (argc < 1 || argc > 2) {
+            fprintf(stderr, "Usage: tests replay <capture> [<layer>]\n");
+            return 1;
+        }
+
+        capture::Capture capture;
+        std::ifstream file(argv[0], std::ios::binary);
+        capture.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (!capture::parse(capture)) {
+            fprintf(stderr, "%s is not a supported capture file\n", argv[0]);
+            return 1;
+        }
+
+        Options options;
+        if (argc > 1) {
+            options.layerPath = argv[1];
+        }
+        Report report;
+        try {
+            report = replay(capture, options);
+        } catch (std::exception& exc) {
+            fprintf(stderr, "Replay failed: %s\n", exc.what());
+            return 1;
+        }
+
+        // The capture's cost of the layer against the replay's, for the same inputs from the runtime.
+        std::vector<uint64_t> capturedNs[(size_t)capture::RecordType::Count];
+        for (const capture::Record& record : capture.records) {
+            if ((size_t)record.type < (size_t)capture::RecordType::Count) {
+                capturedNs[(size_t)record.type].push_back(record.durationNs -
+                                                          std::min(record.durationNs, record.runtimeNs));
+            }
+        }
+        printf("%-36s %8s %14s %14s %14s %14s\n",
+               "Layer CPU cost",
+               "Calls",
+               "Capture p50us",
+               "Replay p50us",
+               "Capture p99us",
+               "Replay p99us");
+        for (size_t i = 1; i < (size_t)capture::RecordType::Count; i++) {
+            if (!report.calls[i].count) {
+                continue;
+            }
+            printf("%-36s %8llu %14.2f %14.2f %14.2f %14.2f\n",
+                   capture::getRecordTypeName((capture::RecordType)i),
+                   report.calls[i].count,
+                   percentile(capturedNs[i], 0.5) / 1e3,
+                   percentile(report.calls[i].layerNs, 0.5) / 1e3,
+                   percentile(capturedNs[i], 0.99) / 1e3,
+                   percentile(report.calls[i].layerNs, 0.99) / 1e3);
+        }
+
+        printf("\n%llu calls replayed, %llu differ from the capture", report.replayedCalls, report.mismatches);
+        if (report.skippedComparisons) {
+            printf(" (%llu outputs of upscaling not compared)", report.skippedComparisons);
+        }
+        printf("\n");
+        for (const std::string& difference : report.differences) {
+            printf("  %s\n", difference.c_str());
+        }
+
+        return report.mismatches ? 2 : 0;
+    }
+
+} // namespace openxr_api_layer::test::replay
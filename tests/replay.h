@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+// Replays a capture (see utils/capture.h) into a build of the layer, on top of a stub runtime that returns the
+// runtime's outputs from the capture. The calls are replayed in order from a single thread, and the layer's outputs
+// are compared against the ones in the capture.
+
+#include <utils/capture.h>
+
+namespace openxr_api_layer::test::replay {
+
+    struct CallStatistics {
+        uint64_t count{0};
+
+        // Time spent in the layer's entry point, minus the time spent in the stub runtime.
+        std::vector<uint64_t> layerNs;
+    };
+
+    struct Report {
+        uint64_t replayedCalls{0};
+
+        // Calls whose result or outputs differ from the capture, and the description of the first ones.
+        uint64_t mismatches{0};
+        std::vector<std::string> differences;
+
+        // The stub runtime has no graphics API, so the layer cannot upscale: the image sizes recommended under
+        // upscaling are not compared.
+        uint64_t skippedComparisons{0};
+
+        CallStatistics calls[(size_t)utils::capture::RecordType::Count];
+
+        // The layer's own capture of the replay, when requested.
+        std::optional<utils::capture::Capture> capture;
+    };
+
+    struct Options {
+        // Defaults to the layer built next to the tests.
+        std::filesystem::path layerPath;
+
+        bool compareOutputs{true};
+        bool captureReplay{false};
+    };
+
+    // The layer runs with the settings of the capture, in a registry key and a %LOCALAPPDATA% folder of its own.
+    Report replay(const utils::capture::Capture& capture, const Options& options = {});
+
+    // Usage: tests replay <capture> [<layer>]
+    int replayCommand(int argc, char** argv);
+
+} // namespace openxr_api_layer::test::replay
@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+// A minimal test runner: each TEST_CASE() registers itself, and the runner reports the failed CHECK()s. Each
+// BENCHMARK() registers itself too, but only runs on demand and prints its own measurements.
+
+namespace openxr_api_layer::test {
+
+    using TestFunction = void (*)();
+
+    void registerTest(const char* name, TestFunction function);
+    void registerBenchmark(const char* name, TestFunction function);
+    [[noreturn]] void fail(const char* file, int line, const char* expression);
+
+    struct Registration {
+        Registration(const char* name, TestFunction function) {
+            registerTest(name, function);
+        }
+    };
+
+    struct BenchmarkRegistration {
+        BenchmarkRegistration(const char* name, TestFunction function) {
+            registerBenchmark(name, function);
+        }
+    };
+
+    // The best time of several runs of a function, in seconds.
+    template <typename Function>
+    double measure(Function&& function, uint32_t runs = 5) {
+        double best = std::numeric_limits<double>::max();
+        for (uint32_t i = 0; i < runs; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+} // namespace openxr_api_layer::test
+
+#define TEST_CASE(name)                                                                                                \
+    static void name();                                                                                                \
+    static const openxr_api_layer::test::Registration name##_registration(#name, name);                               \
+    static void name()
+
+#define BENCHMARK(name)                                                                                                \
+    static void name();                                                                                                \
+    static const openxr_api_layer::test::BenchmarkRegistration name##_registration(#name, name);                      \
+    static void name()
+
+#define CHECK(expression)                                                                                              \
+    do {                                                                                                               \
+        if (!(expression)) {                                                                                           \
+            openxr_api_layer::test::fail(__FILE__, __LINE__, #expression);                                             \
+        }                                                                                                              \
+    } while (false)
@@ -0,0 +1,146 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "test.h"
+
+using namespace openxr_api_layer::utils::graphics;
+
+namespace {
+
+    // A command list is an identifier, and whether it is open for recording.
+    struct FakeCommandList {
+        uint32_t id{0};
+        bool isOpen{false};
+    };
+
+    // A queue whose fence only advances when the test completes submissions, or when the ring waits for them.
+    struct FakeQueue : ICommandListQueue<FakeCommandList> {
+        FakeCommandList create() override {
+            m_submittedFenceValues.push_back(0);
+            return {m_created++, true};
+        }
+
+        void reset(FakeCommandList& commandList) override {
+            // The GPU must be done with the command list.
+            CHECK(!commandList.isOpen);
+            CHECK(m_completedFenceValue >= m_submittedFenceValues[commandList.id]);
+            commandList.isOpen = true;
+            m_resets++;
+        }
+
+        void submit(FakeCommandList& commandList, uint64_t fenceValue) override {
+            CHECK(commandList.isOpen);
+            commandList.isOpen = false;
+            m_submittedFenceValues[commandList.id] = fenceValue;
+            m_signaledFenceValues.push_back(fenceValue);
+        }
+
+        uint64_t getCompletedFenceValue() const override {
+            return m_completedFenceValue;
+        }
+
+        void waitForFenceValue(uint64_t fenceValue) override {
+            m_waits.push_back(fenceValue);
+            m_completedFenceValue = std::max(m_completedFenceValue, fenceValue);
+        }
+
+        uint32_t m_created{0};
+        uint32_t m_resets{0};
+        uint64_t m_completedFenceValue{0};
+        std::vector<uint64_t> m_submittedFenceValues;
+        std::vector<uint64_t> m_signaledFenceValues;
+        std::vector<uint64_t> m_waits;
+    };
+
+} // namespace
+
+TEST_CASE(CommandListRing_SignalsIncreasingFenceValues) {
+    FakeQueue queue;
+    {
+        CommandListRing<FakeCommandList> ring(queue, 8);
+        for (uint32_t i = 0; i < 3; i++) {
+            CHECK(ring.submit(ring.acquire()) == i + 1);
+        }
+
+        // Nothing completed: each submission needs its own command list.
+        const CommandListStatistics statistics = ring.getStatistics();
+        CHECK(statistics.submissions == 3);
+        CHECK(statistics.allocations == 3);
+        CHECK(statistics.reuses == 0);
+        CHECK(statistics.stalls == 0);
+    }
+
+    CHECK(queue.m_signaledFenceValues == std::vector<uint64_t>({1, 2, 3}));
+    // The ring waits for the last submission before releasing the command lists.
+    CHECK(queue.m_waits == std::vector<uint64_t>({3}));
+}
+
+TEST_CASE(CommandListRing_ReusesCompletedCommandListsInOrder) {
+    FakeQueue queue;
+    CommandListRing<FakeCommandList> ring(queue, 8);
+
+    ring.submit(ring.acquire());
+    ring.submit(ring.acquire());
+
+    // Only the first submission completed.
+    queue.m_completedFenceValue = 1;
+    const FakeCommandList reused = ring.acquire();
+    CHECK(reused.id == 0);
+    CHECK(reused.isOpen);
+    ring.submit(reused);
+
+    // The second one is still in flight.
+    const FakeCommandList allocated = ring.acquire();
+    CHECK(allocated.id == 2);
+    ring.submit(allocated);
+
+    const CommandListStatistics statistics = ring.getStatistics();
+    CHECK(statistics.submissions == 4);
+    CHECK(statistics.allocations == 3);
+    CHECK(statistics.reuses == 1);
+    CHECK(statistics.stalls == 0);
+    CHECK(queue.m_resets == 1);
+    CHECK(queue.m_waits.empty());
+}
+
+TEST_CASE(CommandListRing_WaitsForTheOldestSubmissionWhenFull) {
+    FakeQueue queue;
+    CommandListRing<FakeCommandList> ring(queue, 2);
+
+    ring.submit(ring.acquire());
+    ring.submit(ring.acquire());
+
+    // Rather than allocating a third command list, wait for the first one.
+    const FakeCommandList commandList = ring.acquire();
+    CHECK(commandList.id == 0);
+    CHECK(queue.m_waits == std::vector<uint64_t>({1}));
+    ring.submit(commandList);
+
+    const CommandListStatistics statistics = ring.getStatistics();
+    CHECK(statistics.allocations == 2);
+    CHECK(statistics.reuses == 1);
+    CHECK(statistics.stalls == 1);
+    CHECK(queue.m_created == 2);
+}
@@ -0,0 +1,137 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "test.h"
+
+using namespace openxr_api_layer::utils::graphics;
+
+TEST_CASE(CompositionWorker_RunsJobsInOrderOnAnotherThread) {
+    const std::shared_ptr<ICompositionWorker> worker = createCompositionWorker(4);
+
+    std::mutex mutex;
+    std::vector<uint32_t> order;
+    std::atomic<bool> ranOnCallerThread{false};
+    const std::thread::id callerThread = std::this_thread::get_id();
+    for (uint32_t i = 0; i < 32; i++) {
+        CHECK(worker->queue([&, i] {
+            if (std::this_thread::get_id() == callerThread) {
+                ranOnCallerThread = true;
+            }
+            std::unique_lock lock(mutex);
+            order.push_back(i);
+            return XR_SUCCESS;
+        }) == XR_SUCCESS);
+    }
+    worker->waitForIdle();
+
+    CHECK(!ranOnCallerThread);
+    CHECK(order.size() == 32);
+    for (uint32_t i = 0; i < order.size(); i++) {
+        CHECK(order[i] == i);
+    }
+}
+
+TEST_CASE(CompositionWorker_QueueReturnsBeforeTheJobCompletes) {
+    const std::shared_ptr<ICompositionWorker> worker = createCompositionWorker(1);
+
+    // The application's next frame overlaps with the composition of the previous one.
+    std::atomic<bool> release{false};
+    std::atomic<bool> completed{false};
+    const auto start = std::chrono::steady_clock::now();
+    worker->queue([&] {
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+        completed = true;
+        return XR_SUCCESS;
+    });
+    const auto latency = std::chrono::steady_clock::now() - start;
+    CHECK(!completed);
+    CHECK(latency < 100ms);
+
+    release = true;
+    worker->waitForIdle();
+    CHECK(completed);
+}
+
+TEST_CASE(CompositionWorker_QueueBlocksWhenFull) {
+    const std::shared_ptr<ICompositionWorker> worker = createCompositionWorker(1);
+
+    std::atomic<bool> release{false};
+    std::atomic<uint32_t> completed{0};
+    const auto blockingJob = [&] {
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+        completed++;
+        return XR_SUCCESS;
+    };
+
+    // One job running and one job waiting: the third one must wait for room in the queue.
+    worker->queue(blockingJob);
+    worker->queue(blockingJob);
+    std::atomic<bool> queued{false};
+    std::thread producer([&] {
+        worker->queue(blockingJob);
+        queued = true;
+    });
+    std::this_thread::sleep_for(50ms);
+    CHECK(!queued);
+
+    release = true;
+    producer.join();
+    CHECK(queued);
+    worker->waitForIdle();
+    CHECK(completed == 3);
+}
+
+TEST_CASE(CompositionWorker_ReportsFailuresWithTheNextJob) {
+    const std::shared_ptr<ICompositionWorker> worker = createCompositionWorker(1);
+
+    CHECK(worker->queue([] { return XR_ERROR_SESSION_LOST; }) == XR_SUCCESS);
+    worker->waitForIdle();
+    CHECK(worker->queue([] { return XR_SUCCESS; }) == XR_ERROR_SESSION_LOST);
+    worker->waitForIdle();
+    CHECK(worker->queue([] { return XR_SUCCESS; }) == XR_SUCCESS);
+
+    CHECK(worker->queue([]() -> XrResult { throw std::runtime_error("Composition failed"); }) == XR_SUCCESS);
+    worker->waitForIdle();
+    CHECK(worker->queue([] { return XR_SUCCESS; }) == XR_ERROR_RUNTIME_FAILURE);
+}
+
+TEST_CASE(CompositionWorker_CompletesQueuedJobsWhenDestroyed) {
+    std::atomic<uint32_t> completed{0};
+    {
+        const std::shared_ptr<ICompositionWorker> worker = createCompositionWorker(8);
+        for (uint32_t i = 0; i < 8; i++) {
+            worker->queue([&] {
+                std::this_thread::sleep_for(1ms);
+                completed++;
+                return XR_SUCCESS;
+            });
+        }
+    }
+    CHECK(completed == 8);
+}
@@ -0,0 +1,212 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "test.h"
+#include <utils/executor.h>
+
+using namespace openxr_api_layer::utils::executor;
+using namespace openxr_api_layer::utils::graphics;
+
+namespace {
+
+    // A fence signaled from the CPU, standing in for a GPU timeline.
+    struct CpuFence : IGraphicsFence {
+        Api getApi() const override {
+            return Api::D3D11;
+        }
+
+        void* getNativeFencePtr() const override {
+            return nullptr;
+        }
+
+        ShareableHandle getFenceHandle() const override {
+            throw std::runtime_error("Fence is not shareable");
+        }
+
+        void signal(uint64_t value) override {
+            std::unique_lock lock(m_mutex);
+            m_value = value;
+            m_signaled.notify_all();
+        }
+
+        void waitOnDevice(uint64_t value) override {
+            throw std::runtime_error("Fence has no device");
+        }
+
+        // Signaling from a worker would pretend that the data is ready.
+        bool waitOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            m_signaledByWaiter = true;
+            signal(value);
+            return true;
+        }
+
+        bool waitForValueOnCpu(uint64_t value, const FenceWaitPolicy& policy = {}) override {
+            // The test thread signals the fence, so it would wait forever.
+            if (std::this_thread::get_id() == m_testThread) {
+                m_waitedByTestThread = true;
+                return false;
+            }
+            std::unique_lock lock(m_mutex);
+            return m_signaled.wait_for(
+                lock, std::chrono::milliseconds(policy.timeoutMs), [&] { return m_value >= value; });
+        }
+
+        bool isShareable() const override {
+            return false;
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_signaled;
+        uint64_t m_value{0};
+        std::atomic<bool> m_signaledByWaiter{false};
+        const std::thread::id m_testThread{std::this_thread::get_id()};
+        std::atomic<bool> m_waitedByTestThread{false};
+    };
+
+    // Some arithmetic that the compiler cannot remove, standing in for a tile of pixels.
+    uint32_t spin(uint32_t iterations, uint32_t seed) {
+        volatile uint32_t state = seed;
+        for (uint32_t i = 0; i < iterations; i++) {
+            state = state * 1664525 + 1013904223;
+        }
+        return state;
+    }
+
+} // namespace
+
+TEST_CASE(Executor_RunsAfterFenceIsSignaled) {
+    const std::shared_ptr<IExecutor> executor = createExecutor(2);
+    const auto fence = std::make_shared<CpuFence>();
+
+    std::atomic<uint32_t> ran{0};
+    const std::shared_ptr<IJob> job = executor->parallelForAfter(fence, 1, 8, [&](uint32_t index) { ran++; });
+
+    // The workers must keep waiting until the producer signals the value.
+    std::this_thread::sleep_for(50ms);
+    CHECK(!job->isComplete());
+    CHECK(ran == 0);
+    CHECK(!fence->m_signaledByWaiter);
+
+    fence->signal(1);
+    job->wait();
+    CHECK(ran == 8);
+    CHECK(!fence->m_signaledByWaiter);
+}
+
+TEST_CASE(Executor_RunsWhenFenceWasAlreadySignaled) {
+    const std::shared_ptr<IExecutor> executor = createExecutor(2);
+    const auto fence = std::make_shared<CpuFence>();
+    fence->signal(2);
+
+    std::atomic<uint32_t> ran{0};
+    executor->parallelForAfter(fence, 1, 8, [&](uint32_t index) { ran++; })->wait();
+    CHECK(ran == 8);
+    CHECK(!fence->m_signaledByWaiter);
+}
+
+TEST_CASE(Executor_WaitDoesNotRunTheGatesOfOtherJobs) {
+    const std::shared_ptr<IExecutor> executor = createExecutor(1);
+    const auto fence = std::make_shared<CpuFence>();
+
+    // Keep the only worker busy, so that the waiting thread runs the pending tasks itself.
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+    const std::shared_ptr<IJob> blocker = executor->parallelFor(1, [&](uint32_t index) {
+        started = true;
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    // The gate of this job is queued before the tasks of the next one.
+    std::atomic<uint32_t> gatedRan{0};
+    const std::shared_ptr<IJob> gated = executor->parallelForAfter(fence, 1, 4, [&](uint32_t index) { gatedRan++; });
+    std::atomic<uint32_t> ran{0};
+    executor->parallelFor(4, [&](uint32_t index) { ran++; })->wait();
+    const bool wasGatedComplete = gated->isComplete();
+
+    // Let the worker go before checking, so that the executor can be destroyed.
+    release = true;
+    CHECK(ran == 4);
+    CHECK(!fence->m_waitedByTestThread);
+    CHECK(!wasGatedComplete);
+
+    fence->signal(1);
+    gated->wait();
+    blocker->wait();
+    CHECK(gatedRan == 4);
+    CHECK(!fence->m_waitedByTestThread);
+}
+
+TEST_CASE(Executor_CompletesManySmallJobs) {
+    // Workers take tasks as soon as they are pushed, while other jobs are still being submitted.
+    const std::shared_ptr<IExecutor> executor = createExecutor(3);
+    std::atomic<uint32_t> ran{0};
+    for (uint32_t i = 0; i < 2000; i++) {
+        executor->parallelFor(3, [&](uint32_t index) { ran++; })->wait();
+    }
+    CHECK(ran == 6000);
+}
+
+BENCHMARK(Executor_Scaling) {
+    // The same work split into tiles, with 1 to N workers (and the waiting thread helping).
+    constexpr uint32_t TileCount = 256;
+    constexpr uint32_t Iterations = 200000;
+    const uint32_t maxWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    double baseline = 0;
+    for (uint32_t workerCount = 1; workerCount <= maxWorkers; workerCount = std::min(workerCount * 2, maxWorkers)) {
+        const std::shared_ptr<IExecutor> executor = createExecutor(workerCount);
+        std::atomic<uint32_t> sink{0};
+        const double seconds = openxr_api_layer::test::measure([&] {
+            executor->parallelFor(TileCount, [&](uint32_t index) { sink += spin(Iterations, index); })->wait();
+        });
+        if (workerCount == 1) {
+            baseline = seconds;
+        }
+        // The waiting thread counts as one more core.
+        printf("  %2u workers: %8.2f ms, %5.2fx speedup, %3.0f%% efficiency\n",
+               workerCount,
+               seconds * 1e3,
+               baseline / seconds,
+               baseline / seconds / ((workerCount + 1) / 2.) * 100);
+        if (workerCount == maxWorkers) {
+            break;
+        }
+    }
+
+    // The overhead of the scheduling itself, with empty tasks.
+    const std::shared_ptr<IExecutor> executor = createExecutor(maxWorkers);
+    constexpr uint32_t JobCount = 1000;
+    const double seconds = openxr_api_layer::test::measure([&] {
+        for (uint32_t i = 0; i < JobCount; i++) {
+            executor->parallelFor(TileCount, [](uint32_t index) {})->wait();
+        }
+    });
+    printf("  %2u workers: %8.2f us per job of %u empty tasks\n", maxWorkers, seconds / JobCount * 1e6, TileCount);
+}
@@ -0,0 +1,306 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "test.h"
+#include <utils/general.h>
+
+using namespace openxr_api_layer::utils::general;
+
+namespace {
+
+    struct SessionState {
+        int frameCount{0};
+    };
+
+    // Same shape as the layer's session table.
+    using SessionTable = std::vector<std::pair<uint64_t, std::shared_ptr<SessionState>>>;
+
+} // namespace
+
+TEST_CASE(SnapshotPublisher_PublishesUpdates) {
+    SnapshotPublisher<int> publisher(1);
+    CHECK(*publisher.load() == 1);
+
+    CHECK(!publisher.update([](int& value) { return false; }));
+    CHECK(*publisher.load() == 1);
+
+    CHECK(publisher.update([](int& value) {
+        value++;
+        return true;
+    }));
+    CHECK(*publisher.load() == 2);
+}
+
+TEST_CASE(SnapshotPublisher_FreesDestroyedSessions) {
+    SnapshotPublisher<SessionTable> sessions;
+
+    std::vector<std::weak_ptr<SessionState>> destroyed;
+    for (uint64_t session = 1; session <= 100; session++) {
+        auto state = std::make_shared<SessionState>();
+        destroyed.push_back(state);
+        sessions.update([&](SessionTable& table) {
+            table.emplace_back(session, std::move(state));
+            return true;
+        });
+        sessions.update([&](SessionTable& table) {
+            table.erase(std::remove_if(table.begin(),
+                                       table.end(),
+                                       [&](const auto& entry) { return entry.first == session; }),
+                        table.end());
+            return true;
+        });
+    }
+
+    CHECK(sessions.load()->empty());
+    for (const auto& state : destroyed) {
+        CHECK(state.expired());
+    }
+}
+
+TEST_CASE(SnapshotPublisher_ReaderKeepsSnapshotAlive) {
+    SnapshotPublisher<SessionTable> sessions;
+    std::weak_ptr<SessionState> destroyed;
+    {
+        auto state = std::make_shared<SessionState>();
+        destroyed = state;
+        sessions.publish({{1, std::move(state)}});
+    }
+
+    SnapshotPublisher<SessionTable>::Snapshot reader = sessions.load();
+    sessions.publish({});
+    CHECK(!destroyed.expired());
+    CHECK(reader->size() == 1);
+    CHECK(sessions.getRetiredCount() == 1);
+
+    // The snapshot is freed by the next writer after its last reader released it.
+    reader.reset();
+    CHECK(!destroyed.expired());
+    sessions.publish({});
+    CHECK(destroyed.expired());
+    CHECK(sessions.getRetiredCount() == 0);
+}
+
+TEST_CASE(SnapshotPublisher_NestedReadersUseSeparateSlots) {
+    SnapshotPublisher<int> publisher(1);
+    const auto outer = publisher.load();
+    publisher.publish(2);
+    {
+        const auto inner = publisher.load();
+        CHECK(*outer == 1);
+        CHECK(*inner == 2);
+        publisher.publish(3);
+        CHECK(publisher.getRetiredCount() == 2);
+    }
+    publisher.publish(4);
+    CHECK(*outer == 1);
+    CHECK(publisher.getRetiredCount() == 1);
+}
+
+TEST_CASE(SnapshotPublisher_LocateViewsDuringSessionChurn) {
+    // A snapshot whose fields are written together, and poisoned when freed.
+    struct FovSettings {
+        FovSettings(uint32_t generation = 0) : generation(generation), fovUp(generation), fovDown(generation * 2) {
+        }
+
+        ~FovSettings() {
+            generation = fovUp = fovDown = 0xdeadbeef;
+        }
+
+        FovSettings(const FovSettings&) = default;
+        FovSettings& operator=(const FovSettings&) = default;
+
+        uint32_t generation;
+        uint32_t fovUp;
+        uint32_t fovDown;
+    };
+
+    SnapshotPublisher<FovSettings> fovSettings;
+    SnapshotPublisher<SessionTable> sessions;
+    constexpr uint64_t SessionCount = 8;
+    constexpr uint32_t Iterations = 20000;
+
+    // Same lookup as the layer's getSessionState(), registering the sessions that are not known yet.
+    const auto getSessionState = [&](uint64_t session) {
+        const auto find = [session](const SessionTable& table) -> std::shared_ptr<SessionState> {
+            for (const auto& entry : table) {
+                if (entry.first == session) {
+                    return entry.second;
+                }
+            }
+            return {};
+        };
+
+        std::shared_ptr<SessionState> state = find(*sessions.load());
+        if (!state) {
+            sessions.update([&](SessionTable& table) {
+                state = find(table);
+                if (state) {
+                    return false;
+                }
+                state = std::make_shared<SessionState>();
+                table.emplace_back(session, state);
+                return true;
+            });
+        }
+        return state;
+    };
+
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> started{0};
+    std::atomic<uint32_t> failures{0};
+    std::vector<std::thread> threads;
+
+    // The application's threads locating views.
+    const uint32_t readerCount = std::max(4u, std::thread::hardware_concurrency());
+    for (uint32_t i = 0; i < readerCount; i++) {
+        threads.emplace_back([&, i] {
+            started++;
+            uint32_t lastGeneration = 0;
+            for (uint64_t frame = 0; !done; frame++) {
+                const std::shared_ptr<SessionState> state = getSessionState(1 + (frame + i) % SessionCount);
+                if (!state) {
+                    failures++;
+                }
+
+                const auto settings = fovSettings.load();
+                if (settings->fovUp != settings->generation || settings->fovDown != settings->generation * 2 ||
+                    settings->generation < lastGeneration) {
+                    failures++;
+                }
+                lastGeneration = settings->generation;
+            }
+        });
+    }
+
+    while (started != readerCount) {
+        std::this_thread::yield();
+    }
+
+    // Sessions being created and destroyed, and the settings being changed.
+    std::vector<std::weak_ptr<SessionState>> destroyed;
+    for (uint32_t i = 1; i <= Iterations; i++) {
+        const uint64_t session = 1 + i % SessionCount;
+        sessions.update([&](SessionTable& table) {
+            const auto it = std::find_if(
+                table.begin(), table.end(), [session](const auto& entry) { return entry.first == session; });
+            if (it == table.end()) {
+                return false;
+            }
+            if (i % 64 == 0) {
+                destroyed.push_back(it->second);
+            }
+            table.erase(it);
+            return true;
+        });
+        fovSettings.publish(FovSettings(i));
+    }
+    done = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(failures == 0);
+    CHECK(fovSettings.load()->generation == Iterations);
+
+    // Once all the readers are gone, every destroyed session is freed by the next writers.
+    sessions.publish({});
+    fovSettings.publish({});
+    CHECK(sessions.getRetiredCount() == 0);
+    CHECK(fovSettings.getRetiredCount() == 0);
+    for (const auto& state : destroyed) {
+        CHECK(state.expired());
+    }
+}
+
+TEST_CASE(TimerPool_ResolvesInFrameOrder) {
+    const std::shared_ptr<ITimerPool> pool = createTimerPool(3);
+
+    // Frames stop out of order, as with several frames in flight.
+    pool->start(10);
+    pool->start(11);
+    pool->start(12);
+    std::this_thread::sleep_for(2ms);
+    pool->stop(12);
+    pool->stop(10);
+    pool->stop(11);
+
+    const std::vector<TimerMeasurement> measurements = pool->resolve();
+    CHECK(measurements.size() == 3);
+    for (uint32_t i = 0; i < measurements.size(); i++) {
+        CHECK(measurements[i].frameId == 10 + i);
+        CHECK(measurements[i].duration >= 2000);
+    }
+}
+
+TEST_CASE(TimerPool_ResolveOnlyReturnsNewMeasurements) {
+    const std::shared_ptr<ITimerPool> pool = createTimerPool(2);
+
+    pool->start(0);
+    pool->stop(0);
+    CHECK(pool->resolve().size() == 1);
+    CHECK(pool->resolve().empty());
+
+    // A started timer is not complete.
+    pool->start(1);
+    CHECK(pool->resolve().empty());
+    pool->stop(1);
+    const std::vector<TimerMeasurement> measurements = pool->resolve();
+    CHECK(measurements.size() == 1);
+    CHECK(measurements[0].frameId == 1);
+}
+
+TEST_CASE(TimerPool_ReusesTimersAfterFrameLatency) {
+    const std::shared_ptr<ITimerPool> pool = createTimerPool(2);
+
+    // Frame 2 uses the timer of frame 0, whose measurement was not collected.
+    pool->start(0);
+    pool->stop(0);
+    pool->start(1);
+    pool->stop(1);
+    pool->start(2);
+    pool->stop(2);
+
+    const std::vector<TimerMeasurement> measurements = pool->resolve();
+    CHECK(measurements.size() == 2);
+    CHECK(measurements[0].frameId == 1);
+    CHECK(measurements[1].frameId == 2);
+}
+
+TEST_CASE(TimerPool_IgnoresStopForAnotherFrame) {
+    const std::shared_ptr<ITimerPool> pool = createTimerPool(2);
+
+    // Frame 1 was never started, and frame 2 took over the timer of frame 0.
+    pool->stop(1);
+    pool->start(0);
+    pool->start(2);
+    pool->stop(0);
+    CHECK(pool->resolve().empty());
+
+    pool->stop(2);
+    pool->stop(2);
+    const std::vector<TimerMeasurement> measurements = pool->resolve();
+    CHECK(measurements.size() == 1);
+    CHECK(measurements[0].frameId == 2);
+}
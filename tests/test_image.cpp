@@ -0,0 +1,677 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "test.h"
+#include <utils/image.h>
+#include <utils/placement.h>
+
+using namespace openxr_api_layer::utils;
+using namespace openxr_api_layer::utils::image;
+
+namespace {
+
+    // The vectorized variants, which must produce the same bits as the scalar code. Variants that the CPU does not
+    // support run the scalar code instead.
+    constexpr InstructionSet VectorizedInstructionSets[] = {InstructionSet::SSE2, InstructionSet::AVX2};
+
+    // Convert a single row of pixels.
+    template <typename Destination, typename Source>
+    std::vector<Destination> convertRow(const std::vector<Source>& source,
+                                        DXGI_FORMAT sourceFormat,
+                                        DXGI_FORMAT destinationFormat,
+                                        InstructionSet instructionSet) {
+        const uint32_t width = (uint32_t)(source.size() * sizeof(Source) / getBytesPerPixel(sourceFormat));
+        const uint32_t destinationRowPitch = width * getBytesPerPixel(destinationFormat);
+        std::vector<Destination> destination(destinationRowPitch / sizeof(Destination));
+        convert(Image{reinterpret_cast<uint8_t*>(const_cast<Source*>(source.data())),
+                      width,
+                      1,
+                      (uint32_t)(source.size() * sizeof(Source)),
+                      sourceFormat},
+                Image{reinterpret_cast<uint8_t*>(destination.data()), width, 1, destinationRowPitch, destinationFormat},
+                nullptr,
+                instructionSet);
+        return destination;
+    }
+
+    float fromBits(uint32_t bits) {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint32_t toBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Linear values with an odd pixel count, so that every variant also runs its remainder loop.
+    std::vector<float> getLinearValues() {
+        std::vector<float> values;
+        for (uint32_t i = 0; i < 4 * 37; i++) {
+            values.push_back(i / (4 * 36.f));
+        }
+        values.insert(values.end(),
+                      {-0.5f,
+                       1.5f,
+                       -0.f,
+                       std::numeric_limits<float>::infinity(),
+                       -std::numeric_limits<float>::infinity(),
+                       std::numeric_limits<float>::quiet_NaN(),
+                       std::numeric_limits<float>::denorm_min(),
+                       0.5f / 255.f});
+        return values;
+    }
+
+    // An image owning its pixels, with padding at the end of the rows to catch pitch mistakes.
+    struct OwnedImage {
+        OwnedImage(uint32_t width, uint32_t height, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM)
+            : rowPitch(width * getBytesPerPixel(format) + 12), pixels((size_t)rowPitch * height, 0xcd),
+              image{pixels.data(), width, height, rowPitch, format} {
+        }
+
+        uint8_t* pixel(uint32_t x, uint32_t y) {
+            return pixels.data() + (size_t)y * rowPitch + (size_t)x * getBytesPerPixel(image.format);
+        }
+
+        uint32_t get(uint32_t x, uint32_t y) {
+            uint32_t value;
+            memcpy(&value, pixel(x, y), sizeof(value));
+            return value;
+        }
+
+        // The channel c of an 8-bit pixel.
+        uint8_t channel(uint32_t x, uint32_t y, uint32_t c) {
+            return pixel(x, y)[c];
+        }
+
+        uint32_t rowPitch;
+        std::vector<uint8_t> pixels;
+        Image image;
+    };
+
+    // A reproducible pattern of smooth gradients and hard edges, in every channel.
+    OwnedImage makePattern(uint32_t width, uint32_t height, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM) {
+        OwnedImage result(width, height, format);
+        uint32_t state = 12345;
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                state = state * 1664525 + 1013904223;
+                uint8_t* const pixel = result.pixel(x, y);
+                pixel[0] = (uint8_t)(x * 255 / std::max(width - 1, 1u));
+                pixel[1] = (uint8_t)(y * 255 / std::max(height - 1, 1u));
+                pixel[2] = ((x / 5 + y / 3) & 1) ? 230 : 20;
+                pixel[3] = (uint8_t)(state >> 24);
+            }
+        }
+        return result;
+    }
+
+    bool sameContent(OwnedImage& a, OwnedImage& b, const XrRect2Di& rect) {
+        for (int32_t y = rect.offset.y; y < rect.offset.y + rect.extent.height; y++) {
+            if (memcmp(a.pixel(rect.offset.x, y), b.pixel(rect.offset.x, y), (size_t)rect.extent.width * 4)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Function>
+    bool throws(Function&& function) {
+        try {
+            function();
+        } catch (std::runtime_error&) {
+            return true;
+        }
+        return false;
+    }
+
+    // The bilinear filter in floating point, without the quantization of the weights.
+    float bilinearReference(OwnedImage& source, const XrExtent2Di& destinationExtent, int32_t x, int32_t y, int c) {
+        const auto position = [](int32_t i, uint32_t sourceExtent, int32_t destinationExtent) {
+            const float ratio = (float)sourceExtent / destinationExtent;
+            return std::clamp((i + 0.5f) * ratio - 0.5f, 0.f, (float)(sourceExtent - 1));
+        };
+        const float px = position(x, source.image.width, destinationExtent.width);
+        const float py = position(y, source.image.height, destinationExtent.height);
+        const uint32_t x0 = (uint32_t)px, y0 = (uint32_t)py;
+        const uint32_t x1 = std::min(x0 + 1, source.image.width - 1), y1 = std::min(y0 + 1, source.image.height - 1);
+        const float fx = px - x0, fy = py - y0;
+        const float top = source.channel(x0, y0, c) * (1 - fx) + source.channel(x1, y0, c) * fx;
+        const float bottom = source.channel(x0, y1, c) * (1 - fx) + source.channel(x1, y1, c) * fx;
+        return top * (1 - fy) + bottom * fy;
+    }
+
+    constexpr graphics::ScalingFilter Filters[] = {graphics::ScalingFilter::Bilinear,
+                                                   graphics::ScalingFilter::Lanczos,
+                                                   graphics::ScalingFilter::EdgeAdaptive};
+
+} // namespace
+
+TEST_CASE(Image_HalfToFloatMatchesScalar) {
+    // Every half value, including the subnormals, the infinities and the NaNs.
+    std::vector<uint16_t> halves(65536);
+    for (uint32_t i = 0; i < halves.size(); i++) {
+        halves[i] = (uint16_t)i;
+    }
+
+    const auto expected = convertRow<uint32_t>(
+        halves, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT, InstructionSet::Scalar);
+    CHECK(fromBits(expected[0x0001]) == ldexpf(1.f, -24));
+    CHECK(fromBits(expected[0x03ff]) == ldexpf(1023.f, -24));
+    CHECK(fromBits(expected[0x8001]) == -ldexpf(1.f, -24));
+    CHECK(fromBits(expected[0x7bff]) == 65504.f);
+    CHECK(fromBits(expected[0x7c00]) == std::numeric_limits<float>::infinity());
+    CHECK(fromBits(expected[0xfc00]) == -std::numeric_limits<float>::infinity());
+    // NaNs are quieted and keep their payload.
+    CHECK(expected[0x7e00] == 0x7fc00000);
+    CHECK(expected[0x7c01] == 0x7fc02000);
+    CHECK(expected[0xfd55] == 0xffeaa000);
+
+    for (const InstructionSet instructionSet : VectorizedInstructionSets) {
+        CHECK(convertRow<uint32_t>(
+                  halves, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT, instructionSet) ==
+              expected);
+    }
+}
+
+TEST_CASE(Image_FloatToHalfMatchesScalar) {
+    std::vector<uint32_t> floats = {
+        toBits(0.f),
+        toBits(-0.f),
+        // Half subnormals, and the values that round to the smallest one or to zero.
+        toBits(ldexpf(1.f, -24)),
+        toBits(ldexpf(1.f, -25)),
+        toBits(ldexpf(1.5f, -25)),
+        toBits(-ldexpf(1023.f, -24)),
+        toBits(ldexpf(1023.5f, -24)),
+        // Float subnormals.
+        toBits(std::numeric_limits<float>::denorm_min()),
+        toBits(-std::numeric_limits<float>::denorm_min()),
+        // Ties to even, the largest half, and overflow.
+        toBits(1.f + ldexpf(1.f, -11)),
+        toBits(1.f + ldexpf(3.f, -11)),
+        toBits(65504.f),
+        toBits(65519.f),
+        toBits(65520.f),
+        toBits(-1e10f),
+        toBits(std::numeric_limits<float>::infinity()),
+        toBits(-std::numeric_limits<float>::infinity()),
+        // Quiet and signaling NaNs, with payloads.
+        0x7fc00000,
+        0xffc00000,
+        0x7f800001,
+        0x7fa00000,
+        0xff812345,
+        0x7fffffff,
+    };
+    // Every exponent, with a few mantissas around the rounding boundaries.
+    for (uint32_t exponent = 0; exponent < 256; exponent++) {
+        for (const uint32_t mantissa : {0x000000u, 0x000fffu, 0x001000u, 0x001001u, 0x002fffu, 0x7fe000u, 0x7fffffu}) {
+            floats.push_back((exponent << 23) | mantissa);
+            floats.push_back(0x80000000 | (exponent << 23) | mantissa);
+        }
+    }
+    floats.resize((floats.size() + 3) / 4 * 4 + 4, toBits(1.f));
+
+    const auto expected = convertRow<uint16_t>(
+        floats, DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, InstructionSet::Scalar);
+    CHECK(expected[2] == 0x0001);
+    CHECK(expected[3] == 0x0000);
+    CHECK(expected[4] == 0x0001);
+    CHECK(expected[6] == 0x0400);
+    CHECK(expected[7] == 0x0000);
+    CHECK(expected[8] == 0x8000);
+    CHECK(expected[9] == 0x3c00);
+    CHECK(expected[10] == 0x3c02);
+    CHECK(expected[11] == 0x7bff);
+    CHECK(expected[12] == 0x7bff);
+    CHECK(expected[13] == 0x7c00);
+    CHECK(expected[14] == 0xfc00);
+    CHECK(expected[16] == 0xfc00);
+    // NaNs stay NaNs, quieted, and keep the top of their payload.
+    CHECK(expected[17] == 0x7e00);
+    CHECK(expected[18] == 0xfe00);
+    CHECK(expected[19] == 0x7e00);
+    CHECK(expected[20] == 0x7f00);
+    CHECK(expected[21] == 0xfe09);
+    CHECK(expected[22] == 0x7fff);
+
+    for (const InstructionSet instructionSet : VectorizedInstructionSets) {
+        CHECK(convertRow<uint16_t>(
+                  floats, DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, instructionSet) ==
+              expected);
+    }
+}
+
+TEST_CASE(Image_FloatToUnormMatchesScalar) {
+    const std::vector<float> linear = getLinearValues();
+
+    for (const DXGI_FORMAT format : {DXGI_FORMAT_R8G8B8A8_UNORM,
+                                     DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+                                     DXGI_FORMAT_B8G8R8A8_UNORM,
+                                     DXGI_FORMAT_B8G8R8A8_UNORM_SRGB}) {
+        const auto expected =
+            convertRow<uint8_t>(linear, DXGI_FORMAT_R32G32B32A32_FLOAT, format, InstructionSet::Scalar);
+        // Out of range values are clamped and NaN becomes 0, in both transfer functions.
+        const size_t special = 4 * 37;
+        const bool isBGRA = format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+        CHECK(expected[special + (isBGRA ? 2 : 0)] == 0);
+        CHECK(expected[special + 1] == 255);
+        CHECK(expected[special + (isBGRA ? 0 : 2)] == 0);
+        CHECK(expected[special + 3] == 255);
+        CHECK(expected[special + 4 + (isBGRA ? 2 : 0)] == 0);
+        CHECK(expected[special + 4 + 1] == 0);
+
+        for (const InstructionSet instructionSet : VectorizedInstructionSets) {
+            CHECK(convertRow<uint8_t>(linear, DXGI_FORMAT_R32G32B32A32_FLOAT, format, instructionSet) == expected);
+        }
+    }
+}
+
+TEST_CASE(Image_UnormToFloatMatchesScalar) {
+    std::vector<uint8_t> pixels(4 * 67);
+    for (uint32_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = (uint8_t)(i * 7);
+    }
+
+    for (const DXGI_FORMAT format : {DXGI_FORMAT_R8G8B8A8_UNORM,
+                                     DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+                                     DXGI_FORMAT_B8G8R8A8_UNORM,
+                                     DXGI_FORMAT_B8G8R8X8_UNORM_SRGB}) {
+        const auto expected =
+            convertRow<uint32_t>(pixels, format, DXGI_FORMAT_R32G32B32A32_FLOAT, InstructionSet::Scalar);
+        CHECK(fromBits(expected[3]) == (format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB ? 1.f : 21 * (1.f / 255.f)));
+
+        for (const InstructionSet instructionSet : VectorizedInstructionSets) {
+            CHECK(convertRow<uint32_t>(pixels, format, DXGI_FORMAT_R32G32B32A32_FLOAT, instructionSet) == expected);
+        }
+    }
+
+    // Only the channel order differs, so the pixels are swizzled without decoding.
+    const auto swizzled =
+        convertRow<uint8_t>(pixels, DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, InstructionSet::Scalar);
+    CHECK(swizzled[0] == pixels[2] && swizzled[1] == pixels[1] && swizzled[2] == pixels[0] &&
+          swizzled[3] == pixels[3]);
+    for (const InstructionSet instructionSet : VectorizedInstructionSets) {
+        CHECK(convertRow<uint8_t>(pixels, DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, instructionSet) ==
+              swizzled);
+    }
+}
+
+TEST_CASE(Image_BlitCopiesAndCropsExactly) {
+    OwnedImage source = makePattern(37, 23);
+    OwnedImage destination(41, 29);
+
+    // Crop a sub-rectangle to an offset in the destination, leaving the rest untouched.
+    const XrRect2Di crop{{3, 5}, {30, 17}};
+    blit(source.image, crop, destination.image, {7, 2});
+    for (uint32_t y = 0; y < destination.image.height; y++) {
+        for (uint32_t x = 0; x < destination.image.width; x++) {
+            const bool isInside = x >= 7 && x < 37 && y >= 2 && y < 19;
+            CHECK(destination.get(x, y) == (isInside ? source.get(x - 7 + 3, y - 2 + 5) : 0xcdcdcdcd));
+        }
+    }
+
+    // The same with an executor.
+    const std::shared_ptr<executor::IExecutor> executor = executor::createExecutor(3);
+    OwnedImage parallelDestination(41, 29);
+    blit(source.image, crop, parallelDestination.image, {7, 2}, executor.get());
+    CHECK(parallelDestination.pixels == destination.pixels);
+
+    CHECK(throws([&] { blit(source.image, {{10, 0}, {30, 1}}, destination.image, {0, 0}); }));
+    CHECK(throws([&] { blit(source.image, {{0, 0}, {30, 1}}, destination.image, {12, 0}); }));
+    CHECK(throws([&] { blit(source.image, {{-1, 0}, {3, 1}}, destination.image, {0, 0}); }));
+    OwnedImage wideDestination(41, 29, DXGI_FORMAT_R16G16B16A16_FLOAT);
+    CHECK(throws([&] { blit(source.image, crop, wideDestination.image, {0, 0}); }));
+}
+
+TEST_CASE(Image_FillEncodesTheColor) {
+    const XrColor4f color{0.5f, 0.f, 1.f, 1.f};
+    const XrRect2Di rect{{2, 1}, {35, 3}};
+
+    // The fill of an odd width runs the remainder loops.
+    for (const DXGI_FORMAT format : {DXGI_FORMAT_R8G8B8A8_UNORM,
+                                     DXGI_FORMAT_B8G8R8A8_UNORM,
+                                     DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+                                     DXGI_FORMAT_R16G16B16A16_FLOAT}) {
+        OwnedImage expected(40, 5, format);
+        fill(expected.image, rect, color, nullptr, InstructionSet::Scalar);
+        for (const InstructionSet instructionSet : VectorizedInstructionSets) {
+            OwnedImage actual(40, 5, format);
+            fill(actual.image, rect, color, nullptr, instructionSet);
+            CHECK(actual.pixels == expected.pixels);
+        }
+        CHECK(expected.channel(0, 0, 0) == 0xcd);
+        CHECK(expected.channel(1, 1, 0) == 0xcd);
+        CHECK(expected.channel(37, 1, 0) == 0xcd);
+        CHECK(expected.channel(2, 4, 0) == 0xcd);
+        if (format == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+            CHECK(memcmp(expected.pixel(36, 3), "\x00\x38\x00\x00\x00\x3c\x00\x3c", 8) == 0);
+            continue;
+        }
+
+        const bool isBGRA = format == DXGI_FORMAT_B8G8R8A8_UNORM;
+        const uint8_t red = format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ? 188 : 128;
+        CHECK(expected.channel(36, 3, isBGRA ? 2 : 0) == red);
+        CHECK(expected.channel(36, 3, 1) == 0);
+        CHECK(expected.channel(36, 3, isBGRA ? 0 : 2) == 255);
+        CHECK(expected.channel(36, 3, 3) == 255);
+    }
+
+    OwnedImage image(40, 5);
+    CHECK(throws([&] { fill(image.image, {{0, 0}, {41, 1}}, color); }));
+}
+
+TEST_CASE(Image_PadEdgesReplicatesTheOutermostPixels) {
+    const XrRect2Di content{{5, 3}, {11, 4}};
+    OwnedImage expected = makePattern(23, 9);
+    padEdges(expected.image, content, InstructionSet::Scalar);
+
+    for (uint32_t y = 0; y < 9; y++) {
+        const uint32_t clampedY = std::clamp(y, 3u, 6u);
+        for (uint32_t x = 0; x < 23; x++) {
+            OwnedImage original = makePattern(23, 9);
+            CHECK(expected.get(x, y) == original.get(std::clamp(x, 5u, 15u), clampedY));
+        }
+    }
+
+    for (const InstructionSet instructionSet : VectorizedInstructionSets) {
+        OwnedImage actual = makePattern(23, 9);
+        padEdges(actual.image, content, instructionSet);
+        CHECK(actual.pixels == expected.pixels);
+    }
+}
+
+TEST_CASE(Image_BilinearScaleMatchesScalar) {
+    OwnedImage source = makePattern(61, 47);
+    const XrRect2Di sourceRect{{4, 3}, {50, 40}};
+
+    // Upscaling and downscaling, into an offset rectangle.
+    for (const XrExtent2Di extent : {XrExtent2Di{87, 71}, XrExtent2Di{29, 17}, XrExtent2Di{50, 40}}) {
+        const XrRect2Di destinationRect{{2, 1}, extent};
+        OwnedImage expected(extent.width + 5, extent.height + 3);
+        scale(source.image,
+              sourceRect,
+              expected.image,
+              destinationRect,
+              graphics::ScalingFilter::Bilinear,
+              nullptr,
+              InstructionSet::Scalar);
+        for (const InstructionSet instructionSet : VectorizedInstructionSets) {
+            OwnedImage actual(extent.width + 5, extent.height + 3);
+            scale(source.image,
+                  sourceRect,
+                  actual.image,
+                  destinationRect,
+                  graphics::ScalingFilter::Bilinear,
+                  nullptr,
+                  instructionSet);
+            CHECK(actual.pixels == expected.pixels);
+        }
+        CHECK(expected.get(0, 0) == 0xcdcdcdcd);
+        CHECK(expected.get(extent.width + 2, extent.height + 1) == 0xcdcdcdcd);
+    }
+}
+
+TEST_CASE(Image_BilinearScaleIsCloseToTheExactFilter) {
+    OwnedImage source = makePattern(50, 40);
+    for (const XrExtent2Di extent : {XrExtent2Di{87, 71}, XrExtent2Di{29, 17}}) {
+        OwnedImage destination(extent.width, extent.height);
+        scale(source.image, {{0, 0}, {50, 40}}, destination.image, {{0, 0}, extent});
+        for (int32_t y = 0; y < extent.height; y++) {
+            for (int32_t x = 0; x < extent.width; x++) {
+                for (int c = 0; c < 4; c++) {
+                    // The 7-bit weights are within 1/256 of the exact ones, on both axes.
+                    CHECK(std::abs(destination.channel(x, y, c) - bilinearReference(source, extent, x, y, c)) <= 2.f);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(Image_ScaleFiltersPreserveIdentityAndConstants) {
+    OwnedImage source = makePattern(33, 21);
+    OwnedImage constant(33, 21);
+    fill(constant.image, {{0, 0}, {33, 21}}, {0.25f, 0.5f, 0.75f, 1.f});
+
+    for (const graphics::ScalingFilter filter : Filters) {
+        // At the same size, the samples fall on the texel centers.
+        if (filter != graphics::ScalingFilter::EdgeAdaptive) {
+            OwnedImage copy(33, 21);
+            scale(source.image, {{0, 0}, {33, 21}}, copy.image, {{0, 0}, {33, 21}}, filter);
+            CHECK(sameContent(copy, source, {{0, 0}, {33, 21}}));
+        }
+
+        for (const XrExtent2Di extent : {XrExtent2Di{71, 45}, XrExtent2Di{13, 8}}) {
+            OwnedImage scaled(extent.width, extent.height);
+            scale(constant.image, {{0, 0}, {33, 21}}, scaled.image, {{0, 0}, extent}, filter);
+            for (int32_t y = 0; y < extent.height; y++) {
+                for (int32_t x = 0; x < extent.width; x++) {
+                    CHECK(scaled.get(x, y) == constant.get(0, 0));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(Image_ScaleFiltersDoNotRing) {
+    // A hard vertical edge, upscaled: every output stays within the values of the texels around its sample.
+    OwnedImage source(16, 8);
+    fill(source.image, {{0, 0}, {8, 8}}, {0.1f, 0.1f, 0.1f, 1.f});
+    fill(source.image, {{8, 0}, {8, 8}}, {0.9f, 0.9f, 0.9f, 1.f});
+    const uint8_t low = source.channel(0, 0, 0);
+    const uint8_t high = source.channel(15, 0, 0);
+
+    for (const graphics::ScalingFilter filter : Filters) {
+        OwnedImage scaled(53, 19);
+        scale(source.image, {{0, 0}, {16, 8}}, scaled.image, {{0, 0}, {53, 19}}, filter);
+        for (int32_t y = 0; y < 19; y++) {
+            uint8_t previous = low;
+            for (int32_t x = 0; x < 53; x++) {
+                const uint8_t value = scaled.channel(x, y, 0);
+                CHECK(value >= low && value <= high);
+                // Monotonic across the edge.
+                CHECK(value >= previous);
+                previous = value;
+            }
+            CHECK(scaled.channel(0, y, 0) == low);
+            CHECK(scaled.channel(52, y, 0) == high);
+        }
+    }
+}
+
+TEST_CASE(Image_ScaleFiltersClampToTheSourceRectangle) {
+    // Views are packed side by side: the neighbor view must not bleed into the scaled one.
+    OwnedImage source(40, 10);
+    fill(source.image, {{0, 0}, {20, 10}}, {1.f, 0.f, 0.f, 1.f});
+    fill(source.image, {{20, 0}, {20, 10}}, {0.f, 1.f, 0.f, 1.f});
+
+    for (const graphics::ScalingFilter filter : Filters) {
+        OwnedImage scaled(50, 25);
+        scale(source.image, {{20, 0}, {20, 10}}, scaled.image, {{0, 0}, {50, 25}}, filter);
+        for (int32_t y = 0; y < 25; y++) {
+            for (int32_t x = 0; x < 50; x++) {
+                CHECK(scaled.get(x, y) == source.get(39, 0));
+            }
+        }
+    }
+}
+
+TEST_CASE(Image_ScaleHandlesBGRAAndExecutors) {
+    OwnedImage rgba = makePattern(30, 20);
+    OwnedImage bgra(30, 20, DXGI_FORMAT_B8G8R8A8_UNORM);
+    convert(rgba.image, bgra.image);
+    const std::shared_ptr<executor::IExecutor> executor = executor::createExecutor(3);
+
+    for (const graphics::ScalingFilter filter : Filters) {
+        OwnedImage expected(45, 50);
+        scale(rgba.image, {{0, 0}, {30, 20}}, expected.image, {{0, 0}, {45, 50}}, filter);
+
+        OwnedImage parallel(45, 50);
+        scale(rgba.image, {{0, 0}, {30, 20}}, parallel.image, {{0, 0}, {45, 50}}, filter, executor.get());
+        CHECK(parallel.pixels == expected.pixels);
+
+        // The filters weigh the channels by luma, so they must see the same colors in both orders.
+        OwnedImage scaledBGRA(45, 50, DXGI_FORMAT_B8G8R8A8_UNORM);
+        scale(bgra.image, {{0, 0}, {30, 20}}, scaledBGRA.image, {{0, 0}, {45, 50}}, filter);
+        OwnedImage swizzled(45, 50);
+        convert(scaledBGRA.image, swizzled.image);
+        CHECK(sameContent(swizzled, expected, {{0, 0}, {45, 50}}));
+    }
+
+    OwnedImage wide(30, 20, DXGI_FORMAT_R16G16B16A16_FLOAT);
+    CHECK(throws([&] { scale(rgba.image, {{0, 0}, {30, 20}}, wide.image, {{0, 0}, {30, 20}}); }));
+    CHECK(throws([&] { scale(rgba.image, {{0, 0}, {30, 20}}, bgra.image, {{0, 0}, {30, 20}}); }));
+}
+
+TEST_CASE(Image_PadsAViewLikeTheLayer) {
+    // An upscaled view with its FOV extended upwards and downwards, edge-clamped like the layer does it with
+    // scaleTextureRegion(): the borders are the first and last rows of the source, stretched.
+    const XrFovf fov{-0.8f, 0.8f, 0.6f, -0.7f};
+    const XrFovf nativeFov = placement::getNativeFov(fov, 0.8f, 0.9f);
+    const float upscalingFactor = 0.75f;
+    const XrRect2Di sourceRect{{0, 0}, {48, 40}};
+    OwnedImage source = makePattern(48, 40);
+
+    const float ratio = placement::getPaddingRatio(fov, nativeFov);
+    const XrExtent2Di size = placement::getSubmittedSize(sourceRect.extent, upscalingFactor, ratio);
+    const int32_t upscaledHeight = (int32_t)std::lround(sourceRect.extent.height / upscalingFactor);
+    auto [topPadding, bottomPadding] = placement::getPadding(fov, nativeFov, upscaledHeight);
+    const XrRect2Di rect = placement::getUpscaledRect(sourceRect, upscalingFactor, ratio, size, topPadding);
+    topPadding = std::min(topPadding, rect.offset.y);
+    bottomPadding = std::min(bottomPadding, size.height - (rect.offset.y + rect.extent.height));
+    CHECK(topPadding > 0 && bottomPadding > 0);
+    CHECK(rect.extent.width == 64 && rect.extent.height == upscaledHeight);
+
+    OwnedImage layer(size.width, size.height);
+    scale(source.image, sourceRect, layer.image, rect);
+    scale(source.image,
+          {sourceRect.offset, {sourceRect.extent.width, 1}},
+          layer.image,
+          {{rect.offset.x, rect.offset.y - topPadding}, {rect.extent.width, topPadding}});
+    scale(source.image,
+          {{sourceRect.offset.x, sourceRect.extent.height - 1}, {sourceRect.extent.width, 1}},
+          layer.image,
+          {{rect.offset.x, rect.offset.y + rect.extent.height}, {rect.extent.width, bottomPadding}});
+
+    // When upscaling, the outermost rows of the view are the outermost rows of the source, so padding the edges of
+    // the view gives the same borders.
+    OwnedImage padded(size.width, size.height);
+    scale(source.image, sourceRect, padded.image, rect);
+    const XrRect2Di paddedRect{{rect.offset.x, rect.offset.y - topPadding},
+                               {rect.extent.width, topPadding + rect.extent.height + bottomPadding}};
+    Image view = padded.image;
+    view.data = padded.pixel(paddedRect.offset.x, paddedRect.offset.y);
+    view.width = paddedRect.extent.width;
+    view.height = paddedRect.extent.height;
+    padEdges(view, {{0, topPadding}, rect.extent});
+    CHECK(sameContent(layer, padded, paddedRect));
+
+    // Anything below the padded view is untouched.
+    for (int32_t y = paddedRect.offset.y + paddedRect.extent.height; y < size.height; y++) {
+        CHECK(layer.get(0, y) == 0xcdcdcdcd);
+    }
+
+    // The black borders are a fill of the same rectangles.
+    fill(padded.image, {{rect.offset.x, rect.offset.y - topPadding}, {rect.extent.width, topPadding}}, {0, 0, 0, 1});
+    CHECK(padded.get(0, paddedRect.offset.y) == 0xff000000);
+    CHECK(padded.get(rect.extent.width - 1, rect.offset.y - 1) == 0xff000000);
+    CHECK(padded.get(0, rect.offset.y) == layer.get(0, rect.offset.y));
+}
+
+BENCHMARK(Image_Throughput) {
+    using openxr_api_layer::test::measure;
+
+    // A typical eye buffer, larger than the caches.
+    constexpr uint32_t Width = 2048;
+    constexpr uint32_t Height = 2048;
+    OwnedImage source = makePattern(Width, Height);
+    OwnedImage destination(Width, Height);
+    OwnedImage wide(Width, Height, DXGI_FORMAT_R16G16B16A16_FLOAT);
+    const XrRect2Di full{{0, 0}, {Width, Height}};
+    const double bytes = (double)Width * Height * 4;
+    const std::shared_ptr<executor::IExecutor> executor = executor::createExecutor();
+
+    // The throughput counts the bytes written to the destination.
+    const auto report = [](const char* name, double bytes, double seconds) {
+        printf("  %-40s %8.2f GB/s\n", name, bytes / seconds * 1e-9);
+    };
+
+    const char* const names[] = {"Scalar", "SSE2", "AVX2"};
+    for (const InstructionSet instructionSet : {InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2}) {
+        if (instructionSet > getInstructionSet()) {
+            continue;
+        }
+        const std::string suffix = fmt::format(" ({})", names[(int)instructionSet]);
+        report(("fill" + suffix).c_str(), bytes, measure([&] {
+                   fill(destination.image, full, {0.f, 0.f, 0.f, 1.f}, nullptr, instructionSet);
+               }));
+        report(("padEdges 1/2 height" + suffix).c_str(), bytes / 2, measure([&] {
+                   padEdges(destination.image, {{0, Height / 4}, {Width, Height / 2}}, instructionSet);
+               }));
+        report(("scale bilinear 0.75x" + suffix).c_str(), bytes, measure([&] {
+                   scale(source.image,
+                         {{0, 0}, {Width * 3 / 4, Height * 3 / 4}},
+                         destination.image,
+                         full,
+                         graphics::ScalingFilter::Bilinear,
+                         nullptr,
+                         instructionSet);
+               }));
+        report(("convert RGBA8 to RGBA16F" + suffix).c_str(), bytes * 2, measure([&] {
+                   convert(source.image, wide.image, nullptr, instructionSet);
+               }));
+    }
+
+    report("blit", bytes, measure([&] { blit(source.image, full, destination.image, {0, 0}); }));
+    report("blit (executor)", bytes, measure([&] {
+               blit(source.image, full, destination.image, {0, 0}, executor.get());
+           }));
+    report("scale bilinear 0.75x (executor)", bytes, measure([&] {
+               scale(source.image,
+                     {{0, 0}, {Width * 3 / 4, Height * 3 / 4}},
+                     destination.image,
+                     full,
+                     graphics::ScalingFilter::Bilinear,
+                     executor.get());
+           }));
+    // The references are far slower: a single run is enough.
+    report("scale Lanczos 0.75x (reference)", bytes, measure([&] {
+               scale(source.image,
+                     {{0, 0}, {Width * 3 / 4, Height * 3 / 4}},
+                     destination.image,
+                     full,
+                     graphics::ScalingFilter::Lanczos);
+           }, 1));
+    report("scale edge-adaptive 0.75x (reference)", bytes, measure([&] {
+               scale(source.image,
+                     {{0, 0}, {Width * 3 / 4, Height * 3 / 4}},
+                     destination.image,
+                     full,
+                     graphics::ScalingFilter::EdgeAdaptive);
+           }, 1));
+}
@@ -0,0 +1,205 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "test.h"
+#include <utils/placement.h>
+
+using namespace openxr_api_layer::utils::placement;
+
+namespace {
+
+    XrFovf makeFov(float tanUp, float tanDown) {
+        return {-0.8f, 0.8f, atan(tanUp), atan(tanDown)};
+    }
+
+    // The placement of one view at the top of its swapchain, clipped like the layer does.
+    struct Placement {
+        XrExtent2Di size;
+        XrRect2Di rect;
+        int32_t topPadding;
+        int32_t bottomPadding;
+        XrFovf paddedFov;
+    };
+
+    Placement place(const XrFovf& fov, const XrFovf& nativeFov, int32_t width, int32_t height, float upscalingFactor) {
+        Placement placement{};
+        placement.size = getSubmittedSize({width, height}, upscalingFactor, getPaddingRatio(fov, nativeFov));
+        const int32_t upscaledHeight = (int32_t)std::lround(height / upscalingFactor);
+        std::tie(placement.topPadding, placement.bottomPadding) = getPadding(fov, nativeFov, upscaledHeight);
+        placement.rect = getUpscaledRect({{0, 0}, {width, height}},
+                                         upscalingFactor,
+                                         getPaddingRatio(fov, nativeFov),
+                                         placement.size,
+                                         placement.topPadding);
+        placement.topPadding = std::min(placement.topPadding, placement.rect.offset.y);
+        placement.bottomPadding =
+            std::min(placement.bottomPadding,
+                     placement.size.height - (placement.rect.offset.y + placement.rect.extent.height));
+        placement.paddedFov =
+            getPaddedFov(fov, placement.rect.extent.height, placement.topPadding, placement.bottomPadding);
+        return placement;
+    }
+
+} // namespace
+
+TEST_CASE(Placement_NativeFovUndoesTheSettings) {
+    const XrFovf fov{-0.9f, 0.8f, 0.56f, -0.63f};
+    const XrFovf nativeFov = getNativeFov(fov, 0.8f, 0.9f);
+    CHECK(nativeFov.angleLeft == fov.angleLeft);
+    CHECK(nativeFov.angleRight == fov.angleRight);
+    CHECK(std::abs(nativeFov.angleUp - 0.7f) < 1e-6f);
+    CHECK(std::abs(nativeFov.angleDown + 0.7f) < 1e-6f);
+
+    // Unset settings leave the angles alone, and the angles stay away from the singularity of the tangent.
+    CHECK(getNativeFov(fov, 0.f, 0.f).angleUp == fov.angleUp);
+    CHECK(getNativeFov(fov, 0.1f, 0.1f).angleUp == MaxAngle);
+    CHECK(getNativeFov(fov, 0.1f, 0.1f).angleDown == -MaxAngle);
+}
+
+TEST_CASE(Placement_PadsBothSidesToTheNativeFov) {
+    // The tangents span 1 for the cropped FOV, and 2 for the native one.
+    const XrFovf fov = makeFov(0.5f, -0.5f);
+    const XrFovf nativeFov = makeFov(1.f, -1.f);
+    CHECK(std::abs(getPaddingRatio(fov, nativeFov) - 2.f) < 1e-6f);
+
+    const Placement placement = place(fov, nativeFov, 1000, 1000, 1.f);
+    CHECK(placement.size.width == 1000);
+    CHECK(placement.size.height == 2000);
+    CHECK(placement.topPadding == 500);
+    CHECK(placement.bottomPadding == 500);
+    CHECK(placement.rect.offset.x == 0);
+    CHECK(placement.rect.offset.y == 500);
+    CHECK(placement.rect.extent.width == 1000);
+    CHECK(placement.rect.extent.height == 1000);
+}
+
+TEST_CASE(Placement_RoundsTheBordersToTheNearestPixel) {
+    // Only the top is cropped: 1003 * 0.25 = 250.75 pixels of border.
+    const XrFovf fov = makeFov(0.5f, -0.5f);
+    const XrFovf nativeFov = makeFov(0.75f, -0.5f);
+    CHECK(getPadding(fov, nativeFov, 1003) == std::make_pair(251, 0));
+    // 1003 * 0.2 = 200.6, and 1003 * 0.2 = 200.6 on the other side.
+    CHECK(getPadding(fov, makeFov(0.7f, -0.7f), 1003) == std::make_pair(201, 201));
+    // 1001 * 0.1 = 100.1 pixels.
+    CHECK(getPadding(fov, makeFov(0.6f, -0.5f), 1001) == std::make_pair(100, 0));
+
+    // The height of the swapchain is rounded up: 1003 * 1.25 = 1253.75 pixels.
+    const Placement placement = place(fov, nativeFov, 1003, 1003, 1.f);
+    CHECK(placement.size.height == 1254);
+    CHECK(placement.rect.offset.y == 251);
+    CHECK(placement.rect.extent.height == 1003);
+    CHECK(placement.bottomPadding == 0);
+
+    // A FOV wider than the native one is never padded.
+    CHECK(getPadding(nativeFov, fov, 1003) == std::make_pair(0, 0));
+    CHECK(getPaddingRatio(nativeFov, fov) == 1.f);
+}
+
+TEST_CASE(Placement_IgnoresDegenerateFovs) {
+    const XrFovf fov = makeFov(0.5f, 0.5f);
+    const XrFovf nativeFov = makeFov(1.f, -1.f);
+    CHECK(getPaddingRatio(fov, nativeFov) == 1.f);
+    CHECK(getPadding(fov, nativeFov, 1000) == std::make_pair(0, 0));
+    const XrFovf paddedFov = getPaddedFov(fov, 1000, 10, 10);
+    CHECK(paddedFov.angleUp == fov.angleUp);
+    CHECK(paddedFov.angleDown == fov.angleDown);
+    CHECK(getPaddedFov(makeFov(0.5f, -0.5f), 0, 10, 10).angleUp == atan(0.5f));
+}
+
+TEST_CASE(Placement_UpscaledViewsTileWithoutGapsOrOverlaps) {
+    // Two views side by side, split at an odd column: 749 / 0.75 = 998.67 and 1500 / 0.75 = 2000.
+    constexpr float UpscalingFactor = 0.75f;
+    const XrExtent2Di size = getSubmittedSize({1500, 900}, UpscalingFactor, 1.f);
+    CHECK(size.width == 2000);
+    CHECK(size.height == 1200);
+
+    const XrRect2Di left = getUpscaledRect({{0, 0}, {749, 900}}, UpscalingFactor, 1.f, size, 0);
+    const XrRect2Di right = getUpscaledRect({{749, 0}, {751, 900}}, UpscalingFactor, 1.f, size, 0);
+    CHECK(left.offset.x == 0);
+    CHECK(left.extent.width == 999);
+    CHECK(right.offset.x == 999);
+    CHECK(right.extent.width == 1001);
+    CHECK(left.extent.height == 1200);
+    CHECK(right.extent.height == 1200);
+
+    // Any split of the columns tiles the submitted swapchain.
+    for (int32_t split = 1; split < 1500; split++) {
+        const XrRect2Di a = getUpscaledRect({{0, 0}, {split, 900}}, UpscalingFactor, 1.f, size, 0);
+        const XrRect2Di b = getUpscaledRect({{split, 0}, {1500 - split, 900}}, UpscalingFactor, 1.f, size, 0);
+        CHECK(a.offset.x + a.extent.width == b.offset.x);
+        CHECK(b.offset.x + b.extent.width == size.width);
+    }
+}
+
+TEST_CASE(Placement_StretchesTheVerticalLayoutAndClipsToTheSwapchain) {
+    // Two views stacked vertically in a swapchain padded by 1.25.
+    const XrExtent2Di size = getSubmittedSize({1000, 2000}, 1.f, 1.25f);
+    CHECK(size.height == 2500);
+    const XrRect2Di bottom = getUpscaledRect({{0, 1000}, {1000, 1000}}, 1.f, 1.25f, size, 125);
+    CHECK(bottom.offset.y == 1375);
+    CHECK(bottom.extent.height == 1000);
+
+    // A view that does not fit is clipped rather than written out of bounds.
+    const XrRect2Di outside = getUpscaledRect({{900, 1800}, {200, 200}}, 1.f, 1.25f, size, 125);
+    CHECK(outside.offset.x == 900);
+    CHECK(outside.extent.width == 100);
+    CHECK(outside.offset.y == 2375);
+    CHECK(outside.extent.height == 125);
+}
+
+TEST_CASE(Placement_PaddedFovRoundTripsToTheNativeFov) {
+    for (float fovUp = 0.5f; fovUp <= 1.f; fovUp += 0.05f) {
+        for (float fovDown = 0.6f; fovDown <= 1.f; fovDown += 0.1f) {
+            for (int32_t height = 501; height <= 2500; height += 37) {
+                for (const float upscalingFactor : {1.f, 0.8f, 0.5f}) {
+                    const XrFovf nativeFov{-0.8f, 0.8f, 0.75f, -0.85f};
+                    const XrFovf fov{-0.8f, 0.8f, nativeFov.angleUp * fovUp, nativeFov.angleDown * fovDown};
+                    CHECK(std::abs(getNativeFov(fov, fovUp, fovDown).angleUp - nativeFov.angleUp) < 1e-5f);
+
+                    const Placement placement = place(fov, nativeFov, height, height, upscalingFactor);
+
+                    // The padded view fits. The swapchain is sized before the upscaled height is rounded, so up to
+                    // half a pixel times the ratio, and the rounding of the borders, are left unused at the bottom.
+                    const float ratio = getPaddingRatio(fov, nativeFov);
+                    const int32_t paddedHeight =
+                        placement.topPadding + placement.rect.extent.height + placement.bottomPadding;
+                    CHECK(placement.rect.offset.y == placement.topPadding);
+                    CHECK(paddedHeight <= placement.size.height);
+                    CHECK(placement.size.height - paddedHeight <= 0.5f * ratio + 2.f);
+                    CHECK(placement.rect.extent.height == (int32_t)std::lround(height / upscalingFactor));
+
+                    // The padded FOV is the native FOV within the rounding of the borders.
+                    const float tangentsPerPixel =
+                        (tan(fov.angleUp) - tan(fov.angleDown)) / placement.rect.extent.height;
+                    CHECK(placement.paddedFov.angleLeft == fov.angleLeft);
+                    CHECK(std::abs(tan(placement.paddedFov.angleUp) - tan(nativeFov.angleUp)) <=
+                          0.5f * tangentsPerPixel + 1e-5f);
+                    CHECK(std::abs(tan(placement.paddedFov.angleDown) - tan(nativeFov.angleDown)) <=
+                          1.5f * tangentsPerPixel + 1e-5f);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,251 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "pch.h"
+
+#include "replay.h"
+#include "test.h"
+
+using namespace openxr_api_layer::test::replay;
+using namespace openxr_api_layer::utils;
+using namespace openxr_api_layer::utils::capture;
+
+namespace {
+
+    constexpr uint64_t SystemId = 42;
+    constexpr uint64_t Session = 7;
+    constexpr uint64_t Swapchain = 9;
+    constexpr uint32_t NativeSize = 2000;
+
+    // Append records to a capture in memory, as the layer's writer does.
+    struct CaptureBuilder {
+        CaptureBuilder() {
+            header.magic = FileMagic;
+            header.version = FileVersion;
+            header.headerSize = sizeof(FileHeader);
+            strcpy_s(header.applicationName, "ReplayTest");
+            strcpy_s(header.runtimeName, "Stub");
+            header.fovUpSetting = 800;
+            header.fovDownSetting = 900;
+            header.angleUpSetting = header.angleDownSetting = 45000;
+            header.upscalingSetting = 1000;
+        }
+
+        template <typename Payload>
+        void add(RecordType type, uint64_t handle, const Payload& payload, XrResult result = XR_SUCCESS) {
+            std::vector<uint8_t> record(getRecordSize(sizeof(Payload)));
+            RecordHeader* const recordHeader = reinterpret_cast<RecordHeader*>(record.data());
+            recordHeader->type.store(type);
+            recordHeader->size = (uint16_t)record.size();
+            recordHeader->result = result;
+            recordHeader->handle = handle;
+            memcpy(record.data() + sizeof(RecordHeader), &payload, sizeof(Payload));
+            records.insert(records.end(), record.begin(), record.end());
+        }
+
+        Capture build() const {
+            Capture capture;
+            capture.data.resize(sizeof(FileHeader));
+            memcpy(capture.data.data(), &header, sizeof(FileHeader));
+            capture.data.insert(capture.data.end(), records.begin(), records.end());
+            CHECK(parse(capture));
+            return capture;
+        }
+
+        FileHeader header{};
+        std::vector<uint8_t> records;
+    };
+
+    telemetry::Fov getNativeFov(uint32_t view, uint32_t frame) {
+        const float offset = frame * 0.01f;
+        return {view ? -0.8f : -0.9f, view ? 0.9f : 0.8f, 0.8f + offset, -0.85f - offset};
+    }
+
+    // A session as recorded by the layer, without the layer's outputs.
+    Capture buildSession(uint32_t frameCount, bool withSwapchain = false) {
+        CaptureBuilder builder;
+        builder.add(RecordType::GetSystem, SystemId, GetSystemPayload{XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY});
+
+        EnumerateViewConfigurationViewsPayload views{XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, 2};
+        builder.add(RecordType::EnumerateViewConfigurationViews, SystemId, views);
+        views.nativeImageSize[0] = views.nativeImageSize[1] = {NativeSize, NativeSize};
+        builder.add(RecordType::EnumerateViewConfigurationViews, SystemId, views);
+
+        builder.add(RecordType::CreateSession, Session, CreateSessionPayload{SystemId});
+        if (withSwapchain) {
+            CreateSwapchainPayload swapchain{Swapchain};
+            swapchain.usageFlags = XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+            swapchain.format = 29; // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+            swapchain.sampleCount = swapchain.faceCount = swapchain.arraySize = swapchain.mipCount = 1;
+            swapchain.width = swapchain.height = NativeSize;
+            builder.add(RecordType::CreateSwapchain, Session, swapchain);
+        }
+        for (uint32_t frame = 0; frame < frameCount; frame++) {
+            LocateViewsPayload locate{XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, 2, 1000 + frame};
+            locate.nativeFov[0] = getNativeFov(0, frame);
+            locate.nativeFov[1] = getNativeFov(1, frame);
+            builder.add(RecordType::LocateViews, Session, locate);
+            if (withSwapchain) {
+                builder.add(RecordType::AcquireSwapchainImage, Swapchain, AcquireSwapchainImagePayload{frame % 3});
+                // The application polls the image with a short timeout, then waits for it.
+                builder.add(RecordType::WaitSwapchainImage,
+                            Swapchain,
+                            WaitSwapchainImagePayload{1000000},
+                            XR_TIMEOUT_EXPIRED);
+                builder.add(RecordType::WaitSwapchainImage, Swapchain, WaitSwapchainImagePayload{XR_INFINITE_DURATION});
+                builder.add(RecordType::ReleaseSwapchainImage, Swapchain, ReleaseSwapchainImagePayload{});
+            }
+            builder.add(RecordType::EndFrame,
+                        Session,
+                        EndFramePayload{1000 + frame, 1, XR_ENVIRONMENT_BLEND_MODE_OPAQUE});
+        }
+        if (withSwapchain) {
+            builder.add(RecordType::DestroySwapchain, Swapchain, DestroySwapchainPayload{});
+        }
+        builder.add(RecordType::DestroySession, Session, DestroySessionPayload{});
+        return builder.build();
+    }
+
+} // namespace
+
+TEST_CASE(Replay_LayerCaptureReplaysIdentically) {
+    constexpr uint32_t FrameCount = 10;
+    const Capture session = buildSession(FrameCount);
+
+    // Record the layer's outputs for the runtime's inputs.
+    Options recordOptions;
+    recordOptions.compareOutputs = false;
+    recordOptions.captureReplay = true;
+    const Report recording = replay(session, recordOptions);
+    CHECK(recording.mismatches == 0);
+    CHECK(recording.replayedCalls == session.records.size());
+    CHECK(recording.calls[(size_t)RecordType::LocateViews].count == FrameCount);
+    CHECK(recording.calls[(size_t)RecordType::LocateViews].layerNs.size() == FrameCount);
+    CHECK(recording.capture.has_value());
+
+    const Capture& layerCapture = recording.capture.value();
+    CHECK(layerCapture.header.fovUpSetting == 800);
+    CHECK(layerCapture.header.fovDownSetting == 900);
+    CHECK(layerCapture.records.size() == session.records.size());
+    for (size_t i = 0; i < session.records.size(); i++) {
+        CHECK(layerCapture.records[i].type == session.records[i].type);
+        CHECK(layerCapture.records[i].result == XR_SUCCESS);
+    }
+
+    // The views are cropped from the 45 degrees angles of the settings until the first frame discovers the system's.
+    const auto& views = layerCapture.records[2].as<EnumerateViewConfigurationViewsPayload>();
+    const float angle = DirectX::XM_PI / 4;
+    const float expectedHeight = (tan(angle * 0.8f) + tan(angle * 0.9f)) / (2 * tan(angle)) * NativeSize;
+    CHECK(views.nativeImageSize[0].height == NativeSize);
+    CHECK(views.recommendedImageSize[0].width == NativeSize);
+    CHECK(std::abs((float)views.recommendedImageSize[0].height - expectedHeight) <= 1.f);
+
+    uint32_t frame = 0;
+    for (const Record& record : layerCapture.records) {
+        if (record.type != RecordType::LocateViews) {
+            continue;
+        }
+        const auto& locate = record.as<LocateViewsPayload>();
+        for (uint32_t view = 0; view < 2; view++) {
+            const telemetry::Fov nativeFov = getNativeFov(view, frame);
+            CHECK(locate.nativeFov[view].angleUp == nativeFov.angleUp);
+            CHECK(locate.customizedFov[view].angleLeft == nativeFov.angleLeft);
+            CHECK(locate.customizedFov[view].angleUp == nativeFov.angleUp * 0.8f);
+            CHECK(locate.customizedFov[view].angleDown == nativeFov.angleDown * 0.9f);
+        }
+        frame++;
+    }
+
+    // The same build of the layer reproduces its outputs.
+    const Report replayed = replay(layerCapture);
+    CHECK(replayed.replayedCalls == session.records.size());
+    CHECK(replayed.mismatches == 0);
+    CHECK(replayed.differences.empty());
+}
+
+TEST_CASE(Replay_ReportsDifferentOutputs) {
+    Options recordOptions;
+    recordOptions.compareOutputs = false;
+    recordOptions.captureReplay = true;
+    const Report recording = replay(buildSession(4), recordOptions);
+    CHECK(recording.capture.has_value());
+
+    // Pretend that another build of the layer customized one frame differently.
+    Capture tampered;
+    tampered.data = recording.capture->data;
+    CHECK(parse(tampered));
+    for (const Record& record : tampered.records) {
+        if (record.type == RecordType::LocateViews) {
+            const_cast<LocateViewsPayload&>(record.as<LocateViewsPayload>()).customizedFov[1].angleUp += 0.01f;
+            break;
+        }
+    }
+
+    const Report replayed = replay(tampered);
+    CHECK(replayed.mismatches == 1);
+    CHECK(replayed.differences.size() == 1);
+    CHECK(replayed.differences[0].find("xrLocateViews") != std::string::npos);
+}
+
+TEST_CASE(Replay_SwapchainCallsReplayIdentically) {
+    constexpr uint32_t FrameCount = 4;
+    const Capture session = buildSession(FrameCount, true /* withSwapchain */);
+
+    Options recordOptions;
+    recordOptions.compareOutputs = false;
+    recordOptions.captureReplay = true;
+    const Report recording = replay(session, recordOptions);
+    CHECK(recording.mismatches == 0);
+    CHECK(recording.replayedCalls == session.records.size());
+    CHECK(recording.calls[(size_t)RecordType::CreateSwapchain].count == 1);
+    CHECK(recording.calls[(size_t)RecordType::AcquireSwapchainImage].count == FrameCount);
+    CHECK(recording.calls[(size_t)RecordType::WaitSwapchainImage].count == 2 * FrameCount);
+    CHECK(recording.calls[(size_t)RecordType::ReleaseSwapchainImage].count == FrameCount);
+    CHECK(recording.calls[(size_t)RecordType::DestroySwapchain].count == 1);
+    CHECK(recording.capture.has_value());
+
+    // The runtime's timeouts reach the application, and the layer records the calls as the application made them.
+    const Capture& layerCapture = recording.capture.value();
+    CHECK(layerCapture.records.size() == session.records.size());
+    for (size_t i = 0; i < session.records.size(); i++) {
+        const Record& record = layerCapture.records[i];
+        CHECK(record.type == session.records[i].type);
+        CHECK(record.result == session.records[i].result);
+        CHECK(record.handle == session.records[i].handle);
+        if (record.type == RecordType::CreateSwapchain) {
+            CHECK(record.as<CreateSwapchainPayload>().swapchain == Swapchain);
+            CHECK(record.as<CreateSwapchainPayload>().width == NativeSize);
+        } else if (record.type == RecordType::AcquireSwapchainImage) {
+            CHECK(record.as<AcquireSwapchainImagePayload>().index ==
+                  session.records[i].as<AcquireSwapchainImagePayload>().index);
+        } else if (record.type == RecordType::WaitSwapchainImage) {
+            CHECK(record.as<WaitSwapchainImagePayload>().timeout ==
+                  session.records[i].as<WaitSwapchainImagePayload>().timeout);
+        }
+    }
+
+    const Report replayed = replay(layerCapture);
+    CHECK(replayed.replayedCalls == session.records.size());
+    CHECK(replayed.mismatches == 0);
+}
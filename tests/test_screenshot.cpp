@@ -0,0 +1,154 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "test.h"
+#include <utils/screenshot.h>
+
+using namespace openxr_api_layer::utils::screenshot;
+
+namespace {
+
+    uint32_t readBigEndian32(const uint8_t* data) {
+        return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+    }
+
+    // A decoder following the QOI specification, returning RGBA pixels.
+    std::vector<uint8_t> decodeQOI(const std::vector<uint8_t>& file, uint32_t width, uint32_t height) {
+        CHECK(file.size() >= 14 + 8);
+        CHECK(memcmp(file.data(), "qoif", 4) == 0);
+        CHECK(readBigEndian32(&file[4]) == width);
+        CHECK(readBigEndian32(&file[8]) == height);
+        CHECK(file[12] == 3);
+
+        struct Pixel {
+            uint8_t r, g, b, a;
+        };
+        Pixel index[64]{};
+        Pixel pixel{0, 0, 0, 255};
+
+        std::vector<uint8_t> rgba;
+        const size_t end = file.size() - 8;
+        size_t offset = 14;
+        uint32_t run = 0;
+        for (uint64_t i = 0; i < (uint64_t)width * height; i++) {
+            if (run > 0) {
+                run--;
+            } else {
+                CHECK(offset < end);
+                const uint8_t op = file[offset++];
+                if (op == 0xFE) {
+                    CHECK(offset + 3 <= end);
+                    pixel.r = file[offset++];
+                    pixel.g = file[offset++];
+                    pixel.b = file[offset++];
+                } else if (op == 0xFF) {
+                    CHECK(offset + 4 <= end);
+                    pixel = {file[offset], file[offset + 1], file[offset + 2], file[offset + 3]};
+                    offset += 4;
+                } else if ((op & 0xC0) == 0x00) {
+                    pixel = index[op];
+                } else if ((op & 0xC0) == 0x40) {
+                    pixel.r += ((op >> 4) & 3) - 2;
+                    pixel.g += ((op >> 2) & 3) - 2;
+                    pixel.b += (op & 3) - 2;
+                } else if ((op & 0xC0) == 0x80) {
+                    CHECK(offset < end);
+                    const int dg = (op & 0x3F) - 32;
+                    const uint8_t next = file[offset++];
+                    pixel.r += dg + ((next >> 4) & 0xF) - 8;
+                    pixel.g += dg;
+                    pixel.b += dg + (next & 0xF) - 8;
+                } else {
+                    run = op & 0x3F;
+                }
+                index[(pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) % 64] = pixel;
+            }
+            rgba.insert(rgba.end(), {pixel.r, pixel.g, pixel.b, pixel.a});
+        }
+
+        CHECK(offset == end);
+        const uint8_t endMarker[] = {0, 0, 0, 0, 0, 0, 0, 1};
+        CHECK(memcmp(&file[end], endMarker, sizeof(endMarker)) == 0);
+        return rgba;
+    }
+
+    // Encode the pixels with a padded row pitch and check that they decode to the same colors, opaque.
+    void checkQOIRoundTrip(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height) {
+        const uint32_t rowPitch = width * 4 + 12;
+        std::vector<uint8_t> padded((size_t)rowPitch * height, 0xCD);
+        for (uint32_t y = 0; y < height; y++) {
+            memcpy(&padded[(size_t)y * rowPitch], &rgba[(size_t)y * width * 4], (size_t)width * 4);
+        }
+
+        const std::vector<uint8_t> file = encodeQOI(padded.data(), width, height, rowPitch);
+        const std::vector<uint8_t> decoded = decodeQOI(file, width, height);
+        CHECK(decoded.size() == rgba.size());
+        for (size_t i = 0; i < rgba.size(); i += 4) {
+            CHECK(decoded[i] == rgba[i]);
+            CHECK(decoded[i + 1] == rgba[i + 1]);
+            CHECK(decoded[i + 2] == rgba[i + 2]);
+            CHECK(decoded[i + 3] == 255);
+        }
+    }
+
+} // namespace
+
+TEST_CASE(Screenshot_QOIRoundTripsBlackFirstPixel) {
+    // The first pixel matches the decoder's initial pixel and starts a run, black comes back after other colors.
+    const std::vector<uint8_t> rgba = {
+        0, 0, 0, 255, 0, 0, 0, 255, 200, 10, 10, 255, 0, 0, 0, 255,
+        1, 1, 1, 255, 200, 10, 10, 255, 1, 1, 1, 255, 0, 0, 0, 255,
+        255, 255, 255, 255, 0, 0, 0, 0, 90, 91, 92, 255, 0, 0, 0, 255,
+    };
+    checkQOIRoundTrip(rgba, 4, 3);
+}
+
+TEST_CASE(Screenshot_QOIRoundTripsBlackAfterOtherColors) {
+    // Black is first found in the index slot that the decoder has not written yet.
+    const std::vector<uint8_t> rgba = {
+        200, 10, 10, 255, 0, 0, 0, 255, 0, 0, 0, 255,
+        1, 1, 1, 255, 200, 10, 10, 255, 1, 1, 1, 255,
+    };
+    checkQOIRoundTrip(rgba, 6, 1);
+}
+
+TEST_CASE(Screenshot_QOIRoundTripsGradients) {
+    // Long runs, small and large differences, and many index hits.
+    const uint32_t width = 97;
+    const uint32_t height = 31;
+    std::vector<uint8_t> rgba;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            if (y < 2) {
+                rgba.insert(rgba.end(), {0, 0, 0, 255});
+            } else if (y % 3 == 0) {
+                rgba.insert(rgba.end(), {(uint8_t)x, (uint8_t)(x + y), (uint8_t)(x * 2), 255});
+            } else {
+                rgba.insert(rgba.end(), {(uint8_t)(x * 37 + y), (uint8_t)(y * 11), (uint8_t)((x / 4) * 50), 128});
+            }
+        }
+    }
+    checkQOIRoundTrip(rgba, width, height);
+}
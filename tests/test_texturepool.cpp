@@ -0,0 +1,321 @@
+// MIT License
+//
+// Copyright(c) 2023 cubexvr
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "test.h"
+
+using namespace openxr_api_layer::utils::graphics;
+
+namespace {
+
+    // A texture without storage. Opening it on another device refers to the texture it was created as.
+    struct CpuTexture : IGraphicsTexture {
+        CpuTexture(const XrSwapchainCreateInfo& info, bool shareable, const CpuTexture* source = nullptr)
+            : m_info(info), m_isShareable(shareable), m_source(source ? source : this) {
+        }
+
+        Api getApi() const override {
+            return Api::D3D11;
+        }
+
+        void* getNativeTexturePtr() const override {
+            return const_cast<CpuTexture*>(m_source);
+        }
+
+        ShareableHandle getTextureHandle() const override {
+            if (!m_isShareable) {
+                throw std::runtime_error("Texture is not shareable");
+            }
+            ShareableHandle handle;
+            handle.handle = getNativeTexturePtr();
+            handle.origin = Api::D3D11;
+            return handle;
+        }
+
+        const XrSwapchainCreateInfo& getInfo() const override {
+            return m_info;
+        }
+
+        bool isShareable() const override {
+            return m_isShareable;
+        }
+
+        const XrSwapchainCreateInfo m_info;
+        const bool m_isShareable;
+        const CpuTexture* const m_source;
+    };
+
+    // A device that only counts the texture operations.
+    struct CpuDevice : IGraphicsDevice {
+        Api getApi() const override {
+            return Api::D3D11;
+        }
+
+        void* getNativeDevicePtr() const override {
+            return nullptr;
+        }
+
+        void* getNativeContextPtr() const override {
+            return nullptr;
+        }
+
+        std::shared_ptr<IGraphicsTimer> createTimer() override {
+            throw std::runtime_error("Not implemented");
+        }
+
+        std::shared_ptr<IGraphicsTimerPool> createTimerPool(uint32_t frameLatency) override {
+            throw std::runtime_error("Not implemented");
+        }
+
+        std::shared_ptr<IGraphicsFence> createFence(bool shareable) override {
+            throw std::runtime_error("Not implemented");
+        }
+
+        std::shared_ptr<IGraphicsFence> openFence(const ShareableHandle& handle) override {
+            throw std::runtime_error("Not implemented");
+        }
+
+        std::shared_ptr<IGraphicsTexture> createTexture(const XrSwapchainCreateInfo& info, bool shareable) override {
+            m_createdTextures++;
+            m_createdShareableTextures += shareable ? 1 : 0;
+            return std::make_shared<CpuTexture>(info, shareable);
+        }
+
+        std::shared_ptr<IGraphicsTexture> openTexture(const ShareableHandle& handle,
+                                                      const XrSwapchainCreateInfo& info) override {
+            m_openedTextures++;
+            const auto source = reinterpret_cast<const CpuTexture*>(handle.handle);
+            const auto texture = std::make_shared<CpuTexture>(info, false, source);
+            m_liveOpenedTextures.push_back(texture);
+            return texture;
+        }
+
+        std::shared_ptr<IGraphicsTexture> openTexturePtr(void* nativeTexturePtr,
+                                                         const XrSwapchainCreateInfo& info) override {
+            throw std::runtime_error("Not implemented");
+        }
+
+        std::shared_ptr<IGraphicsReadback>
+        createReadback(int64_t format, uint32_t width, uint32_t height, uint32_t depth) override {
+            throw std::runtime_error("Not implemented");
+        }
+
+        void copyTexture(IGraphicsTexture* from, IGraphicsTexture* to) override {
+            m_copies++;
+        }
+
+        void copyTextureRegion(IGraphicsTexture* from,
+                               const XrRect2Di& fromRect,
+                               uint32_t fromArraySlice,
+                               IGraphicsTexture* to,
+                               const XrOffset2Di& toOffset,
+                               uint32_t toArraySlice,
+                               uint32_t mipLevel) override {
+            m_regionCopies++;
+        }
+
+        void scaleTextureRegion(IGraphicsTexture* from,
+                                const XrRect2Di& fromRect,
+                                uint32_t fromArraySlice,
+                                int64_t fromFormat,
+                                IGraphicsTexture* to,
+                                const XrRect2Di& toRect,
+                                uint32_t toArraySlice,
+                                int64_t toFormat,
+                                ScalingFilter filter) override {
+            throw std::runtime_error("Not implemented");
+        }
+
+        void clearTexture(IGraphicsTexture* texture,
+                          uint32_t arraySlice,
+                          int64_t format,
+                          const XrColor4f& color) override {
+            throw std::runtime_error("Not implemented");
+        }
+
+        GenericFormat translateToGenericFormat(int64_t format) const override {
+            return (DXGI_FORMAT)format;
+        }
+
+        int64_t translateFromGenericFormat(GenericFormat format) const override {
+            return format;
+        }
+
+        LUID getAdapterLuid() const override {
+            return {};
+        }
+
+        CommandListStatistics getCommandListStatistics() const override {
+            return {};
+        }
+
+        uint32_t getLiveOpenedTextures() {
+            return (uint32_t)std::count_if(m_liveOpenedTextures.cbegin(),
+                                           m_liveOpenedTextures.cend(),
+                                           [](const std::weak_ptr<IGraphicsTexture>& texture) {
+                                               return !texture.expired();
+                                           });
+        }
+
+        uint32_t m_createdTextures{0};
+        uint32_t m_createdShareableTextures{0};
+        uint32_t m_openedTextures{0};
+        uint32_t m_copies{0};
+        uint32_t m_regionCopies{0};
+        std::vector<std::weak_ptr<IGraphicsTexture>> m_liveOpenedTextures;
+    };
+
+    XrSwapchainCreateInfo getTextureInfo(uint32_t width, uint32_t height) {
+        XrSwapchainCreateInfo info{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+        info.usageFlags = XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+        info.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        info.sampleCount = info.faceCount = info.arraySize = info.mipCount = 1;
+        info.width = width;
+        info.height = height;
+        return info;
+    }
+
+    XrSwapchainSubImage getSubImage(int32_t x, int32_t y, int32_t width, int32_t height) {
+        XrSwapchainSubImage subImage{};
+        subImage.imageRect = {{x, y}, {width, height}};
+        return subImage;
+    }
+
+    constexpr uint64_t TextureSize = 1024 * 1024 * 4;
+
+} // namespace
+
+TEST_CASE(TexturePool_ReusesTexturesAcrossSessions) {
+    CpuDevice compositionDevice;
+    const std::shared_ptr<ITexturePool> pool = createTexturePool(&compositionDevice, 4 * TextureSize);
+    const XrSwapchainCreateInfo info = getTextureInfo(1024, 1024);
+
+    // First session: one allocation, opened once on the application device, then reused as is.
+    CpuDevice firstApplicationDevice;
+    for (uint32_t i = 0; i < 3; i++) {
+        SharedTexture texture = pool->acquire(&firstApplicationDevice, info, info);
+        CHECK(texture.onApplicationDevice->getNativeTexturePtr() == texture.onCompositionDevice.get());
+        pool->release(std::move(texture), TextureSize);
+    }
+    CHECK(compositionDevice.m_createdTextures == 1);
+    CHECK(compositionDevice.m_createdShareableTextures == 1);
+    CHECK(firstApplicationDevice.m_openedTextures == 1);
+    pool->forgetApplicationDevice(&firstApplicationDevice);
+    CHECK(firstApplicationDevice.getLiveOpenedTextures() == 0);
+
+    // Second session on another application device: the texture is reused, and only opened again.
+    CpuDevice secondApplicationDevice;
+    SharedTexture texture = pool->acquire(&secondApplicationDevice, info, info);
+    CHECK(texture.onApplicationDevice->getNativeTexturePtr() == texture.onCompositionDevice.get());
+    CHECK(compositionDevice.m_createdTextures == 1);
+    CHECK(secondApplicationDevice.m_openedTextures == 1);
+
+    // Another description needs another texture.
+    SharedTexture otherTexture = pool->acquire(&secondApplicationDevice, info, getTextureInfo(512, 1024));
+    CHECK(compositionDevice.m_createdTextures == 2);
+    CHECK(secondApplicationDevice.m_openedTextures == 2);
+
+    const TexturePoolStatistics statistics = pool->getStatistics();
+    CHECK(statistics.hits == 3);
+    CHECK(statistics.misses == 2);
+    CHECK(statistics.opens == 3);
+    CHECK(statistics.evictions == 0);
+    CHECK(statistics.freeMemorySize == 0);
+}
+
+TEST_CASE(TexturePool_SharedDeviceAllocatesNonShareableTextures) {
+    // When composition happens on the application device, nothing is exported or opened.
+    CpuDevice device;
+    const std::shared_ptr<ITexturePool> pool = createTexturePool(&device, 4 * TextureSize);
+    const XrSwapchainCreateInfo info = getTextureInfo(1024, 1024);
+
+    for (uint32_t i = 0; i < 3; i++) {
+        SharedTexture texture = pool->acquire(&device, info, info);
+        CHECK(texture.onApplicationDevice == texture.onCompositionDevice);
+        CHECK(!texture.onCompositionDevice->isShareable());
+        pool->release(std::move(texture), TextureSize);
+    }
+    CHECK(device.m_createdTextures == 1);
+    CHECK(device.m_createdShareableTextures == 0);
+    CHECK(device.m_openedTextures == 0);
+
+    // The texture cannot be used with another device.
+    pool->forgetApplicationDevice(&device);
+    const TexturePoolStatistics statistics = pool->getStatistics();
+    CHECK(statistics.hits == 2);
+    CHECK(statistics.misses == 1);
+    CHECK(statistics.opens == 0);
+    CHECK(statistics.freeMemorySize == 0);
+}
+
+TEST_CASE(TexturePool_CopiesOnlySubmittedRegions) {
+    CpuDevice compositionDevice;
+    CpuDevice applicationDevice;
+    const std::shared_ptr<ITexturePool> pool = createTexturePool(&compositionDevice, 4 * TextureSize);
+    const XrSwapchainCreateInfo info = getTextureInfo(1024, 1024);
+    const SharedTexture texture = pool->acquire(&applicationDevice, info, info);
+    CpuTexture swapchainImage(info, false);
+
+    // Without sub-images, the whole texture is copied at once.
+    pool->copy(&applicationDevice, &swapchainImage, texture.onApplicationDevice.get(), {});
+    CHECK(applicationDevice.m_copies == 1);
+    CHECK(applicationDevice.m_regionCopies == 0);
+
+    pool->copy(&applicationDevice,
+               texture.onApplicationDevice.get(),
+               &swapchainImage,
+               {getSubImage(0, 0, 512, 1024), getSubImage(512, 0, 512, 1024)});
+    CHECK(applicationDevice.m_copies == 1);
+    CHECK(applicationDevice.m_regionCopies == 2);
+
+    // Copies happen on the application device only.
+    CHECK(compositionDevice.m_copies == 0);
+    CHECK(compositionDevice.m_regionCopies == 0);
+    CHECK(pool->getStatistics().copies == 3);
+}
+
+TEST_CASE(TexturePool_EvictsLeastRecentlyReleasedPastBudget) {
+    CpuDevice compositionDevice;
+    CpuDevice applicationDevice;
+    const std::shared_ptr<ITexturePool> pool = createTexturePool(&compositionDevice, 2 * TextureSize);
+
+    std::vector<SharedTexture> textures;
+    for (uint32_t i = 0; i < 3; i++) {
+        const XrSwapchainCreateInfo info = getTextureInfo(1024, 1024 + i);
+        textures.push_back(pool->acquire(&applicationDevice, info, info));
+    }
+    for (SharedTexture& texture : textures) {
+        pool->release(std::move(texture), TextureSize);
+    }
+    CHECK(pool->getStatistics().evictions == 1);
+    CHECK(pool->getStatistics().freeMemorySize == 2 * TextureSize);
+
+    // The first texture was evicted, the last one is reused.
+    pool->acquire(&applicationDevice, getTextureInfo(1024, 1024), getTextureInfo(1024, 1024));
+    pool->acquire(&applicationDevice, getTextureInfo(1024, 1026), getTextureInfo(1024, 1026));
+    CHECK(compositionDevice.m_createdTextures == 4);
+    CHECK(applicationDevice.m_openedTextures == 4);
+    CHECK(pool->getStatistics().hits == 1);
+    CHECK(pool->getStatistics().misses == 4);
+}